@@ -18,6 +18,12 @@
 **********************************************************************
 */
 
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+  #define _GNU_SOURCE                 // CPU_SET(), pthread_setaffinity_np()
+#endif
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -36,12 +42,18 @@
 #include <sys/time.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <time.h>
 #include <unistd.h>
 #endif
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <winioctl.h>
 #include <time.h>
 #include <winsock2.h>
 #include "getopt.h"
@@ -223,6 +235,29 @@
   #define RTT_SEND_THRESHOLD   512
 #endif
 
+/*********************************************************************
+*
+*       RTT_TRANSFER_SIZE
+*  Maximum number of bytes moved per direction and poll. Read with one
+*  request once the packet size has been negotiated, see
+*  RTT_NEGOTIATE_PACKET_SIZE.
+*
+*/
+#ifndef   RTT_TRANSFER_SIZE
+  #define RTT_TRANSFER_SIZE    T32_MAXPACKETSIZE_MAX
+#endif
+
+/*********************************************************************
+*
+*       RTT_NEGOTIATE_PACKET_SIZE
+*  Probe the largest RCL payload PowerView accepts after connecting,
+*  otherwise transfers are split into T32_MAXPACKETSIZE_DEFAULT chunks.
+*
+*/
+#ifndef   RTT_NEGOTIATE_PACKET_SIZE
+  #define RTT_NEGOTIATE_PACKET_SIZE  1
+#endif
+
 /*********************************************************************
 *
 *       RTT_COMM_POLL_INTERVAL
@@ -233,6 +268,231 @@
   #define RTT_COMM_POLL_INTERVAL    2
 #endif
 
+/*********************************************************************
+*
+*       RTT_CB_MAX_NUM_BUFFERS
+*  Maximum number of up / down buffers per direction which are cached
+*  from the RTT control block. Bounds the size of the bulk read.
+*
+*/
+#ifndef   RTT_CB_MAX_NUM_BUFFERS
+  #define RTT_CB_MAX_NUM_BUFFERS    16
+#endif
+
+/*********************************************************************
+*
+*       RTT_MAX_NUM_TARGETS
+*  Maximum number of TRACE32 instances bridged by one process.
+*
+*/
+#ifndef   RTT_MAX_NUM_TARGETS
+  #define RTT_MAX_NUM_TARGETS       16
+#endif
+
+/*********************************************************************
+*
+*       RTT_MAX_NUM_BLOCKS
+*  Maximum number of RTT control blocks per target, e.g. one per core.
+*
+*/
+#ifndef   RTT_MAX_NUM_BLOCKS
+  #define RTT_MAX_NUM_BLOCKS        8
+#endif
+
+/*********************************************************************
+*
+*       RTT_DEFAULT_ACCESS
+*  TRACE32 memory access class of control blocks which do not specify
+*  one. Accessed with the plain memory API, other classes use the
+*  object API.
+*
+*/
+#ifndef   RTT_DEFAULT_ACCESS
+  #define RTT_DEFAULT_ACCESS        "E"
+#endif
+
+/*********************************************************************
+*
+*       RTT_BUNDLE_MAX_DATA
+*  Reply data of a memory bundle read, including the header and the
+*  status of each chunk, below the message limit of TRACE32 (0x3c00).
+*
+*/
+#define RTT_BUNDLE_MAX_DATA         0x3800u
+
+/*********************************************************************
+*
+*       RTT_RECONNECT_DELAY
+*  Initial delay [ms] before an offline target is reconnected.
+*  Doubled on every failed attempt up to RTT_RECONNECT_DELAY_MAX.
+*
+*/
+#ifndef   RTT_RECONNECT_DELAY
+  #define RTT_RECONNECT_DELAY       1000
+#endif
+
+#ifndef   RTT_RECONNECT_DELAY_MAX
+  #define RTT_RECONNECT_DELAY_MAX   30000
+#endif
+
+/*********************************************************************
+*
+*       RTT_PROBE_*
+*  State of the reachability probe of an offline target, see
+*  _PROBE_Thread(). The blocking RCL connect handshake of an offline
+*  target runs in a probe thread, the poll loop connects the target
+*  only after TRACE32 has answered.
+*
+*/
+#define RTT_PROBE_IDLE              0   // No probe requested
+#define RTT_PROBE_PENDING           1   // The probe thread connects
+#define RTT_PROBE_OK                2   // TRACE32 answered
+#define RTT_PROBE_FAILED            3   // TRACE32 did not answer
+
+/*********************************************************************
+*
+*       RTT_STATS_INTERVAL
+*  Interval [ms] in which the statistics of all targets are logged.
+*
+*/
+#ifndef   RTT_STATS_INTERVAL
+  #define RTT_STATS_INTERVAL        60000
+#endif
+
+/*********************************************************************
+*
+*       RTT_APISTATS_MAX
+*  Max. number of RCL API functions listed by the SIGUSR1 dump.
+*
+*/
+#ifndef   RTT_APISTATS_MAX
+  #define RTT_APISTATS_MAX          64
+#endif
+
+/*********************************************************************
+*
+*       RTT_RCL_MAX_REQUESTS, RTT_RCL_MAX_BYTES
+*  Default RCL budget per target [requests/s, bytes/s], 0 for no limit.
+*  Leaves room for PowerView and scripts sharing the link, see --budget.
+*
+*/
+#ifndef   RTT_RCL_MAX_REQUESTS
+  #define RTT_RCL_MAX_REQUESTS      0
+#endif
+
+#ifndef   RTT_RCL_MAX_BYTES
+  #define RTT_RCL_MAX_BYTES         0
+#endif
+
+/*********************************************************************
+*
+*       RTT_RCL_LOCK_TIMEOUT, RTT_RCL_BURST_POLLS
+*  With --apilock, a target is polled in exclusive bursts: T32_APILock()
+*  waits up to RTT_RCL_LOCK_TIMEOUT [ms], then up to RTT_RCL_BURST_POLLS
+*  polls are done back to back as long as data is moving.
+*
+*/
+#ifndef   RTT_RCL_LOCK_TIMEOUT
+  #define RTT_RCL_LOCK_TIMEOUT      0
+#endif
+
+#ifndef   RTT_RCL_BURST_POLLS
+  #define RTT_RCL_BURST_POLLS       8
+#endif
+
+/*********************************************************************
+*
+*       RTT_COALESCE_GAP, RTT_COALESCE_MAX_READ
+*  Small reads (up to RTT_COALESCE_MAX_READ bytes, e.g. the offsets of
+*  a ring descriptor) of one poll step are served from a single read
+*  of all nearby ranges. Ranges at most RTT_COALESCE_GAP bytes apart
+*  are merged, see --coalesce.
+*
+*/
+#ifndef   RTT_COALESCE_GAP
+  #define RTT_COALESCE_GAP          64
+#endif
+
+#ifndef   RTT_COALESCE_MAX_READ
+  #define RTT_COALESCE_MAX_READ     16
+#endif
+
+/*********************************************************************
+*
+*       RTT_LOAD_RETRIES, RTT_LOAD_REPORT_INTERVAL
+*  A --load which failed is resumed from the last acknowledged offset
+*  up to RTT_LOAD_RETRIES times. The progress is reported every
+*  RTT_LOAD_REPORT_INTERVAL [ms].
+*
+*/
+#ifndef   RTT_LOAD_RETRIES
+  #define RTT_LOAD_RETRIES          3
+#endif
+
+#ifndef   RTT_LOAD_REPORT_INTERVAL
+  #define RTT_LOAD_REPORT_INTERVAL  500
+#endif
+
+/*********************************************************************
+*
+*       RTT_VERIFY_BLOCK_SIZE
+*  --verify reads back and compares blocks of this size [bytes] whose
+*  TRACE32 checksum differs from the file.
+*
+*/
+#ifndef   RTT_VERIFY_BLOCK_SIZE
+  #define RTT_VERIFY_BLOCK_SIZE     1024
+#endif
+
+/*********************************************************************
+*
+*       RTT_DUMP_PAGE_SIZE
+*  --dump leaves pages of this size [bytes] which read as all zero
+*  unwritten, so that they stay holes of the sparse output file.
+*
+*/
+#ifndef   RTT_DUMP_PAGE_SIZE
+  #define RTT_DUMP_PAGE_SIZE        4096
+#endif
+
+#define RTT_COALESCE_MAX_RANGES     32
+#define RTT_COALESCE_SIZE           (RTT_MAX_NUM_BLOCKS * RTTCB_SIZEOF_IMAGE + 512)  // Control block images and small reads
+
+/*********************************************************************
+*
+*       RTT_MEMCACHE_TTL, RTT_MEMCACHE_NAME_SIZE
+*  Host side cache of control block memory which rarely changes, see
+*  _MEMCACHE_Read(). Buffer flags are kept for RTT_MEMCACHE_TTL [ms],
+*  RTT_MEMCACHE_NAME_SIZE bytes are cached per channel name.
+*
+*/
+#ifndef   RTT_MEMCACHE_TTL
+  #define RTT_MEMCACHE_TTL          1000
+#endif
+
+#ifndef   RTT_MEMCACHE_NAME_SIZE
+  #define RTT_MEMCACHE_NAME_SIZE    32
+#endif
+
+#define RTT_MEMCACHE_MAX_REGIONS    128
+#define RTT_MEMCACHE_SIZE           2048
+
+/*********************************************************************
+*
+*       RTT_RT_PRIORITY, RTT_RT_BUSY_POLL
+*  Low-latency profile, see --realtime: SCHED_FIFO priority of the
+*  poll loop and SO_BUSY_POLL time [us] of the RCL sockets.
+*  The loop then runs at a fixed period of RTT_COMM_POLL_INTERVAL.
+*
+*/
+#ifndef   RTT_RT_PRIORITY
+  #define RTT_RT_PRIORITY           50
+#endif
+
+#ifndef   RTT_RT_BUSY_POLL
+  #define RTT_RT_BUSY_POLL          50
+#endif
+
 /*********************************************************************
 *
 *       Function-like macros
@@ -266,6 +526,37 @@
 
 typedef int _SYS_SOCKET_HANDLE;
 
+//
+// Host side copy of one RTT ring buffer descriptor.
+//
+typedef struct {
+  const char* sAccess;          // Access class of the owning control block
+  unsigned Addr;                // Target address of the descriptor
+  unsigned pBuffer;
+  unsigned SizeOfBuffer;
+  unsigned WrOff;               // Snapshot of the last control block update
+  unsigned RdOff;
+  unsigned Flags;
+} RTT_BUFFER_DESC;
+
+//
+// Host side copy of the RTT control block. Only valid while IsValid is set,
+// it is dropped and re-discovered whenever a target reset is detected.
+//
+typedef struct {
+  unsigned        Address;      // Target address of the control block
+  char            acAccess[16]; // TRACE32 access class, e.g. "E" or "EAXI"
+  int             IsValid;
+  unsigned        NumResets;
+  unsigned        MaxNumUpBuffers;
+  unsigned        MaxNumDownBuffers;
+  unsigned        CacheEpoch;   // RTT_MEMCACHE.Epoch the regions of the block were defined in
+  RTT_BUFFER_DESC aUp[RTT_CB_MAX_NUM_BUFFERS];
+  RTT_BUFFER_DESC aDown[RTT_CB_MAX_NUM_BUFFERS];
+} RTT_CB_CACHE;
+
+#define RTTCB_SIZEOF_IMAGE    (RTTCB_OFFSET_AUP(0) + 2u * RTT_CB_MAX_NUM_BUFFERS * RTTCB_SIZEOF_AUP)
+
 typedef enum _VT_STATE_T {
   Normal,
   Esc,
@@ -275,6 +566,188 @@ typedef enum _VT_STATE_T {
   DropOne
 } VT_STATE_T;
 
+//
+// Record file of one telnet session, see RTT_TelnetLogS().
+//
+typedef struct {
+  char*      sFile;
+  FILE*      pFile;
+  VT_STATE_T vt_state;
+} RTT_LOG;
+
+typedef struct {
+  unsigned NumPolls;
+  unsigned NumBytesUp;          // Target -> telnet
+  unsigned NumBytesDown;        // Telnet -> target
+  unsigned NumConnects;
+  unsigned NumLinkErrors;
+  unsigned NumClients;
+} RTT_TARGET_STATS;
+
+//
+// RCL budget of one target. The credit is refilled with the budget and
+// charged with the measured traffic of each poll [units of 1/1000].
+// A poll is skipped while a credit is used up, so a burst which
+// overdraws the credit delays the following polls.
+//
+typedef struct {
+  int64_t  CreditRequests;
+  int64_t  CreditBytes;
+  unsigned LastRefill;
+  unsigned WindowStart;         // Usage of the current one second window
+  unsigned WindowRequests;
+  unsigned WindowBytes;
+  unsigned RateRequests;        // Usage of the last window [requests/s]
+  unsigned RateBytes;           // [bytes/s]
+  unsigned NumThrottled;        // Polls skipped for the budget
+  unsigned NumLocked;           // Bursts skipped, API locked by another client
+} RTT_GOVERNOR;
+
+//
+// Lifetime of a cached memory region, see _MEMCACHE_IsValid().
+//
+typedef enum {
+  RTT_CACHE_IMMUTABLE,          // Until the target is reset
+  RTT_CACHE_TTL,                // For TtlMs after it has been read
+  RTT_CACHE_EVENT               // Until the target is halted or started
+} RTT_MEMCACHE_POLICY;
+
+typedef struct {
+  const char*         sAccess;
+  unsigned            Addr;
+  unsigned            NumBytes;
+  unsigned            Offset;   // Position of the data in RTT_MEMCACHE.acData
+  RTT_MEMCACHE_POLICY Policy;
+  unsigned            TtlMs;
+  unsigned            Gen;      // Generation the data was read in, 0: not read
+  unsigned            ReadTime;
+} RTT_MEMCACHE_REGION;
+
+//
+// Memory cache of one target. Regions are defined when a control block
+// is found and dropped together when it is invalidated (reset). The
+// generation is incremented whenever the target is halted or started.
+//
+typedef struct {
+  unsigned            Gen;
+  unsigned            Epoch;    // Incremented when all regions are dropped
+  unsigned            NumRegions;
+  unsigned            NumUsed;  // Bytes of acData in use
+  RTT_MEMCACHE_REGION aRegion[RTT_MEMCACHE_MAX_REGIONS];
+  unsigned char       acData[RTT_MEMCACHE_SIZE];
+  unsigned            NumHits;
+  unsigned            NumReads;
+} RTT_MEMCACHE;
+
+//
+// Target memory range known to the read coalescer.
+//
+typedef struct {
+  const char* sAccess;
+  unsigned    Addr;
+  unsigned    NumBytes;
+  unsigned    Offset;           // Position of the data in RTT_COALESCER.acData
+  int         IsStored;         // Passed in by _COALESCE_Store(), not read by the coalescer
+} RTT_COALESCE_RANGE;
+
+//
+// Read coalescer of one target, see _COALESCE_Read(). Small reads are
+// served from the data read during the current poll step. A miss reads
+// the missed range together with the small reads of the previous step,
+// merged into as few requests as the gap allows.
+//
+typedef struct {
+  unsigned           NumRanges;
+  unsigned           NumUsed;       // Bytes of acData in use
+  unsigned           NumHints;
+  unsigned           NumNext;
+  RTT_COALESCE_RANGE aRange[RTT_COALESCE_MAX_RANGES];   // Valid during the current step
+  RTT_COALESCE_RANGE aHint[RTT_COALESCE_MAX_RANGES];    // Small reads of the previous step
+  RTT_COALESCE_RANGE aNext[RTT_COALESCE_MAX_RANGES];    // Small reads of the current step
+  unsigned char      acData[RTT_COALESCE_SIZE];
+  unsigned           NumRequests;   // Small reads served
+  unsigned           NumReads;      // Target reads done for them
+} RTT_COALESCER;
+
+//
+// One RTT control block of a target, e.g. one per core of a
+// heterogeneous SoC. The channel map selects the up / down buffer
+// which is bridged to the telnet port of the block.
+//
+typedef struct {
+  char*              sSymbol;       // Symbol of the control block, NULL if the address is given
+  unsigned           UpIndex;
+  unsigned           DownIndex;
+  unsigned           LocalPort;
+  unsigned           LastReadTime;
+  RTT_CB_CACHE       RTTCB;
+  RTT_LOG            Log;
+  _SYS_SOCKET_HANDLE hSockListen;
+  _SYS_SOCKET_HANDLE hSockSV;
+} RTT_BLOCK;
+
+//
+// One bridged TRACE32 instance. Each target owns its RCL channel
+// (see T32_GetChannelSize()), its control blocks and their telnet sockets.
+//
+typedef struct {
+  char*              sNode;
+  char*              sPort;
+  void*              pChannel;
+  int                IsOnline;
+  int                Resync;        // Saved _RTTCBResync while another target is selected
+  int                LinkError;     // Saved _T32LinkError while another target is selected
+  unsigned           RetryTime;
+  unsigned           RetryDelay;
+  int                ProbeState;    // RTT_PROBE_*, shared with the probe thread under _ProbeMutex
+  int                HasDefaultBlock;  // aBlock[0] was implied by --target / --lport
+  unsigned           NumBlocks;
+  RTT_BLOCK          aBlock[RTT_MAX_NUM_BLOCKS];
+  RTT_TARGET_STATS   Stats;
+  RTT_GOVERNOR       Gov;
+  RTT_COALESCER      Coalesce;
+  RTT_MEMCACHE       MemCache;
+} RTT_TARGET;
+
+//
+// Poll period of the low-latency profile, see _RT_Wait().
+//
+typedef struct {
+  uint64_t NextNs;              // Absolute deadline of the next poll [ns, CLOCK_MONOTONIC]
+  uint64_t SumLateNs;           // Wake-up delay behind the deadlines
+  unsigned MaxLateNs;
+  unsigned NumPeriods;
+  unsigned NumOverruns;         // Polls which took longer than one period
+} RTT_RT_STATS;
+
+//
+// Progress report of --load and --dump, see _LOAD_Progress().
+//
+typedef struct {
+  const char* sAction;          // "loaded" or "dumped"
+  unsigned    NextReport;       // Tick of the next progress line
+  uint32_t    Retransmits;      // Of the current attempt
+  uint32_t    PacketSize;       // Of the current attempt, see T32_LoadProgress
+  uint32_t    Window;
+} RTT_LOAD_REPORT;
+
+//
+// Output file of --dump, see _DUMP_Store().
+//
+typedef struct {
+  RTT_LOAD_REPORT Report;
+  uint8_t*        pMap;         // File mapped for writing
+  uint64_t        NumZero;      // Bytes left as holes
+  uint64_t        NumFailed;    // Bytes the target failed to read
+  unsigned        NumRanges;    // Ranges the target failed to read
+#ifdef _WIN32
+  HANDLE          hFile;
+  HANDLE          hMapping;
+#else
+  int             fd;
+#endif
+} RTT_DUMP_FILE;
+
 /*********************************************************************
 *
 *       static data
@@ -285,6 +758,43 @@ typedef enum _VT_STATE_T {
 static int            _int1   = 1;
 static const char hexchar[] = "0123456789ABCDEF";
 static       char telnetCmd[] = {0xff, 0xfb, 0x01, 0xff, 0xfb, 0x03, 0xff, 0xfc, 0x1f};
+static const char _acRTTID[]  = "SEGGER RTT";
+
+static volatile int _RTTCBResync;   // Set on reset errors and state notifications, cleared by _TARGET_Poll()
+static          int _T32LinkError;  // First communication error of the selected target
+
+static RTT_TARGET   _aTarget[RTT_MAX_NUM_TARGETS];
+static unsigned     _NumTargets;
+static RTT_TARGET*  _pTarget;       // Target whose RCL channel is currently selected
+
+#ifdef __linux__
+static pthread_mutex_t _ProbeMutex = PTHREAD_MUTEX_INITIALIZER;
+static int             _ProbeEnabled;     // Offline targets are probed in a thread first
+static char*           _pProbePackLen;
+#endif
+static char         _acBuf[RTT_TRANSFER_SIZE];  // Transfer buffer shared by all targets
+
+static unsigned     _GovMaxRequests = RTT_RCL_MAX_REQUESTS;  // RCL budget per target, 0: no limit
+static unsigned     _GovMaxBytes    = RTT_RCL_MAX_BYTES;
+static int          _GovUseLock;                             // Poll in exclusive bursts, see --apilock
+
+static int            _CoalesceGap = RTT_COALESCE_GAP;       // -1: reads are not coalesced, see --coalesce
+static RTT_COALESCER* _pCoalesce;                            // Coalescer of the poll step in progress
+
+static int          _RtEnable;                               // Low-latency profile, see --realtime
+static int          _RtCpu         = -1;                     // Core the poll loop is pinned to, -1: any
+static int          _RtPriority    = RTT_RT_PRIORITY;
+static unsigned     _RtBusyPollUs  = RTT_RT_BUSY_POLL;
+static RTT_RT_STATS _RtStats;
+
+static const char*  _pCaptureFile;                           // pcapng file of the RCL traffic, see --capture
+static const char*  _pReplayFile;                            // Capture answering the requests, see --replay
+static const char*  _pLoadArg;                               // <file>:<address>[:<access>], see --load
+static const char*  _pVerifyArg;                             // <file>:<address>[:<access>], see --verify
+static const char*  _pDumpArg;                               // <file>:<address>:<size>[:<access>], see --dump
+
+static volatile sig_atomic_t _ApiStatsRequest;             // Set by SIGUSR1, dump pending
+static T32_ApiStats _aApiStats[RTT_APISTATS_MAX];           // Snapshot of the dump
 
 /*********************************************************************
 *
@@ -307,6 +817,9 @@ static       char telnetCmd[] = {0xff, 0xfb, 0x01, 0xff, 0xfb, 0x03, 0xff, 0xfc,
 **********************************************************************
 */
 static void T32_DefaultState(int exit);
+static void _TARGET_ExitAll(void);
+static void _TARGET_LogStats(void);
+static void _TARGET_LogApiStats(void);
 
 /*********************************************************************
 *
@@ -395,6 +908,120 @@ int32_t SYS_Sleep(uint32_t msec) {
 }
 #endif
 
+/*********************************************************************
+*
+*       SYS_GetTickCount()
+*
+*  Function description
+*    Returns a free running millisecond counter.
+*/
+static unsigned SYS_GetTickCount(void) {
+#ifdef __linux__
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000);
+#endif
+#ifdef _WIN32
+  return (unsigned)GetTickCount();
+#endif
+}
+
+/*********************************************************************
+*
+*       _RT_GetTimeNs()
+*
+*  Function description
+*    Returns a free running nanosecond counter.
+*/
+#ifdef __linux__
+static uint64_t _RT_GetTimeNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+/*********************************************************************
+*
+*       _RT_Enter()
+*
+*  Function description
+*    Enters the low-latency profile, see --realtime. Locks all pages,
+*    pins the calling thread to _RtCpu and runs it under SCHED_FIFO.
+*    Steps which are not permitted are logged and skipped.
+*/
+#ifdef __linux__
+static void _RT_Enter(void) {
+  struct sched_param Param;
+  cpu_set_t          Set;
+  int                r;
+
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    SYS_Log("realtime: mlockall failed (%s)\n", strerror(errno));
+  }
+  if (_RtCpu >= 0) {
+    CPU_ZERO(&Set);
+    CPU_SET(_RtCpu, &Set);
+    r = pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set);
+    if (r != 0) {
+      SYS_Log("realtime: cannot pin to cpu %d (%s)\n", _RtCpu, strerror(r));
+    }
+  }
+  memset(&Param, 0, sizeof(Param));
+  Param.sched_priority = _RtPriority;
+  r = pthread_setschedparam(pthread_self(), SCHED_FIFO, &Param);
+  if (r != 0) {
+    SYS_Log("realtime: cannot set SCHED_FIFO priority %d (%s)\n", _RtPriority, strerror(r));
+  }
+  _RtStats.NextNs = _RT_GetTimeNs();
+}
+#endif
+#ifdef _WIN32
+static void _RT_Enter(void) {
+}
+#endif
+
+/*********************************************************************
+*
+*       _RT_Wait()
+*
+*  Function description
+*    Sleeps until the next poll deadline, PeriodUs after the previous
+*    one. Absolute deadlines keep the period free of drift, the delay
+*    of each wake-up is recorded in _RtStats. A poll which overran its
+*    period restarts the schedule at once.
+*/
+#ifdef __linux__
+static void _RT_Wait(uint32_t PeriodUs) {
+  struct timespec ts;
+  uint64_t        Now;
+  uint64_t        Late;
+
+  _RtStats.NextNs += (uint64_t)PeriodUs * 1000u;
+  Now = _RT_GetTimeNs();
+  if (Now >= _RtStats.NextNs) {
+    _RtStats.NumOverruns++;
+    _RtStats.NextNs = Now;
+    return;
+  }
+  ts.tv_sec  = (time_t)(_RtStats.NextNs / 1000000000u);
+  ts.tv_nsec = (long)(_RtStats.NextNs % 1000000000u);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+  }
+  Late = _RT_GetTimeNs() - _RtStats.NextNs;
+  _RtStats.SumLateNs += Late;
+  if (Late > _RtStats.MaxLateNs) {
+    _RtStats.MaxLateNs = (unsigned)Late;
+  }
+  _RtStats.NumPeriods++;
+}
+#endif
+#ifdef _WIN32
+static void _RT_Wait(uint32_t PeriodUs) {
+  SYS_Sleep(PeriodUs / 1000u);
+}
+#endif
+
 /*********************************************************************
 *
 *       system signal functions
@@ -626,22 +1253,27 @@ static int gettimeofday(struct timeval *tp, struct timezone *tzp) {
 *    Execute the current command line.
 *
 */
-static void RTT_TelnetLogS(char *logFile, char *outBuf, uint32_t outLen) {
-  static FILE       *pFile    = NULL;
-  static VT_STATE_T  vt_state = Normal;
+static void RTT_TelnetLogS(RTT_LOG *pLog, char *outBuf, uint32_t outLen) {
+  FILE              *pFile;
+  VT_STATE_T         vt_state;
   char              *sPath    = NULL;
   int                chr      = 0;
 
-  if (pFile == NULL) {
+  if (pLog->sFile == NULL) {
+    return;
+  }
+  if (pLog->pFile == NULL) {
     // Convert the script to an absolute path
-    sPath = LRealPath(logFile);
+    sPath = LRealPath(pLog->sFile);
 
     //
     // call output routine.
     //
-    pFile = fopen(sPath, "a+");
+    pLog->pFile = fopen(sPath, "a+");
     free(sPath);
   }
+  pFile    = pLog->pFile;
+  vt_state = pLog->vt_state;
 
   if (pFile != NULL) {
     while (outLen--) {
@@ -721,6 +1353,7 @@ static void RTT_TelnetLogS(char *logFile, char *outBuf, uint32_t outLen) {
     } // while (outLen--) {
     fflush(pFile);
   } // if (pFile != NULL) {
+  pLog->vt_state = vt_state;
 }
 
 /*********************************************************************
@@ -764,9 +1397,8 @@ int SEGGER_atoi(const char* s) {
 */
 static void SYS_ExitHandler(int signum) {
 
-  T32_DefaultState(0);
-  //T32_Terminate(T32_OK);
-  T32_Exit();
+  _TARGET_LogStats();
+  _TARGET_ExitAll();
 
   switch (signum) {
     // interrupt
@@ -792,6 +1424,20 @@ static void SYS_ExitHandler(int signum) {
 }
 
 
+/*********************************************************************
+*
+*       SYS_ApiStatsHandler
+*
+*  Function description
+*    SIGUSR1 handler, requests a dump of the RCL API statistics from
+*    the poll loop.
+*/
+static void SYS_ApiStatsHandler(int signum) {
+  _ApiStatsRequest = 1;
+  signal(signum, SYS_ApiStatsHandler);
+}
+
+
 /*********************************************************************
 *
 *       trace32 rtt functions
@@ -811,7 +1457,7 @@ unsigned int T32_GetRTTCBAddr(const char * symname) {
   Result = T32_GetSymbol( symname, &address, &size, &reserved );
   if (Result != T32_OK) {
     Log_Print("T32_GetRTTCBAddr error, Result = %s.\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
+    return 0;
   }
   return address;
 }
@@ -834,1991 +1480,4369 @@ unsigned int T32_GetRTTCBSize(const char * symname) {
 
 /*********************************************************************
 *
-*      T32_GetBytes
+*      _IsResetError
 *
+*  Function description
+*    Checks whether a memory access failed because the target has been
+*    reset. Such errors are not fatal, the RTT control block is
+*    re-discovered instead.
 */
-void T32_GetBytes(unsigned int address, unsigned int cnt, void *dest) {
-  int Result;
-  Result = T32_ReadMemory(address, 0x40 /* E:*/, (unsigned char*)(dest), cnt);
-  if (Result != T32_OK) {
-    Log_Print("T32_GetBytes error, Result = %s.\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
-  }
+static int _IsResetError(int Result) {
+  return (Result == T32_ERR_STD_RESET) || (Result == T32_ERR_STD_RESETDETECTED);
 }
 
 /*********************************************************************
 *
-*      T32_GetByte
+*      _SetLinkError
 *
+*  Function description
+*    Latches the first communication error of the selected target.
+*    The target is taken offline and reconnected by the main loop,
+*    the other targets are not affected.
 */
-unsigned char T32_GetByte(unsigned int address) {
-  char byte;
-  T32_GetBytes(address, sizeof(char), &byte);
-  return byte;
+static void _SetLinkError(int Result) {
+  if (_T32LinkError == T32_OK) {
+    _T32LinkError = Result;
+  }
 }
 
 /*********************************************************************
 *
-*      T32_GetWord
+*      _T32_ReadMemory
 *
+*  Function description
+*    Reads target memory with the given access class. The default class
+*    uses the plain memory API, any other class (e.g. "EAXI" for a
+*    different bus of the SoC) is passed as access string of an address
+*    object.
 */
-unsigned int T32_GetWord(unsigned int address) {
-  int word;
-  T32_GetBytes(address, sizeof(int), &word);
-  return word;
+static int _T32_ReadMemory(const char* sAccess, unsigned Addr, void* pData, unsigned NumBytes) {
+  T32_AddressHandle hAddr;
+  T32_BufferHandle  hBuf;
+  int               Result;
+
+  if ((sAccess == NULL) || (strcmp(sAccess, RTT_DEFAULT_ACCESS) == 0)) {
+    return T32_ReadMemory(Addr, 0x40 /* E:*/, (unsigned char*)pData, NumBytes);
+  }
+  if (NumBytes == 0u) {
+    return T32_OK;
+  }
+  Result = T32_RequestAddressObjA32(&hAddr, Addr);
+  if (Result != T32_OK) {
+    return Result;
+  }
+  Result = T32_SetAddressObjAccessString(hAddr, sAccess);
+  if (Result == T32_OK) {
+    Result = T32_RequestBufferObj(&hBuf, NumBytes);
+  }
+  if (Result != T32_OK) {
+    T32_ReleaseAddressObj(&hAddr);
+    return Result;
+  }
+  Result = T32_ReadMemoryObj(hBuf, hAddr, NumBytes);
+  if (Result == T32_OK) {
+    T32_CopyDataFromBufferObj((uint8_t*)pData, NumBytes, hBuf);
+  }
+  T32_ReleaseBufferObj(&hBuf);
+  T32_ReleaseAddressObj(&hAddr);
+  return Result;
 }
 
 /*********************************************************************
 *
-*      T32_SetBytes
+*      _T32_WriteMemory
 *
+*  Function description
+*    Writes target memory with the given access class, see _T32_ReadMemory().
 */
-void T32_SetBytes(unsigned int address, unsigned int cnt, void const *src) {
-  int Result;
-  Result = T32_WriteMemory(address, 0x40 /* E:*/, (unsigned char*)(src), cnt);
+static int _T32_WriteMemory(const char* sAccess, unsigned Addr, const void* pData, unsigned NumBytes) {
+  T32_AddressHandle hAddr;
+  T32_BufferHandle  hBuf;
+  int               Result;
+
+  if ((sAccess == NULL) || (strcmp(sAccess, RTT_DEFAULT_ACCESS) == 0)) {
+    return T32_WriteMemory(Addr, 0x40 /* E:*/, (const unsigned char*)pData, NumBytes);
+  }
+  if (NumBytes == 0u) {
+    return T32_OK;
+  }
+  Result = T32_RequestAddressObjA32(&hAddr, Addr);
   if (Result != T32_OK) {
-    Log_Print("T32_SetBytes error, Result = %s.\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
+    return Result;
+  }
+  Result = T32_SetAddressObjAccessString(hAddr, sAccess);
+  if (Result == T32_OK) {
+    Result = T32_RequestBufferObj(&hBuf, NumBytes);
+  }
+  if (Result != T32_OK) {
+    T32_ReleaseAddressObj(&hAddr);
+    return Result;
   }
+  T32_CopyDataToBufferObj(hBuf, NumBytes, (const uint8_t*)pData);
+  Result = T32_WriteMemoryObj(hBuf, hAddr, NumBytes);
+  T32_ReleaseBufferObj(&hBuf);
+  T32_ReleaseAddressObj(&hAddr);
+  return Result;
 }
 
 /*********************************************************************
 *
-*      T32_SetByte
+*       _T32_OnReadDone()
 *
+*  Function description
+*    Completion of a pipelined read, latches the first error.
 */
-void T32_SetByte(unsigned int address, unsigned char data) {
-  T32_SetBytes(address, sizeof(char), &data);
+static void _T32_OnReadDone(void* p, int err, uint8_t* pData, int size) {
+  USE_PARA(pData);
+  USE_PARA(size);
+  if (*(int*)p == T32_OK) {
+    *(int*)p = err;
+  }
 }
 
 /*********************************************************************
 *
-*      T32_SetWord
+*      _MEMCACHE_Get
 *
+*  Function description
+*    Returns the memory cache of the selected target.
 */
-void T32_SetWord(unsigned int address, unsigned int data) {
-  T32_SetBytes(address, sizeof(int), &data);
+static RTT_MEMCACHE* _MEMCACHE_Get(void) {
+  return _pTarget ? &_pTarget->MemCache : NULL;
 }
 
 /*********************************************************************
 *
-*       T32_strlen
+*      _MEMCACHE_Clear
 *
+*  Function description
+*    Drops all regions, e.g. on a target reset.
 */
-unsigned T32_strlen(const char * s) {
-  unsigned Len;
-  char   c = 0;
-  int addr = 0;
+static void _MEMCACHE_Clear(RTT_MEMCACHE* pCache) {
+  if (pCache) {
+    pCache->NumRegions = 0;
+    pCache->NumUsed    = 0;
+    pCache->Gen++;
+    pCache->Epoch++;
+  }
+}
 
-   addr = (unsigned int)s;
+/*********************************************************************
+*
+*      _MEMCACHE_OnRunStateChange
+*
+*  Function description
+*    Starts a new generation of the selected target after it has been
+*    halted or started. RTT_CACHE_EVENT regions are read again.
+*/
+static void _MEMCACHE_OnRunStateChange(void) {
+  RTT_MEMCACHE* pCache;
 
-  Len = 0;
-  c = T32_GetByte(addr);
-  while (c != '\0') {
-    c = T32_GetByte(addr);
-    addr = addr + 1;
-    Len++;
+  pCache = _MEMCACHE_Get();
+  if (pCache) {
+    pCache->Gen++;
   }
-  return Len;
 }
 
 /*********************************************************************
 *
-*      T32_strcpy
+*      _MEMCACHE_OnWrite
 *
+*  Function description
+*    Drops the data of all regions of the selected target overlapping a
+*    range written by the host.
 */
-char * T32_strcpy(char * dst, char * src) {
-   char * p = NULL;
-   char   c = 0;
-   int addr = 0;
-
-   addr = (unsigned int)src;
+static void _MEMCACHE_OnWrite(unsigned Addr, unsigned NumBytes) {
+  RTT_MEMCACHE* pCache;
+  unsigned      i;
 
-   if (dst != NULL) {
-     p = dst;
-     c = T32_GetByte(addr);
-     while(c != '\0') {
-      c = T32_GetByte(addr);
-      *dst++ = c;
-      addr = addr + 1;
-     }
-     *dst = '\0';
-   }
-   return p;
+  pCache = _MEMCACHE_Get();
+  if (pCache == NULL) {
+    return;
+  }
+  for (i = 0; i < pCache->NumRegions; i++) {
+    if ((Addr < pCache->aRegion[i].Addr + pCache->aRegion[i].NumBytes) && (pCache->aRegion[i].Addr < Addr + NumBytes)) {
+      pCache->aRegion[i].Gen = 0;
+    }
+  }
 }
 
 /*********************************************************************
 *
-*       T32_memcpy2P()
+*      _MEMCACHE_Define
 *
+*  Function description
+*    Adds a region to the cache of the selected target. The region is
+*    read on first use. Ignored if the cache is full.
 */
-void T32_memcpy2P(void* pDest, void* pSrc, unsigned NumBytes) {
-  int Result;
-  Result = T32_ReadMemory((unsigned int)pSrc, 0x40 /* E:*/, (unsigned char *)pDest, NumBytes);
-  if (Result != T32_OK) {
-    Log_Print("T32 memcpy to pc error, Result = %s.\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
+static void _MEMCACHE_Define(const char* sAccess, unsigned Addr, unsigned NumBytes, RTT_MEMCACHE_POLICY Policy, unsigned TtlMs) {
+  RTT_MEMCACHE*        pCache;
+  RTT_MEMCACHE_REGION* pRegion;
+
+  pCache = _MEMCACHE_Get();
+  if ((pCache == NULL) || (pCache->NumRegions >= RTT_MEMCACHE_MAX_REGIONS) || (pCache->NumUsed + NumBytes > RTT_MEMCACHE_SIZE)) {
+    return;
   }
+  pRegion           = &pCache->aRegion[pCache->NumRegions++];
+  pRegion->sAccess  = sAccess;
+  pRegion->Addr     = Addr;
+  pRegion->NumBytes = NumBytes;
+  pRegion->Offset   = pCache->NumUsed;
+  pRegion->Policy   = Policy;
+  pRegion->TtlMs    = TtlMs;
+  pRegion->Gen      = 0;
+  pCache->NumUsed  += NumBytes;
 }
 
 /*********************************************************************
 *
-*       T32_memcpy2C()
+*      _MEMCACHE_IsValid
 *
 */
-void T32_memcpy2C(void* pDest, void* pSrc, unsigned NumBytes) {
-  int Result;
-  Result = T32_WriteMemory((unsigned int)pDest, 0x40 /* E:*/, (unsigned char *)pSrc, NumBytes);
-  if (Result != T32_OK) {
-    Log_Print("T32 memcpy to chip error, Result = %s.\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
+static int _MEMCACHE_IsValid(const RTT_MEMCACHE* pCache, const RTT_MEMCACHE_REGION* pRegion, unsigned Now) {
+  if (pRegion->Gen == 0u) {
+    return 0;
+  }
+  switch (pRegion->Policy) {
+  case RTT_CACHE_TTL:
+    return (Now - pRegion->ReadTime) < pRegion->TtlMs;
+  case RTT_CACHE_EVENT:
+    return pRegion->Gen == pCache->Gen;
+  default:
+    return 1;
   }
 }
 
 /*********************************************************************
 *
-*       T32_RetryGetState()
+*      _MEMCACHE_Read
+*
+*  Function description
+*    Serves a read which lies within one region of the selected target
+*    from the cache. A region which is not valid is read as a whole.
 *
+*  Return value
+*    == 0  Data copied to pData
+*    <  0  Not served, the caller reads the target itself
 */
-static int T32_RetryGetState(int (*pGetState)(int *pState), int *pState, int nRetry) {
-  int Result;
-
-  while (nRetry > 0) {
-    Result = pGetState(pState);
-    if (Result == T32_ERR_COM_RECEIVE_FAIL || Result == T32_ERR_COM_TRANSMIT_FAIL) {
-      nRetry--;
-      SYS_Sleep(5);
+static int _MEMCACHE_Read(const char* sAccess, unsigned Addr, unsigned NumBytes, void* pData) {
+  RTT_MEMCACHE*        pCache;
+  RTT_MEMCACHE_REGION* pRegion;
+  unsigned             Now;
+  unsigned             i;
+
+  pCache = _MEMCACHE_Get();
+  if ((pCache == NULL) || (NumBytes == 0u)) {
+    return -1;
+  }
+  for (i = 0; i < pCache->NumRegions; i++) {
+    pRegion = &pCache->aRegion[i];
+    if ((Addr >= pRegion->Addr) && (Addr + NumBytes <= pRegion->Addr + pRegion->NumBytes)
+     && (strcmp(sAccess ? sAccess : RTT_DEFAULT_ACCESS, pRegion->sAccess ? pRegion->sAccess : RTT_DEFAULT_ACCESS) == 0)) {
+      break;
     }
-    else {
-      return Result;
+  }
+  if (i == pCache->NumRegions) {
+    return -1;
+  }
+  Now = SYS_GetTickCount();
+  if (_MEMCACHE_IsValid(pCache, pRegion, Now)) {
+    pCache->NumHits++;
+  } else {
+    pCache->NumReads++;
+    if (_T32_ReadMemory(pRegion->sAccess, pRegion->Addr, &pCache->acData[pRegion->Offset], pRegion->NumBytes) != T32_OK) {
+      pRegion->Gen = 0;
+      return -1;                                       // The caller reads again and reports the error
     }
+    pRegion->Gen      = pCache->Gen;
+    pRegion->ReadTime = Now;
   }
-  return Result;
+  memcpy(pData, &pCache->acData[pRegion->Offset + (Addr - pRegion->Addr)], NumBytes);
+  return 0;
 }
 
 /*********************************************************************
 *
-*       T32_WaitPractise()
+*      _COALESCE_IsSameAccess
 *
 */
-static void T32_WaitPractise(int nRetry, int nDelay) {
-  int Result;
-  int pState;
-
-  for (;;) {
-    Result = T32_RetryGetState(&T32_GetPracticeState, &pState, nRetry);
-    if (Result != T32_OK) {
-      Log_Print("Failed to query Trace32 state (error code: %s)\n", T32_Err2Str(Result));
-      SYS_ExitHandler(Result);
-    }
-
-    if (pState == 0) {
-      Log_Print("Practise done.\n");
-      break;
-    }
-    else if (pState == 1) {
-      Log_Print("Practise running.\n");
-      SYS_Sleep(nDelay);
-    }
-    else if (pState == 2) {
-      Log_Print("ERROR Trace32 is in dialog mode. It waits for an input.\n");
-      SYS_ExitHandler(Result);
-    }
-    else {
-      Log_Print("ERROR Unknown status. What is going on?\n");
-      SYS_ExitHandler(Result);
-    } // end if (pState == 0)
-  } // for (;;) {
+static int _COALESCE_IsSameAccess(const char* sAccess0, const char* sAccess1) {
+  return strcmp(sAccess0 ? sAccess0 : RTT_DEFAULT_ACCESS, sAccess1 ? sAccess1 : RTT_DEFAULT_ACCESS) == 0;
 }
 
 /*********************************************************************
 *
-*       T32_RunScriptFile()
+*      _COALESCE_Find
 *
 *  Function description
-*    Makes Trace32 synchronouly execute a CMM script arg.
-*    The script arg is systematically converted to an absolute path.
-*
+*    Returns the range of the list which covers the given one, NULL if none.
 */
-static void T32_RunScriptFile(const char *pCmmFile) {
-  int  Result;
-  char *sPath = NULL;
-
-  // Convert the script to an absolute path
-  sPath = LRealPath(pCmmFile);
+static RTT_COALESCE_RANGE* _COALESCE_Find(RTT_COALESCE_RANGE* aRange, unsigned NumRanges, const char* sAccess, unsigned Addr, unsigned NumBytes) {
+  unsigned i;
 
-  // Ask T32 to run the script. If the function succeeds, T32 will be
-  // loading the script asynchronously!
-  Result = T32_Cmd_f("DO \"%s\"", sPath);
-  if (Result != T32_OK) {
-    Log_Print("Failed to execute CMM script '%s' (error code: %s)\n", sPath, T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
+  for (i = 0; i < NumRanges; i++) {
+    if ((Addr >= aRange[i].Addr) && (Addr + NumBytes <= aRange[i].Addr + aRange[i].NumBytes)
+     && _COALESCE_IsSameAccess(sAccess, aRange[i].sAccess)) {
+      return &aRange[i];
+    }
   }
-
-  Log_Print("Remotely running script '%s'. This may take some time.\n", sPath);
-
-  free(sPath);
-  T32_WaitPractise(8, 2);
+  return NULL;
 }
 
 /*********************************************************************
 *
-*       T32_ConfigSet()
+*      _COALESCE_Begin
 *
+*  Function description
+*    Starts a poll step. Data of the previous step is dropped, its
+*    small reads become the read-ahead hints of this one.
 */
-static void T32_ConfigSet(const char *String1, const char *String2) {
-  int Result;
-
-  Log_Print("\"%s\", \"%s\"\n", String1, String2);
-  Result = T32_Config(String1, String2);
-  if (Result != T32_OK) {
-    Log_Print("Failed to set config '%s-%s' (error code: %s)\n", String1, String2, T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
+static void _COALESCE_Begin(RTT_COALESCER* pC) {
+  _pCoalesce = NULL;
+  if (_CoalesceGap < 0) {
+    return;
   }
+  memcpy(pC->aHint, pC->aNext, pC->NumNext * sizeof(RTT_COALESCE_RANGE));
+  pC->NumHints  = pC->NumNext;
+  pC->NumNext   = 0;
+  pC->NumRanges = 0;
+  pC->NumUsed   = 0;
+  _pCoalesce    = pC;
 }
 
 /*********************************************************************
 *
-*       T32_DefaultState()
+*      _COALESCE_End
 *
 */
-static void T32_DefaultState(int exit) {
-  int Result;
-  int pState;
-
-  Result = T32_RetryGetState(&T32_GetPracticeState, &pState, 8);
-  if (Result != T32_OK) {
-    Log_Print("Failed to query Trace32 practice state (error code: %s)\n", T32_Err2Str(Result));
-    if (exit == 1) {
-      SYS_ExitHandler(Result);
-    }
-  }
-  // Running
-  if (pState == 1) {
-    Log_Print("Practise running.\n");
-    Result = T32_Stop();
-    if (Result != T32_OK) {
-      Log_Print("Failed to stop (error code: %s)\n", T32_Err2Str(Result));
-      if (exit == 1) {
-        SYS_ExitHandler(Result);
-      }
-    }
-  }
-
-  Result = T32_RetryGetState(&T32_GetState, &pState, 8);
-  if (Result != T32_OK) {
-    Log_Print("Failed to query Trace32 debugger state (error code: %s)\n", T32_Err2Str(Result));
-    if (exit == 1) {
-      SYS_ExitHandler(Result);
-    }
-  }
-  // Running
-  if (pState == 3) {
-    Log_Print("Debugger running.\n");
-    Result = T32_Break();
-    if (Result != T32_OK) {
-      Log_Print("Failed to break (error code: %s)\n", T32_Err2Str(Result));
-      if (exit == 1) {
-        SYS_ExitHandler(Result);
-      }
-    }
-  }
+static void _COALESCE_End(void) {
+  _pCoalesce = NULL;
 }
 
 /*********************************************************************
 *
-*       T32_IFStop2Run()
+*      _COALESCE_Invalidate
 *
+*  Function description
+*    Drops the data of the current step. Called on every write, the
+*    target may react to it.
 */
-static void T32_IFStop2Run(void) {
-  int Result;
-  int pState;
-
-  Result = T32_RetryGetState(&T32_GetState, &pState, 8);
-  if (Result != T32_OK) {
-    Log_Print("Failed to query Trace32 debugger state (error code: %s)\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
-  }
-  // Stopped
-  if (pState == 2) {
-    Log_Print("Debugger Stopped.\n");
-    Result = T32_Go();
-    if (Result != T32_OK) {
-      Log_Print("Failed to break (error code: %s)\n", T32_Err2Str(Result));
-      SYS_ExitHandler(Result);
-    }
+static void _COALESCE_Invalidate(void) {
+  if (_pCoalesce) {
+    _pCoalesce->NumRanges = 0;
+    _pCoalesce->NumUsed   = 0;
   }
 }
 
 /*********************************************************************
 *
-*       T32_IFRun2Stop()
+*      _COALESCE_Store
 *
+*  Function description
+*    Passes data read by other means in the current step, e.g. the
+*    control block image, so small reads within it are served from it.
 */
-static void T32_IFRun2Stop(void) {
-  int Result;
-  int pState;
+static void _COALESCE_Store(const char* sAccess, unsigned Addr, const void* pData, unsigned NumBytes) {
+  RTT_COALESCER*      pC;
+  RTT_COALESCE_RANGE* pRange;
 
-  Result = T32_RetryGetState(&T32_GetState, &pState, 8);
-  if (Result != T32_OK) {
-    Log_Print("Failed to query Trace32 debugger state (error code: %s)\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
-  }
-  // Running
-  if (pState == 3) {
-    Log_Print("Debugger running.\n");
-    Result = T32_Break();
-    if (Result != T32_OK) {
-      Log_Print("Failed to break (error code: %s)\n", T32_Err2Str(Result));
-      SYS_ExitHandler(Result);
-    }
+  pC = _pCoalesce;
+  if ((pC == NULL) || (pC->NumRanges >= RTT_COALESCE_MAX_RANGES) || (pC->NumUsed + NumBytes > RTT_COALESCE_SIZE)) {
+    return;
   }
+  pRange           = &pC->aRange[pC->NumRanges++];
+  pRange->sAccess  = sAccess;
+  pRange->Addr     = Addr;
+  pRange->NumBytes = NumBytes;
+  pRange->Offset   = pC->NumUsed;
+  pRange->IsStored = 1;
+  memcpy(&pC->acData[pC->NumUsed], pData, NumBytes);
+  pC->NumUsed += NumBytes;
 }
 
 /*********************************************************************
 *
-*       T32_InitDEVICD()
+*      _COALESCE_Fetch
+*
+*  Function description
+*    Reads the missed range together with the hints of the same access
+*    class. Ranges are sorted and merged if at most _CoalesceGap bytes
+*    apart. With the default access class all merged ranges are read
+*    with pipelined requests in one round trip, other classes only read
+*    the merged range which covers the miss.
 *
+*  Return value
+*    == T32_OK  Ranges added to the current step
+*    != T32_OK  Error, nothing added
 */
-static void T32_InitDEVICD(char *Node, char *Port, char *PackLen, char *cmmFile ) {
-  int Result;
-
-  T32_ConfigSet("NODE="   , Node);
-  T32_ConfigSet("PORT="   , Port);
-  if (PackLen != NULL) {
-    T32_ConfigSet("PACKLEN=", PackLen);
+static int _COALESCE_Fetch(RTT_COALESCER* pC, const char* sAccess, unsigned Addr, unsigned NumBytes) {
+  RTT_COALESCE_RANGE aRun[RTT_COALESCE_MAX_RANGES + 1];
+  RTT_COALESCE_RANGE Run;
+  RTT_COALESCE_RANGE* pHint;
+  unsigned           NumRuns;
+  unsigned           NumTotal;
+  unsigned           i;
+  unsigned           j;
+  int                IsDefault;
+  int                Result;
+  int                ReadResult;
+  //
+  // Collect the miss and the hints which are not available yet, sorted by address
+  //
+  aRun[0].sAccess  = sAccess;
+  aRun[0].Addr     = Addr;
+  aRun[0].NumBytes = NumBytes;
+  NumRuns = 1;
+  for (i = 0; i < pC->NumHints; i++) {
+    pHint = &pC->aHint[i];
+    if (_COALESCE_IsSameAccess(sAccess, pHint->sAccess)
+     && (_COALESCE_Find(pC->aRange, pC->NumRanges, pHint->sAccess, pHint->Addr, pHint->NumBytes) == NULL)) {
+      Run = *pHint;
+      for (j = NumRuns; (j > 0) && (aRun[j - 1].Addr > Run.Addr); j--) {
+        aRun[j] = aRun[j - 1];
+      }
+      aRun[j] = Run;
+      NumRuns++;
+    }
   }
-
   //
-  // Trace32 Init
+  // Merge overlapping ranges and ranges within the gap
   //
-  Result = T32_Init();
-  if(Result != T32_OK) {
-    Log_Print("Error initializing TRACE32, Result = %s.\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
-  };
-
+  j = 0;
+  for (i = 1; i < NumRuns; i++) {
+    if (aRun[i].Addr <= aRun[j].Addr + aRun[j].NumBytes + (unsigned)_CoalesceGap) {
+      aRun[j].NumBytes = MAX(aRun[j].NumBytes, aRun[i].Addr + aRun[i].NumBytes - aRun[j].Addr);
+    } else {
+      aRun[++j] = aRun[i];
+    }
+  }
+  NumRuns   = j + 1;
+  IsDefault = _COALESCE_IsSameAccess(sAccess, NULL);
+  if (IsDefault == 0) {
+    for (i = 0; (aRun[i].Addr + aRun[i].NumBytes) < (Addr + NumBytes); i++) {
+    }
+    aRun[0] = aRun[i];
+    NumRuns = 1;
+  }
   //
-  // Attach to T32. The parameter is the device identifier.  T32_DEV_ICD and
-  // T32_DEV_ICE are identical and mean the same thing: the debugger
+  // Make room, the data of the step is dropped if it is full
   //
-  Result = T32_Attach(T32_DEV_ICD);
-  if(Result != T32_OK) {
-    Log_Print("Error no device, Result = %s.\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
-  };
-
-  if (cmmFile != NULL) {
-    T32_IFRun2Stop();
+  NumTotal = 0;
+  for (i = 0; i < NumRuns; i++) {
+    NumTotal += aRun[i].NumBytes;
   }
-  else {
-    T32_IFStop2Run();
+  if ((pC->NumRanges + NumRuns > RTT_COALESCE_MAX_RANGES) || (pC->NumUsed + NumTotal > RTT_COALESCE_SIZE)) {
+    pC->NumRanges = 0;
+    pC->NumUsed   = 0;
+    if ((NumRuns > RTT_COALESCE_MAX_RANGES) || (NumTotal > RTT_COALESCE_SIZE)) {
+      return T32_ERR_MALLOC_FAIL;
+    }
   }
-
-  Result = T32_Nop();
-  if(Result != T32_OK) {
-    Log_Print("Error nop, Result = %s.\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
-  };
-
-  Result = T32_Ping();
-  if(Result != T32_OK) {
-    Log_Print("Sends one PING message to the system fail, Result = %s.\n", T32_Err2Str(Result));
-    SYS_ExitHandler(Result);
-  };
-
-  if ( cmmFile != NULL) {
-    T32_RunScriptFile(cmmFile);
+  for (i = 0; i < NumRuns; i++) {
+    aRun[i].sAccess  = sAccess;
+    aRun[i].Offset   = pC->NumUsed;
+    aRun[i].IsStored = 0;
+    pC->NumUsed     += aRun[i].NumBytes;
+  }
+  //
+  // Read all runs
+  //
+  if (NumRuns == 1) {
+    Result = _T32_ReadMemory(sAccess, aRun[0].Addr, &pC->acData[aRun[0].Offset], aRun[0].NumBytes);
+  } else {
+    ReadResult = T32_OK;
+    Result     = T32_OK;
+    for (i = 0; (i < NumRuns) && (Result == T32_OK); i++) {
+      Result = T32_AsyncReadMemory(aRun[i].Addr, 0x40 /* E:*/, &pC->acData[aRun[i].Offset], aRun[i].NumBytes, _T32_OnReadDone, &ReadResult);
+    }
+    if (T32_AsyncComplete(-1) != T32_OK) {             // Always drain the window
+      Result = T32_COM_RECEIVE_FAIL;
+    }
+    if (Result == T32_OK) {
+      Result = ReadResult;
+    }
+  }
+  pC->NumReads++;
+  if (Result != T32_OK) {
+    pC->NumUsed -= NumTotal;
+    return Result;
   }
+  memcpy(&pC->aRange[pC->NumRanges], aRun, NumRuns * sizeof(RTT_COALESCE_RANGE));
+  pC->NumRanges += NumRuns;
+  return T32_OK;
 }
 
 /*********************************************************************
 *
-*       _WriteBlocking()
+*      _COALESCE_Read
 *
 *  Function description
-*    Stores a specified number of characters in SEGGER RTT ring buffer
-*    and updates the associated write pointer which is periodically
-*    read by the host.
-*    The caller is responsible for managing the write chunk sizes as
-*    _WriteBlocking() will block until all data has been posted successfully.
-*
-*  Parameters
-*    pRing        Ring buffer to post to.
-*    pBuffer      Pointer to character array. Does not need to point to a \0 terminated string.
-*    NumBytes     Number of bytes to be stored in the SEGGER RTT control block.
+*    Serves a small read of the current poll step from coalesced data.
 *
 *  Return value
-*    >= 0 - Number of bytes written into buffer.
+*    == 0  Data copied to pData
+*    <  0  Not served, the caller reads the target itself
 */
-static unsigned _WriteBlocking(unsigned Address, const char* pBuffer, unsigned NumBytes) {
-  unsigned NumBytesToWrite;
-  unsigned NumBytesWritten;
-  unsigned RdOff;
-  unsigned WrOff;
-  char*    pDst;
-  //Log_Print("Address = 0x%08X\n", Address);
+static int _COALESCE_Read(const char* sAccess, unsigned Addr, unsigned NumBytes, void* pData) {
+  RTT_COALESCER*      pC;
+  RTT_COALESCE_RANGE* pRange;
+  RTT_COALESCE_RANGE* pNext;
+
+  pC = _pCoalesce;
+  if ((pC == NULL) || (NumBytes == 0u) || (NumBytes > RTT_COALESCE_MAX_READ)) {
+    return -1;
+  }
+  pRange = _COALESCE_Find(pC->aRange, pC->NumRanges, sAccess, Addr, NumBytes);
+  if (pRange == NULL) {
+    if (_COALESCE_Fetch(pC, sAccess, Addr, NumBytes) != T32_OK) {
+      pC->NumHints = 0;                                // Hints may be stale after a reload, forget them
+      return -1;                                       // The caller reads again and reports the error
+    }
+    pRange = _COALESCE_Find(pC->aRange, pC->NumRanges, sAccess, Addr, NumBytes);
+  }
   //
-  // Write data to buffer and handle wrap-around if necessary
+  // Remember the read as hint for the next step, unless it is part of stored data
   //
-  NumBytesWritten = 0u;
-  WrOff = T32_GetWord(RTTBUFFER_OFFSET_WROFF(Address));
-  do {
-    RdOff = T32_GetWord(RTTBUFFER_OFFSET_RDOFF(Address));                         // May be changed by host (debug probe) in the meantime
-    if (RdOff > WrOff) {
-      NumBytesToWrite = RdOff - WrOff - 1u;
-    } else {
-      NumBytesToWrite = T32_GetWord(RTTBUFFER_OFFSET_SIZEOFBUFFER(Address)) - (WrOff - RdOff + 1u);
-    }
-    NumBytesToWrite = MIN(NumBytesToWrite, (T32_GetWord(RTTBUFFER_OFFSET_SIZEOFBUFFER(Address)) - WrOff));      // Number of bytes that can be written until buffer wrap-around
-    NumBytesToWrite = MIN(NumBytesToWrite, NumBytes);
-    pDst = (char *)(T32_GetWord(RTTBUFFER_OFFSET_PBUFFER(Address)) + WrOff);
-    T32_memcpy2C((void*)pDst, (void*)pBuffer, NumBytesToWrite);
-    NumBytesWritten += NumBytesToWrite;
-    pBuffer         += NumBytesToWrite;
-    NumBytes        -= NumBytesToWrite;
-    WrOff           += NumBytesToWrite;
-    if (WrOff == T32_GetWord(RTTBUFFER_OFFSET_SIZEOFBUFFER(Address))) {
-      WrOff = 0u;
-    }
-    T32_SetWord(RTTBUFFER_OFFSET_WROFF(Address), WrOff);
-  } while (NumBytes);
-  return NumBytesWritten;
+  if ((pRange->IsStored == 0) && (pC->NumNext < RTT_COALESCE_MAX_RANGES)
+   && (_COALESCE_Find(pC->aNext, pC->NumNext, sAccess, Addr, NumBytes) == NULL)) {
+    pNext           = &pC->aNext[pC->NumNext++];
+    pNext->sAccess  = sAccess;
+    pNext->Addr     = Addr;
+    pNext->NumBytes = NumBytes;
+  }
+  memcpy(pData, &pC->acData[pRange->Offset + (Addr - pRange->Addr)], NumBytes);
+  pC->NumRequests++;
+  return 0;
 }
 
 /*********************************************************************
 *
-*       _WriteNoCheck()
+*      T32_GetBytes
 *
-*  Function description
-*    Stores a specified number of characters in SEGGER RTT ring buffer
-*    and updates the associated write pointer which is periodically
-*    read by the host.
-*    It is callers responsibility to make sure data actually fits in buffer.
+*/
+void T32_GetBytes(const char* sAccess, unsigned int address, unsigned int cnt, void *dest) {
+  int Result;
+  if ((_MEMCACHE_Read(sAccess, address, cnt, dest) == 0) || (_COALESCE_Read(sAccess, address, cnt, dest) == 0)) {
+    return;
+  }
+  Result = _T32_ReadMemory(sAccess, address, dest, cnt);
+  if (_IsResetError(Result)) {
+    Log_Print("T32_GetBytes reset detected, Result = %s.\n", T32_Err2Str(Result));
+    memset(dest, 0, cnt);
+    _RTTCBResync = 1;
+    return;
+  }
+  if (Result != T32_OK) {
+    Log_Print("T32_GetBytes error, Result = %s.\n", T32_Err2Str(Result));
+    memset(dest, 0, cnt);
+    _SetLinkError(Result);
+  }
+}
+
+/*********************************************************************
 *
-*  Parameters
-*    pRing        Ring buffer to post to.
-*    pBuffer      Pointer to character array. Does not need to point to a \0 terminated string.
-*    NumBytes     Number of bytes to be stored in the SEGGER RTT control block.
+*      T32_GetByte
 *
-*  Notes
-*    (1) If there might not be enough space in the "Up"-buffer, call _WriteBlocking
 */
-static void _WriteNoCheck(unsigned Address, const char* pData, unsigned NumBytes) {
-  unsigned NumBytesAtOnce;
-  unsigned WrOff;
-  unsigned Rem;
-  char*    pDst;
-
-  //Log_Print("Address = 0x%08X\n", Address);
-  WrOff = T32_GetWord(RTTBUFFER_OFFSET_WROFF(Address));
-  Rem = T32_GetWord(RTTBUFFER_OFFSET_SIZEOFBUFFER(Address)) - WrOff;
-  if (Rem > NumBytes) {
-    //
-    // All data fits before wrap around
-    //
-    pDst = (char *)(T32_GetWord(RTTBUFFER_OFFSET_PBUFFER(Address)) + WrOff);
-    T32_memcpy2C((void*)pDst, (void*)pData, NumBytes);
-    T32_SetWord(RTTBUFFER_OFFSET_WROFF(Address), WrOff + NumBytes);
-  } else {
-    //
-    // We reach the end of the buffer, so need to wrap around
-    //
-    NumBytesAtOnce = Rem;
-    pDst = (char *)(T32_GetWord(RTTBUFFER_OFFSET_PBUFFER(Address)) + WrOff);
-    T32_memcpy2C((void*)pDst, (void*)pData, NumBytesAtOnce);
-    NumBytesAtOnce = NumBytes - Rem;
-    pDst = (char *)T32_GetWord(RTTBUFFER_OFFSET_PBUFFER(Address));
-    T32_memcpy2C((void*)pDst, (void*)(pData + Rem), NumBytesAtOnce);
-    T32_SetWord(RTTBUFFER_OFFSET_WROFF(Address), NumBytesAtOnce);
-  }
+unsigned char T32_GetByte(const char* sAccess, unsigned int address) {
+  char byte;
+  T32_GetBytes(sAccess, address, sizeof(char), &byte);
+  return byte;
 }
 
 /*********************************************************************
 *
-*       _GetAvailWriteSpace()
+*      T32_GetWord
 *
-*  Function description
-*    Returns the number of bytes that can be written to the ring
-*    buffer without blocking.
+*/
+unsigned int T32_GetWord(const char* sAccess, unsigned int address) {
+  int word;
+  T32_GetBytes(sAccess, address, sizeof(int), &word);
+  return word;
+}
+
+/*********************************************************************
 *
-*  Parameters
-*    pRing        Ring buffer to check.
+*      T32_SetBytes
 *
-*  Return value
-*    Number of bytes that are free in the buffer.
 */
-static unsigned _GetAvailWriteSpace(unsigned Address) {
-  unsigned RdOff;
-  unsigned WrOff;
-  unsigned r;
-  //Log_Print("Address = 0x%08X\n", Address);
-  //
-  // Avoid warnings regarding volatile access order.  It's not a problem
-  // in this case, but dampen compiler enthusiasm.
-  //
-  RdOff = T32_GetWord(RTTBUFFER_OFFSET_RDOFF(Address));
-  WrOff = T32_GetWord(RTTBUFFER_OFFSET_WROFF(Address));
-  if (RdOff <= WrOff) {
-    r = T32_GetWord(RTTBUFFER_OFFSET_SIZEOFBUFFER(Address)) - 1u - WrOff + RdOff;
-  } else {
-    r = RdOff - WrOff - 1u;
+void T32_SetBytes(const char* sAccess, unsigned int address, unsigned int cnt, void const *src) {
+  int Result;
+  _COALESCE_Invalidate();
+  _MEMCACHE_OnWrite(address, cnt);
+  Result = _T32_WriteMemory(sAccess, address, src, cnt);
+  if (_IsResetError(Result)) {
+    Log_Print("T32_SetBytes reset detected, Result = %s.\n", T32_Err2Str(Result));
+    _RTTCBResync = 1;
+    return;
+  }
+  if (Result != T32_OK) {
+    Log_Print("T32_SetBytes error, Result = %s.\n", T32_Err2Str(Result));
+    _SetLinkError(Result);
   }
-  return r;
 }
 
 /*********************************************************************
 *
-*       Public code
+*      T32_SetByte
 *
-**********************************************************************
 */
+void T32_SetByte(const char* sAccess, unsigned int address, unsigned char data) {
+  T32_SetBytes(sAccess, address, sizeof(char), &data);
+}
 
 /*********************************************************************
 *
-*       SEGGER_RTT_ReadUpBufferNoLock()
-*
-*  Function description
-*    Reads characters from SEGGER real-time-terminal control block
-*    which have been previously stored by the application.
-*    Do not lock against interrupts and multiple access.
-*    Used to do the same operation that J-Link does, to transfer
-*    RTT data via other channels, such as TCP/IP or UART.
+*      T32_SetWord
 *
-*  Parameters
-*    BufferIndex  Index of Up-buffer to be used.
-*    pBuffer      Pointer to buffer provided by target application, to copy characters from RTT-up-buffer to.
-*    BufferSize   Size of the target application buffer.
+*/
+void T32_SetWord(const char* sAccess, unsigned int address, unsigned int data) {
+  T32_SetBytes(sAccess, address, sizeof(int), &data);
+}
+
+/*********************************************************************
 *
-*  Return value
-*    Number of bytes that have been read.
+*       T32_strlen
 *
-*  Additional information
-*    This function must not be called when J-Link might also do RTT.
 */
-unsigned SEGGER_RTT_ReadUpBufferNoLock(unsigned Address, unsigned BufferIndex, void* pData, unsigned BufferSize) {
-  unsigned                NumBytesRem;
-  unsigned                NumBytesRead;
-  unsigned                RdOff;
-  unsigned                WrOff;
-  unsigned                RingAddr;
-  unsigned char*          pBuffer;
-           char*          pSrc;
+unsigned T32_strlen(const char* sAccess, const char * s) {
+  unsigned Len;
+  char   c = 0;
+  int addr = 0;
 
-  RingAddr = RTTCB_OFFSET_AUP_INDEX(Address, BufferIndex);
-  //Log_Print("Address = 0x%08X RingAddr = 0x%08X BufferIndex = 0x%08X\n", Address, RingAddr, BufferIndex);
-  pBuffer = (unsigned char*)pData;
-  RdOff = T32_GetWord(RTTBUFFER_OFFSET_RDOFF(RingAddr));
-  WrOff = T32_GetWord(RTTBUFFER_OFFSET_WROFF(RingAddr));
-  NumBytesRead = 0u;
-  //
-  // Read from current read position to wrap-around of buffer, first
-  //
-  if (RdOff > WrOff) {
-    NumBytesRem = T32_GetWord(RTTBUFFER_OFFSET_SIZEOFBUFFER(RingAddr)) - RdOff;
-    NumBytesRem = MIN(NumBytesRem, BufferSize);
-    pSrc = (char *)(T32_GetWord(RTTBUFFER_OFFSET_PBUFFER(RingAddr)) + RdOff);
-    T32_memcpy2P(pBuffer, (void*)pSrc, NumBytesRem);
-    NumBytesRead += NumBytesRem;
-    pBuffer      += NumBytesRem;
-    BufferSize   -= NumBytesRem;
-    RdOff        += NumBytesRem;
-    //
-    // Handle wrap-around of buffer
-    //
-    if (RdOff == T32_GetWord(RTTBUFFER_OFFSET_SIZEOFBUFFER(RingAddr))) {
-      RdOff = 0u;
-    }
-  }
-  //
-  // Read remaining items of buffer
-  //
-  NumBytesRem = WrOff - RdOff;
-  NumBytesRem = MIN(NumBytesRem, BufferSize);
-  if (NumBytesRem > 0u) {
-    pSrc = (char *)(T32_GetWord(RTTBUFFER_OFFSET_PBUFFER(RingAddr)) + RdOff);
-    T32_memcpy2P(pBuffer, (void*)pSrc, NumBytesRem);
-    NumBytesRead += NumBytesRem;
-    pBuffer      += NumBytesRem;
-    BufferSize   -= NumBytesRem;
-    RdOff        += NumBytesRem;
-  }
-  //
-  // Update read offset of buffer
-  //
-  if (NumBytesRead) {
-    T32_SetWord(RTTBUFFER_OFFSET_RDOFF(RingAddr), RdOff);
+   addr = (unsigned int)s;
+
+  Len = 0;
+  c = T32_GetByte(sAccess, addr);
+  while (c != '\0') {
+    c = T32_GetByte(sAccess, addr);
+    addr = addr + 1;
+    Len++;
   }
-  //
-  return NumBytesRead;
+  return Len;
 }
 
 /*********************************************************************
 *
-*       SEGGER_RTT_WriteDownBufferNoLock
-*
-*  Function description
-*    Stores a specified number of characters in SEGGER RTT
-*    control block inside a <Down> buffer.
-*    SEGGER_RTT_WriteDownBufferNoLock does not lock the application.
-*    Used to do the same operation that J-Link does, to transfer
-*    RTT data from other channels, such as TCP/IP or UART.
-*
-*  Parameters
-*    BufferIndex  Index of "Down"-buffer to be used.
-*    pBuffer      Pointer to character array. Does not need to point to a \0 terminated string.
-*    NumBytes     Number of bytes to be stored in the SEGGER RTT control block.
-*
-*  Return value
-*    Number of bytes which have been stored in the "Down"-buffer.
-*
-*  Notes
-*    (1) Data is stored according to buffer flags.
-*    (2) For performance reasons this function does not call Init()
-*        and may only be called after RTT has been initialized.
-*        Either by calling SEGGER_RTT_Init() or calling another RTT API function first.
+*      T32_strcpy
 *
-*  Additional information
-*    This function must not be called when J-Link might also do RTT.
 */
-unsigned SEGGER_RTT_WriteDownBufferNoLock(unsigned Address, unsigned BufferIndex, const void* pBuffer, unsigned NumBytes) {
-  unsigned                Status;
-  unsigned                Avail;
-  const char*             pData;
-  unsigned                RingAddr;
-  unsigned                MaxUpNum;
-  //
-  // Get "to-target" ring buffer.
-  // It is save to cast that to a "to-host" buffer. Up and Down buffer differ in volatility of offsets that might be modified by J-Link.
-  //
-  MaxUpNum = T32_GetWord(RTTCB_OFFSET_MAXNUMUPBUFFERS(Address));
-  pData = (const char *)pBuffer;
-  RingAddr = RTTCB_OFFSET_ADOWN_INDEX(Address, MaxUpNum, BufferIndex);
-  //Log_Print("Address = 0x%08X RingAddr = 0x%08X BufferIndex = 0x%08X\n", Address, RingAddr, BufferIndex);
-  //
-  // How we output depends upon the mode...
-  //
-  switch (T32_GetWord(RTTBUFFER_OFFSET_FLAGS(RingAddr))) {
-  case SEGGER_RTT_MODE_NO_BLOCK_SKIP:
-    //
-    // If we are in skip mode and there is no space for the whole
-    // of this output, don't bother.
-    //
-    Avail = _GetAvailWriteSpace(RingAddr);
-    if (Avail < NumBytes) {
-      Status = 0u;
-    } else {
-      Status = NumBytes;
-      _WriteNoCheck(RingAddr, pData, NumBytes);
-    }
-    break;
-  case SEGGER_RTT_MODE_NO_BLOCK_TRIM:
-    //
-    // If we are in trim mode, trim to what we can output without blocking.
-    //
-    Avail = _GetAvailWriteSpace(RingAddr);
-    Status = Avail < NumBytes ? Avail : NumBytes;
-    _WriteNoCheck(RingAddr, pData, Status);
-    break;
-  case SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL:
-    //
-    // If we are in blocking mode, output everything.
-    //
-    Status = _WriteBlocking(RingAddr, pData, NumBytes);
-    break;
-  default:
-    Status = 0u;
-    break;
-  }
-  //
-  // Finish up.
-  //
-  return Status;
+char * T32_strcpy(const char* sAccess, char * dst, char * src) {
+   char * p = NULL;
+   char   c = 0;
+   int addr = 0;
+
+   addr = (unsigned int)src;
+
+   if (dst != NULL) {
+     p = dst;
+     c = T32_GetByte(sAccess, addr);
+     while(c != '\0') {
+      c = T32_GetByte(sAccess, addr);
+      *dst++ = c;
+      addr = addr + 1;
+     }
+     *dst = '\0';
+   }
+   return p;
 }
 
 /*********************************************************************
 *
-*       SEGGER_RTT_GetBytesInBuffer()
-*
-*  Function description
-*    Returns the number of bytes currently used in the up buffer.
-*
-*  Parameters
-*    BufferIndex  Index of the up buffer.
+*       T32_memcpy2P()
 *
-*  Return value
-*    Number of bytes that are used in the buffer.
 */
-unsigned SEGGER_RTT_GetBytesInBuffer(unsigned Address, unsigned BufferIndex) {
-  unsigned RdOff;
-  unsigned WrOff;
-  unsigned r;
-  //Log_Print("Address = 0x%08X BufferIndex = 0x%08X\n", Address, BufferIndex);
-  //
-  // Avoid warnings regarding volatile access order.  It's not a problem
-  // in this case, but dampen compiler enthusiasm.
-  //
-  RdOff = T32_GetWord(RTTCB_OFFSET_AUP_RDOFF(Address, BufferIndex));
-  WrOff = T32_GetWord(RTTCB_OFFSET_AUP_WROFF(Address, BufferIndex));
-  if (RdOff <= WrOff) {
-    r = WrOff - RdOff;
-  } else {
-    r = T32_GetWord(RTTCB_OFFSET_AUP_SIZEOFBUFFER(Address, BufferIndex)) - (WrOff - RdOff);
+void T32_memcpy2P(const char* sAccess, void* pDest, void* pSrc, unsigned NumBytes) {
+  int Result;
+  Result = _T32_ReadMemory(sAccess, (unsigned int)pSrc, pDest, NumBytes);
+  if (_IsResetError(Result)) {
+    Log_Print("T32 memcpy to pc reset detected, Result = %s.\n", T32_Err2Str(Result));
+    memset(pDest, 0, NumBytes);
+    _RTTCBResync = 1;
+    return;
+  }
+  if (Result != T32_OK) {
+    Log_Print("T32 memcpy to pc error, Result = %s.\n", T32_Err2Str(Result));
+    memset(pDest, 0, NumBytes);
+    _SetLinkError(Result);
   }
-  return r;
 }
 
 /*********************************************************************
 *
-*       SEGGER_Terminal_GetChannelID()
+*       _T32_ReadBundle2()
 *
 *  Function description
-*    Returns the RTT <Up> / <Down> channel ID used by Terminal.
+*    Reads two target areas with one memory bundle, a single request
+*    and reply message.
+*
+*  Return value
+*    == T32_OK  O.K.
+*    != T32_OK  Error
 */
-int SEGGER_Terminal_GetChannelID(void) {
-  return 0;
+static int _T32_ReadBundle2(const char* sAccess, void* pDest0, void* pSrc0, unsigned NumBytes0, void* pDest1, void* pSrc1, unsigned NumBytes1) {
+  T32_MemoryBundleHandle hBundle;
+  T32_AddressHandle      hAddr;
+  T32_BufferSynchStatus  Status0;
+  T32_BufferSynchStatus  Status1;
+  int                    Result;
+
+  Result = T32_RequestMemoryBundleObj(&hBundle, 2);
+  if (Result != T32_OK) {
+    return Result;
+  }
+  T32_RequestAddressObjA32(&hAddr, (uint32_t)(uintptr_t)pSrc0);
+  T32_SetAddressObjAccessString(hAddr, sAccess);
+  T32_AddToBundleObjAddrLength(hBundle, hAddr, NumBytes0);
+  T32_ReleaseAddressObj(&hAddr);                     // Bundle holds its own copy
+  T32_RequestAddressObjA32(&hAddr, (uint32_t)(uintptr_t)pSrc1);
+  T32_SetAddressObjAccessString(hAddr, sAccess);
+  T32_AddToBundleObjAddrLength(hBundle, hAddr, NumBytes1);
+  T32_ReleaseAddressObj(&hAddr);
+  Result = T32_TransferMemoryBundleObj(hBundle);
+  if (Result == T32_OK) {
+    Status0 = T32_BUFFER_ERROR;
+    Status1 = T32_BUFFER_ERROR;
+    T32_GetBundleObjSyncStatusByIndex(hBundle, &Status0, 0);
+    T32_GetBundleObjSyncStatusByIndex(hBundle, &Status1, 1);
+    if ((Status0 != T32_BUFFER_READ) || (Status1 != T32_BUFFER_READ)) {
+      Result = T32_ERR_TRANSFERMEMOBJ_TRANSFERFAIL;
+    } else {
+      T32_CopyDataFromBundleObjByIndex((uint8_t*)pDest0, (int)NumBytes0, hBundle, 0);
+      T32_CopyDataFromBundleObjByIndex((uint8_t*)pDest1, (int)NumBytes1, hBundle, 1);
+    }
+  }
+  T32_ReleaseMemoryBundleObj(&hBundle);
+  return Result;
 }
 
 /*********************************************************************
 *
-*       _WaitPolling
+*       T32_memcpy2P2()
 *
 *  Function description
-*    Poll SystemView Buffer to reach threshold fill level.
-*
+*    Reads two target areas, e.g. both parts of a wrapped ring buffer,
+*    with the default access class in a single round trip where
+*    possible: pipelined (T32_AsyncReadMemory()) if the line driver
+*    keeps several requests in flight, else as one memory bundle if
+*    both fit into a message. Over UDP the driver waits for the reply
+*    of every request, pipelining would not save the second round trip.
 */
-static void _WaitPolling(unsigned Address, int Timeout, int ChannelID) {
-  int BytesInBuffer;
-  do {
-    BytesInBuffer = SEGGER_RTT_GetBytesInBuffer(Address, ChannelID);
-    if (BytesInBuffer >= RTT_SEND_THRESHOLD) {
-      break;
+void T32_memcpy2P2(const char* sAccess, void* pDest0, void* pSrc0, unsigned NumBytes0, void* pDest1, void* pSrc1, unsigned NumBytes1) {
+  unsigned MaxSize;
+  int      Result;
+  int      ReadResult;
+
+  MaxSize = (unsigned)T32_GetMaxPacketSize();
+  if ((NumBytes0 == 0u) || (NumBytes1 == 0u) || (NumBytes0 > MaxSize) || (NumBytes1 > MaxSize)
+   || ((sAccess != NULL) && (strcmp(sAccess, RTT_DEFAULT_ACCESS) != 0))
+   || ((T32_AsyncGetWindow() < 2) && (NumBytes0 + NumBytes1 + 8u > MIN(MaxSize, RTT_BUNDLE_MAX_DATA)))) {
+    if (NumBytes0) {
+      T32_memcpy2P(sAccess, pDest0, pSrc0, NumBytes0);
+    }
+    if (NumBytes1) {
+      T32_memcpy2P(sAccess, pDest1, pSrc1, NumBytes1);
+    }
+    return;
+  }
+  if (T32_AsyncGetWindow() < 2) {
+    Result = _T32_ReadBundle2(RTT_DEFAULT_ACCESS, pDest0, pSrc0, NumBytes0, pDest1, pSrc1, NumBytes1);
+  } else {
+    ReadResult = T32_OK;
+    Result = T32_AsyncReadMemory((uint32_t)(uintptr_t)pSrc0, 0x40 /* E:*/, (uint8_t*)pDest0, (int)NumBytes0, _T32_OnReadDone, &ReadResult);
+    if (Result == T32_OK) {
+      Result = T32_AsyncReadMemory((uint32_t)(uintptr_t)pSrc1, 0x40 /* E:*/, (uint8_t*)pDest1, (int)NumBytes1, _T32_OnReadDone, &ReadResult);
+    }
+    if (T32_AsyncComplete(-1) != T32_OK) {             // Always drain the window
+      Result = T32_COM_RECEIVE_FAIL;
     }
-    SYS_Sleep(RTT_COMM_POLL_INTERVAL);
-    Timeout -= RTT_COMM_POLL_INTERVAL;
-  } while (Timeout > 0);
+    if (Result == T32_OK) {
+      Result = ReadResult;
+    }
+  }
+  if (_IsResetError(Result)) {
+    Log_Print("T32 memcpy to pc reset detected, Result = %s.\n", T32_Err2Str(Result));
+    memset(pDest0, 0, NumBytes0);
+    memset(pDest1, 0, NumBytes1);
+    _RTTCBResync = 1;
+    return;
+  }
+  if (Result != T32_OK) {
+    Log_Print("T32 memcpy to pc error, Result = %s.\n", T32_Err2Str(Result));
+    memset(pDest0, 0, NumBytes0);
+    memset(pDest1, 0, NumBytes1);
+    _SetLinkError(Result);
+  }
 }
 
 /*********************************************************************
 *
-*       init functions
+*       T32_memcpy2C()
 *
-**********************************************************************
 */
+void T32_memcpy2C(const char* sAccess, void* pDest, void* pSrc, unsigned NumBytes) {
+  int Result;
+  _COALESCE_Invalidate();
+  _MEMCACHE_OnWrite((uint32_t)(uintptr_t)pDest, NumBytes);
+  Result = _T32_WriteMemory(sAccess, (unsigned int)pDest, pSrc, NumBytes);
+  if (_IsResetError(Result)) {
+    Log_Print("T32 memcpy to chip reset detected, Result = %s.\n", T32_Err2Str(Result));
+    _RTTCBResync = 1;
+    return;
+  }
+  if (Result != T32_OK) {
+    Log_Print("T32 memcpy to chip error, Result = %s.\n", T32_Err2Str(Result));
+    _SetLinkError(Result);
+  }
+}
 
 /*********************************************************************
 *
-*       SIGNAL_HandlerInit()
+*       T32_RetryGetState()
 *
-*  Function description
-*    This is NOP crash handler. Just to make things compiling if
-*    you don't have a real crash handler on your OS.
 */
-static int SIGNAL_HandlerInit(void) {
-  signal(SIGINT  , SYS_ExitHandler);
-  signal(SIGTERM , SYS_ExitHandler);
-  signal(SIGILL  , SYS_ExitHandler);
-  signal(SIGFPE  , SYS_ExitHandler);
-  signal(SIGSEGV , SYS_ExitHandler);
-#ifdef _WIN32
-  signal(SIGBREAK, SYS_ExitHandler);
-#endif
-  signal(SIGABRT , SYS_ExitHandler);
-  return 0;
+static int T32_RetryGetState(int (*pGetState)(int *pState), int *pState, int nRetry) {
+  int Result;
+
+  while (nRetry > 0) {
+    Result = pGetState(pState);
+    if (Result == T32_ERR_COM_RECEIVE_FAIL || Result == T32_ERR_COM_TRANSMIT_FAIL) {
+      nRetry--;
+      SYS_Sleep(5);
+    }
+    else {
+      return Result;
+    }
+  }
+  return Result;
 }
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _WSAStartup
+*       T32_WaitPractise()
 *
-*  Function description
-*    Initializes Winsock API. Needs to be called once before using any socket API.
-*    May be called multiple times.
 */
-static void _WSAStartup(void) {
-  WORD    wVersionRequested;
-  WSADATA wsaData;
-  //
-  // Init Winsock API
-  //
-  wVersionRequested = MAKEWORD(2, 2);
-  WSAStartup(wVersionRequested, &wsaData);
+static void T32_WaitPractise(int nRetry, int nDelay) {
+  int Result;
+  int pState;
+
+  for (;;) {
+    Result = T32_RetryGetState(&T32_GetPracticeState, &pState, nRetry);
+    if (Result != T32_OK) {
+      Log_Print("Failed to query Trace32 state (error code: %s)\n", T32_Err2Str(Result));
+      SYS_ExitHandler(Result);
+    }
+
+    if (pState == 0) {
+      Log_Print("Practise done.\n");
+      break;
+    }
+    else if (pState == 1) {
+      Log_Print("Practise running.\n");
+      SYS_Sleep(nDelay);
+    }
+    else if (pState == 2) {
+      Log_Print("ERROR Trace32 is in dialog mode. It waits for an input.\n");
+      SYS_ExitHandler(Result);
+    }
+    else {
+      Log_Print("ERROR Unknown status. What is going on?\n");
+      SYS_ExitHandler(Result);
+    } // end if (pState == 0)
+  } // for (;;) {
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _WSACleanup
+*       T32_RunScriptFile()
 *
 *  Function description
-*    Cleans up Winsock API. WSACleanup() needs to be called as many times
-*    as WSAStartup() if socket API is no longer needed.
+*    Makes Trace32 synchronouly execute a CMM script arg.
+*    The script arg is systematically converted to an absolute path.
+*
 */
-static void _WSACleanup(void) {
-  WSACleanup();
+static void T32_RunScriptFile(const char *pCmmFile) {
+  int  Result;
+  char *sPath = NULL;
+
+  // Convert the script to an absolute path
+  sPath = LRealPath(pCmmFile);
+
+  // Ask T32 to run the script. If the function succeeds, T32 will be
+  // loading the script asynchronously!
+  Result = T32_Cmd_f("DO \"%s\"", sPath);
+  if (Result != T32_OK) {
+    Log_Print("Failed to execute CMM script '%s' (error code: %s)\n", sPath, T32_Err2Str(Result));
+    SYS_ExitHandler(Result);
+  }
+
+  Log_Print("Remotely running script '%s'. This may take some time.\n", sPath);
+
+  free(sPath);
+  T32_WaitPractise(8, 2);
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_OpenUDP
-*
-*  Function description
-*    Creates an IPv4 TCP socket.
+*       T32_ConfigSet()
 *
-*  Return value
-*    Handle to socket
 */
-static _SYS_SOCKET_HANDLE _SYS_SOCKET_OpenUDP(void) {
-  _SYS_SOCKET_HANDLE sock;
-  //
-  // Create socket
-  //
-  sock = socket(AF_INET, SOCK_DGRAM, 0);
-  if (sock != INVALID_SOCKET) {
-    return (_SYS_SOCKET_HANDLE)sock;
-  } else {
-    return _SYS_SOCKET_INVALID_HANDLE;
+static void T32_ConfigSet(const char *String1, const char *String2) {
+  int Result;
+
+  Log_Print("\"%s\", \"%s\"\n", String1, String2);
+  Result = T32_Config(String1, String2);
+  if (Result != T32_OK) {
+    Log_Print("Failed to set config '%s-%s' (error code: %s)\n", String1, String2, T32_Err2Str(Result));
+    SYS_ExitHandler(Result);
   }
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_IPV6_OpenUDP
-*
-*  Function description
-*    Creates an IPv4 TCP socket.
+*       T32_DefaultState()
 *
-*  Return value
-*    Handle to socket
 */
-static _SYS_SOCKET_HANDLE _SYS_SOCKET_IPV6_OpenUDP(char DualStack) {
-  _SYS_SOCKET_HANDLE sock;
-  //
-  // Create socket
-  //
-  sock = socket(AF_INET6, SOCK_DGRAM, 0);
-  if (sock != INVALID_SOCKET && DualStack) {
-    //
-    // Disable Nagle's algorithm to speed things up
-    // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
-    //
-    setsockopt(sock, IPPROTO_IPV6, TCP_CC_INFO, (char*)&_int1, sizeof(int));
-  } else {
-    return _SYS_SOCKET_INVALID_HANDLE;
+static void T32_DefaultState(int exit) {
+  int Result;
+  int pState;
+
+  Result = T32_RetryGetState(&T32_GetPracticeState, &pState, 8);
+  if (Result != T32_OK) {
+    Log_Print("Failed to query Trace32 practice state (error code: %s)\n", T32_Err2Str(Result));
+    if (exit == 1) {
+      SYS_ExitHandler(Result);
+    }
+  }
+  // Running
+  if (pState == 1) {
+    Log_Print("Practise running.\n");
+    _MEMCACHE_OnRunStateChange();
+    Result = T32_Stop();
+    if (Result != T32_OK) {
+      Log_Print("Failed to stop (error code: %s)\n", T32_Err2Str(Result));
+      if (exit == 1) {
+        SYS_ExitHandler(Result);
+      }
+    }
+  }
+
+  Result = T32_RetryGetState(&T32_GetState, &pState, 8);
+  if (Result != T32_OK) {
+    Log_Print("Failed to query Trace32 debugger state (error code: %s)\n", T32_Err2Str(Result));
+    if (exit == 1) {
+      SYS_ExitHandler(Result);
+    }
+  }
+  // Running
+  if (pState == 3) {
+    Log_Print("Debugger running.\n");
+    _MEMCACHE_OnRunStateChange();
+    Result = T32_Break();
+    if (Result != T32_OK) {
+      Log_Print("Failed to break (error code: %s)\n", T32_Err2Str(Result));
+      if (exit == 1) {
+        SYS_ExitHandler(Result);
+      }
+    }
   }
-  return (_SYS_SOCKET_HANDLE)sock;
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_OpenTCP
+*       T32_IFStop2Run()
 *
-*  Function description
-*    Creates an IPv4 TCP socket.
+*/
+static int T32_IFStop2Run(void) {
+  int Result;
+  int pState;
+
+  Result = T32_RetryGetState(&T32_GetState, &pState, 8);
+  if (Result != T32_OK) {
+    Log_Print("Failed to query Trace32 debugger state (error code: %s)\n", T32_Err2Str(Result));
+    return Result;
+  }
+  // Stopped
+  if (pState == 2) {
+    Log_Print("Debugger Stopped.\n");
+    _MEMCACHE_OnRunStateChange();
+    Result = T32_Go();
+    if (Result != T32_OK) {
+      Log_Print("Failed to break (error code: %s)\n", T32_Err2Str(Result));
+    }
+  }
+  return Result;
+}
+
+/*********************************************************************
+*
+*       T32_IFRun2Stop()
 *
-*  Return value
-*    Handle to socket
 */
-static _SYS_SOCKET_HANDLE _SYS_SOCKET_OpenTCP(void) {
-  SOCKET sock;
-  //
-  // Init Winsock API as this is the first socket-related function being called
-  // WSACleanup is called on SocketClose()
-  //
-  _WSAStartup();
-  //
-  // Create socket
-  //
-  sock = socket(AF_INET, SOCK_STREAM, 0);
-  if (sock != INVALID_SOCKET) {
-    //
-    // Disable Nagle's algorithm to speed things up
-    // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
-    //
-    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
-  } else {
-    return _SYS_SOCKET_INVALID_HANDLE;
+static int T32_IFRun2Stop(void) {
+  int Result;
+  int pState;
+
+  Result = T32_RetryGetState(&T32_GetState, &pState, 8);
+  if (Result != T32_OK) {
+    Log_Print("Failed to query Trace32 debugger state (error code: %s)\n", T32_Err2Str(Result));
+    return Result;
   }
-  return (_SYS_SOCKET_HANDLE)sock;
+  // Running
+  if (pState == 3) {
+    Log_Print("Debugger running.\n");
+    _MEMCACHE_OnRunStateChange();
+    Result = T32_Break();
+    if (Result != T32_OK) {
+      Log_Print("Failed to break (error code: %s)\n", T32_Err2Str(Result));
+    }
+  }
+  return Result;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_OpenTCP
+*       T32_InitDEVICD()
 *
 *  Function description
-*    Creates an IPv4 TCP socket.
+*    Configures and connects the currently selected RCL channel.
 *
 *  Return value
-*    Handle to socket
+*    == T32_OK  O.K.
+*    != T32_OK  Error, the channel is not usable
 */
-static _SYS_SOCKET_HANDLE SYS_SOCKET_IPV6_OpenTCP(char DualStack) {
-  _SYS_SOCKET_HANDLE sock;
+static int T32_InitDEVICD(char *Node, char *Port, char *PackLen, char *cmmFile ) {
+  int  Result;
+  char acBusyPoll[16];
+
+  T32_ConfigSet("NODE="   , Node);
+  T32_ConfigSet("PORT="   , Port);
+  if (PackLen != NULL) {
+    T32_ConfigSet("PACKLEN=", PackLen);
+  }
+  if (_RtEnable && _RtBusyPollUs != 0u) {
+    snprintf(acBusyPoll, sizeof(acBusyPoll), "%u", _RtBusyPollUs);
+    T32_ConfigSet("BUSYPOLL=", acBusyPoll);
+  }
+  if (_pReplayFile != NULL) {
+    T32_ConfigSet("REPLAY="    , _pReplayFile);
+    T32_ConfigSet("REPLAYPACE=", "1");
+  }
+  if (_pCaptureFile != NULL) {
+    T32_ConfigSet("CAPTURE=", _pCaptureFile);        // One file for all targets, opened once
+    _pCaptureFile = NULL;
+  }
+
   //
-  // Create socket
+  // Trace32 Init
   //
-  sock = socket(AF_INET6, SOCK_STREAM, 0);
-  if (sock == INVALID_SOCKET) {
-    return _SYS_SOCKET_INVALID_HANDLE;
+  Result = T32_Init();
+  if(Result != T32_OK) {
+    Log_Print("Error initializing TRACE32, Result = %s.\n", T32_Err2Str(Result));
+    return Result;
+  };
+
+  //
+  // Attach to T32. The parameter is the device identifier.  T32_DEV_ICD and
+  // T32_DEV_ICE are identical and mean the same thing: the debugger
+  //
+  Result = T32_Attach(T32_DEV_ICD);
+  if(Result != T32_OK) {
+    Log_Print("Error no device, Result = %s.\n", T32_Err2Str(Result));
+    return Result;
+  };
+  if (_RtEnable && _RtBusyPollUs != 0u && _pReplayFile == NULL) {
+    T32_LineStats Line;
+
+    T32_GetLineStats(&Line);
+    if (Line.BusyPollUs == 0u) {
+      SYS_Log("realtime: SO_BUSY_POLL %u us not in effect (needs CAP_NET_ADMIN)\n", _RtBusyPollUs);
+    }
   }
-  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
-  if (!DualStack) {
-    return (_SYS_SOCKET_HANDLE)sock;
+
+  if (cmmFile != NULL) {
+    Result = T32_IFRun2Stop();
   }
-  setsockopt(sock, IPPROTO_IPV6, TCP_CC_INFO, (char*)&_int1, sizeof(int));
-  return (_SYS_SOCKET_HANDLE)sock;
+  else {
+    Result = T32_IFStop2Run();
+  }
+  if(Result != T32_OK) {
+    return Result;
+  };
+
+  Result = T32_Nop();
+  if(Result != T32_OK) {
+    Log_Print("Error nop, Result = %s.\n", T32_Err2Str(Result));
+    return Result;
+  };
+
+  Result = T32_Ping();
+  if(Result != T32_OK) {
+    Log_Print("Sends one PING message to the system fail, Result = %s.\n", T32_Err2Str(Result));
+    return Result;
+  };
+
+  if ( cmmFile != NULL) {
+    T32_RunScriptFile(cmmFile);
+  }
+  return T32_OK;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_OpenTCP
+*       _LOAD_Progress()
 *
 *  Function description
-*    Creates an IPv4 TCP socket.
-*
-*  Return value
-*    Handle to socket
+*    Progress callback of T32_LoadMemory(). Prints the loaded bytes
+*    and the throughput of the current attempt at most every
+*    RTT_LOAD_REPORT_INTERVAL ms.
 */
-static _SYS_SOCKET_HANDLE _SYS_SOCKET_OpenTCP(void) {
-  _SYS_SOCKET_HANDLE sock;
-  //
-  // Create socket
-  //
-  sock = socket(AF_INET, SOCK_STREAM, 0);
-  if (sock != INVALID_SOCKET) {
-    //
-    // Disable Nagle's algorithm to speed things up
-    // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
-    //
-    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
-  } else {
-    return _SYS_SOCKET_INVALID_HANDLE;
+static int _LOAD_Progress(void* pUser, const T32_LoadProgress* pProgress) {
+  RTT_LOAD_REPORT* pReport;
+  unsigned         t;
+  uint64_t         Rate;
+
+  pReport = (RTT_LOAD_REPORT*)pUser;
+  pReport->Retransmits = pProgress->Retransmits;
+  pReport->PacketSize  = pProgress->PacketSize;
+  pReport->Window      = pProgress->Window;
+  t = SYS_GetTickCount();
+  if ((int)(t - pReport->NextReport) < 0 && pProgress->Done != pProgress->Total) {
+    return 0;
   }
-  return (_SYS_SOCKET_HANDLE)sock;
+  pReport->NextReport = t + RTT_LOAD_REPORT_INTERVAL;
+  Rate = (pProgress->ElapsedUs != 0u) ? (uint64_t)(pProgress->Done - pProgress->Start) * 1000000u / pProgress->ElapsedUs / 1024u : 0u;
+  printf("\r%s %u of %u bytes (%u%%), %u KB/s   ", pReport->sAction, pProgress->Done, pProgress->Total,
+         (pProgress->Total != 0u) ? (unsigned)((uint64_t)pProgress->Done * 100u / pProgress->Total) : 100u, (unsigned)Rate);
+  fflush(stdout);
+  return 0;
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_Close
+*       _LOAD_ParseNumber()
 *
 *  Function description
-*    Closes a socket. Resources allocated by this socket are freed.
+*    Parses a number 0..Max of a --load, --verify or --dump argument,
+*    decimal, hex with 0x or octal with a leading 0.
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*  Return value
+*    == 0  O.K., *pValue set
+*     < 0  Error, not a number or out of range
 */
-static void _SYS_SOCKET_Close(_SYS_SOCKET_HANDLE hSocket) {
-  SOCKET Sock;
-  int OptVal;
-  int OptLen;
-  //
-  // MSDN: A socket that is using the SO_EXCLUSIVEADDRUSE option must be shut down properly prior to closing it. Failure to do so can cause a denial of service attack if the associated service needs to restart.
-  //
-  Sock = (SOCKET)hSocket;
-  OptLen = 4;
-  OptVal = 0;  // Make sure it is zero initialized in case getsockopt does not fill it completely
-  getsockopt(Sock, SOL_SOCKET, -5, (char*)&OptVal, &OptLen);  // SO_EXCLUSIVEADDRUSE (Define not known in the VC6 headers, we use...)
-  if (OptVal) {
-    shutdown(Sock, SD_BOTH);
+static int _LOAD_ParseNumber(const char* s, unsigned long Max, unsigned long* pValue) {
+  unsigned long Value;
+  char*         pEnd;
+
+  if ((*s < '0') || (*s > '9')) {
+    return -1;
   }
-  //
-  // Close socket
-  //
-  closesocket(Sock);
-  //
-  // De-init Winsock API. Needs to be called as often as WSAStartup() has been called
-  // Has an internal reference counter
-  // If the counter reaches 0, all sockets opened by the process, are forced closed
-  //
-  _WSACleanup();
+  errno = 0;
+  Value = strtoul(s, &pEnd, 0);
+  if ((errno != 0) || (*pEnd != '\0') || (Value > Max)) {
+    return -1;
+  }
+  *pValue = Value;
+  return 0;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_Close
+*       _LOAD_ReadFile()
 *
 *  Function description
-*    Closes a socket. Resources allocated by this socket are freed.
+*    Reads the file of a --load or --verify argument
+*    <file>:<address>[:<access>]. The argument is split from the end so
+*    that the file name may contain colons.
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*  Return value
+*    == T32_OK  O.K., *ppData to be freed by the caller
+*    != T32_OK  Error
 */
-static void _SYS_SOCKET_Close(_SYS_SOCKET_HANDLE hSocket) {
-  //
-  // Close socket
-  //
-  close(hSocket);
+static int _LOAD_ReadFile(const char* sOption, const char* sArg, unsigned char** ppData, long* pFileSize, uint32_t* pAddress, int* pAccess) {
+  char*          sFile;
+  char*          s;
+  FILE*          pFile;
+  unsigned char* pData;
+  long           FileSize;
+  const char*    sAddress;
+  const char*    sAccess;
+  const char*    sBad;
+  unsigned long  Address;
+  unsigned long  Value;
+
+  sFile = strdup(sArg);
+  s     = (sFile != NULL) ? strrchr(sFile, ':') : NULL;
+  if (s == NULL) {
+    printf("%s option requires <file>:<address>[:<access>]\n", sOption);
+    free(sFile);
+    return T32_COM_PARA_FAIL;
+  }
+  *s = '\0';
+  sAddress = s + 1;
+  sAccess  = NULL;
+  s = strrchr(sFile, ':');
+  if (s != NULL && s[1] != '\0' && strchr(s + 1, '/') == NULL && strchr(s + 1, '\\') == NULL) {
+    *s = '\0';
+    sAccess  = sAddress;
+    sAddress = s + 1;
+  }
+  sBad  = NULL;
+  Value = T32_MEMORY_ACCESS_DATA;
+  if (_LOAD_ParseNumber(sAddress, 0xFFFFFFFFuL, &Address) < 0) {
+    sBad = "address";
+  } else if (sAccess != NULL && _LOAD_ParseNumber(sAccess, 255u, &Value) < 0) {
+    sBad     = "access";
+    sAddress = sAccess;
+  }
+  if (sBad != NULL) {
+    printf("%s %s: invalid %s \"%s\", expected <file>:<address>[:<access>] with <address> 0..0xFFFFFFFF and <access> 0..255\n",
+           sOption, sArg, sBad, sAddress);
+    free(sFile);
+    return T32_COM_PARA_FAIL;
+  }
+  *pAddress = (uint32_t)Address;
+  *pAccess  = (int)Value;
+  pFile = fopen(sFile, "rb");
+  if (pFile == NULL) {
+    printf("can not open %s\n", sFile);
+    free(sFile);
+    return T32_COM_PARA_FAIL;
+  }
+  fseek(pFile, 0, SEEK_END);
+  FileSize = ftell(pFile);
+  fseek(pFile, 0, SEEK_SET);
+  pData = (FileSize > 0) ? (unsigned char*)malloc((size_t)FileSize) : NULL;
+  if (pData == NULL || fread(pData, 1, (size_t)FileSize, pFile) != (size_t)FileSize) {
+    printf("can not read %s\n", sFile);
+    fclose(pFile);
+    free(pData);
+    free(sFile);
+    return T32_COM_PARA_FAIL;
+  }
+  fclose(pFile);
+  printf("%s: %s, %ld bytes at 0x%08X, access %d\n", sOption, sFile, FileSize, *pAddress, *pAccess);
+  free(sFile);
+  *ppData    = pData;
+  *pFileSize = FileSize;
+  return T32_OK;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_Shutdown
+*       _LOAD_Connect()
 *
 *  Function description
-*    Closes a socket. Resources allocated by this socket are freed.
+*    Connects the link of --load and --verify.
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*  Return value
+*    == T32_OK  O.K.
+*    != T32_OK  Error
 */
-static void _SYS_SOCKET_Shutdown (_SYS_SOCKET_HANDLE hSocket, int How) {
-  _SYS_SOCKET_HANDLE Sock;
-  int r;
-
-  Sock = (_SYS_SOCKET_HANDLE)hSocket;
-  r    = How;
+static int _LOAD_Connect(char* Node, char* Port, char* PackLen) {
+  int Result;
 
-  switch (r) {
-    case _SYS_SOCKET_SHUT_RD:
-      shutdown(Sock, 0);
-    case _SYS_SOCKET_SHUT_WR:
-      shutdown(Sock, 1);
-    case _SYS_SOCKET_SHUT_RDWR:
-      shutdown(Sock, 2);
+  T32_ConfigSet("NODE=", Node);
+  T32_ConfigSet("PORT=", Port);
+  if (PackLen != NULL) {
+    T32_ConfigSet("PACKLEN=", PackLen);
   }
+  Result = T32_Init();
+  if (Result == T32_OK) {
+    Result = T32_Attach(T32_DEV_ICD);
+  }
+  return Result;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       SYS_SOCKET_SetTimeouts
+*       _LOAD_Run()
 *
 *  Function description
-*    Closes a socket. Resources allocated by this socket are freed.
+*    Loads a binary file into target memory, see --load. The file is
+*    streamed with T32_LoadMemory() in pipe packets of the negotiated
+*    size. Over a line driver which recovers several requests in flight
+*    up to T32_ASYNC_MAX_WINDOW packets are pipelined; over UDP each
+*    packet waits for its reply, so the packet size alone sets the
+*    throughput. After an error the link is reconnected and the load
+*    resumed from the last offset the target acknowledged.
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*  Return value
+*    == T32_OK  O.K.
+*    != T32_OK  Error
 */
-int SYS_SOCKET_SetTimeouts(int hSocket, int TimeoutSend, int TimeoutReceive) {
-  struct timeval timeout;
+static int _LOAD_Run(char* Node, char* Port, char* PackLen) {
+  unsigned char* pData;
+  long           FileSize;
+  uint32_t       Address;
+  int            Access;
+  uint32_t       Done;
+  uint32_t       Retransmits;
+  unsigned       Attempt;
+  unsigned       t0;
+  unsigned       ms;
+  int            Result;
+  RTT_LOAD_REPORT Report;
+
+  Result = _LOAD_ReadFile("--load", _pLoadArg, &pData, &FileSize, &Address, &Access);
+  if (Result != T32_OK) {
+    return Result;
+  }
+  Done        = 0;
+  Retransmits = 0;
+  t0          = SYS_GetTickCount();
+  Report.sAction    = "loaded";
+  Report.NextReport = t0;
+  for (Attempt = 0; ; Attempt++) {
+    Result = _LOAD_Connect(Node, Port, PackLen);
+    if (Result == T32_OK) {
+      T32_NegotiatePacketSize(Address, Access);
+      T32_AsyncSetWindow(T32_ASYNC_MAX_WINDOW);
+      Report.Retransmits = 0;
+      Result = T32_LoadMemory(Address, Access, pData, (uint32_t)FileSize, &Done, _LOAD_Progress, &Report);
+      Retransmits += Report.Retransmits;
+    }
+    if (Result == T32_OK || Attempt >= RTT_LOAD_RETRIES) {
+      break;
+    }
+    printf("\nload error %s at offset %u, resuming\n", T32_Err2Str(Result), Done);
+    T32_Exit();
+  }
+  ms = SYS_GetTickCount() - t0;
+  printf("\n");
+  if (Result == T32_OK) {
+    printf("loaded %ld bytes in %u ms, %u KB/s, packet %d bytes, ", FileSize, ms,
+           (ms != 0u) ? (unsigned)((uint64_t)FileSize * 1000u / ms / 1024u) : 0u, T32_GetMaxPacketSize());
+    if (T32_AsyncGetWindow() > 1) {
+      printf("window %d, ", T32_AsyncGetWindow());
+    } else {
+      printf("one packet per round trip, ");
+    }
+    printf("%u retransmits, %u resumes\n", Retransmits, Attempt);
+  } else {
+    printf("load failed, %s, %u of %ld bytes acknowledged\n", T32_Err2Str(Result), Done, FileSize);
+  }
+  T32_Exit();
+  free(pData);
+  return Result;
+}
 
-  timeout.tv_sec  = TimeoutSend / 1000;
-  timeout.tv_usec = (TimeoutSend % 1000) * 1000;
-  setsockopt(hSocket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+/*********************************************************************
+*
+*       _VERIFY_Mismatch()
+*
+*  Function description
+*    Mismatch callback of T32_VerifyMemory(). Prints the differing
+*    range of a block.
+*/
+static void _VERIFY_Mismatch(void* pUser, uint32_t Address, const uint8_t* pTarget, const uint8_t* pExpected, uint32_t Size) {
+  uint32_t First;
+  uint32_t Last;
 
-  timeout.tv_sec  = TimeoutReceive / 1000;
-  timeout.tv_usec = (TimeoutReceive % 1000) * 1000;
-  return setsockopt(hSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  USE_PARA(pUser);
+  for (First = 0; First < Size && pTarget[First] == pExpected[First]; First++) {
+  }
+  for (Last = Size - 1; Last > First && pTarget[Last] == pExpected[Last]; Last--) {
+  }
+  printf("mismatch at 0x%08X..0x%08X, target %02X, file %02X\n",
+         Address + First, Address + Last, pTarget[First], pExpected[First]);
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       SYS_SOCKET_DisableLinger
+*       _VERIFY_Run()
 *
 *  Function description
-*    Closes a socket. Resources allocated by this socket are freed.
+*    Verifies target memory against a binary file, see --verify.
+*    TRACE32 computes the CRC-32 of the range, which is compared with
+*    the one of the file. Only blocks of RTT_VERIFY_BLOCK_SIZE whose
+*    checksum differs are read back, see T32_VerifyMemory().
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*  Return value
+*    == 0  Target memory equals the file
+*    != 0  Mismatch or error
 */
-int SYS_SOCKET_DisableLinger(_SYS_SOCKET_HANDLE hSocket) {
-  struct linger  so_linger;
-
-  so_linger.l_onoff  = 0;
-  so_linger.l_linger = 0;
+static int _VERIFY_Run(char* Node, char* Port, char* PackLen) {
+  unsigned char*  pData;
+  long            FileSize;
+  uint32_t        Address;
+  int             Access;
+  unsigned        t0;
+  unsigned        ms;
+  int             Result;
+  T32_VerifyStats Stats;
+
+  Result = _LOAD_ReadFile("--verify", _pVerifyArg, &pData, &FileSize, &Address, &Access);
+  if (Result != T32_OK) {
+    return 1;
+  }
+  t0     = SYS_GetTickCount();
+  Result = _LOAD_Connect(Node, Port, PackLen);
+  if (Result == T32_OK) {
+    Result = T32_VerifyMemory(Address, Access, pData, (uint32_t)FileSize, RTT_VERIFY_BLOCK_SIZE, _VERIFY_Mismatch, NULL, &Stats);
+  }
+  ms = SYS_GetTickCount() - t0;
+  if (Result != T32_OK) {
+    printf("verify failed, %s\n", T32_Err2Str(Result));
+  } else {
+    printf("verified %ld bytes in %u ms, %u checksums, %u bytes read back, %u bad blocks, %u bad bytes\n",
+           FileSize, ms, Stats.Checksums, Stats.BytesRead, Stats.BadBlocks, Stats.BadBytes);
+  }
+  T32_Exit();
+  free(pData);
+  return (Result != T32_OK || Stats.BadBytes != 0u) ? 1 : 0;
+}
 
-  return setsockopt(hSocket, SOL_SOCKET, SO_LINGER, &so_linger, sizeof(so_linger));
+/*********************************************************************
+*
+*       _DUMP_Store()
+*
+*  Function description
+*    Data callback of T32_DumpMemory(). Copies the data into the mapped
+*    output file, except for pages of RTT_DUMP_PAGE_SIZE (relative to
+*    the start of the file) which are all zero. Those are left
+*    unwritten and stay holes. Ranges the target failed to read are
+*    reported and read as zero as well.
+*/
+static void _DUMP_Store(void* pUser, uint32_t Offset, const uint8_t* pData, uint32_t Size, int Err) {
+  RTT_DUMP_FILE* pDump;
+  uint32_t       NumBytes;
+
+  pDump = (RTT_DUMP_FILE*)pUser;
+  if (pData == NULL) {
+    printf("\ncan not read 0x%X bytes at offset 0x%08X, %s\n", Size, Offset, T32_Err2Str(Err));
+    pDump->NumFailed += Size;
+    pDump->NumRanges++;
+    return;
+  }
+  while (Size != 0u) {
+    NumBytes = RTT_DUMP_PAGE_SIZE - Offset % RTT_DUMP_PAGE_SIZE;
+    if (NumBytes > Size) {
+      NumBytes = Size;
+    }
+    if (pData[0] == 0u && memcmp(pData, pData + 1, NumBytes - 1u) == 0) {
+      pDump->NumZero += NumBytes;
+    } else {
+      memcpy(pDump->pMap + Offset, pData, NumBytes);
+    }
+    pData  += NumBytes;
+    Offset += NumBytes;
+    Size   -= NumBytes;
+  }
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       SYS_SOCKET_EnableLinger
+*       _DUMP_MapFile()
 *
 *  Function description
-*    Closes a socket. Resources allocated by this socket are freed.
+*    Creates a sparse output file of the given size and maps it for
+*    writing.
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*  Return value
+*    == 0  O.K.
+*    != 0  Error
 */
-int SYS_SOCKET_EnableLinger(_SYS_SOCKET_HANDLE hSocket, int TimeoutLinger) {
+static int _DUMP_MapFile(RTT_DUMP_FILE* pDump, const char* sFile, uint32_t Size) {
+#ifdef _WIN32
+  DWORD Dummy;
 
-  struct linger  so_linger;
-  int timeout;
+  pDump->hFile = CreateFileA(sFile, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (pDump->hFile == INVALID_HANDLE_VALUE) {
+    return -1;
+  }
+  DeviceIoControl(pDump->hFile, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &Dummy, NULL);   // Best effort, holes need NTFS
+  pDump->hMapping = CreateFileMappingA(pDump->hFile, NULL, PAGE_READWRITE, 0, Size, NULL);
+  pDump->pMap     = (pDump->hMapping != NULL) ? (uint8_t*)MapViewOfFile(pDump->hMapping, FILE_MAP_WRITE, 0, 0, Size) : NULL;
+  if (pDump->pMap == NULL) {
+    if (pDump->hMapping != NULL) {
+      CloseHandle(pDump->hMapping);
+    }
+    CloseHandle(pDump->hFile);
+    return -1;
+  }
+#else
+  void* p;
 
-  timeout = 0;
-  if (TimeoutLinger) {
-    timeout = 1;
-    if (TimeoutLinger > 999)
-      timeout = (TimeoutLinger + 500) / 1000;
+  pDump->fd = open(sFile, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (pDump->fd < 0) {
+    return -1;
   }
-  so_linger.l_onoff  = 1;
-  so_linger.l_linger = timeout;
-  setsockopt(hSocket, SOL_SOCKET, SO_LINGER, &so_linger, sizeof(so_linger));
+  p = (ftruncate(pDump->fd, (off_t)Size) == 0) ? mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, pDump->fd, 0) : MAP_FAILED;
+  if (p == MAP_FAILED) {
+    close(pDump->fd);
+    return -1;
+  }
+  pDump->pMap = (uint8_t*)p;
+#endif
   return 0;
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_ListenAtTCPAddr
+*       _DUMP_UnmapFile()
 *
 *  Function description
-*    Puts IPv4 socket into listening state.
+*    Writes back and closes the output file.
+*/
+static void _DUMP_UnmapFile(RTT_DUMP_FILE* pDump, uint32_t Size) {
+#ifdef _WIN32
+  USE_PARA(Size);
+  FlushViewOfFile(pDump->pMap, 0);
+  UnmapViewOfFile(pDump->pMap);
+  CloseHandle(pDump->hMapping);
+  CloseHandle(pDump->hFile);
+#else
+  msync(pDump->pMap, Size, MS_SYNC);
+  munmap(pDump->pMap, Size);
+  close(pDump->fd);
+#endif
+}
+
+/*********************************************************************
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
-*    IPAddr   IPv4 address expected in little endian form, meaning 127.0.0.1 is expected as 0x7F000001
-*             To accept connections from any IP address, pass _SYS_SOCKET_IP_ADDR_ANY
-*    Port     Port to listen at
+*       _DUMP_Run()
+*
+*  Function description
+*    Dumps target memory into a file, see --dump. The range is read
+*    with T32_DumpMemory() in packets of the negotiated size, straight
+*    into the mapped file: up to T32_ASYNC_MAX_WINDOW of them in flight
+*    over a line driver which allows it, else as many per round trip as
+*    fit into a memory bundle. Ranges the target fails to read are
+*    retried on their own and left zero. After a communication error the link is
+*    reconnected and the dump resumed.
 *
 *  Return value
-*    >= 0: O.K.
-*     < 0: Error
+*    == 0  O.K.
+*    != 0  Error, or ranges which could not be read
 */
-static int _SYS_SOCKET_ListenAtTCPAddr(_SYS_SOCKET_HANDLE hSocket, unsigned IPAddr, unsigned Port, unsigned NumConnectionsQueued) {
-  struct sockaddr_in addr;
-  SOCKET Sock;
-  int r;
-  //
-  // Option SO_REUSEADDR:
-  //
-  // <IPAddr>: IP addresses of network adapters
-  //
-  // ==================================================
-  // Original idea from BSD sockets
-  // ==================================================
-  // bind() without SO_REUSEADDR set (default):
-  // bind(SockA, 0.0.0.0:21)
-  // bind(SockB, 192.168.0.1:21)
-  // SockB will fail because <IPAddr> of SockA is a wildcard that means "Any local address",
-  // so it is not possible to bind to any other local address with the same port.
-  // bind(SockA, 127.0.0.1:21)
-  // bind(SockB, 192.168.0.1:21)
-  // Both calls will succeed, as different <IPAddr>:<Port> combinations are used.
-  //
-  // bind() with SO_REUSEADDR set:
-  // bind(SockA, 0.0.0.0:21)
-  // bind(SockB, 192.168.0.1:21)
-  // SockA and SockB will succeed.
-  // The original idea includes that *each* of the sockets must have SO_REUSEADDR set before bind().
-  // If only the second one calls it, bind() will fail as the first socket did not allow sharing at all.
-  //
-  // This was the original idea of SO_REUSEADDR.
-  // NOTE: Not sure who really ever needed this, but that's the way it is...
-  //
-  // ==================================================
-  // Second effect of SO_REUSEADDR (TIME_WAIT)
-  // ==================================================
-  // There is another case where this option has an effect on:
-  // Calls to send() do not guarantee that data is sent when the function returns. It may be sent delayed.
-  // Therefore, it is possible that when calling close() to close a socket, send data is still pending.
-  // What the OS does is: preparing everything for closing the connection and return from close().
-  // Now the socket changed it's state from ACTIVE to TIME_WAIT but still exists inside the OS (not accessible for the user anymore)
-  // If now a new socket is opened and a bind() is performed on exactly the <IPAddr>:<Port> combination of the TIME_WAIT socket, the behavior depends on if the original socket had SO_REUSEADDR set.
-  //
-  // SO_REUSEADDR not set:
-  // bind() will fail as TIME_WAIT is handled as if it is ACTIVE
-  //
-  // SO_REUSEADDR set:
-  // bind() will succeed as TIME_WAIT is handled as if socket was not existing anymore.
-  // NOTE: Under rare circumstances, it now can happen that if there is any receive data arriving late at the system, the new socket that did the bind(), will receive it.
-  //
-  // ==================================================
-  // OS specifics
-  // ==================================================
-  //
-  // Windows:
-  // When specifying SO_REUSEADDR before bind(), Windows will report SUCCESS on bind(),
-  // even if there is another ACTIVE socket that is bound to the same <IPAddr>:<Port> combination.
-  // It does not matter if the process that did the first bind() did specify SO_REUSEADDR for its socket or not
-  // This allows processes to steal data from other ones...pretty awful bug in Windows... (See MSDN: Using SO_REUSEADDR and SO_EXCLUSIVEADDRUSE)
-  // Microsoft introduced SO_EXCLUSIVEADDRUSE for this.
-  // This makes sure hijacking the socket data is not possible.
-  // But it still allows the special behavior in case a bind() to a closed socket in TIME_WAIT state is possible. (See "Second effect of SO_REUSEADDR (TIME_WAIT)" above)
-  //
-  // MSDN: A socket that is using the SO_EXCLUSIVEADDRUSE option must be shut down properly prior to closing it. Failure to do so can cause a denial of service attack if the associated service needs to restart.
-  //
-  // Linux:
-  // Listening socket:
-  // SO_REUSEADDR does not have any effect for the "original idea" (see above). Linux is more restrictive than BSD sockets here.
-  // But it has the desired effect on closed sockets in TIME_WAIT state (see above).
-  //
-  // Client socket:
-  // Behaves like the original BSD idea and has the TIME_WAIT effect
-  //
-  // Kernel >= 3.9: To have "original idea" effect for listening sockets, since kernel 3.9 SO_REUSEPORT has been introduced.
+static int _DUMP_Run(char* Node, char* Port, char* PackLen) {
+  char*         sFile;
+  char*         s;
+  unsigned long aValue[3];
+  int           NumValues;
+  uint32_t      Address;
+  uint32_t      Size;
+  int           Access;
+  uint32_t      Done;
+  uint32_t      Retransmits;
+  unsigned      Attempt;
+  unsigned      t0;
+  unsigned      ms;
+  int           Result;
+  RTT_DUMP_FILE Dump;
+
   //
-  // Normal TCP connection close:
-  // Client1 (C1), Client2 (C2)
-  // C1 -> C2  FIN
-  // C1 <- C2  ACK
-  // C1 <- C2  FIN
-  // C1 -> C2  ACK
-  // Socket of C1 (as the initiator of the close request) now is in TIME_WAIT state and can stay there several seconds/minutes
-  // so the <IPAddr>:<Port> combination is blocked for some time, after the socket has been closed
-  // As this is not acceptable for us as the DLL and other J-Link utilities must be able to be started / terminated multiple times in a row,
-  // we make use of SO_REUSEADDR for all of our listener sockets which need to bind() to a specific port
+  // <file>:<address>:<size>[:<access>], numbers are split from the end
+  // so that the file name may contain colons
   //
-  Sock = (SOCKET)hSocket;
-  r = setsockopt(Sock, SOL_SOCKET, -5, (char*)&_int1, sizeof(int));  // SO_EXCLUSIVEADDRUSE (Define not known in the VC6 headers, we use...)
-  if (r == 0) {
-    addr.sin_family      = AF_INET;
-    addr.sin_port        = htons((unsigned short)Port);
-    addr.sin_addr.s_addr = htonl(IPAddr);
-    r = bind(Sock, (struct sockaddr*)&addr, sizeof(addr));
-    if (r == 0) {
-      r = listen(Sock, NumConnectionsQueued);
+  sFile     = strdup(_pDumpArg);
+  NumValues = 0;
+  while (sFile != NULL && NumValues < 3 && (s = strrchr(sFile, ':')) != NULL) {
+    if (_LOAD_ParseNumber(s + 1, 0xFFFFFFFFuL, &aValue[NumValues]) < 0) {
+      break;
     }
-    if (r) {
-      r = -1;
+    *s = '\0';
+    NumValues++;
+  }
+  if (NumValues < 2 || sFile[0] == '\0') {
+    printf("--dump %s: expected <file>:<address>:<size>[:<access>] with <address> and <size> 0..0xFFFFFFFF\n", _pDumpArg);
+    free(sFile);
+    return 1;
+  }
+  if ((NumValues == 3 && aValue[0] > 255u) || (uint64_t)aValue[NumValues - 1] + aValue[NumValues - 2] > 0x100000000uLL) {
+    printf("--dump %s: invalid %s, <access> is 0..255 and the range must end at or below 0xFFFFFFFF\n", _pDumpArg,
+           (NumValues == 3 && aValue[0] > 255u) ? "access" : "size");
+    free(sFile);
+    return 1;
+  }
+  Access  = (NumValues == 3) ? (int)aValue[0] : T32_MEMORY_ACCESS_DATA;
+  Size    = (uint32_t)aValue[NumValues - 2];
+  Address = (uint32_t)aValue[NumValues - 1];
+  memset(&Dump, 0, sizeof(Dump));
+  if (Size == 0u || _DUMP_MapFile(&Dump, sFile, Size) != 0) {
+    printf("can not create %s of %u bytes\n", sFile, Size);
+    free(sFile);
+    return 1;
+  }
+  printf("--dump: 0x%X bytes at 0x%08X, access %d, to %s\n", Size, Address, Access, sFile);
+  free(sFile);
+
+  Done        = 0;
+  Retransmits = 0;
+  t0          = SYS_GetTickCount();
+  Dump.Report.sAction    = "dumped";
+  Dump.Report.NextReport = t0;
+  for (Attempt = 0; ; Attempt++) {
+    Result = _LOAD_Connect(Node, Port, PackLen);
+    if (Result == T32_OK) {
+      T32_NegotiatePacketSize(Address, Access);
+      T32_AsyncSetWindow(T32_ASYNC_MAX_WINDOW);
+      Dump.Report.Retransmits = 0;
+      Result = T32_DumpMemory(Address, Access, Size, &Done, _DUMP_Store, _LOAD_Progress, &Dump);
+      Retransmits += Dump.Report.Retransmits;
+    }
+    if (Result == T32_OK || Attempt >= RTT_LOAD_RETRIES) {
+      break;
+    }
+    printf("\ndump error %s at offset %u, resuming\n", T32_Err2Str(Result), Done);
+    T32_Exit();
+  }
+  ms = SYS_GetTickCount() - t0;
+  printf("\n");
+  if (Result == T32_OK) {
+    printf("dumped %u bytes in %u ms, %.2f MB/s, packet %u bytes, ", Size, ms,
+           (ms != 0u) ? (double)Size * 1000.0 / ms / (1024.0 * 1024.0) : 0.0, Dump.Report.PacketSize);
+    if (T32_AsyncGetWindow() > 1) {
+      printf("window %u, ", Dump.Report.Window);
+    } else {
+      printf("%u packets per round trip, ", Dump.Report.Window);
     }
+    printf("%u retransmits, %u resumes\n", Retransmits, Attempt);
+    printf("%llu bytes sparse, %llu bytes in %u ranges unreadable\n",
+           (unsigned long long)Dump.NumZero, (unsigned long long)Dump.NumFailed, Dump.NumRanges);
   } else {
-    r = -1;
+    printf("dump failed, %s, %u of %u bytes done\n", T32_Err2Str(Result), Done, Size);
   }
-  return r;
+  T32_Exit();
+  _DUMP_UnmapFile(&Dump, Size);
+  return (Result != T32_OK || Dump.NumRanges != 0u) ? 1 : 0;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_ListenAtTCPAddr
+*       _RTTCB_Invalidate()
 *
 *  Function description
-*    Puts IPv4 socket into listening state.
+*    Drops all cached buffer descriptors. The control block is
+*    re-discovered by the next call of _RTTCB_Update().
+*/
+static void _RTTCB_Invalidate(RTT_CB_CACHE* pCB, const char* sReason) {
+  USE_PARA(sReason);
+  if (pCB->IsValid) {
+    Log_Print("RTT control block at 0x%08X invalidated: %s\n", pCB->Address, sReason);
+    pCB->NumResets++;
+  }
+  pCB->IsValid           = 0;
+  pCB->MaxNumUpBuffers   = 0;
+  pCB->MaxNumDownBuffers = 0;
+  _MEMCACHE_Clear(_MEMCACHE_Get());                   // Other blocks of the target define theirs again
+}
+
+/*********************************************************************
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
-*    IPAddr   IPv4 address expected in little endian form, meaning 127.0.0.1 is expected as 0x7F000001
-*             To accept connections from any IP address, pass _SYS_SOCKET_IP_ADDR_ANY
+*       _RTTCB_LoadDesc()
+*
+*  Function description
+*    Loads one buffer descriptor from the raw control block image.
+*
+*  Return value
+*    == 0 - Descriptor is plausible.
+*    <  0 - Descriptor contains stale or uninitialized data.
+*/
+static int _RTTCB_LoadDesc(RTT_BUFFER_DESC* pRing, const char* sAccess, unsigned Addr, const unsigned char* pData) {
+  memcpy(&pRing->pBuffer,      pData + RTTBUFFER_OFFSET_PBUFFER(0),      sizeof(unsigned));
+  memcpy(&pRing->SizeOfBuffer, pData + RTTBUFFER_OFFSET_SIZEOFBUFFER(0), sizeof(unsigned));
+  memcpy(&pRing->WrOff,        pData + RTTBUFFER_OFFSET_WROFF(0),        sizeof(unsigned));
+  memcpy(&pRing->RdOff,        pData + RTTBUFFER_OFFSET_RDOFF(0),        sizeof(unsigned));
+  memcpy(&pRing->Flags,        pData + RTTBUFFER_OFFSET_FLAGS(0),        sizeof(unsigned));
+  pRing->sAccess = sAccess;
+  pRing->Addr    = Addr;
+  if (pRing->SizeOfBuffer == 0u) {
+    return 0;                                                          // Unused channel
+  }
+  if ((pRing->pBuffer == 0u) || (pRing->WrOff >= pRing->SizeOfBuffer) || (pRing->RdOff >= pRing->SizeOfBuffer)) {
+    return -1;
+  }
+  return 0;
+}
+
+/*********************************************************************
+*
+*       _RTTCB_DefineRegions()
+*
+*  Function description
+*    Adds the parts of a valid control block which the target does not
+*    change to the memory cache of the selected target: header, buffer
+*    name pointers, buffer pointers and sizes. Buffer flags may be
+*    reconfigured by the application and expire after RTT_MEMCACHE_TTL,
+*    channel names are read again after the target was halted or
+*    started. Offsets are never cached.
+*
+*  Parameters
+*    pCB    Control block, valid.
+*    pData  Image of the control block.
+*/
+static void _RTTCB_DefineRegions(RTT_CB_CACHE* pCB, const unsigned char* pData) {
+  unsigned NumDesc;
+  unsigned Addr;
+  unsigned pName;
+  unsigned i;
+
+  _MEMCACHE_Define(pCB->acAccess, pCB->Address, RTTCB_OFFSET_AUP(0), RTT_CACHE_IMMUTABLE, 0u);
+  NumDesc = pCB->MaxNumUpBuffers + pCB->MaxNumDownBuffers;
+  for (i = 0u; i < NumDesc; i++) {
+    Addr = RTTCB_OFFSET_AUP_INDEX(pCB->Address, i);                    // Down descriptors follow the up descriptors
+    _MEMCACHE_Define(pCB->acAccess, RTTBUFFER_OFFSET_SNAME(Addr), RTTBUFFER_OFFSET_WROFF(0), RTT_CACHE_IMMUTABLE, 0u);
+    _MEMCACHE_Define(pCB->acAccess, RTTBUFFER_OFFSET_FLAGS(Addr), RTTBUFFER_SIZEOF_FLAGS, RTT_CACHE_TTL, RTT_MEMCACHE_TTL);
+    memcpy(&pName, pData + RTTCB_OFFSET_AUP_INDEX(0, i) + RTTBUFFER_OFFSET_SNAME(0), sizeof(unsigned));
+    if (pName != 0u) {
+      _MEMCACHE_Define(pCB->acAccess, pName, RTT_MEMCACHE_NAME_SIZE, RTT_CACHE_EVENT, 0u);
+    }
+  }
+  pCB->CacheEpoch = _pTarget->MemCache.Epoch;
+}
+
+/*********************************************************************
+*
+*       _RTTCB_GetImageSize()
+*
+*  Function description
+*    Returns the number of bytes of the control block read per poll:
+*    the complete descriptor table while the cache is valid, the header
+*    otherwise.
+*/
+static unsigned _RTTCB_GetImageSize(const RTT_CB_CACHE* pCB) {
+  if (pCB->IsValid) {
+    return RTTCB_OFFSET_ADOWN_INDEX(0, pCB->MaxNumUpBuffers, pCB->MaxNumDownBuffers);
+  }
+  return RTTCB_OFFSET_AUP(0);
+}
+
+/*********************************************************************
+*
+*       _RTTCB_Update()
+*
+*  Function description
+*    Refreshes the host side copy of the RTT control block.
+*    While the cache is valid, signature, buffer counts and all
+*    descriptors are fetched with a single bulk read, so the check is
+*    not more expensive than reading the offsets of one channel.
+*    After a detected reset the control block is re-discovered with
+*    one read of the header and one read of the descriptor table.
+*
+*  Parameters
+*    pCB    Control block cache.
+*    pImage Image of the valid control block fetched by _TARGET_Prefetch(),
+*           NULL to read it here.
+*
+*  Return value
+*    == 0 - Control block is valid, descriptors are up to date.
+*    <  0 - Control block is not (yet) initialized by the target.
+*/
+static int _RTTCB_Update(RTT_CB_CACHE* pCB, const unsigned char* pImage) {
+  unsigned char acData[RTTCB_SIZEOF_IMAGE];
+  unsigned      NumUp;
+  unsigned      NumDown;
+  unsigned      i;
+  int           r;
+
+  if (pCB->IsValid && pImage) {
+    memcpy(acData, pImage, _RTTCB_GetImageSize(pCB));
+  } else {
+    T32_GetBytes(pCB->acAccess, pCB->Address, _RTTCB_GetImageSize(pCB), acData);
+    if (_RTTCBResync) {
+      return -1;
+    }
+  }
+  //
+  // Firmware writes the ID last during SEGGER_RTT_Init(),
+  // so a matching ID implies a completely initialized control block.
+  //
+  if (memcmp(&acData[RTTCB_OFFSET_ACID(0)], _acRTTID, sizeof(_acRTTID)) != 0) {
+    _RTTCB_Invalidate(pCB, "signature changed");
+    return -1;
+  }
+  memcpy(&NumUp,   &acData[RTTCB_OFFSET_MAXNUMUPBUFFERS(0)],   sizeof(unsigned));
+  memcpy(&NumDown, &acData[RTTCB_OFFSET_MAXNUMDOWNBUFFERS(0)], sizeof(unsigned));
+  if ((NumUp == 0u) || (NumUp > RTT_CB_MAX_NUM_BUFFERS) || (NumDown > RTT_CB_MAX_NUM_BUFFERS)) {
+    _RTTCB_Invalidate(pCB, "invalid number of buffers");
+    return -1;
+  }
+  if (pCB->IsValid == 0) {
+    T32_GetBytes(pCB->acAccess, RTTCB_OFFSET_AUP(pCB->Address), (NumUp + NumDown) * RTTCB_SIZEOF_AUP, &acData[RTTCB_OFFSET_AUP(0)]);
+    if (_RTTCBResync) {
+      return -1;
+    }
+  } else if ((NumUp != pCB->MaxNumUpBuffers) || (NumDown != pCB->MaxNumDownBuffers)) {
+    _RTTCB_Invalidate(pCB, "layout changed");
+    return -1;
+  }
+  r = 0;
+  for (i = 0u; i < NumUp; i++) {
+    r |= _RTTCB_LoadDesc(&pCB->aUp[i], pCB->acAccess, RTTCB_OFFSET_AUP_INDEX(pCB->Address, i), &acData[RTTCB_OFFSET_AUP_INDEX(0, i)]);
+  }
+  for (i = 0u; i < NumDown; i++) {
+    r |= _RTTCB_LoadDesc(&pCB->aDown[i], pCB->acAccess, RTTCB_OFFSET_ADOWN_INDEX(pCB->Address, NumUp, i), &acData[RTTCB_OFFSET_ADOWN_INDEX(0, NumUp, i)]);
+  }
+  if (r != 0) {
+    _RTTCB_Invalidate(pCB, "stale buffer offsets");
+    return -1;
+  }
+  if (pCB->IsValid == 0) {
+    pCB->IsValid           = 1;
+    pCB->MaxNumUpBuffers   = NumUp;
+    pCB->MaxNumDownBuffers = NumDown;
+    Log_Print("RTT control block found at 0x%08X, %u up / %u down buffers\n", pCB->Address, NumUp, NumDown);
+  }
+  if ((_pTarget != NULL) && (pCB->CacheEpoch != _pTarget->MemCache.Epoch)) {
+    _RTTCB_DefineRegions(pCB, acData);
+  }
+  _COALESCE_Store(pCB->acAccess, pCB->Address, acData, _RTTCB_GetImageSize(pCB));  // Serves the offset reads of this step
+  return 0;
+}
+
+#ifdef ENABLE_NOTIFICATION
+/*********************************************************************
+*
+*       _RTTCB_OnBreak()
+*
+*  Function description
+*    Break notification callback. The target may have been reset or
+*    reloaded while halted, so the control block is re-validated.
+*/
+static void _RTTCB_OnBreak(int Para, uint64_t pc, uint64_t reason) {
+  USE_PARA(Para);
+  USE_PARA(pc);
+  USE_PARA(reason);
+  _MEMCACHE_OnRunStateChange();
+  _RTTCBResync = 1;
+}
+#endif
+
+/*********************************************************************
+*
+*       _WriteBlocking()
+*
+*  Function description
+*    Stores a specified number of characters in SEGGER RTT ring buffer
+*    and updates the associated write pointer which is periodically
+*    read by the host.
+*    The caller is responsible for managing the write chunk sizes as
+*    _WriteBlocking() will block until all data has been posted successfully.
+*
+*  Parameters
+*    pRing        Ring buffer to post to.
+*    pBuffer      Pointer to character array. Does not need to point to a \0 terminated string.
+*    NumBytes     Number of bytes to be stored in the SEGGER RTT control block.
+*
+*  Return value
+*    >= 0 - Number of bytes written into buffer.
+*/
+static unsigned _WriteBlocking(RTT_BUFFER_DESC* pRing, const char* pBuffer, unsigned NumBytes) {
+  unsigned NumBytesToWrite;
+  unsigned NumBytesWritten;
+  unsigned RdOff;
+  unsigned WrOff;
+  char*    pDst;
+  //
+  // Write data to buffer and handle wrap-around if necessary
+  //
+  NumBytesWritten = 0u;
+  WrOff = pRing->WrOff;
+  do {
+    RdOff = T32_GetWord(pRing->sAccess, RTTBUFFER_OFFSET_RDOFF(pRing->Addr));     // May be changed by target in the meantime
+    if (_RTTCBResync) {
+      break;                                                                      // Target reset, the ring is gone
+    }
+    if (RdOff > WrOff) {
+      NumBytesToWrite = RdOff - WrOff - 1u;
+    } else {
+      NumBytesToWrite = pRing->SizeOfBuffer - (WrOff - RdOff + 1u);
+    }
+    NumBytesToWrite = MIN(NumBytesToWrite, (pRing->SizeOfBuffer - WrOff));      // Number of bytes that can be written until buffer wrap-around
+    NumBytesToWrite = MIN(NumBytesToWrite, NumBytes);
+    pDst = (char *)(pRing->pBuffer + WrOff);
+    T32_memcpy2C(pRing->sAccess, (void*)pDst, (void*)pBuffer, NumBytesToWrite);
+    NumBytesWritten += NumBytesToWrite;
+    pBuffer         += NumBytesToWrite;
+    NumBytes        -= NumBytesToWrite;
+    WrOff           += NumBytesToWrite;
+    if (WrOff == pRing->SizeOfBuffer) {
+      WrOff = 0u;
+    }
+    T32_SetWord(pRing->sAccess, RTTBUFFER_OFFSET_WROFF(pRing->Addr), WrOff);
+    pRing->WrOff = WrOff;
+  } while (NumBytes);
+  return NumBytesWritten;
+}
+
+/*********************************************************************
+*
+*       _WriteNoCheck()
+*
+*  Function description
+*    Stores a specified number of characters in SEGGER RTT ring buffer
+*    and updates the associated write pointer which is periodically
+*    read by the host.
+*    It is callers responsibility to make sure data actually fits in buffer.
+*
+*  Parameters
+*    pRing        Ring buffer to post to.
+*    pBuffer      Pointer to character array. Does not need to point to a \0 terminated string.
+*    NumBytes     Number of bytes to be stored in the SEGGER RTT control block.
+*
+*  Notes
+*    (1) If there might not be enough space in the "Up"-buffer, call _WriteBlocking
+*/
+static void _WriteNoCheck(RTT_BUFFER_DESC* pRing, const char* pData, unsigned NumBytes) {
+  unsigned NumBytesAtOnce;
+  unsigned WrOff;
+  unsigned Rem;
+  char*    pDst;
+
+  WrOff = pRing->WrOff;
+  Rem = pRing->SizeOfBuffer - WrOff;
+  if (Rem > NumBytes) {
+    //
+    // All data fits before wrap around
+    //
+    pDst = (char *)(pRing->pBuffer + WrOff);
+    T32_memcpy2C(pRing->sAccess, (void*)pDst, (void*)pData, NumBytes);
+    WrOff += NumBytes;
+  } else {
+    //
+    // We reach the end of the buffer, so need to wrap around
+    //
+    NumBytesAtOnce = Rem;
+    pDst = (char *)(pRing->pBuffer + WrOff);
+    T32_memcpy2C(pRing->sAccess, (void*)pDst, (void*)pData, NumBytesAtOnce);
+    NumBytesAtOnce = NumBytes - Rem;
+    pDst = (char *)pRing->pBuffer;
+    T32_memcpy2C(pRing->sAccess, (void*)pDst, (void*)(pData + Rem), NumBytesAtOnce);
+    WrOff = NumBytesAtOnce;
+  }
+  T32_SetWord(pRing->sAccess, RTTBUFFER_OFFSET_WROFF(pRing->Addr), WrOff);
+  pRing->WrOff = WrOff;
+}
+
+/*********************************************************************
+*
+*       _GetAvailWriteSpace()
+*
+*  Function description
+*    Returns the number of bytes that can be written to the ring
+*    buffer without blocking.
+*
+*  Parameters
+*    pRing        Ring buffer to check.
+*
+*  Return value
+*    Number of bytes that are free in the buffer.
+*/
+static unsigned _GetAvailWriteSpace(RTT_BUFFER_DESC* pRing) {
+  unsigned RdOff;
+  unsigned WrOff;
+  unsigned r;
+  //
+  // WrOff of a down buffer is owned by the host, only RdOff has to be
+  // fetched from the target.
+  //
+  RdOff = T32_GetWord(pRing->sAccess, RTTBUFFER_OFFSET_RDOFF(pRing->Addr));
+  WrOff = pRing->WrOff;
+  if (RdOff <= WrOff) {
+    r = pRing->SizeOfBuffer - 1u - WrOff + RdOff;
+  } else {
+    r = RdOff - WrOff - 1u;
+  }
+  return r;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       SEGGER_RTT_ReadUpBufferNoLock()
+*
+*  Function description
+*    Reads characters from SEGGER real-time-terminal control block
+*    which have been previously stored by the application.
+*    Do not lock against interrupts and multiple access.
+*    Used to do the same operation that J-Link does, to transfer
+*    RTT data via other channels, such as TCP/IP or UART.
+*
+*  Parameters
+*    pCB          Cached control block, updated by _RTTCB_Update().
+*    BufferIndex  Index of Up-buffer to be used.
+*    pBuffer      Pointer to buffer provided by target application, to copy characters from RTT-up-buffer to.
+*    BufferSize   Size of the target application buffer.
+*
+*  Return value
+*    Number of bytes that have been read.
+*
+*  Additional information
+*    This function must not be called when J-Link might also do RTT.
+*/
+unsigned SEGGER_RTT_ReadUpBufferNoLock(RTT_CB_CACHE* pCB, unsigned BufferIndex, void* pData, unsigned BufferSize) {
+  unsigned                NumBytesRem;
+  unsigned                NumBytesRead;
+  unsigned                RdOff;
+  unsigned                WrOff;
+  RTT_BUFFER_DESC*        pRing;
+  unsigned char*          pBuffer;
+           char*          pSrc;
+
+  if ((pCB->IsValid == 0) || (BufferIndex >= pCB->MaxNumUpBuffers)) {
+    return 0u;
+  }
+  pRing = &pCB->aUp[BufferIndex];
+  if (pRing->SizeOfBuffer == 0u) {
+    return 0u;
+  }
+  pBuffer = (unsigned char*)pData;
+  //
+  // RdOff of an up buffer is owned by the host, only WrOff has to be
+  // fetched from the target.
+  //
+  RdOff = pRing->RdOff;
+  WrOff = T32_GetWord(pRing->sAccess, RTTBUFFER_OFFSET_WROFF(pRing->Addr));
+  if (_RTTCBResync || (WrOff >= pRing->SizeOfBuffer)) {
+    _RTTCBResync = 1;
+    return 0u;
+  }
+  //
+  // Read from current read position to wrap-around of buffer, first
+  //
+  NumBytesRead = 0u;
+  pSrc         = (char *)(pRing->pBuffer + RdOff);
+  if (RdOff > WrOff) {
+    NumBytesRead = pRing->SizeOfBuffer - RdOff;
+    NumBytesRead = MIN(NumBytesRead, BufferSize);
+    BufferSize  -= NumBytesRead;
+    RdOff       += NumBytesRead;
+    //
+    // Handle wrap-around of buffer
+    //
+    if (RdOff == pRing->SizeOfBuffer) {
+      RdOff = 0u;
+    }
+  }
+  //
+  // Read remaining items of buffer. Both parts are fetched together.
+  //
+  NumBytesRem = WrOff - RdOff;
+  NumBytesRem = MIN(NumBytesRem, BufferSize);
+  T32_memcpy2P2(pRing->sAccess, pBuffer, (void*)pSrc, NumBytesRead,
+                pBuffer + NumBytesRead, (void*)(pRing->pBuffer + RdOff), NumBytesRem);
+  NumBytesRead += NumBytesRem;
+  RdOff        += NumBytesRem;
+  if (_RTTCBResync) {
+    return 0u;                                      // Data read during a reset is not trustworthy
+  }
+  //
+  // Update read offset of buffer
+  //
+  if (NumBytesRead) {
+    T32_SetWord(pRing->sAccess, RTTBUFFER_OFFSET_RDOFF(pRing->Addr), RdOff);
+    pRing->RdOff = RdOff;
+  }
+  pRing->WrOff = WrOff;
+  //
+  return NumBytesRead;
+}
+
+/*********************************************************************
+*
+*       SEGGER_RTT_WriteDownBufferNoLock
+*
+*  Function description
+*    Stores a specified number of characters in SEGGER RTT
+*    control block inside a <Down> buffer.
+*    SEGGER_RTT_WriteDownBufferNoLock does not lock the application.
+*    Used to do the same operation that J-Link does, to transfer
+*    RTT data from other channels, such as TCP/IP or UART.
+*
+*  Parameters
+*    pCB          Cached control block, updated by _RTTCB_Update().
+*    BufferIndex  Index of "Down"-buffer to be used.
+*    pBuffer      Pointer to character array. Does not need to point to a \0 terminated string.
+*    NumBytes     Number of bytes to be stored in the SEGGER RTT control block.
+*
+*  Return value
+*    Number of bytes which have been stored in the "Down"-buffer.
+*
+*  Notes
+*    (1) Data is stored according to buffer flags.
+*    (2) For performance reasons this function does not call Init()
+*        and may only be called after RTT has been initialized.
+*        Either by calling SEGGER_RTT_Init() or calling another RTT API function first.
+*
+*  Additional information
+*    This function must not be called when J-Link might also do RTT.
+*/
+unsigned SEGGER_RTT_WriteDownBufferNoLock(RTT_CB_CACHE* pCB, unsigned BufferIndex, const void* pBuffer, unsigned NumBytes) {
+  unsigned                Status;
+  unsigned                Avail;
+  const char*             pData;
+  RTT_BUFFER_DESC*        pRing;
+  //
+  // Get "to-target" ring buffer.
+  // It is save to cast that to a "to-host" buffer. Up and Down buffer differ in volatility of offsets that might be modified by J-Link.
+  //
+  if ((pCB->IsValid == 0) || (BufferIndex >= pCB->MaxNumDownBuffers)) {
+    return 0u;
+  }
+  pRing = &pCB->aDown[BufferIndex];
+  if (pRing->SizeOfBuffer == 0u) {
+    return 0u;
+  }
+  pData = (const char *)pBuffer;
+  //
+  // How we output depends upon the mode...
+  //
+  switch (pRing->Flags & SEGGER_RTT_MODE_MASK) {
+  case SEGGER_RTT_MODE_NO_BLOCK_SKIP:
+    //
+    // If we are in skip mode and there is no space for the whole
+    // of this output, don't bother.
+    //
+    Avail = _GetAvailWriteSpace(pRing);
+    if (Avail < NumBytes) {
+      Status = 0u;
+    } else {
+      Status = NumBytes;
+      _WriteNoCheck(pRing, pData, NumBytes);
+    }
+    break;
+  case SEGGER_RTT_MODE_NO_BLOCK_TRIM:
+    //
+    // If we are in trim mode, trim to what we can output without blocking.
+    //
+    Avail = _GetAvailWriteSpace(pRing);
+    Status = Avail < NumBytes ? Avail : NumBytes;
+    _WriteNoCheck(pRing, pData, Status);
+    break;
+  case SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL:
+    //
+    // If we are in blocking mode, output everything.
+    //
+    Status = _WriteBlocking(pRing, pData, NumBytes);
+    break;
+  default:
+    Status = 0u;
+    break;
+  }
+  //
+  // Finish up.
+  //
+  return _RTTCBResync ? 0u : Status;
+}
+
+/*********************************************************************
+*
+*       SEGGER_RTT_GetBytesInBuffer()
+*
+*  Function description
+*    Returns the number of bytes currently used in the up buffer.
+*    Uses the offsets of the last control block update, no target
+*    access is done.
+*
+*  Parameters
+*    pCB          Cached control block, updated by _RTTCB_Update().
+*    BufferIndex  Index of the up buffer.
+*
+*  Return value
+*    Number of bytes that are used in the buffer.
+*/
+unsigned SEGGER_RTT_GetBytesInBuffer(RTT_CB_CACHE* pCB, unsigned BufferIndex) {
+  unsigned RdOff;
+  unsigned WrOff;
+  unsigned r;
+
+  if ((pCB->IsValid == 0) || (BufferIndex >= pCB->MaxNumUpBuffers)) {
+    return 0u;
+  }
+  RdOff = pCB->aUp[BufferIndex].RdOff;
+  WrOff = pCB->aUp[BufferIndex].WrOff;
+  if (RdOff <= WrOff) {
+    r = WrOff - RdOff;
+  } else {
+    r = pCB->aUp[BufferIndex].SizeOfBuffer - RdOff + WrOff;
+  }
+  return r;
+}
+
+/*********************************************************************
+*
+*       SEGGER_Terminal_GetChannelID()
+*
+*  Function description
+*    Returns the RTT <Up> / <Down> channel ID used by Terminal.
+*/
+int SEGGER_Terminal_GetChannelID(void) {
+  return 0;
+}
+
+/*********************************************************************
+*
+*       init functions
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       SIGNAL_HandlerInit()
+*
+*  Function description
+*    This is NOP crash handler. Just to make things compiling if
+*    you don't have a real crash handler on your OS.
+*/
+static int SIGNAL_HandlerInit(void) {
+  signal(SIGINT  , SYS_ExitHandler);
+  signal(SIGTERM , SYS_ExitHandler);
+  signal(SIGILL  , SYS_ExitHandler);
+  signal(SIGFPE  , SYS_ExitHandler);
+  signal(SIGSEGV , SYS_ExitHandler);
+#ifdef _WIN32
+  signal(SIGBREAK, SYS_ExitHandler);
+#endif
+  signal(SIGABRT , SYS_ExitHandler);
+#ifdef SIGUSR1
+  signal(SIGUSR1 , SYS_ApiStatsHandler);
+#endif
+  return 0;
+}
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _WSAStartup
+*
+*  Function description
+*    Initializes Winsock API. Needs to be called once before using any socket API.
+*    May be called multiple times.
+*/
+static void _WSAStartup(void) {
+  WORD    wVersionRequested;
+  WSADATA wsaData;
+  //
+  // Init Winsock API
+  //
+  wVersionRequested = MAKEWORD(2, 2);
+  WSAStartup(wVersionRequested, &wsaData);
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _WSACleanup
+*
+*  Function description
+*    Cleans up Winsock API. WSACleanup() needs to be called as many times
+*    as WSAStartup() if socket API is no longer needed.
+*/
+static void _WSACleanup(void) {
+  WSACleanup();
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_OpenUDP
+*
+*  Function description
+*    Creates an IPv4 TCP socket.
+*
+*  Return value
+*    Handle to socket
+*/
+static _SYS_SOCKET_HANDLE _SYS_SOCKET_OpenUDP(void) {
+  _SYS_SOCKET_HANDLE sock;
+  //
+  // Create socket
+  //
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock != INVALID_SOCKET) {
+    return (_SYS_SOCKET_HANDLE)sock;
+  } else {
+    return _SYS_SOCKET_INVALID_HANDLE;
+  }
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_IPV6_OpenUDP
+*
+*  Function description
+*    Creates an IPv4 TCP socket.
+*
+*  Return value
+*    Handle to socket
+*/
+static _SYS_SOCKET_HANDLE _SYS_SOCKET_IPV6_OpenUDP(char DualStack) {
+  _SYS_SOCKET_HANDLE sock;
+  //
+  // Create socket
+  //
+  sock = socket(AF_INET6, SOCK_DGRAM, 0);
+  if (sock != INVALID_SOCKET && DualStack) {
+    //
+    // Disable Nagle's algorithm to speed things up
+    // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
+    //
+    setsockopt(sock, IPPROTO_IPV6, TCP_CC_INFO, (char*)&_int1, sizeof(int));
+  } else {
+    return _SYS_SOCKET_INVALID_HANDLE;
+  }
+  return (_SYS_SOCKET_HANDLE)sock;
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_OpenTCP
+*
+*  Function description
+*    Creates an IPv4 TCP socket.
+*
+*  Return value
+*    Handle to socket
+*/
+static _SYS_SOCKET_HANDLE _SYS_SOCKET_OpenTCP(void) {
+  SOCKET sock;
+  //
+  // Init Winsock API as this is the first socket-related function being called
+  // WSACleanup is called on SocketClose()
+  //
+  _WSAStartup();
+  //
+  // Create socket
+  //
+  sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock != INVALID_SOCKET) {
+    //
+    // Disable Nagle's algorithm to speed things up
+    // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
+    //
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
+  } else {
+    return _SYS_SOCKET_INVALID_HANDLE;
+  }
+  return (_SYS_SOCKET_HANDLE)sock;
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_OpenTCP
+*
+*  Function description
+*    Creates an IPv4 TCP socket.
+*
+*  Return value
+*    Handle to socket
+*/
+static _SYS_SOCKET_HANDLE SYS_SOCKET_IPV6_OpenTCP(char DualStack) {
+  _SYS_SOCKET_HANDLE sock;
+  //
+  // Create socket
+  //
+  sock = socket(AF_INET6, SOCK_STREAM, 0);
+  if (sock == INVALID_SOCKET) {
+    return _SYS_SOCKET_INVALID_HANDLE;
+  }
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
+  if (!DualStack) {
+    return (_SYS_SOCKET_HANDLE)sock;
+  }
+  setsockopt(sock, IPPROTO_IPV6, TCP_CC_INFO, (char*)&_int1, sizeof(int));
+  return (_SYS_SOCKET_HANDLE)sock;
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_OpenTCP
+*
+*  Function description
+*    Creates an IPv4 TCP socket.
+*
+*  Return value
+*    Handle to socket
+*/
+static _SYS_SOCKET_HANDLE _SYS_SOCKET_OpenTCP(void) {
+  _SYS_SOCKET_HANDLE sock;
+  //
+  // Create socket
+  //
+  sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock != INVALID_SOCKET) {
+    //
+    // Disable Nagle's algorithm to speed things up
+    // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
+    //
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
+  } else {
+    return _SYS_SOCKET_INVALID_HANDLE;
+  }
+  return (_SYS_SOCKET_HANDLE)sock;
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_Close
+*
+*  Function description
+*    Closes a socket. Resources allocated by this socket are freed.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*/
+static void _SYS_SOCKET_Close(_SYS_SOCKET_HANDLE hSocket) {
+  SOCKET Sock;
+  int OptVal;
+  int OptLen;
+  //
+  // MSDN: A socket that is using the SO_EXCLUSIVEADDRUSE option must be shut down properly prior to closing it. Failure to do so can cause a denial of service attack if the associated service needs to restart.
+  //
+  Sock = (SOCKET)hSocket;
+  OptLen = 4;
+  OptVal = 0;  // Make sure it is zero initialized in case getsockopt does not fill it completely
+  getsockopt(Sock, SOL_SOCKET, -5, (char*)&OptVal, &OptLen);  // SO_EXCLUSIVEADDRUSE (Define not known in the VC6 headers, we use...)
+  if (OptVal) {
+    shutdown(Sock, SD_BOTH);
+  }
+  //
+  // Close socket
+  //
+  closesocket(Sock);
+  //
+  // De-init Winsock API. Needs to be called as often as WSAStartup() has been called
+  // Has an internal reference counter
+  // If the counter reaches 0, all sockets opened by the process, are forced closed
+  //
+  _WSACleanup();
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_Close
+*
+*  Function description
+*    Closes a socket. Resources allocated by this socket are freed.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*/
+static void _SYS_SOCKET_Close(_SYS_SOCKET_HANDLE hSocket) {
+  //
+  // Close socket
+  //
+  close(hSocket);
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_Shutdown
+*
+*  Function description
+*    Closes a socket. Resources allocated by this socket are freed.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*/
+static void _SYS_SOCKET_Shutdown (_SYS_SOCKET_HANDLE hSocket, int How) {
+  _SYS_SOCKET_HANDLE Sock;
+  int r;
+
+  Sock = (_SYS_SOCKET_HANDLE)hSocket;
+  r    = How;
+
+  switch (r) {
+    case _SYS_SOCKET_SHUT_RD:
+      shutdown(Sock, 0);
+    case _SYS_SOCKET_SHUT_WR:
+      shutdown(Sock, 1);
+    case _SYS_SOCKET_SHUT_RDWR:
+      shutdown(Sock, 2);
+  }
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       SYS_SOCKET_SetTimeouts
+*
+*  Function description
+*    Closes a socket. Resources allocated by this socket are freed.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*/
+int SYS_SOCKET_SetTimeouts(int hSocket, int TimeoutSend, int TimeoutReceive) {
+  struct timeval timeout;
+
+  timeout.tv_sec  = TimeoutSend / 1000;
+  timeout.tv_usec = (TimeoutSend % 1000) * 1000;
+  setsockopt(hSocket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  timeout.tv_sec  = TimeoutReceive / 1000;
+  timeout.tv_usec = (TimeoutReceive % 1000) * 1000;
+  return setsockopt(hSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       SYS_SOCKET_DisableLinger
+*
+*  Function description
+*    Closes a socket. Resources allocated by this socket are freed.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*/
+int SYS_SOCKET_DisableLinger(_SYS_SOCKET_HANDLE hSocket) {
+  struct linger  so_linger;
+
+  so_linger.l_onoff  = 0;
+  so_linger.l_linger = 0;
+
+  return setsockopt(hSocket, SOL_SOCKET, SO_LINGER, &so_linger, sizeof(so_linger));
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       SYS_SOCKET_EnableLinger
+*
+*  Function description
+*    Closes a socket. Resources allocated by this socket are freed.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*/
+int SYS_SOCKET_EnableLinger(_SYS_SOCKET_HANDLE hSocket, int TimeoutLinger) {
+
+  struct linger  so_linger;
+  int timeout;
+
+  timeout = 0;
+  if (TimeoutLinger) {
+    timeout = 1;
+    if (TimeoutLinger > 999)
+      timeout = (TimeoutLinger + 500) / 1000;
+  }
+  so_linger.l_onoff  = 1;
+  so_linger.l_linger = timeout;
+  setsockopt(hSocket, SOL_SOCKET, SO_LINGER, &so_linger, sizeof(so_linger));
+  return 0;
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_ListenAtTCPAddr
+*
+*  Function description
+*    Puts IPv4 socket into listening state.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    IPAddr   IPv4 address expected in little endian form, meaning 127.0.0.1 is expected as 0x7F000001
+*             To accept connections from any IP address, pass _SYS_SOCKET_IP_ADDR_ANY
+*    Port     Port to listen at
+*
+*  Return value
+*    >= 0: O.K.
+*     < 0: Error
+*/
+static int _SYS_SOCKET_ListenAtTCPAddr(_SYS_SOCKET_HANDLE hSocket, unsigned IPAddr, unsigned Port, unsigned NumConnectionsQueued) {
+  struct sockaddr_in addr;
+  SOCKET Sock;
+  int r;
+  //
+  // Option SO_REUSEADDR:
+  //
+  // <IPAddr>: IP addresses of network adapters
+  //
+  // ==================================================
+  // Original idea from BSD sockets
+  // ==================================================
+  // bind() without SO_REUSEADDR set (default):
+  // bind(SockA, 0.0.0.0:21)
+  // bind(SockB, 192.168.0.1:21)
+  // SockB will fail because <IPAddr> of SockA is a wildcard that means "Any local address",
+  // so it is not possible to bind to any other local address with the same port.
+  // bind(SockA, 127.0.0.1:21)
+  // bind(SockB, 192.168.0.1:21)
+  // Both calls will succeed, as different <IPAddr>:<Port> combinations are used.
+  //
+  // bind() with SO_REUSEADDR set:
+  // bind(SockA, 0.0.0.0:21)
+  // bind(SockB, 192.168.0.1:21)
+  // SockA and SockB will succeed.
+  // The original idea includes that *each* of the sockets must have SO_REUSEADDR set before bind().
+  // If only the second one calls it, bind() will fail as the first socket did not allow sharing at all.
+  //
+  // This was the original idea of SO_REUSEADDR.
+  // NOTE: Not sure who really ever needed this, but that's the way it is...
+  //
+  // ==================================================
+  // Second effect of SO_REUSEADDR (TIME_WAIT)
+  // ==================================================
+  // There is another case where this option has an effect on:
+  // Calls to send() do not guarantee that data is sent when the function returns. It may be sent delayed.
+  // Therefore, it is possible that when calling close() to close a socket, send data is still pending.
+  // What the OS does is: preparing everything for closing the connection and return from close().
+  // Now the socket changed it's state from ACTIVE to TIME_WAIT but still exists inside the OS (not accessible for the user anymore)
+  // If now a new socket is opened and a bind() is performed on exactly the <IPAddr>:<Port> combination of the TIME_WAIT socket, the behavior depends on if the original socket had SO_REUSEADDR set.
+  //
+  // SO_REUSEADDR not set:
+  // bind() will fail as TIME_WAIT is handled as if it is ACTIVE
+  //
+  // SO_REUSEADDR set:
+  // bind() will succeed as TIME_WAIT is handled as if socket was not existing anymore.
+  // NOTE: Under rare circumstances, it now can happen that if there is any receive data arriving late at the system, the new socket that did the bind(), will receive it.
+  //
+  // ==================================================
+  // OS specifics
+  // ==================================================
+  //
+  // Windows:
+  // When specifying SO_REUSEADDR before bind(), Windows will report SUCCESS on bind(),
+  // even if there is another ACTIVE socket that is bound to the same <IPAddr>:<Port> combination.
+  // It does not matter if the process that did the first bind() did specify SO_REUSEADDR for its socket or not
+  // This allows processes to steal data from other ones...pretty awful bug in Windows... (See MSDN: Using SO_REUSEADDR and SO_EXCLUSIVEADDRUSE)
+  // Microsoft introduced SO_EXCLUSIVEADDRUSE for this.
+  // This makes sure hijacking the socket data is not possible.
+  // But it still allows the special behavior in case a bind() to a closed socket in TIME_WAIT state is possible. (See "Second effect of SO_REUSEADDR (TIME_WAIT)" above)
+  //
+  // MSDN: A socket that is using the SO_EXCLUSIVEADDRUSE option must be shut down properly prior to closing it. Failure to do so can cause a denial of service attack if the associated service needs to restart.
+  //
+  // Linux:
+  // Listening socket:
+  // SO_REUSEADDR does not have any effect for the "original idea" (see above). Linux is more restrictive than BSD sockets here.
+  // But it has the desired effect on closed sockets in TIME_WAIT state (see above).
+  //
+  // Client socket:
+  // Behaves like the original BSD idea and has the TIME_WAIT effect
+  //
+  // Kernel >= 3.9: To have "original idea" effect for listening sockets, since kernel 3.9 SO_REUSEPORT has been introduced.
+  //
+  // Normal TCP connection close:
+  // Client1 (C1), Client2 (C2)
+  // C1 -> C2  FIN
+  // C1 <- C2  ACK
+  // C1 <- C2  FIN
+  // C1 -> C2  ACK
+  // Socket of C1 (as the initiator of the close request) now is in TIME_WAIT state and can stay there several seconds/minutes
+  // so the <IPAddr>:<Port> combination is blocked for some time, after the socket has been closed
+  // As this is not acceptable for us as the DLL and other J-Link utilities must be able to be started / terminated multiple times in a row,
+  // we make use of SO_REUSEADDR for all of our listener sockets which need to bind() to a specific port
+  //
+  Sock = (SOCKET)hSocket;
+  r = setsockopt(Sock, SOL_SOCKET, -5, (char*)&_int1, sizeof(int));  // SO_EXCLUSIVEADDRUSE (Define not known in the VC6 headers, we use...)
+  if (r == 0) {
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons((unsigned short)Port);
+    addr.sin_addr.s_addr = htonl(IPAddr);
+    r = bind(Sock, (struct sockaddr*)&addr, sizeof(addr));
+    if (r == 0) {
+      r = listen(Sock, NumConnectionsQueued);
+    }
+    if (r) {
+      r = -1;
+    }
+  } else {
+    r = -1;
+  }
+  return r;
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_ListenAtTCPAddr
+*
+*  Function description
+*    Puts IPv4 socket into listening state.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    IPAddr   IPv4 address expected in little endian form, meaning 127.0.0.1 is expected as 0x7F000001
+*             To accept connections from any IP address, pass _SYS_SOCKET_IP_ADDR_ANY
 *    Port     Port to listen at
 *
-*  Return value
-*    >= 0: O.K.
-*     < 0: Error
+*  Return value
+*    >= 0: O.K.
+*     < 0: Error
+*/
+static int _SYS_SOCKET_ListenAtTCPAddr(_SYS_SOCKET_HANDLE hSocket, unsigned IPAddr, unsigned Port, unsigned NumConnectionsQueued) {
+  _SYS_SOCKET_HANDLE Sock;
+  struct sockaddr_in addr;
+  int r;
+
+  Sock = (_SYS_SOCKET_HANDLE)hSocket;
+  r = setsockopt(Sock, SOL_SOCKET, SO_REUSEADDR, (char*)&_int1, sizeof(int));
+  if (r == 0) {
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons((unsigned short)Port);
+    addr.sin_addr.s_addr = htonl(IPAddr);
+    r = bind(Sock, (struct sockaddr*)&addr, sizeof(addr));
+    if (r == 0) {
+      r = listen(Sock, NumConnectionsQueued);
+    }
+    if (r) {
+      r = -1;
+    }
+  } else {
+    r = -1;
+  }
+  return r;
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_IsReadable
+*
+*  Function description
+*    Checks if a socket that has been connected with _SYS_SOCKET_Connect() is readable.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*
+*  Return value
+*    == 1  O.K., socket readable
+*    == 0  O.K., socket not readable yet
+*     < 0  Error
+*/
+static int _SYS_SOCKET_IsReadable(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
+  SOCKET Sock;
+  struct timeval tv;
+  fd_set rfds;
+  fd_set efds;
+  int v;
+  //
+  //
+  // Two possible cases when opening a TCP connection:
+  // 1) On the other side, there is a server listening on the destination port
+  // 2) On the other side, there is NO server listening on the destination port
+  //
+  // Reg 1)
+  //   In such cases, the socket is reported non-writable for a few [us] up to a few [s] depending on if this is a localhost, LAN or internet connection
+  //   After that period, the socket is reported as writable
+  //
+  // Reg 2)
+  //   In such cases, the following happens (S = Server):
+  //   C -> S: SYN
+  //   S -> C: RST ACK
+  //   This means, the server has rejected the connection and closed it
+  //   In such a case, we need to close the socket and try connecting again
+  //
+  // However, Windows is difficult regarding 2)...
+  // Usually an RST means "it's over, you can close the socket. There is nobody listening"
+  // Windows keeps the socket in connecting state, so IsReadable() IsWriteable() simply returns 0 instead of 1 (which would allow a following send/receive to return with error)
+  // In the background, Windows performs the SYN sending another 3 times in intervals of 500ms before giving up and reporting an error state
+  // Usually, the retransmissions are there in case we do not get an ACK from the other side and therefore must assume that the packet got lost
+  // Then also the interval time is doubled for each retransmission
+  // However, Microsoft decided to also retry it in case of RST ACK but without increasing the interval time
+  // This is explained here: https://support.microsoft.com/en-in/help/175523/info-winsock-tcp-connection-performance-to-unused-ports
+  //
+  // Unfortunately, even after this 1.5 seconds, Windows not necessarily reports the socket as readable/writable but instead returns "exceptional state" on select()
+  // Therefore, we also pass the "exceptional state" structure to select() to catch this case
+  //
+  Sock = (SOCKET)hSocket;
+  FD_ZERO(&rfds);       // Zero init file descriptor list
+  FD_SET(Sock, &rfds);  // Add socket to file descriptor list to be monitored by select()
+  FD_ZERO(&efds);
+  FD_SET(Sock, &efds);
+  tv.tv_sec = (long)(TimeoutMs / 1000);
+  tv.tv_usec = (TimeoutMs % 1000) * 1000;
+  v = select(0, &rfds, NULL, &efds, &tv);   // > 0: in case of success, == 0: Timeout, < 0: Error
+  return v;
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_IsReadable
+*
+*  Function description
+*    Checks if a socket that has been connected with _SYS_SOCKET_Connect() is readable.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*
+*  Return value
+*    == 1  O.K., socket readable
+*    == 0  O.K., socket not readable yet
+*     < 0  Error
+*/
+static int _SYS_SOCKET_IsReadable(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
+  struct pollfd Fd;
+  int v;
+
+  Fd.fd      = hSocket;   // poll() has no FD_SETSIZE limit on the descriptor number, unlike select()
+  Fd.events  = POLLIN;
+  Fd.revents = 0;
+  v = poll(&Fd, 1, TimeoutMs);   // > 0: in case of success, == 0: Timeout, < 0: Error
+  return v;
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_AcceptEx
+*
+*  Function description
+*    Waits for a connection (with timeout) on the given socket.
+*
+*  Parameters
+*    hSocket   Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    TimeoutMs Timeout in ms for waiting
+*
+*  Return value
+*    >= 0  Handle to socket of new connection that has been established
+*     < 0  Error   (_SYS_SOCKET_INVALID_HANDLE)
+*      -2  Timeout
+*/
+static _SYS_SOCKET_HANDLE _SYS_SOCKET_AcceptEx(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
+  SOCKET SockChild;
+  int r;
+  //
+  // accept() itself does not allow using timeouts
+  // Therefore we check readability first and then call accept() which should not block then
+  //
+  r = _SYS_SOCKET_IsReadable(hSocket, TimeoutMs);
+  if (r < 0) {
+    return _SYS_SOCKET_INVALID_HANDLE; // error
+  } else if (r == 0) {
+    return -2;                        // timeout
+  } else {
+    SockChild = accept((SOCKET)hSocket, NULL, NULL);
+    if (SockChild != INVALID_SOCKET) {
+      //
+      // If connection is successfully established, handle it as an implicit open(), so also init Winsock API as WSACleanup() is called on SocketClose()
+      // No matter if the socket has been opened via open() or accept()
+      //
+      _WSAStartup();
+      //
+      // Disable Nagle's algorithm to speed things up
+      // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
+      //
+      setsockopt(SockChild, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
+    } else {
+      return _SYS_SOCKET_INVALID_HANDLE;
+    }
+  }
+  return (_SYS_SOCKET_HANDLE)SockChild;
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_Accept
+*
+*  Function description
+*    Waits for a connection on the given socket.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*
+*  Return value
+*    Handle to socket of new connection that has been established
+*/
+_SYS_SOCKET_HANDLE _SYS_SOCKET_Accept(_SYS_SOCKET_HANDLE hSocket) {
+  _SYS_SOCKET_HANDLE SockChild;
+
+  SockChild = accept((_SYS_SOCKET_HANDLE)hSocket, NULL, NULL);
+  if (SockChild != INVALID_SOCKET) {
+    //
+    // Disable Nagle's algorithm to speed things up
+    // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
+    //
+    setsockopt(SockChild, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
+  } else {
+    return _SYS_SOCKET_INVALID_HANDLE;
+  }
+  return (_SYS_SOCKET_HANDLE)SockChild;
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_AcceptEx
+*
+*  Function description
+*    Waits for a connection (with timeout) on the given socket.
+*
+*  Parameters
+*    hSocket   Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    TimeoutMs Timeout in ms for waiting
+*
+*  Return value
+*    >= 0  Handle to socket of new connection that has been established
+*     < 0  Error   (_SYS_SOCKET_INVALID_HANDLE)
+*      -2  Timeout
+*/
+static _SYS_SOCKET_HANDLE _SYS_SOCKET_AcceptEx(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
+  _SYS_SOCKET_HANDLE SockChild;
+  struct sockaddr_in  sockAddr;
+  char ipStr[64];
+  int r;
+  int len;
+  //
+  // accept() itself does not allow using timeouts
+  // Therefore we check readability first and then call accept() which should not block then
+  //
+  len = sizeof(struct sockaddr_in);
+  r = _SYS_SOCKET_IsReadable(hSocket, TimeoutMs);
+  if (r < 0) {
+    return _SYS_SOCKET_INVALID_HANDLE; // error
+  } else if (r == 0) {
+    return -2;                        // timeout
+  } else {
+    SockChild = accept(hSocket, (struct sockaddr*)&sockAddr, (socklen_t *)&len);
+    if (SockChild != INVALID_SOCKET) {
+      //
+      // Disable Nagle's algorithm to speed things up
+      // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
+      //
+      setsockopt(SockChild, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
+    } else {
+      return _SYS_SOCKET_INVALID_HANDLE;
+    }
+  }
+  Log_Print("connect client ip: %s\t port: %d\n", inet_ntop(AF_INET, &sockAddr.sin_addr.s_addr, ipStr, sizeof(ipStr)), ntohs(sockAddr.sin_port));
+  return (_SYS_SOCKET_HANDLE)SockChild;
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_Receive
+*
+*  Function description
+*    Receives data on the given socket.
+*
+*  Parameters
+*    hSocket          Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*
+*  Return value
+*    >= 0:  O.K., number of bytes received
+*     < 0:  Error, see _SYS_SOCKET_ERR_*
+*
+*  Notes
+*    (1) Returns as soon as something has been received (may be less than MaxNumBytes) or error happened
+*/
+static int _SYS_SOCKET_Receive(_SYS_SOCKET_HANDLE hSocket, void* pData, unsigned MaxNumBytes) {
+  int r;
+  int Err;
+  SOCKET Sock;
+
+  Sock = (SOCKET)hSocket;
+  r = recv(Sock, (char*)pData, MaxNumBytes, 0);
+  if (r < 0) {
+    Err = WSAGetLastError();
+    switch (Err) {
+    case WSAEWOULDBLOCK:
+      r = _SYS_SOCKET_ERR_WOULDBLOCK;
+      break;
+    case WSAECONNRESET:
+      r = _SYS_SOCKET_ERR_CONNRESET;
+      break;
+    case WSAETIMEDOUT:
+      r = _SYS_SOCKET_ERR_TIMEDOUT;
+      break;
+    default:
+      r = _SYS_SOCKET_ERR_UNSPECIFIED;
+    }
+  }
+  return r;
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_Receive
+*
+*  Function description
+*    Receives data on the given socket.
+*
+*  Parameters
+*    hSocket          Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*
+*  Return value
+*    >= 0:  O.K., number of bytes received
+*     < 0:  Error, see _SYS_SOCKET_ERR_*
+*
+*  Notes
+*    (1) Returns as soon as something has been received (may be less than MaxNumBytes) or error happened
+*/
+static int _SYS_SOCKET_Receive(_SYS_SOCKET_HANDLE hSocket, void* pData, unsigned MaxNumBytes) {
+  int r;
+  int Err;
+  _SYS_SOCKET_HANDLE Sock;
+
+  Sock = (_SYS_SOCKET_HANDLE)hSocket;
+  r = recv(Sock, (char*)pData, MaxNumBytes, 0);
+  if (r < 0) {
+    Err = errno;
+    switch (Err) {
+#if EAGAIN != EWOULDBLOCK
+    case EAGAIN:
+#endif
+    case EWOULDBLOCK:
+      r = _SYS_SOCKET_ERR_WOULDBLOCK;
+      break;
+    case ENETRESET:
+    case ECONNRESET:
+      r = _SYS_SOCKET_ERR_CONNRESET;
+      break;
+    case ETIMEDOUT:
+      r = _SYS_SOCKET_ERR_TIMEDOUT;
+      break;
+    default:
+      r = _SYS_SOCKET_ERR_UNSPECIFIED;
+    }
+  }
+  return r;
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       SYS_SOCKET_Connect
+*
+*  Function description
+*    Connects a given IPv4 socket.
+*
+*  Parameters
+*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    IPAddr   IPv4 address expected in little endian form, meaning 127.0.0.1 is expected as 0x7F000001
+*    Port     Port to connect to
+*
+*  Notes
+*    (1) Returns immediately in case the socket has been configured as non-blocking. In this case, SYS_SOCKET_IsReady() needs to be called afterwards to make sure that the socket is ready
 */
-static int _SYS_SOCKET_ListenAtTCPAddr(_SYS_SOCKET_HANDLE hSocket, unsigned IPAddr, unsigned Port, unsigned NumConnectionsQueued) {
+int _SYS_SOCKET_Connect(_SYS_SOCKET_HANDLE hSocket, unsigned IPAddr, unsigned Port) {
   _SYS_SOCKET_HANDLE Sock;
   struct sockaddr_in addr;
   int r;
 
   Sock = (_SYS_SOCKET_HANDLE)hSocket;
-  r = setsockopt(Sock, SOL_SOCKET, SO_REUSEADDR, (char*)&_int1, sizeof(int));
-  if (r == 0) {
-    addr.sin_family      = AF_INET;
-    addr.sin_port        = htons((unsigned short)Port);
-    addr.sin_addr.s_addr = htonl(IPAddr);
-    r = bind(Sock, (struct sockaddr*)&addr, sizeof(addr));
-    if (r == 0) {
-      r = listen(Sock, NumConnectionsQueued);
+  addr.sin_family                = AF_INET;
+  addr.sin_port                  = htons((unsigned short)Port);
+  *(unsigned int*)&addr.sin_addr = htonl(IPAddr);
+  r = connect(Sock, (struct sockaddr *)&addr, sizeof(addr));
+  return r;
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_Send
+*
+*  Function description
+*    Sends data on the specified socket
+*
+*  Parameters
+*    hSocket          Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*
+*  Return value
+*    >= 0:  O.K., number of bytes sent
+*     < 0:  Error, see _SYS_SOCKET_ERR_*
+*/
+static int _SYS_SOCKET_Send(_SYS_SOCKET_HANDLE hSocket, const void* pData, unsigned NumBytes) {
+  int r;
+  int Err;
+  SOCKET Sock;
+
+  Sock = (SOCKET)hSocket;
+  r = send(Sock, pData, NumBytes, 0);
+  if (r == SOCKET_ERROR) {
+    Err = WSAGetLastError();
+    r = (Err == WSAEWOULDBLOCK) ? _SYS_SOCKET_ERR_WOULDBLOCK : _SYS_SOCKET_ERR_UNSPECIFIED;
+  }
+  return r;
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_Send
+*
+*  Function description
+*    Sends data on the specified socket
+*
+*  Parameters
+*    hSocket          Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*
+*  Return value
+*    >= 0:  O.K., number of bytes sent
+*     < 0:  Error, see _SYS_SOCKET_ERR_*
+*/
+static int _SYS_SOCKET_Send(_SYS_SOCKET_HANDLE hSocket, const void* pData, unsigned NumBytes) {
+  int r;
+  int Err;
+  _SYS_SOCKET_HANDLE Sock;
+
+  Sock = (_SYS_SOCKET_HANDLE)hSocket;
+  //
+  // Sending without MSG_NOSIGNAL can cause a SIGPIPE to be sent if the
+  // connection was closed by peer and our process would be killed.
+  //
+  r = send(Sock, pData, NumBytes, MSG_NOSIGNAL);
+  if (r < 0) {
+    Err = errno;
+    r = (Err == EWOULDBLOCK) ? _SYS_SOCKET_ERR_WOULDBLOCK : _SYS_SOCKET_ERR_UNSPECIFIED;
+  }
+  return r;
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_SetNonBlocking
+*
+*/
+void _SYS_SOCKET_SetNonBlocking(_SYS_SOCKET_HANDLE hSocket) {
+  int on = 1;
+  ioctlsocket(hSocket, FIONBIO, &on);
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_SetNonBlocking
+*
+*/
+void _SYS_SOCKET_SetNonBlocking(_SYS_SOCKET_HANDLE hSocket) {
+  int on = 1;
+  ioctl(hSocket, FIONBIO, &on);
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_SetBlocking
+*
+*/
+void _SYS_SOCKET_SetBlocking(_SYS_SOCKET_HANDLE hSocket) {
+  int on = 0;
+  ioctlsocket(hSocket, FIONBIO, &on);
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_SetBlocking
+*
+*/
+void _SYS_SOCKET_SetBlocking(_SYS_SOCKET_HANDLE hSocket) {
+  int on = 0;
+  ioctl(hSocket, FIONBIO, &on);
+}
+#endif
+
+#ifdef __linux__
+/*********************************************************************
+*
+*       _SYS_SOCKET_EnableKeepalive
+*
+*/
+void _SYS_SOCKET_EnableKeepalive(_SYS_SOCKET_HANDLE hSocket) {
+  int on = 1;
+  setsockopt(hSocket, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(int));
+}
+#endif
+
+#ifdef _WIN32
+/*********************************************************************
+*
+*       _SYS_SOCKET_EnableKeepalive
+*
+*/
+void _SYS_SOCKET_EnableKeepalive(_SYS_SOCKET_HANDLE hSocket) {
+  int on = 1;
+  setsockopt(hSocket, SOL_SOCKET, SO_KEEPALIVE, (char*)&on, sizeof(int));
+}
+#endif
+
+/*********************************************************************
+*
+*       T32_RTTCB_Dump()
+*
+*/
+void T32_RTTCB_Dump(const char* sAccess, unsigned int address) {
+  unsigned char _sName[16] = { 0 };
+
+  Log_Print("\n====================================T32 RTTCB Dump Start\n");
+  Log_Print("acID                  = 0x%08X\n", T32_GetWord(sAccess, RTTCB_OFFSET_ACID(address)));
+  T32_strcpy(sAccess, _sName, (char *)RTTCB_OFFSET_ACID(address));
+  Log_Print("acID                  = %s\n", _sName);
+
+  int MaxNumUpBuffers = T32_GetWord(sAccess, RTTCB_OFFSET_MAXNUMUPBUFFERS(address));
+  Log_Print("MaxNumUpBuffers       = %d\n", MaxNumUpBuffers);
+
+  int MaxNumDownBuffers = T32_GetWord(sAccess, RTTCB_OFFSET_MAXNUMDOWNBUFFERS(address));
+  Log_Print("MaxNumDownBuffers     = %d\n", MaxNumDownBuffers);
+
+  for (size_t i = 0; i < MaxNumUpBuffers; i++) {
+    unsigned int pnameaddr;
+    pnameaddr = T32_GetWord(sAccess, RTTCB_OFFSET_AUP_SNAME(address, i));
+    if (pnameaddr != 0) {
+      Log_Print("aUp[%d].sName          = 0x%08X\n", i, pnameaddr);
+      T32_strcpy(sAccess, _sName, (char *)pnameaddr);
+      Log_Print("aUp[%d].sName          = %s\n", i, _sName);
     }
-    if (r) {
-      r = -1;
+    Log_Print("aUp[%d].pBuffer        = 0x%08X\n", i, T32_GetWord(sAccess, RTTCB_OFFSET_AUP_PBUFFER(address, i)));
+    Log_Print("aUp[%d].SizeOfBuffer   = %d\n",     i, T32_GetWord(sAccess, RTTCB_OFFSET_AUP_SIZEOFBUFFER(address, i)));
+    Log_Print("aUp[%d].WrOff          = %d\n",     i, T32_GetWord(sAccess, RTTCB_OFFSET_AUP_WROFF(address, i)));
+    Log_Print("aUp[%d].RdOff          = %d\n",     i, T32_GetWord(sAccess, RTTCB_OFFSET_AUP_RDOFF(address, i)));
+    Log_Print("aUp[%d].Flags          = %d\n",     i, T32_GetWord(sAccess, RTTCB_OFFSET_AUP_FLAGS(address, i)));
+
+    pnameaddr = T32_GetWord(sAccess, RTTCB_OFFSET_ADOWN_SNAME(address, MaxNumUpBuffers, i));
+    if (pnameaddr != 0) {
+      Log_Print("aDown[%d].sName        = 0x%08X\n", i, pnameaddr);
+      T32_strcpy(sAccess, _sName, (char *)pnameaddr);
+      Log_Print("aDown[%d].sName        = %s\n", i, _sName);
     }
-  } else {
-    r = -1;
+    Log_Print("aDown[%d].pBuffer      = 0x%08X\n", i, T32_GetWord(sAccess, RTTCB_OFFSET_ADOWN_PBUFFER(address, MaxNumUpBuffers, i)));
+    Log_Print("aDown[%d].SizeOfBuffer = %d\n",     i, T32_GetWord(sAccess, RTTCB_OFFSET_ADOWN_SIZEOFBUFFER(address, MaxNumUpBuffers, i)));
+    Log_Print("aDown[%d].WrOff        = %d\n",     i, T32_GetWord(sAccess, RTTCB_OFFSET_ADOWN_WROFF(address, MaxNumUpBuffers, i)));
+    Log_Print("aDown[%d].RdOff        = %d\n",     i, T32_GetWord(sAccess, RTTCB_OFFSET_ADOWN_RDOFF(address, MaxNumUpBuffers, i)));
+    Log_Print("aDown[%d].Flags        = %d\n",     i, T32_GetWord(sAccess, RTTCB_OFFSET_ADOWN_FLAGS(address, MaxNumUpBuffers, i)));
+  }
+  Log_Print("====================================T32 RTTCB Dump End\n\n");
+}
+
+/*********************************************************************
+*
+*       target session functions
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _TARGET_Select()
+*
+*  Function description
+*    Makes the RCL channel of the given target the active one.
+*    The latched error state of the previously selected target is saved.
+*/
+static void _TARGET_Select(RTT_TARGET* pTarget) {
+  if (_pTarget == pTarget) {
+    return;
+  }
+  if (_pTarget != NULL) {
+    _pTarget->Resync    = _RTTCBResync;
+    _pTarget->LinkError = _T32LinkError;
+  }
+  T32_SetChannel(pTarget->pChannel);                 // Also switches the negotiated packet size
+  _RTTCBResync  = pTarget->Resync;
+  _T32LinkError = pTarget->LinkError;
+  _pTarget      = pTarget;
+}
+
+/*********************************************************************
+*
+*       _GOV_IsAllowed()
+*
+*  Function description
+*    Refills the RCL credit of a target and updates its usage window.
+*
+*  Return value
+*    == 1  Poll is within the budget
+*    == 0  Budget used up, skip the poll
+*/
+static int _GOV_IsAllowed(RTT_GOVERNOR* pGov, unsigned Now) {
+  unsigned Elapsed;
+
+  Elapsed = MIN(Now - pGov->LastRefill, 1000u);
+  pGov->LastRefill = Now;
+  pGov->CreditRequests = MIN(pGov->CreditRequests + (int64_t)Elapsed * _GovMaxRequests, (int64_t)_GovMaxRequests * 1000);
+  pGov->CreditBytes    = MIN(pGov->CreditBytes    + (int64_t)Elapsed * _GovMaxBytes,    (int64_t)_GovMaxBytes    * 1000);
+  Elapsed = Now - pGov->WindowStart;
+  if (Elapsed >= 1000u) {
+    pGov->RateRequests   = (unsigned)((uint64_t)pGov->WindowRequests * 1000u / Elapsed);
+    pGov->RateBytes      = (unsigned)((uint64_t)pGov->WindowBytes    * 1000u / Elapsed);
+    pGov->WindowStart    = Now;
+    pGov->WindowRequests = 0;
+    pGov->WindowBytes    = 0;
+  }
+  if ((_GovMaxRequests != 0u) && (pGov->CreditRequests <= 0)) {
+    return 0;
+  }
+  if ((_GovMaxBytes != 0u) && (pGov->CreditBytes <= 0)) {
+    return 0;
   }
-  return r;
+  return 1;
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_IsReady
+*       _GOV_Charge()
 *
 *  Function description
-*    Checks if a socket that has been connected with _SYS_SOCKET_Connect() is ready.
-*    Mainly used on non-blocking sockets to check if they are ready to operate on.
-*    The procedure (non-blocking connect, then trying FIONREAD) is recommended by MS (MSDN).
-*
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
-*
-*  Return value
-*    == 1  O.K., socket ready
-*    == 0  O.K., socket not ready yet
-*     < 0  Error
+*    Charges the traffic of one poll, measured with T32_GetTraffic().
 */
-static unsigned _SYS_SOCKET_IsReady(_SYS_SOCKET_HANDLE hSocket) {
-  SOCKET Sock;
-  int IsReady;
-  unsigned long v;
-
-  Sock = (SOCKET)hSocket;
-  ioctlsocket(Sock, FIONREAD, &v);     // Check if socket is ready to read from
-  IsReady = v ? 1 : 0;
-  return IsReady;
+static void _GOV_Charge(RTT_GOVERNOR* pGov, uint32_t NumRequests, uint32_t NumBytes) {
+  pGov->WindowRequests += NumRequests;
+  pGov->WindowBytes    += NumBytes;
+  if (_GovMaxRequests != 0u) {
+    pGov->CreditRequests -= (int64_t)NumRequests * 1000;
+  }
+  if (_GovMaxBytes != 0u) {
+    pGov->CreditBytes    -= (int64_t)NumBytes * 1000;
+  }
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_IsReady
+*       _BLOCK_Init()
 *
 *  Function description
-*    Checks if a socket that has been connected with _SYS_SOCKET_Connect() is ready.
-*    Mainly used on non-blocking sockets to check if they are ready to operate on.
-*    The procedure (non-blocking connect, then trying FIONREAD) is recommended by MS (MSDN).
+*    Initializes a control block of a target.
 *
 *  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    pBlock      Control block to initialize.
+*    sSymbol     Symbol of the control block, NULL if Address is given.
+*    Address     Fixed address of the control block, ignored if sSymbol is given.
+*    sAccess     TRACE32 access class of the control block.
+*    UpIndex     Up buffer bridged to the telnet port.
+*    DownIndex   Down buffer bridged to the telnet port.
+*    LocalPort   Telnet port of the control block.
+*/
+static void _BLOCK_Init(RTT_BLOCK* pBlock, char* sSymbol, unsigned Address, const char* sAccess, unsigned UpIndex, unsigned DownIndex, unsigned LocalPort) {
+  memset(pBlock, 0, sizeof(RTT_BLOCK));
+  pBlock->sSymbol       = sSymbol;
+  pBlock->RTTCB.Address = (sSymbol == NULL) ? Address : 0u;
+  snprintf(pBlock->RTTCB.acAccess, sizeof(pBlock->RTTCB.acAccess), "%s", sAccess);
+  pBlock->UpIndex       = UpIndex;
+  pBlock->DownIndex     = DownIndex;
+  pBlock->LocalPort     = LocalPort;
+  pBlock->hSockListen   = _SYS_SOCKET_INVALID_HANDLE;
+  pBlock->hSockSV       = _SYS_SOCKET_INVALID_HANDLE;
+}
+
+/*********************************************************************
+*
+*       _ParsePort()
+*
+*  Function description
+*    Parses a decimal port number 0..65535.
 *
 *  Return value
-*    == 1  O.K., socket ready
-*    == 0  O.K., socket not ready yet
-*     < 0  Error
+*    == 0  O.K., *pPort set
+*     < 0  Error, not a number or out of range
 */
-static unsigned _SYS_SOCKET_IsReady(_SYS_SOCKET_HANDLE hSocket) {
-  _SYS_SOCKET_HANDLE Sock;
-  int IsReady;
-  unsigned long v;
+static int _ParsePort(const char* s, unsigned* pPort) {
+  unsigned long Value;
+  char*         pEnd;
 
-  Sock = (_SYS_SOCKET_HANDLE)hSocket;
-  ioctl(Sock, FIONREAD, &v);     // Check if socket is ready to read from
-  IsReady = v ? 1 : 0;
-  return IsReady;
+  if ((*s < '0') || (*s > '9')) {
+    return -1;
+  }
+  errno = 0;
+  Value = strtoul(s, &pEnd, 10);
+  if ((errno != 0) || (*pEnd != '\0') || (Value > 65535u)) {
+    return -1;
+  }
+  *pPort = (unsigned)Value;
+  return 0;
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_IsReadable
+*       _TARGET_Add()
 *
 *  Function description
-*    Checks if a socket that has been connected with _SYS_SOCKET_Connect() is readable.
-*
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    Adds a TRACE32 instance to the list of bridged targets and
+*    allocates its RCL channel. The target is served with the default
+*    control block (_SEGGER_RTT, channel 0) at the given local port
+*    until a control block is added with _TARGET_AddBlock().
+*    sLocalPort may be NULL if blocks are added, the default block
+*    has no listener then.
 *
 *  Return value
-*    == 1  O.K., socket readable
-*    == 0  O.K., socket not readable yet
-*     < 0  Error
+*    == 0  O.K.
+*    == -1 Error, too many targets
+*    == -2 Error, invalid port
 */
-static int _SYS_SOCKET_IsReadable(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
-  SOCKET Sock;
-  struct timeval tv;
-  fd_set rfds;
-  fd_set efds;
-  int v;
-  //
-  //
-  // Two possible cases when opening a TCP connection:
-  // 1) On the other side, there is a server listening on the destination port
-  // 2) On the other side, there is NO server listening on the destination port
-  //
-  // Reg 1)
-  //   In such cases, the socket is reported non-writable for a few [us] up to a few [s] depending on if this is a localhost, LAN or internet connection
-  //   After that period, the socket is reported as writable
-  //
-  // Reg 2)
-  //   In such cases, the following happens (S = Server):
-  //   C -> S: SYN
-  //   S -> C: RST ACK
-  //   This means, the server has rejected the connection and closed it
-  //   In such a case, we need to close the socket and try connecting again
-  //
-  // However, Windows is difficult regarding 2)...
-  // Usually an RST means "it's over, you can close the socket. There is nobody listening"
-  // Windows keeps the socket in connecting state, so IsReadable() IsWriteable() simply returns 0 instead of 1 (which would allow a following send/receive to return with error)
-  // In the background, Windows performs the SYN sending another 3 times in intervals of 500ms before giving up and reporting an error state
-  // Usually, the retransmissions are there in case we do not get an ACK from the other side and therefore must assume that the packet got lost
-  // Then also the interval time is doubled for each retransmission
-  // However, Microsoft decided to also retry it in case of RST ACK but without increasing the interval time
-  // This is explained here: https://support.microsoft.com/en-in/help/175523/info-winsock-tcp-connection-performance-to-unused-ports
-  //
-  // Unfortunately, even after this 1.5 seconds, Windows not necessarily reports the socket as readable/writable but instead returns "exceptional state" on select()
-  // Therefore, we also pass the "exceptional state" structure to select() to catch this case
-  //
-  Sock = (SOCKET)hSocket;
-  FD_ZERO(&rfds);       // Zero init file descriptor list
-  FD_SET(Sock, &rfds);  // Add socket to file descriptor list to be monitored by select()
-  FD_ZERO(&efds);
-  FD_SET(Sock, &efds);
-  tv.tv_sec = (long)(TimeoutMs / 1000);
-  tv.tv_usec = (TimeoutMs % 1000) * 1000;
-  v = select(0, &rfds, NULL, &efds, &tv);   // > 0: in case of success, == 0: Timeout, < 0: Error
-  return v;
+static int _TARGET_Add(char* sNode, char* sPort, char* sLocalPort) {
+  RTT_TARGET* pTarget;
+  unsigned    Port;
+  unsigned    LocalPort;
+
+  if ((_ParsePort(sPort, &Port) != 0) || (Port == 0u)) {
+    return -2;
+  }
+  LocalPort = 0u;
+  if ((sLocalPort != NULL) && ((_ParsePort(sLocalPort, &LocalPort) != 0) || (LocalPort == 0u))) {
+    return -2;
+  }
+  if (_NumTargets >= RTT_MAX_NUM_TARGETS) {
+    return -1;
+  }
+  pTarget = &_aTarget[_NumTargets];
+  memset(pTarget, 0, sizeof(RTT_TARGET));
+  pTarget->pChannel = malloc((size_t)T32_GetChannelSize());
+  if (pTarget->pChannel == NULL) {
+    return -1;
+  }
+  T32_GetChannelDefaults(pTarget->pChannel);
+  pTarget->sNode           = sNode;
+  pTarget->sPort           = sPort;
+  pTarget->RetryDelay      = RTT_RECONNECT_DELAY;
+  pTarget->MemCache.Gen    = 1u;                      // 0 marks regions which have not been read
+  pTarget->MemCache.Epoch  = 1u;
+  pTarget->HasDefaultBlock = 1;
+  pTarget->NumBlocks       = 1;
+  _BLOCK_Init(&pTarget->aBlock[0], "_SEGGER_RTT", 0u, RTT_DEFAULT_ACCESS, 0u, 0u, LocalPort);
+  _NumTargets++;
+  return 0;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_IsReadable
+*       _TARGET_Parse()
 *
 *  Function description
-*    Checks if a socket that has been connected with _SYS_SOCKET_Connect() is readable.
-*
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    Adds a target given as <node>:<port>:<lport>.
 *
 *  Return value
-*    == 1  O.K., socket readable
-*    == 0  O.K., socket not readable yet
+*    == 0  O.K.
 *     < 0  Error
 */
-static int _SYS_SOCKET_IsReadable(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
-  _SYS_SOCKET_HANDLE Sock;
-  struct timeval tv;
-  fd_set rfds;
-  int v;
+static int _TARGET_Parse(char* sArg) {
+  char* sPort;
+  char* sLocalPort;
 
-  Sock = (_SYS_SOCKET_HANDLE)hSocket;
-  FD_ZERO(&rfds);       // Zero init file descriptor list
-  FD_SET(Sock, &rfds);  // Add socket to file descriptor list to be monitored by select()
-  tv.tv_sec = (long)(TimeoutMs / 1000);
-  tv.tv_usec = (TimeoutMs % 1000) * 1000;
-  v = select((hSocket + 1), &rfds, NULL, NULL, &tv);   // > 0: in case of success, == 0: Timeout, < 0: Error
-  return v;
+  sLocalPort = strrchr(sArg, ':');
+  if (sLocalPort == NULL) {
+    return -1;
+  }
+  *sLocalPort++ = '\0';
+  sPort = strrchr(sArg, ':');
+  if (sPort == NULL) {
+    return -1;
+  }
+  *sPort++ = '\0';
+  return _TARGET_Add(sArg, sPort, sLocalPort);
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_AcceptEx
+*       _TARGET_AddBlock()
 *
 *  Function description
-*    Waits for a connection (with timeout) on the given socket.
-*
-*  Parameters
-*    hSocket   Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
-*    TimeoutMs Timeout in ms for waiting
+*    Adds a control block given as
+*    <symbol|0xaddress>:<access>:<up>[/<down>]:<lport> to a target.
+*    An empty access class selects RTT_DEFAULT_ACCESS, the down buffer
+*    defaults to the index of the up buffer. The first block replaces
+*    the default control block of the target.
 *
 *  Return value
-*    >= 0  Handle to socket of new connection that has been established
-*     < 0  Error   (_SYS_SOCKET_INVALID_HANDLE)
-*      -2  Timeout
+*    == 0  O.K.
+*     < 0  Error
 */
-static _SYS_SOCKET_HANDLE _SYS_SOCKET_AcceptEx(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
-  SOCKET SockChild;
-  int r;
-  //
-  // accept() itself does not allow using timeouts
-  // Therefore we check readability first and then call accept() which should not block then
-  //
-  r = _SYS_SOCKET_IsReadable(hSocket, TimeoutMs);
-  if (r < 0) {
-    return _SYS_SOCKET_INVALID_HANDLE; // error
-  } else if (r == 0) {
-    return -2;                        // timeout
+static int _TARGET_AddBlock(RTT_TARGET* pTarget, char* sArg) {
+  char*    sAccess;
+  char*    sChannel;
+  char*    sLocalPort;
+  char*    sDown;
+  unsigned Address;
+  unsigned UpIndex;
+  unsigned DownIndex;
+  unsigned LocalPort;
+
+  if (pTarget->HasDefaultBlock) {
+    pTarget->HasDefaultBlock = 0;
+    pTarget->NumBlocks       = 0;
+  }
+  if (pTarget->NumBlocks >= RTT_MAX_NUM_BLOCKS) {
+    return -1;
+  }
+  sLocalPort = strrchr(sArg, ':');
+  if (sLocalPort == NULL) {
+    return -1;
+  }
+  *sLocalPort++ = '\0';
+  sChannel = strrchr(sArg, ':');
+  if (sChannel == NULL) {
+    return -1;
+  }
+  *sChannel++ = '\0';
+  sAccess = strrchr(sArg, ':');
+  if (sAccess == NULL) {
+    return -1;
+  }
+  *sAccess++ = '\0';
+  sDown = strchr(sChannel, '/');
+  if (sDown != NULL) {
+    *sDown++ = '\0';
+  }
+  UpIndex   = strtoul(sChannel, NULL, 0);
+  DownIndex = (sDown != NULL) ? strtoul(sDown, NULL, 0) : UpIndex;
+  if (_ParsePort(sLocalPort, &LocalPort) != 0) {
+    return -1;
+  }
+  if ((*sArg == '\0') || (LocalPort == 0u) || (UpIndex >= RTT_CB_MAX_NUM_BUFFERS) || (DownIndex >= RTT_CB_MAX_NUM_BUFFERS)) {
+    return -1;
+  }
+  if (*sAccess == '\0') {
+    sAccess = RTT_DEFAULT_ACCESS;
+  }
+  if (strlen(sAccess) >= sizeof(pTarget->aBlock[0].RTTCB.acAccess)) {
+    return -1;
+  }
+  if ((sArg[0] == '0') && ((sArg[1] == 'x') || (sArg[1] == 'X'))) {
+    Address = strtoul(sArg, NULL, 16);
+    _BLOCK_Init(&pTarget->aBlock[pTarget->NumBlocks], NULL, Address, sAccess, UpIndex, DownIndex, LocalPort);
   } else {
-    SockChild = accept((SOCKET)hSocket, NULL, NULL);
-    if (SockChild != INVALID_SOCKET) {
-      //
-      // If connection is successfully established, handle it as an implicit open(), so also init Winsock API as WSACleanup() is called on SocketClose()
-      // No matter if the socket has been opened via open() or accept()
-      //
-      _WSAStartup();
-      //
-      // Disable Nagle's algorithm to speed things up
-      // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
-      //
-      setsockopt(SockChild, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
-    } else {
-      return _SYS_SOCKET_INVALID_HANDLE;
+    _BLOCK_Init(&pTarget->aBlock[pTarget->NumBlocks], sArg, 0u, sAccess, UpIndex, DownIndex, LocalPort);
+  }
+  pTarget->NumBlocks++;
+  return 0;
+}
+
+/*********************************************************************
+*
+*       _TARGET_SetLogFile()
+*
+*  Function description
+*    Assigns the record file. With more than one telnet port, the local
+*    port is appended to keep the sessions apart.
+*/
+static void _TARGET_SetLogFile(char* sFile) {
+  RTT_BLOCK* pBlock;
+  unsigned   NumBlocks;
+  unsigned   i;
+  unsigned   j;
+  size_t     Len;
+
+  NumBlocks = 0;
+  for (i = 0; i < _NumTargets; i++) {
+    NumBlocks += _aTarget[i].NumBlocks;
+  }
+  for (i = 0; i < _NumTargets; i++) {
+    for (j = 0; j < _aTarget[i].NumBlocks; j++) {
+      pBlock = &_aTarget[i].aBlock[j];
+      if (NumBlocks == 1) {
+        pBlock->Log.sFile = sFile;
+      } else {
+        Len = strlen(sFile) + 16;
+        pBlock->Log.sFile = malloc(Len);
+        if (pBlock->Log.sFile != NULL) {
+          snprintf(pBlock->Log.sFile, Len, "%s.%u", sFile, pBlock->LocalPort);
+        }
+      }
     }
   }
-  return (_SYS_SOCKET_HANDLE)SockChild;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_Accept
+*       _TARGET_Invalidate()
 *
 *  Function description
-*    Waits for a connection on the given socket.
+*    Invalidates the cached control blocks of a target.
+*/
+static void _TARGET_Invalidate(RTT_TARGET* pTarget, const char* sReason) {
+  unsigned i;
+
+  for (i = 0; i < pTarget->NumBlocks; i++) {
+    _RTTCB_Invalidate(&pTarget->aBlock[i].RTTCB, sReason);
+  }
+}
+
+/*********************************************************************
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*       _TARGET_ScheduleRetry()
 *
-*  Return value
-*    Handle to socket of new connection that has been established
+*  Function description
+*    Takes the target offline. The next connect is attempted after
+*    an exponentially increasing delay.
 */
-_SYS_SOCKET_HANDLE _SYS_SOCKET_Accept(_SYS_SOCKET_HANDLE hSocket) {
-  _SYS_SOCKET_HANDLE SockChild;
+static void _TARGET_ScheduleRetry(RTT_TARGET* pTarget) {
+  unsigned i;
 
-  SockChild = accept((_SYS_SOCKET_HANDLE)hSocket, NULL, NULL);
-  if (SockChild != INVALID_SOCKET) {
-    //
-    // Disable Nagle's algorithm to speed things up
-    // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
-    //
-    setsockopt(SockChild, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
-  } else {
-    return _SYS_SOCKET_INVALID_HANDLE;
+  pTarget->IsOnline   = 0;
+  for (i = 0; i < pTarget->NumBlocks; i++) {
+    pTarget->aBlock[i].RTTCB.IsValid = 0;
   }
-  return (_SYS_SOCKET_HANDLE)SockChild;
+  pTarget->RetryTime  = SYS_GetTickCount() + pTarget->RetryDelay;
+  pTarget->RetryDelay = MIN(pTarget->RetryDelay * 2u, RTT_RECONNECT_DELAY_MAX);
+  _RTTCBResync  = 0;
+  _T32LinkError = T32_OK;
 }
-#endif
 
 #ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_AcceptEx
+*       _PROBE_Connect()
 *
 *  Function description
-*    Waits for a connection (with timeout) on the given socket.
-*
-*  Parameters
-*    hSocket   Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
-*    TimeoutMs Timeout in ms for waiting
+*    Connects to TRACE32 of a target on a context of its own and
+*    disconnects again. Runs in the probe thread.
 *
 *  Return value
-*    >= 0  Handle to socket of new connection that has been established
-*     < 0  Error   (_SYS_SOCKET_INVALID_HANDLE)
-*      -2  Timeout
+*    == 0  O.K., TRACE32 answered the connect and sync handshake
+*    != 0  Error
 */
-static _SYS_SOCKET_HANDLE _SYS_SOCKET_AcceptEx(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
-  _SYS_SOCKET_HANDLE SockChild;
-  struct sockaddr_in  sockAddr;
-  char ipStr[64];
-  int r;
-  int len;
-  //
-  // accept() itself does not allow using timeouts
-  // Therefore we check readability first and then call accept() which should not block then
-  //
-  len = sizeof(struct sockaddr_in);
-  r = _SYS_SOCKET_IsReadable(hSocket, TimeoutMs);
-  if (r < 0) {
-    return _SYS_SOCKET_INVALID_HANDLE; // error
-  } else if (r == 0) {
-    return -2;                        // timeout
-  } else {
-    SockChild = accept(hSocket, (struct sockaddr*)&sockAddr, (socklen_t *)&len);
-    if (SockChild != INVALID_SOCKET) {
-      //
-      // Disable Nagle's algorithm to speed things up
-      // Nagle's algorithm prevents small packets from being transmitted and collects some time until data is actually sent out
-      //
-      setsockopt(SockChild, IPPROTO_TCP, TCP_NODELAY, (char*)&_int1, sizeof(int));
-    } else {
-      return _SYS_SOCKET_INVALID_HANDLE;
-    }
+static int _PROBE_Connect(const char* sNode, const char* sPort) {
+  T32_Context* pCtx;
+  int          Result;
+
+  pthread_mutex_lock(&_ProbeMutex);      // The API counts the contexts in a global
+  Result = T32_CtxCreate(&pCtx);
+  pthread_mutex_unlock(&_ProbeMutex);
+  if (Result != T32_OK) {
+    return Result;
   }
-  Log_Print("connect client ip: %s\t port: %d\n", inet_ntop(AF_INET, &sockAddr.sin_addr.s_addr, ipStr, sizeof(ipStr)), ntohs(sockAddr.sin_port));
-  return (_SYS_SOCKET_HANDLE)SockChild;
+  T32_CtxConfig(pCtx, "NODE=", sNode);
+  T32_CtxConfig(pCtx, "PORT=", sPort);
+  if (_pProbePackLen != NULL) {
+    T32_CtxConfig(pCtx, "PACKLEN=", _pProbePackLen);
+  }
+  Result = T32_CtxInit(pCtx);
+  T32_CtxExit(pCtx);
+  pthread_mutex_lock(&_ProbeMutex);
+  T32_CtxDestroy(pCtx);
+  pthread_mutex_unlock(&_ProbeMutex);
+  return Result;
+}
+
+/*********************************************************************
+*
+*       _PROBE_Thread()
+*
+*  Function description
+*    Probes one target. A connect to an unreachable TRACE32 waits for
+*    the timeouts of the handshake, up to several seconds, which would
+*    stall the RTT of all other targets in the poll loop. Each offline
+*    target gets a thread of its own so that one unreachable instance
+*    does not delay the probes of the others either.
+*/
+static void* _PROBE_Thread(void* p) {
+  RTT_TARGET* pTarget;
+  int         Result;
+
+  pTarget = (RTT_TARGET*)p;
+  Result  = _PROBE_Connect(pTarget->sNode, pTarget->sPort);
+  pthread_mutex_lock(&_ProbeMutex);
+  pTarget->ProbeState = (Result == 0) ? RTT_PROBE_OK : RTT_PROBE_FAILED;
+  pthread_mutex_unlock(&_ProbeMutex);
+  return NULL;
+}
+
+/*********************************************************************
+*
+*       _PROBE_Enable()
+*
+*  Function description
+*    Enables the probes. Without them, e.g. with --replay where the
+*    capture answers at once, offline targets are connected from the
+*    poll loop directly.
+*/
+static void _PROBE_Enable(char* PackLen) {
+  _pProbePackLen = PackLen;
+  _ProbeEnabled  = 1;
 }
 #endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_Receive
+*       _PROBE_IsReachable()
 *
 *  Function description
-*    Receives data on the given socket.
-*
-*  Parameters
-*    hSocket          Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    Checks the probe of an offline target whose retry time has come.
+*    Requests a probe if none is pending. A failed probe schedules the
+*    next retry without touching the RCL channel.
 *
 *  Return value
-*    >= 0:  O.K., number of bytes received
-*     < 0:  Error, see _SYS_SOCKET_ERR_*
-*
-*  Notes
-*    (1) Returns as soon as something has been received (may be less than MaxNumBytes) or error happened
+*    == 1  TRACE32 answered the probe, connect the target
+*    == 0  Probe pending or failed
 */
-static int _SYS_SOCKET_Receive(_SYS_SOCKET_HANDLE hSocket, void* pData, unsigned MaxNumBytes) {
-  int r;
-  int Err;
-  SOCKET Sock;
-
-  Sock = (SOCKET)hSocket;
-  r = recv(Sock, (char*)pData, MaxNumBytes, 0);
-  if (r < 0) {
-    Err = WSAGetLastError();
-    switch (Err) {
-    case WSAEWOULDBLOCK:
-      r = _SYS_SOCKET_ERR_WOULDBLOCK;
-      break;
-    case WSAECONNRESET:
-      r = _SYS_SOCKET_ERR_CONNRESET;
-      break;
-    case WSAETIMEDOUT:
-      r = _SYS_SOCKET_ERR_TIMEDOUT;
-      break;
-    default:
-      r = _SYS_SOCKET_ERR_UNSPECIFIED;
+static int _PROBE_IsReachable(RTT_TARGET* pTarget) {
+#ifdef __linux__
+  pthread_attr_t     Attr;
+  struct sched_param Param;
+  pthread_t          Thread;
+  int                State;
+  int                r;
+
+  if (_ProbeEnabled == 0) {
+    return 1;
+  }
+  pthread_mutex_lock(&_ProbeMutex);
+  State = pTarget->ProbeState;
+  if (State == RTT_PROBE_IDLE) {
+    pTarget->ProbeState = RTT_PROBE_PENDING;
+  } else if (State != RTT_PROBE_PENDING) {
+    pTarget->ProbeState = RTT_PROBE_IDLE;
+  }
+  pthread_mutex_unlock(&_ProbeMutex);
+  if (State == RTT_PROBE_IDLE) {
+    //
+    // The probe must not inherit SCHED_FIFO of the poll loop, see --realtime
+    //
+    memset(&Param, 0, sizeof(Param));
+    pthread_attr_init(&Attr);
+    pthread_attr_setinheritsched(&Attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&Attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&Attr, &Param);
+    pthread_attr_setdetachstate(&Attr, PTHREAD_CREATE_DETACHED);
+    r = pthread_create(&Thread, &Attr, _PROBE_Thread, pTarget);
+    pthread_attr_destroy(&Attr);
+    if (r != 0) {
+      pTarget->ProbeState = RTT_PROBE_IDLE;     // No thread, connect from the poll loop
+      return 1;
     }
   }
-  return r;
-}
+  if (State == RTT_PROBE_FAILED) {
+    Log_Print("%s:%s offline (no answer), retry in %u ms\n", pTarget->sNode, pTarget->sPort, pTarget->RetryDelay);
+    pTarget->RetryTime  = SYS_GetTickCount() + pTarget->RetryDelay;
+    pTarget->RetryDelay = MIN(pTarget->RetryDelay * 2u, RTT_RECONNECT_DELAY_MAX);
+  }
+  return (State == RTT_PROBE_OK) ? 1 : 0;
+#else
+  (void)pTarget;
+  return 1;
 #endif
+}
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_Receive
+*       _TARGET_Connect()
 *
 *  Function description
-*    Receives data on the given socket.
-*
-*  Parameters
-*    hSocket          Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    Connects the RCL channel of a target and resolves the addresses
+*    of its RTT control blocks. Blocks whose symbol cannot be resolved
+*    are not served, the connect fails only if no block is left.
 *
 *  Return value
-*    >= 0:  O.K., number of bytes received
-*     < 0:  Error, see _SYS_SOCKET_ERR_*
-*
-*  Notes
-*    (1) Returns as soon as something has been received (may be less than MaxNumBytes) or error happened
+*    == T32_OK  O.K., target online
+*    != T32_OK  Error, reconnect has been scheduled
 */
-static int _SYS_SOCKET_Receive(_SYS_SOCKET_HANDLE hSocket, void* pData, unsigned MaxNumBytes) {
-  int r;
-  int Err;
-  _SYS_SOCKET_HANDLE Sock;
-
-  Sock = (_SYS_SOCKET_HANDLE)hSocket;
-  r = recv(Sock, (char*)pData, MaxNumBytes, 0);
-  if (r < 0) {
-    Err = errno;
-    switch (Err) {
-#if EAGAIN != EWOULDBLOCK
-    case EAGAIN:
-#endif
-    case EWOULDBLOCK:
-      r = _SYS_SOCKET_ERR_WOULDBLOCK;
-      break;
-    case ENETRESET:
-    case ECONNRESET:
-      r = _SYS_SOCKET_ERR_CONNRESET;
-      break;
-    case ETIMEDOUT:
-      r = _SYS_SOCKET_ERR_TIMEDOUT;
+static int _TARGET_Connect(RTT_TARGET* pTarget, char* PackLen, char* cmmFile) {
+  RTT_BLOCK* pBlock;
+  unsigned   NumResolved;
+  unsigned   i;
+  int        Result;
+
+  _TARGET_Select(pTarget);
+  _RTTCBResync  = 0;
+  _T32LinkError = T32_OK;
+  _MEMCACHE_Clear(&pTarget->MemCache);                // The target may have been reloaded meanwhile
+  Log_Print("Connecting %s:%s\n", pTarget->sNode, pTarget->sPort);
+  Result = T32_InitDEVICD(pTarget->sNode, pTarget->sPort, PackLen, cmmFile);
+  if (Result == T32_OK) {
+    NumResolved = 0;
+    for (i = 0; i < pTarget->NumBlocks; i++) {
+      pBlock = &pTarget->aBlock[i];
+      if (pBlock->sSymbol != NULL) {
+        pBlock->RTTCB.Address = T32_GetRTTCBAddr(pBlock->sSymbol);
+      }
+      if (pBlock->RTTCB.Address != 0u) {
+        Log_Print("%s:%s %s online, Address = %s:0x%08X\n", pTarget->sNode, pTarget->sPort,
+                  (pBlock->sSymbol != NULL) ? pBlock->sSymbol : "RTTCB", pBlock->RTTCB.acAccess, pBlock->RTTCB.Address);
+        NumResolved++;
+      }
+      pBlock->RTTCB.IsValid = 0;
+    }
+    if (NumResolved == 0u) {
+      Result = T32_ERR_STD_FAILED;
+    }
+  }
+#if RTT_NEGOTIATE_PACKET_SIZE
+  //
+  // Probe at a control block, it is located in RAM
+  //
+  for (i = 0; (Result == T32_OK) && (i < pTarget->NumBlocks); i++) {
+    pBlock = &pTarget->aBlock[i];
+    if ((pBlock->RTTCB.Address != 0u) && (strcmp(pBlock->RTTCB.acAccess, RTT_DEFAULT_ACCESS) == 0)) {
+      Log_Print("%s:%s packet size %d\n", pTarget->sNode, pTarget->sPort, T32_NegotiatePacketSize(pBlock->RTTCB.Address, 0x40 /* E:*/));
       break;
-    default:
-      r = _SYS_SOCKET_ERR_UNSPECIFIED;
     }
   }
-  return r;
-}
 #endif
+  if (Result != T32_OK) {
+    Log_Print("%s:%s offline (%s), retry in %u ms\n", pTarget->sNode, pTarget->sPort, T32_Err2Str(Result), pTarget->RetryDelay);
+    T32_Exit();
+    _TARGET_ScheduleRetry(pTarget);
+    return Result;
+  }
+#ifdef ENABLE_NOTIFICATION
+  T32_NotifyStateEnable(T32_E_BREAK, (T32_NotificationCallback_t)_RTTCB_OnBreak);
+#endif
+  pTarget->IsOnline   = 1;
+  pTarget->RetryDelay = RTT_RECONNECT_DELAY;
+  pTarget->Stats.NumConnects++;
+  return T32_OK;
+}
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_IsWriteable
+*       _TARGET_Disconnect()
 *
 *  Function description
-*    Checks if a socket that has been connected with _SYS_SOCKET_Connect() is writeable.
+*    Closes the RCL channel of a target after a communication error.
+*    The telnet clients stay connected and are served again as soon as
+*    the target is back online.
+*/
+static void _TARGET_Disconnect(RTT_TARGET* pTarget) {
+  _TARGET_Select(pTarget);
+  Log_Print("%s:%s link error (%s)\n", pTarget->sNode, pTarget->sPort, T32_Err2Str(_T32LinkError));
+  pTarget->Stats.NumLinkErrors++;
+  T32_Exit();
+  _TARGET_ScheduleRetry(pTarget);
+}
+
+/*********************************************************************
 *
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*       _BLOCK_CloseClient()
 *
-*  Return value
-*    == 1  O.K., socket writable
-*    == 0  O.K., socket not writable yet
 */
-static int _SYS_SOCKET_IsWriteable(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
-  SOCKET Sock;
-  struct timeval tv;
-  fd_set wfds;
-  fd_set efds;
-  int v;
-  //
-  //
-  // Two possible cases when opening a TCP connection:
-  // 1) On the other side, there is a server listening on the destination port
-  // 2) On the other side, there is NO server listening on the destination port
-  //
-  // Reg 1)
-  //   In such cases, the socket is reported non-writeable for a few [us] up to a few [s] depending on if this is a localhost, LAN or internet connection
-  //   After that period, the socket is reported as writeable
-  //
-  // Reg 2)
-  //   In such cases, the following happens (S = Server):
-  //   C -> S: SYN
-  //   S -> C: RST ACK
-  //   This means, the server has rejected the connection and closed it
-  //   In such a case, we need to close the socket and try connecting again
-  //
-  // However, Windows is difficult regarding 2)...
-  // Usually an RST means "it's over, you can close the socket. There is nobody listening"
-  // Windows keeps the socket in connecting state, so IsReadable() IsWriteable() simply returns 0 instead of 1 (which would allow a following send/receive to return with error)
-  // In the background, Windows performs the SYN sending another 3 times in intervals of 500ms before giving up and reporting an error state
-  // Usually, the retransmissions are there in case we do not get an ACK from the other side and therefore must assume that the packet got lost
-  // Then also the interval time is doubled for each retransmission
-  // However, Microsoft decided to also retry it in case of RST ACK but without increasing the interval time
-  // This is explained here: https://support.microsoft.com/en-in/help/175523/info-winsock-tcp-connection-performance-to-unused-ports
-  //
-  // Unfortunately, even after this 1.5 seconds, Windows not necessarily reports the socket as readable/writable but instead returns "exceptional state" on select()
-  // Therefore, we also pass the "exceptional state" structure to select() to catch this case
-  //
-  Sock = (SOCKET)hSocket;
-  FD_ZERO(&wfds);       // Zero init file descriptor list
-  FD_SET(Sock, &wfds);  // Add socket to file descriptor list to be monitored by select()
-  FD_ZERO(&efds);
-  FD_SET(Sock, &efds);
-  tv.tv_sec = (long)(TimeoutMs / 1000);
-  tv.tv_usec = (TimeoutMs % 1000) * 1000;
-  v = select(0, NULL, &wfds, &efds, &tv);   // > 0: in case of success, == 0: Timeout, < 0: Error
-  return v;
+static void _BLOCK_CloseClient(RTT_BLOCK* pBlock) {
+  _SYS_SOCKET_Close(pBlock->hSockSV);
+  pBlock->hSockSV = _SYS_SOCKET_INVALID_HANDLE;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_IsWriteable
+*       _BLOCK_IsActive()
 *
 *  Function description
-*    Checks if a socket that has been connected with _SYS_SOCKET_Connect() is writeable.
-*
-*  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
-*
-*  Return value
-*    == 1  O.K., socket writeable
-*    == 0  O.K., socket not writeable yet
+*    Returns whether a control block is served in this poll:
+*    it has been resolved and a telnet client is connected.
 */
-static int _SYS_SOCKET_IsWriteable(_SYS_SOCKET_HANDLE hSocket, int TimeoutMs) {
-  _SYS_SOCKET_HANDLE Sock;
-  struct timeval tv;
-  fd_set wfds;
-  int v;
-  Sock = (_SYS_SOCKET_HANDLE)hSocket;
-  FD_ZERO(&wfds);       // Zero init file descriptor list
-  FD_SET(Sock, &wfds);  // Add socket to file descriptor list to be monitored by select()
-  tv.tv_sec = (long)(TimeoutMs / 1000);
-  tv.tv_usec = (TimeoutMs % 1000) * 1000;
-  v = select((hSocket + 1), NULL, &wfds, NULL, &tv);   // > 0: in case of success, == 0: Timeout, < 0: Error
-  return v;
+static int _BLOCK_IsActive(const RTT_BLOCK* pBlock) {
+  return (pBlock->RTTCB.Address != 0u) && (pBlock->hSockSV != _SYS_SOCKET_INVALID_HANDLE);
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       SYS_SOCKET_Connect
+*       _TARGET_Prefetch()
 *
 *  Function description
-*    Connects a given IPv4 socket.
+*    Reads the descriptor tables of all valid, active control blocks of
+*    a target with one memory bundle, so that serving another core does
+*    not add a round trip. A single block is left to _RTTCB_Update(),
+*    which reads it with the plain memory API. The bundle is built per
+*    poll: T32_Exit() releases all objects of the API.
 *
 *  Parameters
-*    hSocket  Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
-*    IPAddr   IPv4 address expected in little endian form, meaning 127.0.0.1 is expected as 0x7F000001
-*    Port     Port to connect to
-*
-*  Notes
-*    (1) Returns immediately in case the socket has been configured as non-blocking. In this case, SYS_SOCKET_IsReady() needs to be called afterwards to make sure that the socket is ready
+*    pTarget     Target, selected.
+*    aaImage     Buffers for the control block images.
+*    apImage     Per block: Pointer to the fetched image, NULL if the
+*                block has not been fetched and is read directly.
 */
-int _SYS_SOCKET_Connect(_SYS_SOCKET_HANDLE hSocket, unsigned IPAddr, unsigned Port) {
-  _SYS_SOCKET_HANDLE Sock;
-  struct sockaddr_in addr;
-  int r;
-
-  Sock = (_SYS_SOCKET_HANDLE)hSocket;
-  addr.sin_family                = AF_INET;
-  addr.sin_port                  = htons((unsigned short)Port);
-  *(unsigned int*)&addr.sin_addr = htonl(IPAddr);
-  r = connect(Sock, (struct sockaddr *)&addr, sizeof(addr));
-  return r;
+static void _TARGET_Prefetch(RTT_TARGET* pTarget, unsigned char aaImage[][RTTCB_SIZEOF_IMAGE], const unsigned char** apImage) {
+  T32_MemoryBundleHandle hBundle;
+  T32_AddressHandle      hAddr;
+  T32_BufferSynchStatus  Status;
+  RTT_BLOCK*             pBlock;
+  int                    aIndex[RTT_MAX_NUM_BLOCKS];
+  int                    NumChunks;
+  unsigned               i;
+  int                    Result;
+
+  NumChunks = 0;
+  for (i = 0; i < pTarget->NumBlocks; i++) {
+    apImage[i] = NULL;
+    aIndex[i]  = -1;
+    pBlock = &pTarget->aBlock[i];
+    if (_BLOCK_IsActive(pBlock) && pBlock->RTTCB.IsValid) {
+      aIndex[i] = NumChunks++;
+    }
+  }
+  if (NumChunks < 2) {
+    return;
+  }
+  T32_RequestMemoryBundleObj(&hBundle, NumChunks);
+  for (i = 0; i < pTarget->NumBlocks; i++) {
+    if (aIndex[i] >= 0) {
+      pBlock = &pTarget->aBlock[i];
+      T32_RequestAddressObjA32(&hAddr, pBlock->RTTCB.Address);
+      T32_SetAddressObjAccessString(hAddr, pBlock->RTTCB.acAccess);
+      T32_AddToBundleObjAddrLength(hBundle, hAddr, _RTTCB_GetImageSize(&pBlock->RTTCB));
+      T32_ReleaseAddressObj(&hAddr);                   // Bundle holds its own copy
+    }
+  }
+  Result = T32_TransferMemoryBundleObj(hBundle);
+  if (_IsResetError(Result)) {
+    Log_Print("Bundle read reset detected, Result = %s.\n", T32_Err2Str(Result));
+    _RTTCBResync = 1;
+  } else if ((Result == T32_OK) || (Result == T32_ERR_TRANSFERMEMOBJ_TRANSFERFAIL)) {
+    //
+    // Chunks which failed are read again by _RTTCB_Update(),
+    // which reports the error of the affected block.
+    //
+    for (i = 0; i < pTarget->NumBlocks; i++) {
+      if (aIndex[i] >= 0) {
+        Status = T32_BUFFER_ERROR;
+        T32_GetBundleObjSyncStatusByIndex(hBundle, &Status, aIndex[i]);
+        if (Status == T32_BUFFER_READ) {
+          T32_CopyDataFromBundleObjByIndex(aaImage[i], _RTTCB_GetImageSize(&pTarget->aBlock[i].RTTCB), hBundle, aIndex[i]);
+          apImage[i] = aaImage[i];
+        }
+      }
+    }
+  } else {
+    Log_Print("Bundle read error, Result = %s.\n", T32_Err2Str(Result));
+    _SetLinkError(Result);
+  }
+  T32_ReleaseMemoryBundleObj(&hBundle);
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_Send
+*       _BLOCK_Accept()
 *
 *  Function description
-*    Sends data on the specified socket
-*
-*  Parameters
-*    hSocket          Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
-*
-*  Return value
-*    >= 0:  O.K., number of bytes sent
-*     < 0:  Error, see _SYS_SOCKET_ERR_*
+*    Accepts a pending telnet client of a control block.
 */
-static int _SYS_SOCKET_Send(_SYS_SOCKET_HANDLE hSocket, const void* pData, unsigned NumBytes) {
-  int r;
-  int Err;
-  SOCKET Sock;
+static void _BLOCK_Accept(RTT_TARGET* pTarget, RTT_BLOCK* pBlock, unsigned Now) {
+  _SYS_SOCKET_HANDLE hSock;
 
-  Sock = (SOCKET)hSocket;
-  r = send(Sock, pData, NumBytes, 0);
-  if (r == SOCKET_ERROR) {
-    Err = WSAGetLastError();
-    r = (Err == WSAEWOULDBLOCK) ? _SYS_SOCKET_ERR_WOULDBLOCK : _SYS_SOCKET_ERR_UNSPECIFIED;
+  if (pBlock->hSockSV != _SYS_SOCKET_INVALID_HANDLE) {
+    return;
   }
-  return r;
+  hSock = _SYS_SOCKET_AcceptEx(pBlock->hSockListen, 0);
+  if (hSock < 0) {
+    return;
+  }
+  _SYS_SOCKET_EnableKeepalive(hSock);
+  _SYS_SOCKET_SetNonBlocking(hSock);
+  _SYS_SOCKET_Send(hSock, telnetCmd, 9);
+  if (_SYS_SOCKET_IsReadable(hSock, RTT_IDLE_DELAY) == 1) {
+    _SYS_SOCKET_Receive(hSock, _acBuf, 6);
+  }
+  pBlock->hSockSV      = hSock;
+  pBlock->LastReadTime = Now;
+  pTarget->Stats.NumClients++;
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_Send
+*       _BLOCK_Transfer()
 *
 *  Function description
-*    Sends data on the specified socket
-*
-*  Parameters
-*    hSocket          Handle to socket that has been returned by _SYS_SOCKET_OpenTCP() / _SYS_SOCKET_OpenUDP()
+*    Moves data between a control block and its telnet client.
+*    Up data is forwarded once the send threshold is reached or the
+*    idle delay has expired.
 *
 *  Return value
-*    >= 0:  O.K., number of bytes sent
-*     < 0:  Error, see _SYS_SOCKET_ERR_*
+*    Number of bytes moved in both directions.
 */
-static int _SYS_SOCKET_Send(_SYS_SOCKET_HANDLE hSocket, const void* pData, unsigned NumBytes) {
-  int r;
-  int Err;
-  _SYS_SOCKET_HANDLE Sock;
+static int _BLOCK_Transfer(RTT_TARGET* pTarget, RTT_BLOCK* pBlock, unsigned Now) {
+  unsigned BytesInBuffer;
+  int      Result;
+  int      NumBytes;
+  int      NumBytesMoved;
 
-  Sock = (_SYS_SOCKET_HANDLE)hSocket;
+  NumBytesMoved = 0;
   //
-  // Sending without MSG_NOSIGNAL can cause a SIGPIPE to be sent if the
-  // connection was closed by peer and our process would be killed.
+  // Check for data sent by telnet client
   //
-  r = send(Sock, pData, NumBytes, MSG_NOSIGNAL);
-  if (r < 0) {
-    Err = errno;
-    r = (Err == EWOULDBLOCK) ? _SYS_SOCKET_ERR_WOULDBLOCK : _SYS_SOCKET_ERR_UNSPECIFIED;
+  Result = _SYS_SOCKET_IsReadable(pBlock->hSockSV, 0);
+  if (Result == 1) {
+    Result = _SYS_SOCKET_Receive(pBlock->hSockSV, _acBuf, sizeof(_acBuf));
+    if (Result <= 0) {                               // Failed to receive data? => Connection lost
+      Log_Print("connect close: failed to receive data: %d\n", Result);
+      _BLOCK_CloseClient(pBlock);
+      return 0;
+    }
+    NumBytes = SEGGER_RTT_WriteDownBufferNoLock(&pBlock->RTTCB, pBlock->DownIndex, &_acBuf[0], Result);
+    pTarget->Stats.NumBytesDown += NumBytes;
+    NumBytesMoved               += NumBytes;
+    RTT_TelnetLogS(&pBlock->Log, &_acBuf[0], NumBytes);
+#ifdef _TELNET_RTT_DEBUG
+    T32_RTTCB_Dump(pBlock->RTTCB.acAccess, pBlock->RTTCB.Address);
+    Log_Print("Result = %d, NumBytes = %d, _SYS_SOCKET_Receive (p=0x%08X)\n", Result, NumBytes, _acBuf);
+    SYS_Hexdump(_acBuf, NumBytes, true, false);
+#endif
   }
-  return r;
+  //
+  // Check for data to send to telnet client
+  //
+  BytesInBuffer = SEGGER_RTT_GetBytesInBuffer(&pBlock->RTTCB, pBlock->UpIndex);
+  if ((BytesInBuffer >= RTT_SEND_THRESHOLD) || ((BytesInBuffer > 0u) && ((Now - pBlock->LastReadTime) >= RTT_IDLE_DELAY))) {
+    pBlock->LastReadTime = Now;
+    NumBytes = SEGGER_RTT_ReadUpBufferNoLock(&pBlock->RTTCB, pBlock->UpIndex, &_acBuf[0], sizeof(_acBuf));
+    if (NumBytes > 0) {
+      Result = _SYS_SOCKET_Send(pBlock->hSockSV, _acBuf, NumBytes);
+      if (Result > 0) {
+        pTarget->Stats.NumBytesUp += Result;
+        NumBytesMoved             += Result;
+        RTT_TelnetLogS(&pBlock->Log, &_acBuf[0], Result);
+      }
+#ifdef _TELNET_RTT_DEBUG
+      T32_RTTCB_Dump(pBlock->RTTCB.acAccess, pBlock->RTTCB.Address);
+      Log_Print("Result = %d, NumBytes = %d, SYS_SOCKET_Send (p=0x%08X)\n", Result, NumBytes, _acBuf);
+      SYS_Hexdump(_acBuf, Result, true, false);
+#endif
+      if (NumBytes != Result) {                      // Failed to send data? => Connection lost
+        Log_Print("connect close: failed to send data. err: %d\n", Result);
+        _BLOCK_CloseClient(pBlock);
+      }
+    }
+  } else if (BytesInBuffer == 0u) {
+    pBlock->LastReadTime = Now;
+  }
+  return NumBytesMoved;
 }
+
+/*********************************************************************
+*
+*       _TARGET_PollBlocks()
+*
+*  Function description
+*    Refreshes the control blocks of the selected target and moves data
+*    of all blocks with a telnet client.
+*
+*  Return value
+*    >= 0  Number of bytes moved
+*     < 0  No control block is valid
+*/
+static int _TARGET_PollBlocks(RTT_TARGET* pTarget, unsigned Now) {
+  unsigned char        aaImage[RTT_MAX_NUM_BLOCKS][RTTCB_SIZEOF_IMAGE];
+  const unsigned char* apImage[RTT_MAX_NUM_BLOCKS];
+  RTT_BLOCK*           pBlock;
+  unsigned             i;
+  int                  NumBytesMoved;
+
+#ifdef ENABLE_NOTIFICATION
+  T32_CheckStateNotify(0);
 #endif
+  if (_RTTCBResync) {
+    _RTTCBResync = 0;
+    _TARGET_Invalidate(pTarget, "target reset or state change");
+  }
+  _TARGET_Prefetch(pTarget, aaImage, apImage);
+  _COALESCE_Begin(&pTarget->Coalesce);
+  NumBytesMoved = -1;
+  for (i = 0; (i < pTarget->NumBlocks) && (_T32LinkError == T32_OK); i++) {
+    pBlock = &pTarget->aBlock[i];
+    if (_BLOCK_IsActive(pBlock) && (_RTTCB_Update(&pBlock->RTTCB, apImage[i]) == 0)) {
+      NumBytesMoved = MAX(NumBytesMoved, 0) + _BLOCK_Transfer(pTarget, pBlock, Now);
+    }
+  }
+  _COALESCE_End();
+  if (NumBytesMoved >= 0) {
+    pTarget->Stats.NumPolls++;
+  }
+  return NumBytesMoved;
+}
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_SetNonBlocking
+*       _TARGET_Service()
 *
+*  Function description
+*    Performs one non-blocking step of a target session:
+*    (re)connect once the probe thread reached TRACE32, accept telnet clients, refresh the control blocks and
+*    move data in both directions. With --apilock the step is an
+*    exclusive burst of up to RTT_RCL_BURST_POLLS polls.
 */
-void _SYS_SOCKET_SetNonBlocking(_SYS_SOCKET_HANDLE hSocket) {
-  int on = 1;
-  ioctlsocket(hSocket, FIONBIO, &on);
+static void _TARGET_Service(RTT_TARGET* pTarget, char* PackLen, char* cmmFile, unsigned Now) {
+  unsigned i;
+  int      IsActive;
+  int      NumPolls;
+  int      Result;
+
+  if (pTarget->IsOnline == 0) {
+    if ((int)(Now - pTarget->RetryTime) < 0) {
+      return;
+    }
+    if (_PROBE_IsReachable(pTarget) == 0) {
+      return;
+    }
+    if (_TARGET_Connect(pTarget, PackLen, cmmFile) != T32_OK) {
+      return;
+    }
+  }
+  IsActive = 0;
+  for (i = 0; i < pTarget->NumBlocks; i++) {
+    _BLOCK_Accept(pTarget, &pTarget->aBlock[i], Now);
+    IsActive |= _BLOCK_IsActive(&pTarget->aBlock[i]);
+  }
+  if (IsActive == 0) {
+    return;
+  }
+  _TARGET_Select(pTarget);
+  if (_GovUseLock == 0) {
+    _TARGET_PollBlocks(pTarget, Now);
+  } else {
+    Result = T32_APILock(RTT_RCL_LOCK_TIMEOUT);
+    if (Result == T32_OK) {
+      NumPolls = RTT_RCL_BURST_POLLS;
+      while ((_TARGET_PollBlocks(pTarget, Now) > 0) && (--NumPolls > 0) && (_T32LinkError == T32_OK)) {
+      }
+      Result = T32_APIUnlock();
+    } else if (Result == T32_ERR_STD_LOCKED) {
+      pTarget->Gov.NumLocked++;                        // PowerView or a script holds the lock, try next time
+      Result = T32_OK;
+    }
+    if (Result != T32_OK) {
+      _SetLinkError(Result);
+    }
+  }
+  if (_T32LinkError != T32_OK) {
+    _TARGET_Disconnect(pTarget);
+  }
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_SetNonBlocking
+*       _TARGET_Poll()
 *
+*  Function description
+*    Services a target within its RCL budget. The traffic of each step
+*    is measured and charged to the budget of the target.
 */
-void _SYS_SOCKET_SetNonBlocking(_SYS_SOCKET_HANDLE hSocket) {
-  int on = 1;
-  ioctl(hSocket, FIONBIO, &on);
+static void _TARGET_Poll(RTT_TARGET* pTarget, char* PackLen, char* cmmFile) {
+  uint32_t NumRequests;
+  uint32_t NumBytes;
+  uint32_t NumRequestsEnd;
+  uint32_t NumBytesEnd;
+  unsigned Now;
+
+  Now = SYS_GetTickCount();
+  if ((_GOV_IsAllowed(&pTarget->Gov, Now) == 0) && pTarget->IsOnline) {
+    pTarget->Gov.NumThrottled++;
+    return;
+  }
+  T32_GetTraffic(&NumRequests, &NumBytes);
+  _TARGET_Service(pTarget, PackLen, cmmFile, Now);
+  T32_GetTraffic(&NumRequestsEnd, &NumBytesEnd);
+  _GOV_Charge(&pTarget->Gov, NumRequestsEnd - NumRequests, NumBytesEnd - NumBytes);
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_SetBlocking
+*       _TARGET_WaitEvents()
 *
+*  Function description
+*    Waits up to TimeoutMs for activity on the telnet sockets of all
+*    online targets (new client, client data) and, with notifications
+*    enabled, on their RCL sockets. Input is then forwarded at once
+*    instead of after the full poll interval. Uses one poll() for all
+*    sockets.
 */
-void _SYS_SOCKET_SetBlocking(_SYS_SOCKET_HANDLE hSocket) {
-  int on = 0;
-  ioctlsocket(hSocket, FIONBIO, &on);
-}
+static void _TARGET_WaitEvents(uint32_t TimeoutMs) {
+#ifdef __linux__
+  struct pollfd aFd[RTT_MAX_NUM_TARGETS * (RTT_MAX_NUM_BLOCKS + 1)];
+  RTT_TARGET*   pTarget;
+  RTT_BLOCK*    pBlock;
+  unsigned      NumFds;
+  unsigned      i;
+  unsigned      j;
+#ifdef ENABLE_NOTIFICATION
+  int           hSockRCL;
 #endif
 
-#ifdef __linux__
+  NumFds = 0;
+  for (i = 0; i < _NumTargets; i++) {
+    pTarget = &_aTarget[i];
+    //
+    // Sockets of offline or throttled targets are not serviced, they would only wake us up
+    //
+    if (pTarget->IsOnline == 0) {
+      continue;
+    }
+    if (((_GovMaxRequests != 0u) && (pTarget->Gov.CreditRequests <= 0)) || ((_GovMaxBytes != 0u) && (pTarget->Gov.CreditBytes <= 0))) {
+      continue;
+    }
+    for (j = 0; j < pTarget->NumBlocks; j++) {
+      pBlock = &pTarget->aBlock[j];
+      //
+      // Watch the client while one is connected, the listener otherwise
+      //
+      aFd[NumFds].fd      = (pBlock->hSockSV >= 0) ? pBlock->hSockSV : pBlock->hSockListen;
+      aFd[NumFds].events  = POLLIN;
+      aFd[NumFds].revents = 0;
+      if (aFd[NumFds].fd >= 0) {
+        NumFds++;
+      }
+    }
+#ifdef ENABLE_NOTIFICATION
+    _TARGET_Select(pTarget);
+    T32_GetSocketHandle(&hSockRCL);
+    aFd[NumFds].fd      = hSockRCL;
+    aFd[NumFds].events  = POLLIN;
+    aFd[NumFds].revents = 0;
+    NumFds++;
+#endif
+  }
+  poll(aFd, NumFds, (int)TimeoutMs);
+#else
+  SYS_Sleep(TimeoutMs);
+#endif
+}
+
 /*********************************************************************
 *
-*       _SYS_SOCKET_SetBlocking
+*       _TARGET_LogStats()
 *
+*  Function description
+*    Logs the statistics of all targets.
 */
-void _SYS_SOCKET_SetBlocking(_SYS_SOCKET_HANDLE hSocket) {
-  int on = 0;
-  ioctl(hSocket, FIONBIO, &on);
+static void _TARGET_LogStats(void) {
+  RTT_TARGET*   pTarget;
+  T32_LineStats Line;
+  unsigned      NumResets;
+  unsigned      i;
+  unsigned      j;
+
+  for (i = 0; i < _NumTargets; i++) {
+    pTarget   = &_aTarget[i];
+    NumResets = 0;
+    for (j = 0; j < pTarget->NumBlocks; j++) {
+      NumResets += pTarget->aBlock[j].RTTCB.NumResets;
+    }
+    SYS_Log("%s:%s -> %u: %s, polls %u, up %u, down %u, connects %u, link errors %u, resets %u, clients %u\n",
+            pTarget->sNode, pTarget->sPort, pTarget->aBlock[0].LocalPort, pTarget->IsOnline ? "online" : "offline",
+            pTarget->Stats.NumPolls, pTarget->Stats.NumBytesUp, pTarget->Stats.NumBytesDown, pTarget->Stats.NumConnects,
+            pTarget->Stats.NumLinkErrors, NumResets, pTarget->Stats.NumClients);
+    SYS_Log("%s:%s -> %u: rcl %u req/s of %u, %u B/s of %u, throttled %u, locked out %u, small reads %u in %u reads\n",
+            pTarget->sNode, pTarget->sPort, pTarget->aBlock[0].LocalPort,
+            pTarget->Gov.RateRequests, _GovMaxRequests, pTarget->Gov.RateBytes, _GovMaxBytes,
+            pTarget->Gov.NumThrottled, pTarget->Gov.NumLocked, pTarget->Coalesce.NumRequests, pTarget->Coalesce.NumReads);
+    SYS_Log("%s:%s -> %u: memory cache %u regions, hits %u, reads %u\n",
+            pTarget->sNode, pTarget->sPort, pTarget->aBlock[0].LocalPort,
+            pTarget->MemCache.NumRegions, pTarget->MemCache.NumHits, pTarget->MemCache.NumReads);
+    _TARGET_Select(pTarget);
+    T32_GetLineStats(&Line);
+    SYS_Log("%s:%s -> %u: link rtt %u us (+/- %u), rto %u us, timeouts %u, retransmits %u, notifications dropped %u\n",
+            pTarget->sNode, pTarget->sPort, pTarget->aBlock[0].LocalPort,
+            Line.SrttUs, Line.RttVarUs, Line.RtoUs, Line.Timeouts, Line.Retransmits, Line.NotificationsDropped);
+    if (_pReplayFile != NULL) {
+      SYS_Log("%s:%s -> %u: replay mismatches %u\n",
+              pTarget->sNode, pTarget->sPort, pTarget->aBlock[0].LocalPort, Line.ReplayMismatches);
+    }
+  }
+  if (_RtEnable && _RtStats.NumPeriods != 0u) {
+    SYS_Log("realtime: period %u us, wake-up jitter avg %u ns, max %u ns, overruns %u of %u\n",
+            RTT_COMM_POLL_INTERVAL * 1000u, (unsigned)(_RtStats.SumLateNs / _RtStats.NumPeriods), _RtStats.MaxLateNs,
+            _RtStats.NumOverruns, _RtStats.NumPeriods + _RtStats.NumOverruns);
+  }
 }
-#endif
 
-#ifdef __linux__
 /*********************************************************************
 *
-*       _SYS_SOCKET_EnableKeepalive
+*       _APISTATS_Compare()
 *
+*  Function description
+*    qsort() callback, orders API statistics by total time, longest first.
 */
-void _SYS_SOCKET_EnableKeepalive(_SYS_SOCKET_HANDLE hSocket) {
-  int on = 1;
-  setsockopt(hSocket, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(int));
+static int _APISTATS_Compare(const void* p0, const void* p1) {
+  const T32_ApiStats* pStats0 = (const T32_ApiStats*)p0;
+  const T32_ApiStats* pStats1 = (const T32_ApiStats*)p1;
+
+  if (pStats0->TotalUs != pStats1->TotalUs) {
+    return (pStats0->TotalUs < pStats1->TotalUs) ? 1 : -1;
+  }
+  return strcmp(pStats0->Name, pStats1->Name);
 }
-#endif
 
-#ifdef _WIN32
 /*********************************************************************
 *
-*       _SYS_SOCKET_EnableKeepalive
+*       _TARGET_LogApiStats()
 *
+*  Function description
+*    Logs calls, RCL messages, bytes and latency percentiles of every
+*    RCL API function and line primitive used so far (all targets),
+*    and the RCL messages spent per RTT byte. Triggered by SIGUSR1, the
+*    table is empty without --apistats.
 */
-void _SYS_SOCKET_EnableKeepalive(_SYS_SOCKET_HANDLE hSocket) {
-  int on = 1;
-  setsockopt(hSocket, SOL_SOCKET, SO_KEEPALIVE, (char*)&on, sizeof(int));
+static void _TARGET_LogApiStats(void) {
+  const T32_ApiStats* pStats;
+  uint32_t            NumRequests;
+  uint32_t            NumBytes;
+  unsigned            NumRTTBytes;
+  int                 NumStats;
+  int                 i;
+
+  NumRTTBytes = 0;
+  for (i = 0; i < (int)_NumTargets; i++) {
+    NumRTTBytes += _aTarget[i].Stats.NumBytesUp + _aTarget[i].Stats.NumBytesDown;
+  }
+  T32_GetTraffic(&NumRequests, &NumBytes);
+  SYS_Log("api: %u rcl requests, %u bytes for %u RTT bytes (%u.%03u requests per RTT byte)\n",
+          NumRequests, NumBytes, NumRTTBytes,
+          (NumRTTBytes != 0u) ? NumRequests / NumRTTBytes : 0u,
+          (NumRTTBytes != 0u) ? (unsigned)((uint64_t)(NumRequests % NumRTTBytes) * 1000u / NumRTTBytes) : 0u);
+  NumStats = T32_GetApiStats(_aApiStats, RTT_APISTATS_MAX);
+  if (NumStats > RTT_APISTATS_MAX) {
+    NumStats = RTT_APISTATS_MAX;
+  }
+  qsort(_aApiStats, (size_t)NumStats, sizeof(T32_ApiStats), _APISTATS_Compare);
+  for (i = 0; i < NumStats; i++) {
+    pStats = &_aApiStats[i];
+    SYS_Log("api: %-26s calls %u, req %u, retx %u, out %llu, in %llu, total %llu us, avg %u, p50 %u, p99 %u, max %u us\n",
+            pStats->Name, pStats->Calls, pStats->Requests, pStats->Retransmits,
+            (unsigned long long)pStats->BytesOut, (unsigned long long)pStats->BytesIn, (unsigned long long)pStats->TotalUs,
+            (unsigned)(pStats->TotalUs / pStats->Calls), T32_GetApiStatsPercentile(pStats, 50),
+            T32_GetApiStatsPercentile(pStats, 99), pStats->MaxUs);
+  }
 }
-#endif
 
 /*********************************************************************
 *
-*       T32_RTTCB_Dump()
+*       _TARGET_ExitAll()
 *
+*  Function description
+*    Restores the default state of all connected targets and closes
+*    their RCL channels.
 */
-void T32_RTTCB_Dump(unsigned int address) {
-  unsigned char _sName[16] = { 0 };
-
-  Log_Print("\n====================================T32 RTTCB Dump Start\n");
-  Log_Print("acID                  = 0x%08X\n", T32_GetWord(RTTCB_OFFSET_ACID(address)));
-  T32_strcpy(_sName, (char *)RTTCB_OFFSET_ACID(address));
-  Log_Print("acID                  = %s\n", _sName);
-
-  int MaxNumUpBuffers = T32_GetWord(RTTCB_OFFSET_MAXNUMUPBUFFERS(address));
-  Log_Print("MaxNumUpBuffers       = %d\n", MaxNumUpBuffers);
-
-  int MaxNumDownBuffers = T32_GetWord(RTTCB_OFFSET_MAXNUMDOWNBUFFERS(address));
-  Log_Print("MaxNumDownBuffers     = %d\n", MaxNumDownBuffers);
-
-  for (size_t i = 0; i < MaxNumUpBuffers; i++) {
-    unsigned int pnameaddr;
-    pnameaddr = T32_GetWord(RTTCB_OFFSET_AUP_SNAME(address, i));
-    if (pnameaddr != 0) {
-      Log_Print("aUp[%d].sName          = 0x%08X\n", i, pnameaddr);
-      T32_strcpy(_sName, (char *)pnameaddr);
-      Log_Print("aUp[%d].sName          = %s\n", i, _sName);
+static void _TARGET_ExitAll(void) {
+  RTT_TARGET* pTarget;
+  unsigned    i;
+
+  for (i = 0; i < _NumTargets; i++) {
+    pTarget = &_aTarget[i];
+    if (pTarget->IsOnline) {
+      _TARGET_Select(pTarget);
+      T32_DefaultState(0);
+      //T32_Terminate(T32_OK);
+      T32_Exit();
+      pTarget->IsOnline = 0;
     }
-    Log_Print("aUp[%d].pBuffer        = 0x%08X\n", i, T32_GetWord(RTTCB_OFFSET_AUP_PBUFFER(address, i)));
-    Log_Print("aUp[%d].SizeOfBuffer   = %d\n",     i, T32_GetWord(RTTCB_OFFSET_AUP_SIZEOFBUFFER(address, i)));
-    Log_Print("aUp[%d].WrOff          = %d\n",     i, T32_GetWord(RTTCB_OFFSET_AUP_WROFF(address, i)));
-    Log_Print("aUp[%d].RdOff          = %d\n",     i, T32_GetWord(RTTCB_OFFSET_AUP_RDOFF(address, i)));
-    Log_Print("aUp[%d].Flags          = %d\n",     i, T32_GetWord(RTTCB_OFFSET_AUP_FLAGS(address, i)));
-
-    pnameaddr = T32_GetWord(RTTCB_OFFSET_ADOWN_SNAME(address, MaxNumUpBuffers, i));
-    if (pnameaddr != 0) {
-      Log_Print("aDown[%d].sName        = 0x%08X\n", i, pnameaddr);
-      T32_strcpy(_sName, (char *)pnameaddr);
-      Log_Print("aDown[%d].sName        = %s\n", i, _sName);
-    }
-    Log_Print("aDown[%d].pBuffer      = 0x%08X\n", i, T32_GetWord(RTTCB_OFFSET_ADOWN_PBUFFER(address, MaxNumUpBuffers, i)));
-    Log_Print("aDown[%d].SizeOfBuffer = %d\n",     i, T32_GetWord(RTTCB_OFFSET_ADOWN_SIZEOFBUFFER(address, MaxNumUpBuffers, i)));
-    Log_Print("aDown[%d].WrOff        = %d\n",     i, T32_GetWord(RTTCB_OFFSET_ADOWN_WROFF(address, MaxNumUpBuffers, i)));
-    Log_Print("aDown[%d].RdOff        = %d\n",     i, T32_GetWord(RTTCB_OFFSET_ADOWN_RDOFF(address, MaxNumUpBuffers, i)));
-    Log_Print("aDown[%d].Flags        = %d\n",     i, T32_GetWord(RTTCB_OFFSET_ADOWN_FLAGS(address, MaxNumUpBuffers, i)));
   }
-  Log_Print("====================================T32 RTTCB Dump End\n\n");
 }
 
 /*********************************************************************
@@ -2881,6 +5905,145 @@ static void usage(void) {
   printf("    <port number>\n");
   printf("      Defines the TCP port. Be sure that these settings fit to the SecureCRT settings \n");
   printf("\n");
+  printf("--target\n");
+  printf("--------\n");
+  printf("  telnet-rtt --target [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <node>:<port>:<lport>\n");
+  printf("      Adds a TRACE32 instance to bridge. May be given up to %d times to serve\n", RTT_MAX_NUM_TARGETS);
+  printf("      several instances from one process. Replaces --node, --tport and --lport.\n");
+  printf("\n");
+  printf("--rttcb\n");
+  printf("--------\n");
+  printf("  telnet-rtt --rttcb [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <symbol|0xaddress>:<access>:<up>[/<down>]:<lport>\n");
+  printf("      Adds an RTT control block, e.g. of another core, to the preceding --target\n");
+  printf("      or to the --node target. <access> is a TRACE32 access class such as E or\n");
+  printf("      EAXI, empty for %s. <up>/<down> select the buffers bridged to <lport>.\n", RTT_DEFAULT_ACCESS);
+  printf("      May be given up to %d times per target, replaces the default _SEGGER_RTT\n", RTT_MAX_NUM_BLOCKS);
+  printf("      block on channel 0.\n");
+  printf("\n");
+  printf("--budget\n");
+  printf("--------\n");
+  printf("  telnet-rtt --budget [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <requests/s>[:<bytes/s>]\n");
+  printf("      Limits the RCL traffic per target so PowerView stays responsive on a shared\n");
+  printf("      link. 0 means no limit. The usage is logged with the statistics.\n");
+  printf("\n");
+  printf("--apilock\n");
+  printf("--------\n");
+  printf("  telnet-rtt --apilock\n");
+  printf("\n");
+  printf("      Polls in short exclusive bursts under T32_APILock() instead of interleaving\n");
+  printf("      single requests with other RCL clients.\n");
+  printf("\n");
+  printf("--apistats\n");
+  printf("--------\n");
+  printf("  telnet-rtt --apistats\n");
+  printf("\n");
+  printf("      Counts calls, RCL messages and latency of every RCL API function. SIGUSR1\n");
+  printf("      logs the table. Off by default, the counting reads the clock twice per call.\n");
+  printf("\n");
+  printf("--rcl\n");
+  printf("--------\n");
+  printf("  telnet-rtt --rcl [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    NETASSIST\n");
+  printf("      UDP link to the TRACE32 RCL=NETASSIST port (default).\n");
+  printf("    TCPRELAY\n");
+  printf("      TCP link to a relay which passes the messages on to the RCL=NETASSIST port\n");
+  printf("      (framing in hlinktcp.c), e.g. t32mux -t <port> next to PowerView; the\n");
+  printf("      --target port is the relay's. Not the TRACE32 RCL=NETTCP protocol, PowerView\n");
+  printf("      does not accept it directly. Must precede --target.\n");
+  printf("    MUX\n");
+  printf("      Link through t32mux on the local host, which shares its PowerView link with\n");
+  printf("      other tools. The --target node is the daemon's socket if it starts with '/',\n");
+  printf("      else %s; the port is not used. Must precede --target.\n", T32MUX_DEFAULT_SOCKET);
+  printf("\n");
+  printf("--capture\n");
+  printf("--------\n");
+  printf("  telnet-rtt --capture [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <file>\n");
+  printf("      Records every RCL datagram of all targets with its timestamp to a pcapng\n");
+  printf("      file, written in the background. NETASSIST only.\n");
+  printf("\n");
+  printf("--replay\n");
+  printf("--------\n");
+  printf("  telnet-rtt --replay [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <file>\n");
+  printf("      Answers the requests with the replies of a --capture file, at the recorded\n");
+  printf("      latency, instead of talking to TRACE32. Must precede --target.\n");
+  printf("\n");
+  printf("--load\n");
+  printf("--------\n");
+  printf("  telnet-rtt --load [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <file>:<address>[:<access>]\n");
+  printf("      Loads a binary file into target memory at <address> and exits, e.g. test\n");
+  printf("      vectors before a test run. Streams writes of the negotiated packet size,\n");
+  printf("      pipelined where the link supports it (--rcl TCPRELAY), one per round trip\n");
+  printf("      over UDP. Reports progress and throughput and resumes from the last\n");
+  printf("      acknowledged offset after an error. <address> is 0..0xFFFFFFFF, <access> a\n");
+  printf("      memory access number 0..255, default %d (D:).\n", T32_MEMORY_ACCESS_DATA);
+  printf("      Uses --node and --tport or the first --target.\n");
+  printf("\n");
+  printf("--verify\n");
+  printf("--------\n");
+  printf("  telnet-rtt --verify [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <file>:<address>[:<access>]\n");
+  printf("      Verifies target memory against a binary file and exits, after --load if\n");
+  printf("      both are given. TRACE32 computes the CRC-32 of the range (Data.SUM /CRC32);\n");
+  printf("      ranges whose checksum differs are bisected and only blocks of %d bytes\n", RTT_VERIFY_BLOCK_SIZE);
+  printf("      which differ are read back. Exits with 1 on a mismatch.\n");
+  printf("\n");
+  printf("--dump\n");
+  printf("--------\n");
+  printf("  telnet-rtt --dump [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <file>:<address>:<size>[:<access>]\n");
+  printf("      Dumps target memory into a file and exits, e.g. RAM for post-mortem\n");
+  printf("      analysis. Keeps reads of the negotiated packet size in flight, or over UDP\n");
+  printf("      bundles several per round trip, writes into the memory-mapped file,\n");
+  printf("      leaves all-zero pages as holes and reports MB/s.\n");
+  printf("      Ranges the target fails to read are retried on their own and left zero.\n");
+  printf("      Exits with 1 if any range could not be read. Not combined with --load\n");
+  printf("      or --verify.\n");
+  printf("\n");
+  printf("--coalesce\n");
+  printf("--------\n");
+  printf("  telnet-rtt --coalesce [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <gap>|off\n");
+  printf("      Serves the small reads of a poll step (ring offsets) from one read of all\n");
+  printf("      ranges at most <gap> bytes apart (default %d). off reads each separately.\n", RTT_COALESCE_GAP);
+  printf("\n");
+  printf("--realtime\n");
+  printf("--------\n");
+  printf("  telnet-rtt --realtime [OPTION]\n");
+  printf("\n");
+  printf("  Options:\n");
+  printf("    <cpu>[:<priority>[:<busy poll us>]]\n");
+  printf("      Low-latency profile for dedicated hosts: pins the poll loop to <cpu> (-1 for\n");
+  printf("      any), runs it under SCHED_FIFO <priority> (default %d) with all memory locked\n", RTT_RT_PRIORITY);
+  printf("      and busy-polls the RCL socket for up to <busy poll us> (default %d, 0 off).\n", RTT_RT_BUSY_POLL);
+  printf("      Polls at a fixed %d ms period, the wake-up jitter is logged with the\n", RTT_COMM_POLL_INTERVAL);
+  printf("      statistics. Needs CAP_SYS_NICE, CAP_IPC_LOCK and CAP_NET_ADMIN.\n");
+  printf("\n");
   printf("--cmm\n");
   printf("--------\n");
   printf("  telnet-rtt --cmm [OPTION]\n");
@@ -2912,6 +6075,19 @@ static const struct option options[] = {
   {"lport"  , required_argument, NULL, 'l'},
   {"cmm"    , required_argument, NULL, 'c'},
   {"record" , required_argument, NULL, 'r'},
+  {"target" , required_argument, NULL, 'T'},
+  {"rttcb"  , required_argument, NULL, 'B'},
+  {"budget" , required_argument, NULL, 'b'},
+  {"apilock", no_argument      , NULL, 'L'},
+  {"apistats", no_argument     , NULL, 'A'},
+  {"rcl"    , required_argument, NULL, 'R'},
+  {"realtime", required_argument, NULL, 'P'},
+  {"coalesce", required_argument, NULL, 'G'},
+  {"capture", required_argument, NULL, 'C'},
+  {"replay" , required_argument, NULL, 'Y'},
+  {"load"   , required_argument, NULL, 'D'},
+  {"verify" , required_argument, NULL, 'V'},
+  {"dump"   , required_argument, NULL, 'M'},
   {NULL     , 0                , NULL,  0 }
 };
 
@@ -2933,14 +6109,20 @@ int main(int argc, char* argv[]) {
   char              *cmmFile     = NULL;
   char              *logFile     = NULL;
 
-  int                ChannelID   =  0;
   int                Result      =  0;
-  int                NumBytes    =  0;
-  unsigned int       Address     =  0;
-  unsigned int       LocalPort   =  0;
-  char               acBuf[2048] = {0};
-  _SYS_SOCKET_HANDLE hSockListen = _SYS_SOCKET_INVALID_HANDLE;
-  _SYS_SOCKET_HANDLE hSockSV     = _SYS_SOCKET_INVALID_HANDLE;
+  unsigned           i           =  0;
+  unsigned           j           =  0;
+  unsigned           NextStats   =  0;
+  RTT_TARGET        *pTarget     = NULL;
+  RTT_BLOCK         *pBlock      = NULL;
+  //
+  // --rttcb arguments, assigned once the --node target exists.
+  // aBlockOwner[] is the number of --target options seen before.
+  //
+  char              *asBlockArg[RTT_MAX_NUM_TARGETS * RTT_MAX_NUM_BLOCKS];
+  unsigned           aBlockOwner[RTT_MAX_NUM_TARGETS * RTT_MAX_NUM_BLOCKS];
+  unsigned           NumBlockArgs =  0;
+  int                HasNodeBlock =  0;
 
   if (argc <= 1) {
     printf("usage : telnet-rtt [OPTION] SUB-COMMAND [OPTION]. (argc <= 1)");
@@ -3010,6 +6192,106 @@ int main(int argc, char* argv[]) {
         }
         logFile = optarg;
         break;
+      case 'T':
+        if(optarg == NULL || _TARGET_Parse(optarg) != 0) {
+          printf("--target option requires <node>:<port>:<lport> with ports 1..65535, at most %d times", RTT_MAX_NUM_TARGETS);
+          goto Done1;
+        }
+        break;
+      case 'B':
+        if(optarg == NULL || NumBlockArgs >= RTT_MAX_NUM_TARGETS * RTT_MAX_NUM_BLOCKS) {
+          printf("--rttcb option requires <symbol|0xaddress>:<access>:<up>[/<down>]:<lport>");
+          goto Done1;
+        }
+        asBlockArg[NumBlockArgs]  = optarg;
+        aBlockOwner[NumBlockArgs] = _NumTargets;
+        HasNodeBlock |= (_NumTargets == 0);
+        NumBlockArgs++;
+        break;
+      case 'b':
+        if(optarg == NULL) {
+          printf("--budget option requires <requests/s>[:<bytes/s>]");
+          goto Done1;
+        }
+        _GovMaxRequests = strtoul(optarg, &optarg, 0);
+        _GovMaxBytes    = (*optarg == ':') ? strtoul(optarg + 1, NULL, 0) : 0u;
+        break;
+      case 'L':
+        _GovUseLock = 1;
+        break;
+      case 'A':
+        T32_EnableApiStats(1);
+        break;
+      case 'C':
+        if(optarg == NULL) {
+          printf("--capture option requires <file>");
+          goto Done1;
+        }
+        _pCaptureFile = optarg;
+        break;
+      case 'Y':
+        if(optarg == NULL || _NumTargets != 0 || T32_Config("RCL=", "REPLAY") != 0) {
+          printf("--replay option requires <file> and must precede --target");
+          goto Done1;
+        }
+        _pReplayFile = optarg;
+        break;
+      case 'D':
+        if(optarg == NULL) {
+          printf("--load option requires <file>:<address>[:<access>]");
+          goto Done1;
+        }
+        _pLoadArg = optarg;
+        break;
+      case 'V':
+        if(optarg == NULL) {
+          printf("--verify option requires <file>:<address>[:<access>]");
+          goto Done1;
+        }
+        _pVerifyArg = optarg;
+        break;
+      case 'M':
+        if(optarg == NULL) {
+          printf("--dump option requires <file>:<address>:<size>[:<access>]");
+          goto Done1;
+        }
+        _pDumpArg = optarg;
+        break;
+      case 'G':
+        if(optarg == NULL) {
+          printf("--coalesce option requires <gap> or off");
+          goto Done1;
+        }
+        _CoalesceGap = (strcmp(optarg, "off") == 0) ? -1 : (int)strtoul(optarg, NULL, 0);
+        break;
+      case 'P':
+#ifdef __linux__
+        if(optarg == NULL) {
+          printf("--realtime option requires <cpu>[:<priority>[:<busy poll us>]]");
+          goto Done1;
+        }
+        _RtEnable = 1;
+        _RtCpu    = (int)strtol(optarg, &optarg, 0);
+        if (*optarg == ':') {
+          _RtPriority = (int)strtol(optarg + 1, &optarg, 0);
+        }
+        if (*optarg == ':') {
+          _RtBusyPollUs = strtoul(optarg + 1, &optarg, 0);
+        }
+#else
+        printf("--realtime option is not supported on this host");
+        goto Done1;
+#endif
+        break;
+      case 'R':
+        //
+        // Channels are sized by the line driver, select it before any target exists
+        //
+        if(optarg == NULL || _NumTargets != 0 || T32_Config("RCL=", optarg) != 0) {
+          printf("--rcl option requires NETASSIST, TCPRELAY or MUX and must precede --target");
+          goto Done1;
+        }
+        break;
       default:
         printf("not a valid option.");
         printf("usage : telnet-rtt [OPTION] SUB-COMMAND [OPTION].");
@@ -3018,124 +6300,121 @@ int main(int argc, char* argv[]) {
     }
   }
 
-  if (Node == NULL || tPort == NULL || lPort == NULL) {
-    printf("--node and --port parameters are required.");
+  if (_pLoadArg != NULL || _pVerifyArg != NULL || _pDumpArg != NULL) {
+    if (_pDumpArg != NULL && (_pLoadArg != NULL || _pVerifyArg != NULL)) {
+      printf("--dump cannot be combined with --load or --verify.");
+      goto Done1;
+    }
+    if (Node == NULL || tPort == NULL) {
+      if (_NumTargets == 0) {
+        printf("--load, --verify and --dump require --node and --tport or --target.");
+        goto Done1;
+      }
+      Node  = _aTarget[0].sNode;
+      tPort = _aTarget[0].sPort;
+    }
+    if (_pDumpArg != NULL) {
+      return _DUMP_Run(Node, tPort, PackLen);
+    }
+    if (_pLoadArg != NULL && _LOAD_Run(Node, tPort, PackLen) != T32_OK) {
+      return 1;
+    }
+    return (_pVerifyArg != NULL) ? _VERIFY_Run(Node, tPort, PackLen) : 0;
+  }
+
+  j = _NumTargets;                                    // Index of the --node target
+  if (Node != NULL && tPort != NULL && (lPort != NULL || HasNodeBlock)) {
+    Result = _TARGET_Add(Node, tPort, lPort);
+    if (Result == -2) {
+      printf("--tport and --lport require a port number 1..65535.");
+      goto Done1;
+    }
+    if (Result != 0) {
+      printf("too many targets.");
+      goto Done1;
+    }
+  }
+  if (_NumTargets == 0) {
+    printf("--node, --tport and --lport or --target parameters are required.");
     printf("usage : telnet-rtt [OPTION] SUB-COMMAND [OPTION].");
+    goto Done1;
+  }
+  for (i = 0; i < NumBlockArgs; i++) {
+    pTarget = (aBlockOwner[i] != 0u) ? &_aTarget[aBlockOwner[i] - 1u] : ((j < _NumTargets) ? &_aTarget[j] : NULL);
+    if (pTarget == NULL || _TARGET_AddBlock(pTarget, asBlockArg[i]) != 0) {
+      printf("invalid --rttcb %s, at most %d per target.", asBlockArg[i], RTT_MAX_NUM_BLOCKS);
+      goto Done1;
+    }
+  }
+  if (logFile != NULL) {
+    _TARGET_SetLogFile(logFile);
   }
 
   SIGNAL_HandlerInit();
-  T32_InitDEVICD(Node, tPort, PackLen, cmmFile);
-
-  Address   = T32_GetRTTCBAddr("_SEGGER_RTT");
-  ChannelID = SEGGER_Terminal_GetChannelID();
-  Log_Print("Address = 0x%08X ChannelID = %d\n", Address, ChannelID);
 
   //
-  // Try and connect to SystemView instance
+  // Open one telnet listener per control block
   //
-  hSockListen = _SYS_SOCKET_OpenTCP();
-  if (hSockListen == _SYS_SOCKET_INVALID_HANDLE) {  // Failed to open socket? => Done
-    Log_Print("Failed to open socket\n");
-    goto Done;
-  }
-  LocalPort = SEGGER_atoi(lPort);
-  Result    = _SYS_SOCKET_ListenAtTCPAddr(hSockListen, _SYS_SOCKET_IP_ADDR_ANY, LocalPort, 1);
-  if (Result < 0) {                                     // Failed to set socket to listening? => Done
-    Log_Print("Failed to set socket to listening\n");
-    goto Done;
+  for (i = 0; i < _NumTargets; i++) {
+    for (j = 0; j < _aTarget[i].NumBlocks; j++) {
+      pBlock = &_aTarget[i].aBlock[j];
+      pBlock->hSockListen = _SYS_SOCKET_OpenTCP();
+      if (pBlock->hSockListen == _SYS_SOCKET_INVALID_HANDLE) {  // Failed to open socket? => Done
+        Log_Print("Failed to open socket\n");
+        goto Done;
+      }
+      Result = _SYS_SOCKET_ListenAtTCPAddr(pBlock->hSockListen, _SYS_SOCKET_IP_ADDR_ANY, pBlock->LocalPort, 1);
+      if (Result < 0) {                                     // Failed to set socket to listening? => Done
+        Log_Print("Failed to set socket to listening\n");
+        goto Done;
+      }
+    }
   }
   //
-  // After a succesful connection, poll RTT buffer for data
+  // Serve all targets from one loop. Each step is non-blocking,
+  // a target which is offline is reconnected in the background.
   //
+#ifdef __linux__
+  if (_pReplayFile == NULL) {
+    _PROBE_Enable(PackLen);
+  }
+#endif
+  if (_RtEnable) {
+    _RT_Enter();
+  }
+  NextStats = SYS_GetTickCount() + RTT_STATS_INTERVAL;
   do {
-    if (hSockSV > _SYS_SOCKET_INVALID_HANDLE) {
-      Result = _SYS_SOCKET_IsWriteable(hSockSV, 10);
-      if (Result == 0) {   // Timeout
-        Log_Print("socket connection timeout .\n");
-        continue;
-      } else if (Result < 0) { // Error
-        Log_Print("socket connection error .\n");
-        _SYS_SOCKET_Close(hSockSV);
-        hSockSV = _SYS_SOCKET_INVALID_HANDLE;
-        continue;
-      }
-    } else {
-      Log_Print("waiting a new socket connection.\n");
-      hSockSV = _SYS_SOCKET_AcceptEx(hSockListen, RTT_IDLE_DELAY);
-      if (hSockSV < 0 && hSockSV != -2 ) {
-        Log_Print("Failed to waiting a new socket connection.\n");
-        SYS_Sleep(1000);
-        continue;
-      }
-      Result = _SYS_SOCKET_IsReady(hSockSV);
-      if (Result != 1) {               // Failed to connect? => Try again later
-        Log_Print("Failed to connect\n");
-        SYS_Sleep(1000);
-        continue;
-      }
-      _SYS_SOCKET_EnableKeepalive(hSockSV);
-      _SYS_SOCKET_SetNonBlocking(hSockSV);
-
-      _SYS_SOCKET_Send(hSockSV, telnetCmd, 9);
-      _SYS_SOCKET_Receive(hSockSV, acBuf, 6);
+    for (i = 0; i < _NumTargets; i++) {
+      _TARGET_Poll(&_aTarget[i], PackLen, cmmFile);
     }
-
-    _WaitPolling(Address, RTT_IDLE_DELAY, ChannelID);
-    //
-    // Connection established? => Handle communication
-    // Check for data sent by SysView
-    //
-    Result = _SYS_SOCKET_IsReadable(hSockSV, 0);
-    if (Result == 1) {                                 // Data to read from SysView available?
-      Result = _SYS_SOCKET_Receive(hSockSV, acBuf, sizeof(acBuf));  // Receive all data
-      if (Result <= 0) {                               // Failed to receive data? => Connection lost
-        Log_Print("connect close: failed to receive data: %d\n", Result);
-        _SYS_SOCKET_Close(hSockSV);
-        hSockSV = _SYS_SOCKET_INVALID_HANDLE;
-        continue;
-      }
-      NumBytes = SEGGER_RTT_WriteDownBufferNoLock(Address, ChannelID, &acBuf[0], Result);  // Write data into corresponding RTT buffer for application to read and handle accordingly
-      if (logFile != NULL) {
-        RTT_TelnetLogS(logFile, &acBuf[0], NumBytes);
-      }
-
-#ifdef _TELNET_RTT_DEBUG
-      T32_RTTCB_Dump(Address);
-      Log_Print("Result = %d, NumBytes = %d, _SYS_SOCKET_Receive (p=0x%08X)\n", Result, NumBytes, acBuf);
-      SYS_Hexdump(acBuf, NumBytes, true, false);
-#endif
+    if ((int)(SYS_GetTickCount() - NextStats) >= 0) {
+      _TARGET_LogStats();
+      NextStats += RTT_STATS_INTERVAL;
     }
-    //
-    // Check for data to send to SysView
-    //
-    NumBytes = SEGGER_RTT_ReadUpBufferNoLock(Address, ChannelID, &acBuf[0], sizeof(acBuf));
-    if (NumBytes > 0) {                               // Data to send available?
-      Result = _SYS_SOCKET_Send(hSockSV, acBuf, NumBytes);  // Send data to SysView
-      if (logFile != NULL) {
-        RTT_TelnetLogS(logFile, &acBuf[0], Result);
-      }
-#ifdef _TELNET_RTT_DEBUG
-      T32_RTTCB_Dump(Address);
-      Log_Print("Result = %d, NumBytes = %d, SYS_SOCKET_Send (p=0x%08X)\n", Result, NumBytes, acBuf);
-      SYS_Hexdump(acBuf, Result, true, false);
-#endif
-      if (NumBytes != Result) {                            // Failed to send data? => Connection lost
-        Log_Print("connect close: failed to send data. err: %d\n", Result);
-        _SYS_SOCKET_Close(hSockSV);
-        hSockSV = _SYS_SOCKET_INVALID_HANDLE;
-      }
+    if (_ApiStatsRequest) {
+      _ApiStatsRequest = 0;
+      _TARGET_LogApiStats();
+    }
+    if (_RtEnable) {
+      _RT_Wait(RTT_COMM_POLL_INTERVAL * 1000u);       // Fixed period, client input waits for the next poll
+    } else {
+      _TARGET_WaitEvents(RTT_COMM_POLL_INTERVAL);     // Wait for client activity or the next poll
     }
-    SYS_Sleep(1);                                     // Sleep for some time before polling again
   } while (1);
 Done:
   //
   // Clean up
   //
-  if (hSockSV >= 0) {
-    _SYS_SOCKET_Close(hSockSV);
-  }
-  if (hSockListen >= 0) {
-    _SYS_SOCKET_Close(hSockListen);
+  for (i = 0; i < _NumTargets; i++) {
+    for (j = 0; j < _aTarget[i].NumBlocks; j++) {
+      pBlock = &_aTarget[i].aBlock[j];
+      if (pBlock->hSockSV >= 0) {
+        _SYS_SOCKET_Close(pBlock->hSockSV);
+      }
+      if (pBlock->hSockListen >= 0) {
+        _SYS_SOCKET_Close(pBlock->hSockListen);
+      }
+    }
   }
 
   SYS_ExitHandler(1);
@@ -190,6 +190,194 @@ T32EXTERN int  T32_APILock(int nTimeoutMS);             /* preliminary*/
 T32EXTERN int  T32_APIUnlock(void);
 T32EXTERN int  T32_GetApiRevision(uint32_t* pRevNum);
 T32EXTERN void T32_GetSocketHandle(int *t32soc);
+T32EXTERN void T32_GetTraffic(uint32_t *pNumRequests, uint32_t *pNumBytes);
+T32EXTERN int  T32_TransferMessage(const uint8_t *pRequest, int nRequest, uint8_t *pReply, int *pnReply);
+
+/* retransmission state of a line, see T32_GetLineStats() */
+typedef struct {
+	uint32_t Retransmits;       /* requests sent again (timeout or duplicate reply) */
+	uint32_t Timeouts;          /* expired retransmission timeouts */
+	uint32_t SrttUs;            /* smoothed round trip time, 0 before the first sample */
+	uint32_t RttVarUs;          /* round trip time variation */
+	uint32_t RtoUs;             /* current retransmission timeout */
+	uint32_t NotificationsDropped;  /* queued notifications lost to a full queue */
+	uint32_t ReplayMismatches;  /* requests differing from the capture, RCL=REPLAY only */
+	uint32_t BusyPollUs;        /* SO_BUSY_POLL in effect, 0: off or refused by the system (BUSYPOLL=) */
+} T32_LineStats;
+
+T32EXTERN int  T32_GetLineStats(T32_LineStats *pStats);
+
+/* call statistics of an API function or line primitive, see T32_EnableApiStats(), T32_GetApiStats() */
+#define T32_APISTATS_BUCKETS    200     /* log-linear, 8 per power of two */
+
+typedef struct {
+	const char *Name;           /* function name */
+	uint32_t Calls;
+	uint32_t Requests;          /* messages sent to TRACE32 within the calls */
+	uint32_t Retransmits;       /* messages sent again within the calls */
+	uint32_t MaxUs;             /* longest call */
+	uint64_t BytesOut;          /* payload bytes sent */
+	uint64_t BytesIn;           /* payload bytes received */
+	uint64_t TotalUs;           /* summed duration of all calls */
+	uint32_t Histogram[T32_APISTATS_BUCKETS];  /* calls per duration, see T32_GetApiStatsBucketUs() */
+} T32_ApiStats;
+
+T32EXTERN void T32_EnableApiStats(int Enable);
+T32EXTERN int  T32_GetApiStats(T32_ApiStats *pStats, int MaxStats);
+T32EXTERN void T32_ResetApiStats(void);
+T32EXTERN uint32_t T32_GetApiStatsBucketUs(int Bucket);
+T32EXTERN uint32_t T32_GetApiStatsPercentile(const T32_ApiStats *pStats, int Percent);
+
+#define T32_MAXPACKETSIZE_DEFAULT   2048    /* data chunk per message before negotiation */
+#define T32_MAXPACKETSIZE_MAX       16384   /* limited by LINE_MSIZE */
+
+T32EXTERN int  T32_NegotiatePacketSize(uint32_t Address, int Access);
+T32EXTERN int  T32_GetMaxPacketSize(void);
+T32EXTERN int  T32_SetMaxPacketSize(int size);
+
+/* binary API trace file (ENABLE_APITRACE, T32APITRACEFILE): a header followed by
+   fixed size records; a T32APITRACE_NAME record is followed by aux bytes of the
+   function name used by later records with the same func */
+#define T32APITRACE_MAGIC       "T32TRACE"
+#define T32APITRACE_VERSION     1
+#define T32APITRACE_MAXARGS     5
+
+#define T32APITRACE_ENTRY       1       /* function entry, arguments */
+#define T32APITRACE_EXIT        2       /* function exit, result */
+#define T32APITRACE_NAME        3       /* name of func */
+#define T32APITRACE_DROPPED     4       /* arg[0] records lost to a full ring */
+
+#define T32APITRACE_ARG_INT     0       /* signed 32 bit */
+#define T32APITRACE_ARG_HEX     1       /* unsigned 32 bit, shown hex */
+#define T32APITRACE_ARG_UINT    2       /* unsigned 64 bit */
+#define T32APITRACE_ARG_STR     3       /* first 8 characters of a string */
+
+typedef struct {
+	char     Magic[8];
+	uint32_t Version;
+	uint32_t RecordSize;            /* sizeof(T32_ApiTraceRecord) */
+} T32_ApiTraceHeader;
+
+typedef struct {
+	uint64_t Time;                  /* ns, monotonic clock */
+	uint64_t Func;                  /* function id, see T32APITRACE_NAME */
+	uint32_t Thread;                /* id of the calling thread's ring */
+	uint8_t  Kind;                  /* T32APITRACE_ENTRY .. T32APITRACE_DROPPED */
+	uint8_t  NumArgs;
+	uint16_t Aux;                   /* 2 bit T32APITRACE_ARG_x per argument, name length */
+	uint64_t Arg[T32APITRACE_MAXARGS];
+} T32_ApiTraceRecord;
+
+/* RCL multiplexer protocol (tools/t32mux.c): a client sends a T32_MuxRequest,
+   followed by Size data bytes for T32MUX_WRITE, over the daemon's Unix domain
+   stream socket and receives a T32_MuxReply with the same Tag, followed by Size
+   data bytes. Host byte order. Requests of one client are served, and replied,
+   in the order they were sent. A client may also send RCL messages framed as by
+   the line driver of hlinktcp.c, the frame type T32MUX_FRAME is no Op; the
+   daemon passes them on with T32_TransferMessage() and returns the reply frame. */
+#define T32MUX_DEFAULT_SOCKET   "/tmp/t32mux.sock"
+#define T32MUX_MAXSIZE          4096    /* data bytes per request */
+#define T32MUX_PRIORITIES       4       /* Priority 0 (highest) .. 3 */
+
+#define T32MUX_READ             1       /* reply data: Size bytes of target memory */
+#define T32MUX_WRITE            2       /* request data: Size bytes to write */
+#define T32MUX_STATS            3       /* reply data: the daemon's metrics as text */
+#define T32MUX_FRAME            0x11    /* framed RCL message instead of a T32_MuxRequest */
+
+typedef struct {
+	uint8_t  Op;                    /* T32MUX_READ .. T32MUX_STATS */
+	uint8_t  Priority;              /* between clients, 0 is served first */
+	uint16_t Reserved;
+	uint32_t Tag;                   /* returned in the reply */
+	uint64_t Address;
+	uint32_t Size;
+	char     Access[12];            /* access class, e.g. "EA:", empty for data */
+} T32_MuxRequest;
+
+typedef struct {
+	uint8_t  Op;
+	uint8_t  Reserved[3];
+	uint32_t Tag;
+	int32_t  Status;                /* T32_OK or a T32 error code */
+	uint32_t Size;
+} T32_MuxReply;
+
+
+/**************************************************/
+/* pipelined asynchronous requests                */
+/**************************************************/
+
+#define T32_ASYNC_MAX_WINDOW        8   /* maximum requests in flight */
+#define T32_ASYNC_DEFAULT_WINDOW    4
+
+typedef void (*T32_AsyncCallback_t)(void *user, int err, uint8_t *pData, int size);
+
+T32EXTERN int T32_AsyncReadMemory (uint32_t Address, int Access, uint8_t *pBuffer, int Size, T32_AsyncCallback_t callback, void *user);
+T32EXTERN int T32_AsyncWriteMemory(uint32_t Address, int Access, const uint8_t *pBuffer, int Size, T32_AsyncCallback_t callback, void *user);
+T32EXTERN int T32_AsyncComplete   (int nMin);
+T32EXTERN int T32_AsyncPoll       (void);
+T32EXTERN int T32_AsyncPending    (void);
+T32EXTERN int T32_AsyncSetWindow  (int nWindow);
+T32EXTERN int T32_AsyncGetWindow  (void);
+T32EXTERN int T32_AsyncWriteMemoryPipe(uint32_t Address, int Access, const uint8_t *pBuffer, int Size, T32_AsyncCallback_t callback, void *user);
+
+/* progress of T32_LoadMemory() */
+typedef struct {
+	uint32_t Done;                  /* bytes acknowledged in sequence, from offset 0 */
+	uint32_t Start;                 /* Done when this call started, see resuming */
+	uint32_t Total;
+	uint32_t PacketSize;            /* data bytes per pipe packet */
+	uint32_t Window;                /* packets kept in flight, 1 over UDP; of T32_DumpMemory(): per round trip */
+	uint32_t Retransmits;           /* within this call */
+	uint64_t ElapsedUs;             /* since this call started */
+} T32_LoadProgress;
+
+typedef int (*T32_LoadProgressCallback_t)(void *user, const T32_LoadProgress *progress);
+
+T32EXTERN int T32_LoadMemory(uint32_t Address, int Access, const uint8_t *pBuffer, uint32_t Size, uint32_t *pDone, T32_LoadProgressCallback_t progress, void *user);
+
+/* data of T32_DumpMemory(), pData NULL with the error of a range the target failed to read */
+typedef void (*T32_DumpDataCallback_t)(void *user, uint32_t Offset, const uint8_t *pData, uint32_t Size, int err);
+
+T32EXTERN int T32_DumpMemory(uint32_t Address, int Access, uint32_t Size, uint32_t *pDone, T32_DumpDataCallback_t data, T32_LoadProgressCallback_t progress, void *user);
+
+/* result of T32_VerifyMemory() */
+typedef struct {
+	uint32_t Checksums;             /* ranges checksummed by TRACE32 */
+	uint32_t BytesRead;             /* read back to locate differences */
+	uint32_t BadBlocks;
+	uint32_t BadBytes;
+} T32_VerifyStats;
+
+typedef void (*T32_VerifyMismatchCallback_t)(void *user, uint32_t Address, const uint8_t *pTarget, const uint8_t *pExpected, uint32_t Size);
+
+T32EXTERN uint32_t T32_Crc32(uint32_t crc, const uint8_t *pData, uint32_t Size);
+T32EXTERN int T32_VerifyMemory(uint32_t Address, int Access, const uint8_t *pBuffer, uint32_t Size, uint32_t BlockSize, T32_VerifyMismatchCallback_t mismatch, void *user, T32_VerifyStats *pStats);
+
+
+/**************************************************/
+/* explicit context API, one context per session */
+/**************************************************/
+
+typedef struct T32_Context_s T32_Context;
+
+T32EXTERN int  T32_CtxCreate(T32_Context **pCtx);
+T32EXTERN void T32_CtxDestroy(T32_Context *ctx);
+T32EXTERN int  T32_CtxConfig(T32_Context *ctx, const char *String1, const char *String2);
+T32EXTERN int  T32_CtxInit(T32_Context *ctx);
+T32EXTERN int  T32_CtxExit(T32_Context *ctx);
+T32EXTERN int  T32_CtxAttach(T32_Context *ctx, int DeviceSpecifier);
+T32EXTERN int  T32_CtxGetErrno(T32_Context *ctx);
+T32EXTERN void T32_CtxGetSocketHandle(T32_Context *ctx, int *t32soc);
+T32EXTERN int  T32_CtxGetLineStats(T32_Context *ctx, T32_LineStats *pStats);
+T32EXTERN int  T32_CtxGetState(T32_Context *ctx, int *pSystemState);
+T32EXTERN int  T32_CtxGetSymbol(T32_Context *ctx, const char *SymbolName, uint32_t *pAddress, uint32_t *pSize, uint32_t *pAccess);
+T32EXTERN int  T32_CtxReadMemory(T32_Context *ctx, uint32_t Address, int Access, uint8_t *pBuffer, int Size);
+T32EXTERN int  T32_CtxReadMemoryWrapped(T32_Context *ctx, uint32_t Address, int Access, uint8_t *pBuffer0, int Size0, uint8_t *pBuffer1, int Size1);
+T32EXTERN int  T32_CtxWriteMemory(T32_Context *ctx, uint32_t Address, int Access, const uint8_t *pBuffer, int Size);
+T32EXTERN int  T32_CtxWriteMemoryPipe(T32_Context *ctx, uint32_t Address, int Access, const uint8_t *pBuffer, int Size);
+T32EXTERN int  T32_CtxNegotiatePacketSize(T32_Context *ctx, uint32_t Address, int Access);
+T32EXTERN int  T32_CtxGetMaxPacketSize(T32_Context *ctx);
 
 
 /*******************************/
@@ -334,6 +522,7 @@ T32EXTERN int  T32_SetMode(int Mode);
 T32EXTERN int  T32_GetCpuInfo(char **pCPUString, uint16_t *pFPUType, uint16_t *pEndianess, uint16_t *pReserved);
 T32EXTERN int  T32_GetState(int *pSystemState);
 T32EXTERN int  T32_ReadMemory     (uint32_t Address, int Access, uint8_t *pBuffer, int Size);
+T32EXTERN int  T32_ReadMemoryWrapped(uint32_t Address, int Access, uint8_t *pBuffer0, int Size0, uint8_t *pBuffer1, int Size1);
 T32EXTERN int  T32_WriteMemory    (uint32_t Address, int Access, const uint8_t *pBuffer, int Size);
 T32EXTERN int  T32_WriteMemoryPipe(uint32_t Address, int Access, const uint8_t *pBuffer, int Size);
 T32EXTERN int  T32_SetMemoryAccessClass(const char* Access);
@@ -368,6 +557,9 @@ typedef void (*T32_NotificationCallback_iicp_t) (int, int, const char*);
 typedef void (*T32_NotificationCallback_iqqq_t) (int, uint64_t, uint64_t, uint64_t);
 T32EXTERN int T32_NotifyEventEnable(const char* event, T32_NotificationCallback_i_t pFunction);
 T32EXTERN int T32_NotifyStateEnable(int EventNumber, T32_NotificationCallback_t pFunction);
+T32EXTERN int T32_CtxNotifyStateEnable(T32_Context *ctx, int EventNumber, T32_NotificationCallback_t pFunction);
+T32EXTERN int T32_CtxCheckStateNotify(T32_Context *ctx, unsigned ParameterOfCallbackFunction);
+T32EXTERN int T32_CtxNotificationPending(T32_Context *ctx);
 inline int T32_NotifyBreakEnable(T32_NotificationCallback_iqq_t pFunction){
 	return T32_NotifyStateEnable(T32_E_BREAK, (T32_NotificationCallback_t) pFunction);
 }
@@ -434,6 +626,7 @@ typedef struct {
 	uint32_t        used;
 	uint8_t        *storage;
 	uint32_t        bufsize;
+	uint32_t        capacity;	/* allocated size of storage, >= bufsize */
 } T32_BufferObj;
 
 /* Buffer handle */
@@ -790,6 +983,7 @@ typedef uint32_t T32_Size;
 
 T32EXTERN int T32_RequestMemoryBundleObj (T32_MemoryBundleHandle *pHandle, const int initial_size);
 T32EXTERN int T32_ReleaseMemoryBundleObj (T32_MemoryBundleHandle *pHandle);
+T32EXTERN int T32_ResetMemoryBundleObj (T32_MemoryBundleHandle bundleHandle);
 
 T32EXTERN int T32_AddToBundleObjAddrLengthByteArray (T32_MemoryBundleHandle bundleHandle, const T32_AddressHandle addrHandle, const T32_Length length, uint8_t *localbuffer);
 T32EXTERN int T32_AddToBundleObjAddrLengthByteArrayMaskArray (T32_MemoryBundleHandle bundleHandle, const T32_AddressHandle addrHandle, const T32_Length length, uint8_t *localbuffer, uint8_t *localmaskbuffer);
@@ -800,6 +994,7 @@ T32EXTERN int T32_GetBundleObjSyncStatusByIndex (T32_MemoryBundleHandle bundleHa
 T32EXTERN int T32_CopyDataFromBundleObjByIndex (uint8_t* localbuffer, int lbsize, T32_MemoryBundleHandle bundleHandle, T32_Index index);
 
 T32EXTERN int T32_TransferMemoryBundleObj (T32_MemoryBundleHandle bundles);
+T32EXTERN int T32_CtxTransferMemoryBundleObj (T32_Context *ctx, T32_MemoryBundleHandle bundles);
 
 /** Memory access API **/
 
@@ -1072,6 +1267,12 @@ T32EXTERN int  T32_ExecuteLua(const char* filename, int mode, const uint8_t* inp
 // These definitions are not intended to be used by a customer.
 // So these definitions are protected by the above #if
 typedef struct LineStruct_s LineStruct;
+/* destination of scattered message data, see ReceiveV */
+typedef struct {
+	unsigned char *data;
+	int      size;
+} LineSegment;
+#define LINE_MAXSEGMENTS 4
 struct T32InternalLineDriver {
 	int      (*Config)(char *in);                              // LINE_LineConfig(char *in);
 	int      (*Init)(char *message);                           // LINE_LineInit(char *message);
@@ -1089,8 +1290,62 @@ struct T32InternalLineDriver {
 	unsigned char (*GetNextMessageId)(void);                   // LINE_GetNextMessageId(void);
 	unsigned char (*GetMessageId)(void);                       // LINE_GetMessageId(void);
 	int      (*NotificationPending)(void);                     // LINE_NotificationPending(void);
+	/* explicit line variants, used by the T32_Ctx* API */
+	int      (*ConfigEx)(LineStruct * line, char *in);
+	int      (*InitEx)(LineStruct * line, char *message);
+	void     (*ExitEx)(LineStruct * line);
+	int      (*GetSocketEx)(LineStruct * line);
+	int      (*TransmitEx)(LineStruct * line, unsigned char *in, int size);
+	int      (*ReceiveEx)(LineStruct * line, unsigned char *out);
+	int      (*ReceiveNotifyMessageEx)(LineStruct * line, unsigned char *package);
+	int      (*SyncEx)(LineStruct * line);
+	void     (*SetReceiveToggleBitEx)(LineStruct * line, int value);
+	int      (*GetReceiveToggleBitEx)(LineStruct * line);
+	unsigned char (*GetNextMessageIdEx)(LineStruct * line);
+	unsigned char (*GetMessageIdEx)(LineStruct * line);
+	int      (*NotificationPendingEx)(LineStruct * line);
+	/* scatter-gather transmit: message head followed by an uncopied payload and padding zero bytes */
+	int      (*TransmitV)(unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding);
+	int      (*TransmitVEx)(LineStruct * line, unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding);
+	/* scatter receive: message head to out, following bytes to the segments */
+	int      (*ReceiveV)(unsigned char *out, int headSize, const LineSegment * seg, int nseg);
+	int      (*ReceiveVEx)(LineStruct * line, unsigned char *out, int headSize, const LineSegment * seg, int nseg);
+	/* retransmission statistics */
+	void     (*GetStats)(T32_LineStats * stats);
+	void     (*GetStatsEx)(LineStruct * line, T32_LineStats * stats);
+	/* non-blocking readiness check, see GetSocket */
+	int      (*ReceivePending)(void);
+	int      (*ReceivePendingEx)(LineStruct * line);
+	/* data chunk per message of the connection, see T32_NegotiatePacketSize() */
+	int      (*GetMaxPacketSize)(void);
+	void     (*SetMaxPacketSize)(int size);
+	int      (*GetMaxPacketSizeEx)(LineStruct * line);
+	void     (*SetMaxPacketSizeEx)(LineStruct * line, int size);
+	/* requests the driver keeps in flight and recovers when packets are lost, see T32_AsyncGetWindow() */
+	int      MaxPending;
 };
 extern struct T32InternalLineDriver *gT32InternalLineDriver;
+extern struct T32InternalLineDriver gLineDrvNetAssist;  /* hlinknet.c, UDP */
+extern struct T32InternalLineDriver gLineDrvNetTcp;     /* hlinktcp.c, TCP */
+extern struct T32InternalLineDriver gLineDrvMux;        /* hlinktcp.c, Unix domain socket of t32mux */
+extern struct T32InternalLineDriver gLineDrvReplay;     /* hlinkreplay.c, replay of a capture */
+
+/* RCL packet capture, hlinkcap.c */
+#define T32_CAPTURE_INBOUND  1      /* epb_flags direction values */
+#define T32_CAPTURE_OUTBOUND 2
+typedef struct {
+	uint64_t TimeNs;            /* capture time, nanoseconds since 1970 */
+	int      Direction;         /* T32_CAPTURE_INBOUND/OUTBOUND, 0: not recorded */
+	unsigned short SrcPort, DstPort;
+	int      Size;              /* size of the UDP payload */
+	unsigned char *Data;        /* UDP payload, i.e. the RCL packet */
+} T32_CaptureRecord;
+extern volatile int T32_CaptureActive;
+int      T32_CaptureOpen(const char *filename);
+void     T32_CaptureClose(void);
+void     T32_CapturePacket(int direction, uint32_t remoteIp, unsigned short remotePort, unsigned short localPort, const unsigned char *data, int size);
+int      T32_CaptureLoad(const char *filename, T32_CaptureRecord ** pRecords, int *pCount);
+void     T32_CaptureFree(T32_CaptureRecord * records, int count);
 #endif
 #endif
 
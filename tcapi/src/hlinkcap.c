@@ -0,0 +1,569 @@
+/*
+ * TRACE32 Remote API
+ *
+ * Copyright (c) 1998-2020 Lauterbach GmbH
+ * All rights reserved
+ *
+ * Capture of the RCL datagrams of hlinknet.c to a pcapng file, enabled
+ * with T32_Config("CAPTURE=", "<file>"), and the reader of such files used
+ * by the replay driver of hlinkreplay.c.
+ *
+ * The file has one interface of link type LINKTYPE_IPV4 with nanosecond
+ * timestamps, each datagram gets a synthesized IPv4/UDP header so that
+ * Wireshark decodes addresses and ports. The direction is stored in the
+ * epb_flags option. Packets are formatted by the caller's thread into a
+ * bounded buffer which a background thread writes to the file; when the
+ * buffer is full packets are dropped and counted, the count goes into an
+ * Interface Statistics Block at the end of the file.
+ *
+ * Licensing restrictions apply to this code.
+ * Please see documentation (api_remote_c.pdf) for
+ * licensing terms and conditions.
+ *
+ * formatted with:
+ *    indent -kr -c0 -cbi0 -cd0 -cli4 -cp10 -di16 -fc1 -il0 -nsc -ppi2 --line-length120 --no-tabs hlinkcap.c
+ */
+
+
+#if defined(T32HOST_UNIX)
+# ifndef T32HOST_SOL
+#  define _XOPEN_SOURCE 500
+# endif
+# ifndef _POSIX_C_SOURCE
+#  define _POSIX_C_SOURCE 200112L
+# endif
+# if defined(T32HOST_SOL)
+#  define __EXTENSIONS__
+# endif
+#endif
+
+
+#define T32INTERNAL_MAGIC 0xfe8ac993
+#include "t32.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(T32HOST_UNIX)
+# include <pthread.h>
+# include <time.h>
+#endif
+
+
+#define PCAPNG_SHB              0x0A0D0D0A  /* section header block */
+#define PCAPNG_IDB              0x00000001  /* interface description block */
+#define PCAPNG_ISB              0x00000005  /* interface statistics block */
+#define PCAPNG_EPB              0x00000006  /* enhanced packet block */
+#define PCAPNG_BYTEORDER        0x1A2B3C4D
+#define PCAPNG_LINKTYPE_ETHERNET 1
+#define PCAPNG_LINKTYPE_SLL     113
+#define PCAPNG_LINKTYPE_IPV4    228
+#define PCAPNG_MAXIF            16          /* interfaces whose timestamp resolution is tracked when reading */
+
+#define CAPTURE_HEADERS         28          /* IPv4 + UDP header in front of each datagram */
+#define CAPTURE_BLOCK_MAX       (28 + CAPTURE_HEADERS + 0x4000 + 12 + 4)   /* EPB of the largest UDP packet */
+#define CAPTURE_RING_SIZE       (1024 * 1024)   /* bytes of formatted blocks not yet written */
+#define CAPTURE_FLUSH_MS        20
+
+
+volatile int    T32_CaptureActive = 0;
+
+
+static void Put16(unsigned char *p, unsigned int v)
+{
+	uint16_t        x = (uint16_t) v;
+	memcpy(p, &x, 2);
+}
+
+
+static void Put32(unsigned char *p, uint32_t v)
+{
+	memcpy(p, &v, 4);
+}
+
+
+static uint32_t Get32(const unsigned char *p)
+{
+	uint32_t        v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+
+static unsigned int Get16(const unsigned char *p)
+{
+	uint16_t        v;
+	memcpy(&v, p, 2);
+	return v;
+}
+
+
+/**************************************************************************
+
+ writer
+
+***************************************************************************/
+
+#if defined(T32HOST_UNIX)
+
+static FILE    *CaptureFile = NULL;
+static unsigned char *CaptureRing = NULL;
+static size_t   CaptureHead, CaptureTail;   /* bytes produced / written, modulo is the ring position */
+static uint64_t CaptureDropped;
+static int      CaptureStop;
+static pthread_t CaptureThread;
+static pthread_mutex_t CaptureMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t CaptureCond = PTHREAD_COND_INITIALIZER;
+
+
+static uint64_t CaptureTimeNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+
+/** Writes blocks in the ring to the file, waking up when the ring is half full or every CAPTURE_FLUSH_MS. */
+static void    *CaptureWriter(void *arg)
+{
+	struct timespec until;
+	size_t          tail, used, pos, chunk;
+	int             stop;
+
+	(void) arg;
+	pthread_mutex_lock(&CaptureMutex);
+	for (;;) {
+		if (!CaptureStop && CaptureHead - CaptureTail < CAPTURE_RING_SIZE / 2) {
+			clock_gettime(CLOCK_REALTIME, &until);
+			until.tv_nsec += CAPTURE_FLUSH_MS * 1000000L;
+			if (until.tv_nsec >= 1000000000L) {
+				until.tv_sec++;
+				until.tv_nsec -= 1000000000L;
+			}
+			pthread_cond_timedwait(&CaptureCond, &CaptureMutex, &until);
+		}
+		stop = CaptureStop;
+		tail = CaptureTail;
+		used = CaptureHead - tail;
+		pthread_mutex_unlock(&CaptureMutex);
+
+		/* producers only write to the free part of the ring, this part is stable */
+		pos = tail % CAPTURE_RING_SIZE;
+		chunk = (used < CAPTURE_RING_SIZE - pos) ? used : CAPTURE_RING_SIZE - pos;
+		if (chunk)
+			fwrite(CaptureRing + pos, 1, chunk, CaptureFile);
+		if (used > chunk)
+			fwrite(CaptureRing, 1, used - chunk, CaptureFile);
+		if (used)
+			fflush(CaptureFile);
+
+		pthread_mutex_lock(&CaptureMutex);
+		CaptureTail = tail + used;
+		if (stop && CaptureHead == CaptureTail)
+			break;
+	}
+	pthread_mutex_unlock(&CaptureMutex);
+	return NULL;
+}
+
+
+/** Appends a block to the ring or counts it as dropped. */
+static void CaptureAppend(const unsigned char *block, size_t size)
+{
+	size_t          pos, chunk, used;
+
+	pthread_mutex_lock(&CaptureMutex);
+	if (!CaptureRing || CaptureStop) {
+		pthread_mutex_unlock(&CaptureMutex);
+		return;
+	}
+	used = CaptureHead - CaptureTail;
+	if (CAPTURE_RING_SIZE - used < size) {
+		CaptureDropped++;
+		pthread_mutex_unlock(&CaptureMutex);
+		return;
+	}
+	pos = CaptureHead % CAPTURE_RING_SIZE;
+	chunk = (size < CAPTURE_RING_SIZE - pos) ? size : CAPTURE_RING_SIZE - pos;
+	memcpy(CaptureRing + pos, block, chunk);
+	memcpy(CaptureRing, block + chunk, size - chunk);
+	CaptureHead += size;
+	/* wake the writer early only when needed, no syscall per packet otherwise */
+	if (used < CAPTURE_RING_SIZE / 2 && used + size >= CAPTURE_RING_SIZE / 2)
+		pthread_cond_signal(&CaptureCond);
+	pthread_mutex_unlock(&CaptureMutex);
+}
+
+
+/** Checksum of the synthesized IPv4 header. */
+static unsigned int IpChecksum(const unsigned char *hdr)
+{
+	uint32_t        sum = 0;
+	int             i;
+
+	for (i = 0; i < 20; i += 2)
+		sum += (hdr[i] << 8) | hdr[i + 1];
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return ~sum & 0xffff;
+}
+
+
+/**
+	Records a datagram of the RCL.
+
+	@param direction  T32_CAPTURE_INBOUND or T32_CAPTURE_OUTBOUND
+	@param remoteIp   address of TRACE32, network byte order
+	@param remotePort UDP port of TRACE32
+	@param localPort  UDP port of the host side
+	@param data       UDP payload
+	@param size       size of payload
+*/
+void T32_CapturePacket(int direction, uint32_t remoteIp, unsigned short remotePort, unsigned short localPort,
+		       const unsigned char *data, int size)
+{
+	unsigned char   block[CAPTURE_BLOCK_MAX];
+	unsigned char  *ip = block + 28, *udp = block + 48;
+	uint64_t        now = CaptureTimeNs();
+	int             captured = size + CAPTURE_HEADERS;
+	int             padded = (captured + 3) & ~3;
+	int             total = 28 + padded + 12 + 4;
+	unsigned short  srcPort, dstPort;
+
+	if (size < 0 || size > 0x4000)
+		return;
+
+	/* enhanced packet block */
+	Put32(block + 0, PCAPNG_EPB);
+	Put32(block + 4, total);
+	Put32(block + 8, 0);                                /* interface 0 */
+	Put32(block + 12, (uint32_t) (now >> 32));
+	Put32(block + 16, (uint32_t) now);
+	Put32(block + 20, captured);
+	Put32(block + 24, captured);
+
+	/* IPv4 header, big endian; the host side address is not known to the driver and stays 0.0.0.0 */
+	memset(ip, 0, 20);
+	ip[0] = 0x45;
+	ip[2] = (unsigned char) (captured >> 8);
+	ip[3] = (unsigned char) captured;
+	ip[6] = 0x40;                                       /* don't fragment */
+	ip[8] = 64;                                         /* TTL */
+	ip[9] = 17;                                         /* UDP */
+	if (direction == T32_CAPTURE_OUTBOUND) {
+		memcpy(ip + 16, &remoteIp, 4);
+		srcPort = localPort;
+		dstPort = remotePort;
+	} else {
+		memcpy(ip + 12, &remoteIp, 4);
+		srcPort = remotePort;
+		dstPort = localPort;
+	}
+	Put16(ip + 10, 0);
+	ip[10] = (unsigned char) (IpChecksum(ip) >> 8);
+	ip[11] = (unsigned char) IpChecksum(ip);
+
+	/* UDP header without checksum */
+	udp[0] = (unsigned char) (srcPort >> 8);
+	udp[1] = (unsigned char) srcPort;
+	udp[2] = (unsigned char) (dstPort >> 8);
+	udp[3] = (unsigned char) dstPort;
+	udp[4] = (unsigned char) ((size + 8) >> 8);
+	udp[5] = (unsigned char) (size + 8);
+	udp[6] = udp[7] = 0;
+
+	memcpy(block + 56, data, size);
+	memset(block + 28 + captured, 0, padded - captured);
+
+	/* epb_flags with the direction, end of options, trailing length */
+	Put16(block + 28 + padded, 2);
+	Put16(block + 30 + padded, 4);
+	Put32(block + 32 + padded, (uint32_t) direction);
+	Put32(block + 36 + padded, 0);
+	Put32(block + 40 + padded, total);
+
+	CaptureAppend(block, total);
+}
+
+
+/**
+	Starts a capture to the given file, ending a previous one.
+	@return 0 on success, -1 on error
+*/
+int T32_CaptureOpen(const char *filename)
+{
+	unsigned char   hdr[28 + 20 + 12];
+
+	T32_CaptureClose();
+	CaptureFile = fopen(filename, "wb");
+	if (!CaptureFile)
+		return -1;
+
+	/* section header block, version 1.0, section length unknown */
+	Put32(hdr + 0, PCAPNG_SHB);
+	Put32(hdr + 4, 28);
+	Put32(hdr + 8, PCAPNG_BYTEORDER);
+	Put16(hdr + 12, 1);
+	Put16(hdr + 14, 0);
+	Put32(hdr + 16, 0xffffffffu);
+	Put32(hdr + 20, 0xffffffffu);
+	Put32(hdr + 24, 28);
+
+	/* interface description block, raw IPv4, no snap length, if_tsresol = 10^-9 */
+	Put32(hdr + 28, PCAPNG_IDB);
+	Put32(hdr + 32, 32);
+	Put16(hdr + 36, PCAPNG_LINKTYPE_IPV4);
+	Put16(hdr + 38, 0);
+	Put32(hdr + 40, 0);
+	Put16(hdr + 44, 9);
+	Put16(hdr + 46, 1);
+	hdr[48] = 9;
+	hdr[49] = hdr[50] = hdr[51] = 0;
+	Put32(hdr + 52, 0);
+	Put32(hdr + 56, 32);
+
+	if (fwrite(hdr, 1, sizeof(hdr), CaptureFile) != sizeof(hdr) || !(CaptureRing = (unsigned char *) malloc(CAPTURE_RING_SIZE))) {
+		fclose(CaptureFile);
+		CaptureFile = NULL;
+		return -1;
+	}
+	CaptureHead = CaptureTail = 0;
+	CaptureDropped = 0;
+	CaptureStop = 0;
+	if (pthread_create(&CaptureThread, NULL, CaptureWriter, NULL)) {
+		free(CaptureRing);
+		CaptureRing = NULL;
+		fclose(CaptureFile);
+		CaptureFile = NULL;
+		return -1;
+	}
+	{
+		static int      registered;
+		if (!registered++)
+			atexit(T32_CaptureClose);
+	}
+	T32_CaptureActive = 1;
+	return 0;
+}
+
+
+/** Writes the pending packets and the drop count, closes the capture file. */
+void T32_CaptureClose(void)
+{
+	unsigned char   isb[24 + 12 + 4 + 4];
+	uint64_t        now;
+
+	if (!CaptureFile)
+		return;
+	T32_CaptureActive = 0;
+	pthread_mutex_lock(&CaptureMutex);
+	CaptureStop = 1;
+	pthread_cond_signal(&CaptureCond);
+	pthread_mutex_unlock(&CaptureMutex);
+	pthread_join(CaptureThread, NULL);
+
+	/* interface statistics block with isb_ifdrop */
+	now = CaptureTimeNs();
+	Put32(isb + 0, PCAPNG_ISB);
+	Put32(isb + 4, sizeof(isb));
+	Put32(isb + 8, 0);
+	Put32(isb + 12, (uint32_t) (now >> 32));
+	Put32(isb + 16, (uint32_t) now);
+	Put16(isb + 20, 5);
+	Put16(isb + 22, 8);
+	memcpy(isb + 24, &CaptureDropped, 8);
+	Put32(isb + 32, 0);
+	Put32(isb + 36, sizeof(isb));
+	fwrite(isb, 1, sizeof(isb), CaptureFile);
+	fclose(CaptureFile);
+	CaptureFile = NULL;
+
+	pthread_mutex_lock(&CaptureMutex);
+	free(CaptureRing);
+	CaptureRing = NULL;
+	pthread_mutex_unlock(&CaptureMutex);
+}
+
+#else
+
+/* no background writer on this host */
+void T32_CapturePacket(int direction, uint32_t remoteIp, unsigned short remotePort, unsigned short localPort,
+		       const unsigned char *data, int size)
+{
+	(void) direction, (void) remoteIp, (void) remotePort, (void) localPort, (void) data, (void) size;
+}
+
+int T32_CaptureOpen(const char *filename)
+{
+	(void) filename;
+	return -1;
+}
+
+void T32_CaptureClose(void)
+{
+}
+
+#endif
+
+
+/**************************************************************************
+
+ reader
+
+***************************************************************************/
+
+/** Adds the UDP payload of a captured frame to the list, other frames are ignored. */
+static int LoadPacket(T32_CaptureRecord ** records, int *count, int *alloc, int linktype, uint64_t timeNs,
+		      uint32_t flags, const unsigned char *frame, uint32_t len)
+{
+	T32_CaptureRecord *rec;
+	unsigned int    ihl, ethertype;
+
+	switch (linktype) {
+	case PCAPNG_LINKTYPE_ETHERNET:
+		if (len < 14)
+			return 0;
+		ethertype = (frame[12] << 8) | frame[13];
+		frame += 14;
+		len -= 14;
+		break;
+	case PCAPNG_LINKTYPE_SLL:
+		if (len < 16)
+			return 0;
+		ethertype = (frame[14] << 8) | frame[15];
+		frame += 16;
+		len -= 16;
+		break;
+	case PCAPNG_LINKTYPE_IPV4:
+		ethertype = 0x0800;
+		break;
+	default:
+		return 0;
+	}
+	if (ethertype != 0x0800 || len < 20 || (frame[0] >> 4) != 4 || frame[9] != 17)
+		return 0;
+	ihl = (frame[0] & 0x0f) * 4;
+	if (len < ihl + 8)
+		return 0;
+
+	if (*count == *alloc) {
+		*alloc = *alloc ? *alloc * 2 : 1024;
+		rec = (T32_CaptureRecord *) realloc(*records, *alloc * sizeof(T32_CaptureRecord));
+		if (!rec)
+			return -1;
+		*records = rec;
+	}
+	rec = &(*records)[*count];
+	rec->TimeNs = timeNs;
+	rec->Direction = (int) (flags & 3);
+	rec->SrcPort = (unsigned short) ((frame[ihl] << 8) | frame[ihl + 1]);
+	rec->DstPort = (unsigned short) ((frame[ihl + 2] << 8) | frame[ihl + 3]);
+	rec->Size = (int) (len - ihl - 8);
+	rec->Data = (unsigned char *) malloc(rec->Size ? rec->Size : 1);
+	if (!rec->Data)
+		return -1;
+	memcpy(rec->Data, frame + ihl + 8, rec->Size);
+	(*count)++;
+	return 0;
+}
+
+
+/**
+	Reads the UDP datagrams of a pcapng file, e.g. one written by
+	T32_CaptureOpen() or by tcpdump on an Ethernet interface. Only
+	sections in host byte order are supported.
+
+	@param filename  capture file
+	@param pRecords  OUT, array of records, release with T32_CaptureFree()
+	@param pCount    OUT, number of records
+	@return 0 on success, -1 on error
+*/
+int T32_CaptureLoad(const char *filename, T32_CaptureRecord ** pRecords, int *pCount)
+{
+	FILE           *f;
+	unsigned char   head[8], *body = NULL, *opt;
+	uint32_t        type, length, flags, optlen;
+	uint64_t        ts, scale[PCAPNG_MAXIF];
+	int             linktype[PCAPNG_MAXIF];
+	int             numif = 0, count = 0, alloc = 0, i, err = -1;
+	T32_CaptureRecord *records = NULL;
+
+	f = fopen(filename, "rb");
+	if (!f)
+		return -1;
+	while (fread(head, 1, 8, f) == 8) {
+		type = Get32(head);
+		length = Get32(head + 4);
+		if (length < 12 || (length & 3) || length > 0x100000)
+			goto done;
+		free(body);
+		body = (unsigned char *) malloc(length - 8);
+		if (!body || fread(body, 1, length - 8, f) != length - 8)
+			goto done;
+
+		switch (type) {
+		case PCAPNG_SHB:
+			if (Get32(body) != PCAPNG_BYTEORDER)
+				goto done;      /* foreign byte order */
+			numif = 0;
+			break;
+		case PCAPNG_IDB:
+			if (numif == PCAPNG_MAXIF || length < 20)
+				break;
+			linktype[numif] = (int) Get16(body);
+			scale[numif] = 1000;        /* default resolution is microseconds */
+			/* if_tsresol: power of ten */
+			for (opt = body + 8; opt + 4 <= body + length - 12 && Get16(opt); opt += 4 + ((optlen + 3) & ~3u)) {
+				optlen = Get16(opt + 2);
+				if (Get16(opt) == 9 && optlen == 1 && !(opt[4] & 0x80) && opt[4] <= 9)
+					for (scale[numif] = 1, i = opt[4]; i < 9; i++)
+						scale[numif] *= 10;
+			}
+			numif++;
+			break;
+		case PCAPNG_EPB:
+			if (length < 32 || Get32(body) >= (uint32_t) numif || Get32(body + 12) > length - 32)
+				break;
+			i = (int) Get32(body);
+			ts = ((uint64_t) Get32(body + 4) << 32 | Get32(body + 8)) * scale[i];
+			flags = 0;
+			for (opt = body + 20 + ((Get32(body + 12) + 3) & ~3u); opt + 4 <= body + length - 12 && Get16(opt);
+			     opt += 4 + ((optlen + 3) & ~3u)) {
+				optlen = Get16(opt + 2);
+				if (Get16(opt) == 2 && optlen == 4)
+					flags = Get32(opt + 4);
+			}
+			if (LoadPacket(&records, &count, &alloc, linktype[i], ts, flags, body + 20, Get32(body + 12)))
+				goto done;
+			break;
+		default:
+			break;
+		}
+	}
+	err = 0;
+
+done:
+	free(body);
+	fclose(f);
+	if (err) {
+		T32_CaptureFree(records, count);
+		return -1;
+	}
+	*pRecords = records;
+	*pCount = count;
+	return 0;
+}
+
+
+/** Releases the records of T32_CaptureLoad(). */
+void T32_CaptureFree(T32_CaptureRecord * records, int count)
+{
+	int             i;
+
+	for (i = 0; i < count; i++)
+		free(records[i].Data);
+	free(records);
+}
@@ -21,6 +21,10 @@
  */
 
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE    /* sendmmsg(), recvmmsg() */
+#endif
+
 #if defined(T32HOST_UNIX)
 # ifndef T32HOST_SOL
 #  define _XOPEN_SOURCE 500
@@ -66,6 +70,8 @@ typedef int     socklen_t;
 # include <netinet/in.h>
 # include <netdb.h>
 # include <sys/select.h>
+# include <sys/uio.h>
+# include <poll.h>
 #endif
 
 
@@ -77,15 +83,65 @@ typedef int     socklen_t;
 
 
 #define PCKLEN_MAX 0x4000 /* maximum size of UDP-packet */
+#define RCVBUF_ASYNC (4 * T32_ASYNC_MAX_WINDOW * T32_MAXPACKETSIZE_MAX) /* incl. the kernel's per packet overhead */
+
+/*
+	On Linux all packets of a message are sent with one sendmmsg() and
+	pending packets are drained with one recvmmsg() into a per-line queue,
+	instead of one syscall (plus a wait) per packet.
+*/
+#if defined(T32HOST_LINUX) && !defined(T32_NO_MMSG)
+# define LINE_USE_MMSG
+# define LINE_MMSG_BATCH 32     /* packets per syscall */
+#endif
+
+/*
+	On UNIX hosts packets are gathered from header and payload iovecs with
+	sendmsg()/sendmmsg(), so the caller's message is neither copied nor
+	patched with packet headers.
+*/
+#if defined(T32HOST_UNIX)
+# define LINE_USE_IOVEC
+# ifdef LINE_USE_MMSG
+#  define LINE_GATHER_BATCH LINE_MMSG_BATCH
+# else
+#  define LINE_GATHER_BATCH 8
+# endif
+#endif
+
+
+/*
+	Requests are sent again when no reply packet arrives within the
+	retransmission timeout, estimated from the measured round trip times
+	like TCP does (RFC 6298). PollTimeSec stays the overall limit. The
+	floor stays above the time PowerView takes to serve common requests,
+	every copy of a request is answered.
+*/
+#define LINE_RTO_INIT_MS  500   /* before the first sample */
+#define LINE_RTO_MIN_MS   250
+#define LINE_RTO_MAX_MS   1000
+#define LINE_RTO_CLOCK_US 1000  /* clock granularity, lower bound of the variance term */
 
 
 #if defined(T32HOST_WIN) || defined(T32HOST_LINUX)
 # define RECEIVEADDR (&ReceiveSocketAddress)
-static T32_THREADLOCAL struct sockaddr ReceiveSocketAddress;
 #else
 # define RECEIVEADDR 0
 #endif
 
+/*
+	Asynchronous notifications which slip into a request/reply pair are
+	queued in a fixed ring per line. On overflow the oldest one is dropped
+	and counted, see T32_LineStats.
+*/
+#define LINE_NOTIFY_SLOTS 8
+
+/* Queued asynchronous notification */
+typedef struct t32_notification {
+	int             length;
+	unsigned char   payload[T32_PCKLEN_MAX];
+} T32_NotificationPackage;
+
 /* *INDENT-OFF* */
 typedef struct LineStruct_s {
 	char               NodeName[80]; /* NODE=     */  /* node name of host running T32 SW */
@@ -95,14 +151,35 @@ typedef struct LineStruct_s {
 	unsigned short     TransmitPort; /* PORT=     */  /* Transmitter Port in T32 */
 	int                PacketSize;   /* PACKLEN=  */  /* Max. size of UDP-packet data */
 	int                PollTimeSec;  /* TIMEOUT=  */
+	int                RtoMinMs;     /* RTOMIN=   */  /* bounds of the retransmission timeout */
+	int                RtoMaxMs;     /* RTOMAX=   */
+	int                BusyPollUs;   /* BUSYPOLL= */  /* SO_BUSY_POLL of the socket, 0: off */
 	int                ReceiveToggleBit;
+	int                MaxPacketSize;                 /* data chunk per message, see T32_NegotiatePacketSize() */
 	unsigned char      MessageId;
 	int                LineUp;
 	unsigned short     ReceiveSeq, TransmitSeq;    /* block-ids */
 	unsigned short     LastReceiveSeq, LastTransmitSeq;
 	unsigned char     *LastTransmitBuffer;
 	int                LastTransmitSize;
+	const unsigned char *LastTransmitPayload;      /* payload of LINE_LineTransmitVEx(), NULL otherwise */
+	int                LastTransmitPayloadSize, LastTransmitPadding;
+	unsigned int       LastTransmitTime;           /* microseconds, see TimeUs() */
+	int                SrttUs, RttVarUs, RtoUs;    /* round trip estimation, see SampleRtt() */
+	int                RttPending;                 /* last request not answered and not repeated (Karn) */
+	int                RequestRetransmits;         /* copies of the last request sent again */
+	int                StaleReplies;               /* replies to copies of the previous request still due */
+	int                RtoHold;                    /* keep-alive seen, wait without retransmitting */
+	T32_LineStats      Stats;
 	struct sockaddr_in SocketAddress;
+	T32_NotificationPackage Notification[LINE_NOTIFY_SLOTS];   /* ring of pending notifications */
+	int                NotificationFirst, NotificationCount;
+#ifdef LINE_USE_MMSG
+	unsigned char     *RxQueue;                    /* LINE_MMSG_BATCH packets of RxSlotSize, see ReceiveWithTimeout() */
+	int                RxSlotSize;
+	int                RxCount, RxNext;            /* received / consumed packets */
+	int                RxLength[LINE_MMSG_BATCH];
+#endif
 } LineStruct;
 /* *INDENT-ON* */
 
@@ -116,7 +193,9 @@ static int      LINE_LineInit(char *message);
 static void     LINE_LineExit(void);
 static int      LINE_LineDriverGetSocket(void);
 static int      LINE_LineTransmit(unsigned char *in, int size);
+static int      LINE_LineTransmitV(unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding);
 static int      LINE_LineReceive(unsigned char *out);
+static int      LINE_LineReceiveV(unsigned char *out, int headSize, const LineSegment * seg, int nseg);
 static int      LINE_ReceiveNotifyMessage(unsigned char *package);
 static int      LINE_LineSync(void);
 static int      LINE_GetLineParamsSize(void);
@@ -127,11 +206,46 @@ static int      LINE_GetReceiveToggleBit(void);
 static unsigned char LINE_GetNextMessageId(void);
 static unsigned char LINE_GetMessageId(void);
 
+static int      LINE_LineConfigEx(LineStruct * line, char *in);
+static int      LINE_LineInitEx(LineStruct * line, char *message);
+static void     LINE_LineExitEx(LineStruct * line);
+static int      LINE_LineDriverGetSocketEx(LineStruct * line);
+static int      LINE_LineTransmitEx(LineStruct * line, unsigned char *in, int size);
+static int      LINE_LineTransmitVEx(LineStruct * line, unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding);
+static int      LINE_LineReceiveEx(LineStruct * line, unsigned char *out);
+static int      LINE_LineReceiveVEx(LineStruct * line, unsigned char *out, int headSize, const LineSegment * seg, int nseg);
+static int      LINE_ReceiveNotifyMessageEx(LineStruct * line, unsigned char *package);
+static int      LINE_LineSyncEx(LineStruct * line);
+static void     LINE_SetReceiveToggleBitEx(LineStruct * line, int value);
+static int      LINE_GetReceiveToggleBitEx(LineStruct * line);
+static unsigned char LINE_GetNextMessageIdEx(LineStruct * line);
+static unsigned char LINE_GetMessageIdEx(LineStruct * line);
+static int      LINE_NotificationPendingEx(LineStruct * line);
+static int      LINE_ReceivePending(void);
+static int      LINE_ReceivePendingEx(LineStruct * line);
+static int      LINE_GetMaxPacketSize(void);
+static void     LINE_SetMaxPacketSize(int size);
+static int      LINE_GetMaxPacketSizeEx(LineStruct * line);
+static void     LINE_SetMaxPacketSizeEx(LineStruct * line, int size);
+static void     LINE_GetStats(T32_LineStats * stats);
+static void     LINE_GetStatsEx(LineStruct * line, T32_LineStats * stats);
+
 int T32_NotificationPending(void);
-static int Connection(unsigned char *ipaddrused);
+static int Connection(LineStruct * line, unsigned char *ipaddrused);
+static void Retransmit(LineStruct * line);
+static void StartRtt(LineStruct * line);
+static void SampleRtt(LineStruct * line, const unsigned char *msg, int count);
+static int WaitForReply(LineStruct * line);
+static int WaitReadable(LineStruct * line, int timeoutUs);
+static T32_NotificationPackage *QueueNotification(LineStruct * line, int length);
+static void CapturePacket(LineStruct * line, int direction, const unsigned char *data, int size);
+#ifdef LINE_USE_IOVEC
+static int TransmitGather(LineStruct * line, unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding);
+#endif
 
 extern T32_THREADLOCAL unsigned int LINE_TransmitCounter;
 T32_THREADLOCAL unsigned int    LINE_TransmitCounter = 0;
+T32_THREADLOCAL unsigned int    LINE_RetransmitCounter = 0;        /* all lines of the thread, see T32_ApiStats */
 
 static T32_THREADLOCAL struct timeval LongTime = { 0, 500000 };
 
@@ -148,7 +262,11 @@ static void SetToDefaultLineParams(LineStruct * params)
 	params->TransmitPort     = 20000;
 	params->PacketSize       = 1024;
 	params->PollTimeSec      = 5;
+	params->RtoMinMs         = LINE_RTO_MIN_MS;
+	params->RtoMaxMs         = LINE_RTO_MAX_MS;
+	params->RtoUs            = LINE_RTO_INIT_MS * 1000;
 	params->ReceiveToggleBit = -1;
+	params->MaxPacketSize    = T32_MAXPACKETSIZE_DEFAULT;
 	if (params == &LineParams)
 		isLineParamsInitialized = 1;
 }
@@ -167,28 +285,52 @@ static int str2dec(char *in)
 }
 
 
+static void LINE_SetReceiveToggleBitEx(LineStruct * line, int value)
+{
+	if (line)
+		line->ReceiveToggleBit = value;
+}
+
+
+static int LINE_GetReceiveToggleBitEx(LineStruct * line)
+{
+	return line ? line->ReceiveToggleBit : 0;
+}
+
+
+static unsigned char LINE_GetNextMessageIdEx(LineStruct * line)
+{
+	return line ? ++line->MessageId : 0;
+}
+
+
+static unsigned char LINE_GetMessageIdEx(LineStruct * line)
+{
+	return line ? line->MessageId : 0;
+}
+
+
 static void LINE_SetReceiveToggleBit(int value)
 {
-	if (pLineParams)
-		pLineParams->ReceiveToggleBit = value;
+	LINE_SetReceiveToggleBitEx(pLineParams, value);
 }
 
 
 static int LINE_GetReceiveToggleBit(void)
 {
-	return pLineParams ? pLineParams->ReceiveToggleBit : 0;
+	return LINE_GetReceiveToggleBitEx(pLineParams);
 }
 
 
 static unsigned char LINE_GetNextMessageId(void)
 {
-	return pLineParams ? ++pLineParams->MessageId : 0;
+	return LINE_GetNextMessageIdEx(pLineParams);
 }
 
 
 static unsigned char LINE_GetMessageId(void)
 {
-	return pLineParams ? pLineParams->MessageId : 0;
+	return LINE_GetMessageIdEx(pLineParams);
 }
 
 
@@ -219,14 +361,18 @@ static void LINE_SetLine(LineStruct * params)
 */
 static int LINE_LineConfig(char *input)
 {
-	int             x;
-	LineStruct     *line;
-
 	if (pLineParams == NULL) {
 		pLineParams = &LineParams;
 		SetToDefaultLineParams(pLineParams);
 	}
-	line = pLineParams;
+	return LINE_LineConfigEx(pLineParams, input);
+}
+
+
+/** Configures parameters of the given communication line, see LINE_LineConfig(). */
+static int LINE_LineConfigEx(LineStruct * line, char *input)
+{
+	int             x;
 
 	if (!strncmp((char *) input, "NODE=", 5)) {
 		strcpy(line->NodeName, input + 5);
@@ -260,6 +406,31 @@ static int LINE_LineConfig(char *input)
 		line->PollTimeSec = x;
 		return 1;
 	}
+	if (!strncmp((char *) input, "RTOMIN=", 7)) {
+		x = str2dec(input + 7);
+		if (x <= 0)
+			return -1;
+		line->RtoMinMs = x;
+		return 1;
+	}
+	if (!strncmp((char *) input, "RTOMAX=", 7)) {
+		x = str2dec(input + 7);
+		if (x <= 0)
+			return -1;
+		line->RtoMaxMs = x;
+		return 1;
+	}
+	if (!strncmp((char *) input, "BUSYPOLL=", 9)) {
+		x = str2dec(input + 9);
+		if (x == -1)
+			return -1;
+		line->BusyPollUs = x;
+		return 1;
+	}
+	if (!strncmp((char *) input, "CAPTURE=", 8)) {
+		/* one capture file for all lines of the process, see hlinkcap.c */
+		return (T32_CaptureOpen(input + 8) == 0) ? 1 : -1;
+	}
 	return -1;
 }
 
@@ -366,14 +537,27 @@ static int32_t GetInetAddress(char *name, char *message)
 		LINE_LineInit() in case of error
  */
 static void LINE_LineExit(void)
+{
+	LINE_LineExitEx(pLineParams);
+}
+
+
+/** Closes the given communication line and drops its pending notifications, see LINE_LineExit(). */
+static void LINE_LineExitEx(LineStruct * line)
 {
 	int             i;
-	LineStruct     *line;
 	static const char discon[] = { 4, 0, 0, 0, 0, 0, 0, 0, 'T', 'R', 'A', 'C', 'E', '3', '2', 0 };
 
-	if (!pLineParams)
+	if (!line)
 		return;
-	line = pLineParams;
+
+	line->NotificationFirst = line->NotificationCount = 0;
+
+#ifdef LINE_USE_MMSG
+	free(line->RxQueue);
+	line->RxQueue = NULL;
+	line->RxCount = line->RxNext = 0;
+#endif
 
 	if (!line->LineUp) {
 		if (line->CommSocket != -1) {
@@ -391,8 +575,11 @@ static void LINE_LineExit(void)
 	if (line->CommSocket != -1) {
 
 		/* Probably multiple packets for skipping loops reading multiple packets so that one packet gets into the "real" handler." */
-		for (i = 0; i < 5; i++)
+		for (i = 0; i < 5; i++) {
 			sendto(line->CommSocket, discon, 16, 0, (struct sockaddr *) &(line->SocketAddress), sizeof(line->SocketAddress));   /* send EXIT 4 */
+			if (T32_CaptureActive)
+				CapturePacket(line, T32_CAPTURE_OUTBOUND, (const unsigned char *) discon, 16);
+		}
 
 #ifdef T32HOST_WIN
 		closesocket(line->CommSocket);
@@ -423,6 +610,17 @@ static void LINE_LineExit(void)
 	@caller only int T32_Init()
 */
 static int LINE_LineInit(char *message)
+{
+	if (pLineParams == NULL) {
+		pLineParams = &LineParams;
+		SetToDefaultLineParams(pLineParams);
+	}
+	return LINE_LineInitEx(pLineParams, message);
+}
+
+
+/** Sets up a connection on the given communication line, see LINE_LineInit(). */
+static int LINE_LineInitEx(LineStruct * line, char *message)
 {
 	int             i, j;
 	socklen_t       length;
@@ -430,13 +628,6 @@ static int LINE_LineInit(char *message)
 	unsigned char   dummy_ipaddr[4];
 	int32_t         remote_ip;
 	int             buflen;
-	LineStruct     *line;
-
-	if (pLineParams == NULL) {
-		pLineParams = &LineParams;
-		SetToDefaultLineParams(pLineParams);
-	}
-	line = pLineParams;
 
 	if (line->LineUp)   /* OK, connection already exists */
 		return 0;
@@ -504,6 +695,18 @@ static int LINE_LineInit(char *message)
 		}
 	}
 
+	/*
+		best effort: room for the replies of a full async window of
+		negotiated reads, which arrive as bursts of small packets
+	*/
+	val = 0;
+	length = sizeof(val);
+	getsockopt(line->CommSocket, SOL_SOCKET, SO_RCVBUF, (char *) &val, &length);
+	if (val < RCVBUF_ASYNC) {
+		val = RCVBUF_ASYNC;
+		setsockopt(line->CommSocket, SOL_SOCKET, SO_RCVBUF, (char *) &val, sizeof(val));
+	}
+
 	val = 0;
 	length = sizeof(val);
 	getsockopt(line->CommSocket, SOL_SOCKET, SO_RCVBUF, (char *) &val, &length);
@@ -530,14 +733,31 @@ static int LINE_LineInit(char *message)
 		}
 	}
 
+#ifdef SO_BUSY_POLL
+	/* spin in the driver for up to BusyPollUs on receive instead of waiting for the interrupt,
+	   raising it needs CAP_NET_ADMIN: whether it took is reported in T32_LineStats.BusyPollUs */
+	line->Stats.BusyPollUs = 0;
+	if (line->BusyPollUs > 0
+	    && setsockopt(line->CommSocket, SOL_SOCKET, SO_BUSY_POLL, (char *) &line->BusyPollUs, sizeof(line->BusyPollUs)) == 0)
+		line->Stats.BusyPollUs = (uint32_t) line->BusyPollUs;
+#endif
+
 	for (i = 0; i < 10; i++) {
-		j = Connection(dummy_ipaddr);
+		j = Connection(line, dummy_ipaddr);
 
 		if (j == 0)
 			continue;
 
 		if (j == 1) {
 			line->LineUp = 1;
+			line->MaxPacketSize = T32_MAXPACKETSIZE_DEFAULT;
+#ifdef LINE_USE_MMSG
+			/* packets are at most PacketSize now, see Connection() */
+			line->RxSlotSize = line->PacketSize;
+			line->RxCount = line->RxNext = 0;
+			free(line->RxQueue);
+			line->RxQueue = (unsigned char *) malloc(LINE_MMSG_BATCH * line->RxSlotSize);
+#endif
 			return 1;   /* OK, new connection established */
 		}
 
@@ -548,7 +768,7 @@ static int LINE_LineInit(char *message)
 	strcpy(message, "TRACE32 not responding");
 
 error:
-	LINE_LineExit();    /* Close connection if no success */
+	LINE_LineExitEx(line);      /* Close connection if no success */
 
 	/*
 		Even in case of error, CommSocket has to be reset, otherwise
@@ -594,21 +814,35 @@ void T32_UnInstallAsyncSelect(HWND hwnd)
 */
 
 static int LINE_LineTransmit(unsigned char *in, int size)
+{
+	if (!pLineParams)
+		return 0;
+
+	LINE_TransmitCounter++;
+
+	return LINE_LineTransmitEx(pLineParams, in, size);
+}
+
+
+/** Sends a message on the given communication line, see LINE_LineTransmit(). */
+static int LINE_LineTransmitEx(LineStruct * line, unsigned char *in, int size)
 {
 	int             packetSize;
 	unsigned int    tmpl;
 	unsigned int    bytesTransmitted = 0;
-	LineStruct     *line;
 
-	if (!pLineParams)
+	if (!line)
 		return 0;
-	line = pLineParams;
-
-	LINE_TransmitCounter++;
 
 	line->LastTransmitBuffer = in;
 	line->LastTransmitSize = size;
+	line->LastTransmitPayload = NULL;
 	line->LastTransmitSeq = line->TransmitSeq;
+	StartRtt(line);
+#ifdef LINE_USE_IOVEC
+	if (size > line->PacketSize - 4)
+		return TransmitGather(line, in, size, NULL, 0, 0);
+#endif
 	in -= 4;    /* space for packet header */
 
 
@@ -631,6 +865,8 @@ static int LINE_LineTransmit(unsigned char *in, int size)
 			SETLONGVAR(in[0], tmpl);    /* restore buffer */
 			return 0;
 		}
+		if (T32_CaptureActive)
+			CapturePacket(line, T32_CAPTURE_OUTBOUND, in, packetSize + 4);
 		bytesTransmitted += packetSize + 4;
 		SETLONGVAR(in[0], tmpl);        /* restore buffer */
 
@@ -644,53 +880,467 @@ static int LINE_LineTransmit(unsigned char *in, int size)
 }
 
 
+/**
+	Sends a message followed by a payload on the current communication line.
+
+	@param in          : pointer to outgoing message head (already includes 5 byte message header)
+	@param size        : size of message head
+	@param payload     : message payload, sent behind the head without being copied
+	@param payloadSize : size of payload
+	@param padding     : number of zero bytes (0..3) appended behind the payload
+	@return total size of message, 0 on error
+	@note
+		the payload must stay valid until the reply has been received,
+		it is sent again when the request has to be repeated
+*/
+static int LINE_LineTransmitV(unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding)
+{
+	if (!pLineParams)
+		return 0;
+
+	LINE_TransmitCounter++;
+
+	return LINE_LineTransmitVEx(pLineParams, in, size, payload, payloadSize, padding);
+}
+
+
+/** Sends a message and a payload on the given communication line, see LINE_LineTransmitV(). */
+static int LINE_LineTransmitVEx(LineStruct * line, unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding)
+{
+#ifdef LINE_USE_IOVEC
+	if (!line)
+		return 0;
+
+	line->LastTransmitBuffer = in;
+	line->LastTransmitSize = size;
+	line->LastTransmitPayload = payload;
+	line->LastTransmitPayloadSize = payloadSize;
+	line->LastTransmitPadding = padding;
+	line->LastTransmitSeq = line->TransmitSeq;
+	StartRtt(line);
+	return TransmitGather(line, in, size, payload, payloadSize, padding);
+#else
+	/* no gather I/O: the head buffer has room for LINE_MSIZE bytes */
+	if (payloadSize > 0)
+		memcpy(in + size, payload, payloadSize);
+	memset(in + size + payloadSize, 0, padding);
+	return LINE_LineTransmitEx(line, in, size + payloadSize + padding);
+#endif
+}
+
+
+/** Sends the last message of the given line again, with its original sequence ID. */
+static void Retransmit(LineStruct * line)
+{
+	unsigned int    sent = line->LastTransmitTime;
+	int             retransmits = line->RequestRetransmits;
+
+	line->TransmitSeq = line->LastTransmitSeq;
+	if (line->LastTransmitPayload)
+		LINE_LineTransmitVEx(line, line->LastTransmitBuffer, line->LastTransmitSize, line->LastTransmitPayload, line->LastTransmitPayloadSize, line->LastTransmitPadding);
+	else
+		LINE_LineTransmitEx(line, line->LastTransmitBuffer, line->LastTransmitSize);
+	line->LastTransmitTime = sent;
+	line->RequestRetransmits = retransmits + 1;
+	line->RttPending = 0;       /* the reply may answer either copy, no sample */
+	line->Stats.Retransmits++;
+	LINE_RetransmitCounter++;
+}
+
+
+/** Returns the retransmission statistics of the current line. */
+static void LINE_GetStats(T32_LineStats * stats)
+{
+	LINE_GetStatsEx(pLineParams, stats);
+}
+
+
+/** Returns the retransmission statistics of the given line. */
+static void LINE_GetStatsEx(LineStruct * line, T32_LineStats * stats)
+{
+	memset(stats, 0, sizeof(T32_LineStats));
+	if (!line)
+		return;
+	*stats = line->Stats;
+	stats->SrttUs = line->SrttUs;
+	stats->RttVarUs = line->RttVarUs;
+	stats->RtoUs = line->RtoUs;
+}
+
+
+/** Microseconds of a free running clock, wraps around. */
+static unsigned int TimeUs(void)
+{
+#ifdef T32HOST_WIN
+	return (unsigned int) GetTickCount() * 1000u;
+#else
+	struct timeval  now;
+
+	gettimeofday(&now, NULL);
+	return (unsigned int) now.tv_sec * 1000000u + (unsigned int) now.tv_usec;
+#endif
+}
+
+
+/** Starts the round trip measurement of a new request. */
+static void StartRtt(LineStruct * line)
+{
+	line->LastTransmitTime = TimeUs();
+	line->RttPending = (line->LastTransmitSize > 0);
+	line->RtoHold = 0;
+	line->RequestRetransmits = 0;
+}
+
+
+/**
+	Updates the retransmission timeout from a completed reply message.
+	Keep-alive replies (TRACE32 still busy) stop retransmissions of the
+	request instead.
+*/
+static void SampleRtt(LineStruct * line, const unsigned char *msg, int count)
+{
+	int             rtt, delta, var;
+
+	if ((count >= 4) && (msg[3] == 0xfe)) {
+		line->RtoHold = 1;
+		line->RttPending = 0;
+		return;
+	}
+	if (!line->RttPending)
+		return;
+	line->RttPending = 0;
+
+	rtt = (int) (TimeUs() - line->LastTransmitTime);
+	if (rtt <= 0)
+		rtt = 1;
+	if (line->SrttUs == 0) {
+		line->SrttUs = rtt;
+		line->RttVarUs = rtt / 2;
+	} else {
+		delta = (line->SrttUs > rtt) ? line->SrttUs - rtt : rtt - line->SrttUs;
+		line->RttVarUs = (3 * line->RttVarUs + delta) / 4;
+		line->SrttUs = (7 * line->SrttUs + rtt) / 8;
+	}
+	var = 4 * line->RttVarUs;
+	if (var < LINE_RTO_CLOCK_US)
+		var = LINE_RTO_CLOCK_US;
+	line->RtoUs = line->SrttUs + var;
+	if (line->RtoUs < line->RtoMinMs * 1000)
+		line->RtoUs = line->RtoMinMs * 1000;
+	if (line->RtoUs > line->RtoMaxMs * 1000)
+		line->RtoUs = line->RtoMaxMs * 1000;
+}
+
+
+/**
+	Waits for the next packet of a reply. When the retransmission timeout
+	expires first, the request is sent again and the timeout is doubled,
+	until PollTimeSec have passed in total.
+	@return >0 packet pending, 0 on timeout, <0 on error
+*/
+static int WaitForReply(LineStruct * line)
+{
+	int             i, wait;
+	unsigned int    start = TimeUs(), elapsed;
+	unsigned int    limit = (unsigned int) line->PollTimeSec * 1000000u;
+
+	for (;;) {
+		elapsed = TimeUs() - start;
+		if (elapsed >= limit)
+			return 0;
+		wait = (int) (limit - elapsed);
+		if (line->LastTransmitSize && !line->RtoHold && (wait > line->RtoUs))
+			wait = line->RtoUs;
+
+		i = WaitReadable(line, wait);
+		if (i != 0)
+			return i;
+
+		line->Stats.Timeouts++;
+		if (line->LastTransmitSize && !line->RtoHold) {
+			Retransmit(line);
+			line->RtoUs = (2 * line->RtoUs < line->RtoMaxMs * 1000) ? 2 * line->RtoUs : line->RtoMaxMs * 1000;
+		}
+	}
+}
+
+
+/**
+	Waits until the socket of the line is readable. UNIX hosts use poll(),
+	which has no FD_SETSIZE limit on the descriptor number.
+	@param timeoutUs  microseconds to wait, 0 only checks
+	@return >0 readable, 0 on timeout, <0 on error
+*/
+static int WaitReadable(LineStruct * line, int timeoutUs)
+{
+#ifdef T32HOST_UNIX
+	struct pollfd   pfd;
+
+	pfd.fd = line->CommSocket;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll(&pfd, 1, (timeoutUs + 999) / 1000);
+#else
+	fd_set          readfds;
+	struct timeval  timeout;
+
+	timeout.tv_sec = timeoutUs / 1000000;
+	timeout.tv_usec = timeoutUs % 1000000;
+	FD_ZERO(&readfds);
+	FD_SET((unsigned int) line->CommSocket, &readfds);
+	return select(FD_SETSIZE, &readfds, (fd_set *) NULL, (fd_set *) NULL, &timeout);
+#endif
+}
+
+
+/** Checks without waiting whether reply data is pending on the current line. */
+static int LINE_ReceivePending(void)
+{
+	return LINE_ReceivePendingEx(pLineParams);
+}
+
+
+/** Data chunk per message of the line, see T32_NegotiatePacketSize(). A new connection starts with the default. */
+static int LINE_GetMaxPacketSizeEx(LineStruct * line)
+{
+	return line ? line->MaxPacketSize : T32_MAXPACKETSIZE_DEFAULT;
+}
+
+
+static void LINE_SetMaxPacketSizeEx(LineStruct * line, int size)
+{
+	if (line)
+		line->MaxPacketSize = size;
+}
+
+
+static int LINE_GetMaxPacketSize(void)
+{
+	return LINE_GetMaxPacketSizeEx(pLineParams);
+}
+
+
+static void LINE_SetMaxPacketSize(int size)
+{
+	LINE_SetMaxPacketSizeEx(pLineParams, size);
+}
+
+
+/**
+	Checks without waiting whether reply data is pending on the given line,
+	i.e. whether a receive would not block. Together with the socket handle
+	(see LINE_LineDriverGetSocketEx()) this lets a caller multiplex several
+	lines on one poll()/epoll() loop.
+*/
+static int LINE_ReceivePendingEx(LineStruct * line)
+{
+	if (!line || (line->CommSocket == -1))
+		return 0;
+#ifdef LINE_USE_MMSG
+	if (line->RxNext < line->RxCount)
+		return 1;
+#endif
+	return WaitReadable(line, 0) > 0;
+}
+
+
+#ifdef LINE_USE_IOVEC
+/** Records a packet of up to size bytes gathered from iovecs, see CapturePacket(). */
+static void CapturePacketV(LineStruct * line, int direction, const struct iovec *iov, int niov, int size)
+{
+	unsigned char   packet[PCKLEN_MAX];
+	int             i, chunk, n = 0;
+
+	if (size > PCKLEN_MAX)
+		size = PCKLEN_MAX;
+	for (i = 0; (i < niov) && (n < size); i++) {
+		chunk = ((int) iov[i].iov_len < size - n) ? (int) iov[i].iov_len : size - n;
+		memcpy(packet + n, iov[i].iov_base, chunk);
+		n += chunk;
+	}
+	CapturePacket(line, direction, packet, n);
+}
+
+
+/**
+	Sends all packets of a message gathered from the head, the payload and
+	padding zero bytes, see LINE_LineTransmitVEx(). The packet headers are
+	kept in separate iovecs, so neither part is modified. On Linux a batch
+	of packets goes out with one sendmmsg(), elsewhere with sendmsg().
+*/
+static int TransmitGather(LineStruct * line, unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding)
+{
+	static const unsigned char zeros[4] = { 0, 0, 0, 0 };
+	const unsigned char *partData[3];
+	int             partSize[3];
+	unsigned char   headers[LINE_GATHER_BATCH][4];
+	struct iovec    iov[LINE_GATHER_BATCH][4];  /* header + at most 3 parts */
+#ifdef LINE_USE_MMSG
+	struct mmsghdr  msgs[LINE_GATHER_BATCH];
+# define GATHER_MSG(n) (msgs[n].msg_hdr)
+#else
+	struct msghdr   msgs[LINE_GATHER_BATCH];
+# define GATHER_MSG(n) (msgs[n])
+#endif
+	int             n, i, sent, packetSize, chunk, niov, remain;
+	int             part = 0, offset = 0;
+	int             total = size + payloadSize + padding;
+
+	partData[0] = in;
+	partSize[0] = size;
+	partData[1] = payload;
+	partSize[1] = payloadSize;
+	partData[2] = zeros;
+	partSize[2] = padding;
+
+	while (total > 0) {
+		memset(msgs, 0, sizeof(msgs));
+		for (n = 0; (n < LINE_GATHER_BATCH) && (total > 0); n++) {
+			packetSize = (total > line->PacketSize - 4) ? line->PacketSize - 4 : total;
+			headers[n][0] = 0x11;       /* transmit data package */
+			headers[n][1] = (total > packetSize) ? 1 : 0;       /* more packets follow */
+			SETWORDVAR(headers[n][2], line->TransmitSeq);       /* packet sequence ID */
+			iov[n][0].iov_base = headers[n];
+			iov[n][0].iov_len = 4;
+			niov = 1;
+			for (remain = packetSize; remain > 0;) {
+				if (offset >= partSize[part]) {
+					part++;
+					offset = 0;
+					continue;
+				}
+				chunk = partSize[part] - offset;
+				if (chunk > remain)
+					chunk = remain;
+				iov[n][niov].iov_base = (void *) (partData[part] + offset);
+				iov[n][niov].iov_len = chunk;
+				niov++;
+				offset += chunk;
+				remain -= chunk;
+			}
+			GATHER_MSG(n).msg_name = &line->SocketAddress;
+			GATHER_MSG(n).msg_namelen = sizeof(line->SocketAddress);
+			GATHER_MSG(n).msg_iov = iov[n];
+			GATHER_MSG(n).msg_iovlen = niov;
+			line->TransmitSeq++;
+			total -= packetSize;
+		}
+#ifdef LINE_USE_MMSG
+		for (i = 0; i < n; i += sent) {
+			sent = sendmmsg(line->CommSocket, msgs + i, n - i, 0);
+			if (sent <= 0)
+				return 0;
+		}
+#else
+		for (i = 0; i < n; i++) {
+			if (sendmsg(line->CommSocket, &msgs[i], 0) <= 0)
+				return 0;
+		}
+		(void) sent;
+#endif
+		if (T32_CaptureActive) {
+			for (i = 0; i < n; i++)
+				CapturePacketV(line, T32_CAPTURE_OUTBOUND, iov[i], (int) GATHER_MSG(i).msg_iovlen, PCKLEN_MAX);
+		}
+	}
+#undef GATHER_MSG
+	return size + payloadSize + padding;
+}
+#endif
+
+
+/** Records a packet of the line in the capture file, see hlinkcap.c. */
+static void CapturePacket(LineStruct * line, int direction, const unsigned char *data, int size)
+{
+	if (size > 0)
+		T32_CapturePacket(direction, line->SocketAddress.sin_addr.s_addr, ntohs(line->SocketAddress.sin_port), line->ReceivePort, data, size);
+}
+
+
 /**
 	Receives a package from the socket, with timeout handling.
+	A NULL timeout waits for a reply, see WaitForReply().
 	@return number of received bytes or error number (<0)
 */
-static int ReceiveWithTimeout(struct timeval *tim, unsigned char *dest, int size)
+static int ReceiveWithTimeout(LineStruct * line, struct timeval *tim, unsigned char *dest, int size)
 {
 	int             i;
 	int             result;
-	fd_set          readfds;
 	socklen_t       length;
-	struct timeval  timeout = *tim;
-	LineStruct     *line;
+#if defined(T32HOST_WIN) || defined(T32HOST_LINUX)
+	struct sockaddr ReceiveSocketAddress;
+#endif
 
-	if (!pLineParams)
+	if (!line)
 		return 0;
-	line = pLineParams;
 
-	FD_ZERO(&readfds);
-	FD_SET((unsigned int) line->CommSocket, &readfds);
+#ifdef LINE_USE_MMSG
+	/* packets drained by an earlier recvmmsg() come first */
+	if (line->RxNext < line->RxCount) {
+		i = line->RxNext++;
+		result = (line->RxLength[i] < size) ? line->RxLength[i] : size;
+		memcpy(dest, line->RxQueue + i * line->RxSlotSize, result);
+		return result;
+	}
 
-	i = select(FD_SETSIZE, &readfds, (fd_set *) NULL, (fd_set *) NULL, &timeout);
+wait:
+#endif
+	if (tim)
+		i = WaitReadable(line, (int) (tim->tv_sec * 1000000 + tim->tv_usec));
+	else
+		i = WaitForReply(line);
 
 	if (i <= 0) {
 		return i;
 	}
 
+#ifdef LINE_USE_MMSG
+	if (line->RxQueue) {
+		struct mmsghdr  msgs[LINE_MMSG_BATCH];
+		struct iovec    iov[LINE_MMSG_BATCH];
+
+		memset(msgs, 0, sizeof(msgs));
+		for (i = 0; i < LINE_MMSG_BATCH; i++) {
+			iov[i].iov_base = line->RxQueue + i * line->RxSlotSize;
+			iov[i].iov_len = line->RxSlotSize;
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		result = recvmmsg(line->CommSocket, msgs, LINE_MMSG_BATCH, MSG_DONTWAIT, NULL);
+		if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			return -1;
+		if (result <= 0)
+			goto wait;  /* readable without a datagram (dropped on a bad checksum) or a signal, like recvfrom() */
+		for (i = 0; i < result; i++) {
+			line->RxLength[i] = (int) msgs[i].msg_len;
+			if (T32_CaptureActive)
+				CapturePacket(line, T32_CAPTURE_INBOUND, line->RxQueue + i * line->RxSlotSize, line->RxLength[i]);
+		}
+		line->RxCount = result;
+		line->RxNext = 0;
+		return ReceiveWithTimeout(line, tim, dest, size);
+	}
+#endif
+
 	length = sizeof(struct sockaddr);
 	result = recvfrom(line->CommSocket, (char *) dest, size, 0, (struct sockaddr *) RECEIVEADDR, &length);
+	if (T32_CaptureActive)
+		CapturePacket(line, T32_CAPTURE_INBOUND, dest, result);
 	return result;
 }
 
 
 static int LINE_LineDriverGetSocket(void)
 {
-	return pLineParams ? pLineParams->CommSocket : 0;
+	return LINE_LineDriverGetSocketEx(pLineParams);
 }
 
 
-typedef struct t32_notification {
-	char            payload[T32_PCKLEN_MAX];
-	struct t32_notification *next;
-	struct t32_notification *prev;
-} T32_NotificationPackage;
+static int LINE_LineDriverGetSocketEx(LineStruct * line)
+{
+	return line ? line->CommSocket : 0;
+}
 
-/* Queue pending notifications */
-static T32_THREADLOCAL T32_NotificationPackage *T32_NotificationHead = NULL;
-static T32_THREADLOCAL T32_NotificationPackage *T32_NotificationTail = NULL;
 
 /**
 	Receives messages from the socket. Assembles multiple packets into
@@ -704,19 +1354,24 @@ static T32_THREADLOCAL T32_NotificationPackage *T32_NotificationTail = NULL;
 		number of bytes of the message or error number (<0)
 */
 static int LINE_LineReceive(unsigned char *out)
+{
+	return LINE_LineReceiveEx(pLineParams, out);
+}
+
+
+/** Receives a message from the given communication line, see LINE_LineReceive(). */
+static int LINE_LineReceiveEx(LineStruct * line, unsigned char *out)
 {
 	int             i, flag;
 	int             count;
 	unsigned short  tmpw;
 	unsigned int    tmpl;
 	unsigned short  s;
-	LineStruct     *line;
 	register unsigned char *dest;
 	static const unsigned char handshake[] = { 7, 0, 0, 0, 0, 0, 0, 0, 'T', 'R', 'A', 'C', 'E', '3', '2', 0 };
 
-	if (!pLineParams)
+	if (!line)
 		return -1;
-	line = pLineParams;
 
 retry:
 	dest = out - 4;     /* adjust pointer so we place header BEFORE "out" and thus payload AT "out" */
@@ -731,9 +1386,7 @@ retry:
 		SETLONGVAR(tmpl, dest[0]);
 
 		do {
-			struct timeval  PollTime = { 0, 0 };
-			PollTime.tv_sec = line->PollTimeSec;
-			if ((i = ReceiveWithTimeout(&PollTime, dest, line->PacketSize)) <= 0) {
+			if ((i = ReceiveWithTimeout(line, NULL, dest, line->PacketSize)) <= 0) {
 				if (i == -2)
 					goto retry;
 				return -1;
@@ -749,22 +1402,9 @@ retry:
 
 			/* Detect and enqeue async notification that slipped into a request/reply pair */
 			if (dest[0] == T32_API_NOTIFICATION) {
-				T32_NotificationPackage *newPackage, *oldHead;
-
-				newPackage = (T32_NotificationPackage *) malloc(sizeof(T32_NotificationPackage));
-				if (newPackage == NULL)
-					return -1;
-
-				memcpy(newPackage, dest, i);    /* in theory i should always be the package size, at least for ethernet */
-				oldHead = T32_NotificationHead;
-				newPackage->prev = NULL;
-				newPackage->next = oldHead;
-				if (oldHead)
-					oldHead->prev = newPackage;
-				T32_NotificationHead = newPackage;
-				if (T32_NotificationTail == NULL) {
-					T32_NotificationTail = newPackage;
-				}
+				T32_NotificationPackage *newPackage = QueueNotification(line, i);
+
+				memcpy(newPackage->payload, dest, newPackage->length);  /* in theory i should always be the package size, at least for ethernet */
 				goto retry;
 			}
 
@@ -773,9 +1413,15 @@ retry:
 			}
 			SETWORDVAR(tmpw, dest[2]);
 
+			/*
+				the previous reply again: TRACE32 lost the current request,
+				unless it answers a copy of the previous one
+			*/
 			if (tmpw == line->LastReceiveSeq && line->LastTransmitSize) {
-				line->TransmitSeq = line->LastTransmitSeq;
-				LINE_LineTransmit(line->LastTransmitBuffer, line->LastTransmitSize);
+				if (line->StaleReplies > 0)
+					line->StaleReplies--;
+				else
+					Retransmit(line);
 			}
 		}
 		while (tmpw != line->ReceiveSeq);
@@ -793,16 +1439,264 @@ retry:
 			if (sendto(line->CommSocket, (const char *) handshake, 16, 0, (struct sockaddr *) &line->SocketAddress, sizeof(line->SocketAddress)) != 16) {     /* send Handshake 7 */
 				return -1;
 			}
+			if (T32_CaptureActive)
+				CapturePacket(line, T32_CAPTURE_OUTBOUND, handshake, 16);
 		}
 	}
 	while (flag);
 
 	line->LastReceiveSeq = s;
+	line->StaleReplies = line->RequestRetransmits;
+	SampleRtt(line, out, count);
 
 	return count;
 }
 
 
+/**
+	Enqueues an asynchronous notification that slipped into a request/reply
+	pair. When the ring is full the oldest notification is dropped.
+	@return the slot to fill with length bytes (clamped to T32_PCKLEN_MAX)
+*/
+static T32_NotificationPackage *QueueNotification(LineStruct * line, int length)
+{
+	T32_NotificationPackage *newPackage;
+
+	if (line->NotificationCount == LINE_NOTIFY_SLOTS) {
+		line->NotificationFirst = (line->NotificationFirst + 1) % LINE_NOTIFY_SLOTS;
+		line->NotificationCount--;
+		line->Stats.NotificationsDropped++;
+	}
+	newPackage = &line->Notification[(line->NotificationFirst + line->NotificationCount) % LINE_NOTIFY_SLOTS];
+	line->NotificationCount++;
+	newPackage->length = (length < T32_PCKLEN_MAX) ? length : T32_PCKLEN_MAX;
+	return newPackage;
+}
+
+
+/**
+	Receives a message like LINE_LineReceive(), but scatters its payload.
+
+	@param out      : output buffer, gets the first headSize bytes of the
+	                  message and all bytes exceeding the segments (at their
+	                  message offset)
+	@param headSize : number of message bytes stored at out
+	@param seg      : destinations of the message bytes following the head
+	@param nseg     : number of segments (0...LINE_MAXSEGMENTS)
+	@return number of bytes of the message or error number (<0)
+	@note
+		on UNIX hosts the packets are received straight into the segments,
+		packets which are dropped (stale sequence IDs, foreign message IDs)
+		may leave data there which a later packet overwrites
+*/
+static int LINE_LineReceiveV(unsigned char *out, int headSize, const LineSegment * seg, int nseg)
+{
+	return LINE_LineReceiveVEx(pLineParams, out, headSize, seg, nseg);
+}
+
+
+#ifdef LINE_USE_IOVEC
+/**
+	Describes the message bytes [offset...offset+size-1] as iovecs, see
+	LINE_LineReceiveV() for the layout.
+	@return number of iovecs (at most nseg+2)
+*/
+static int MessageSlices(unsigned char *out, int headSize, const LineSegment * seg, int nseg, int offset, int size, struct iovec *iov)
+{
+	int             i, chunk, n = 0;
+	int             base = headSize;
+
+	if (offset < headSize) {
+		chunk = (headSize - offset < size) ? headSize - offset : size;
+		iov[n].iov_base = out + offset;
+		iov[n++].iov_len = chunk;
+		offset += chunk;
+		size -= chunk;
+	}
+	for (i = 0; (i < nseg) && (size > 0); i++) {
+		if (offset < base + seg[i].size) {
+			chunk = base + seg[i].size - offset;
+			if (chunk > size)
+				chunk = size;
+			iov[n].iov_base = seg[i].data + (offset - base);
+			iov[n++].iov_len = chunk;
+			offset += chunk;
+			size -= chunk;
+		}
+		base += seg[i].size;
+	}
+	if (size > 0) {
+		iov[n].iov_base = out + offset;
+		iov[n++].iov_len = size;
+	}
+	return n;
+}
+
+
+/** Copies size bytes starting behind the first iovec (the packet header) into dest. */
+static void GatherPacket(unsigned char *dest, const struct iovec *iov, int niov, int size)
+{
+	int             i, chunk;
+
+	for (i = 1; (i < niov) && (size > 0); i++) {
+		chunk = ((int) iov[i].iov_len < size) ? (int) iov[i].iov_len : size;
+		memcpy(dest, iov[i].iov_base, chunk);
+		dest += chunk;
+		size -= chunk;
+	}
+}
+
+
+/**
+	Receives a reply package into the given iovecs, see WaitForReply().
+	Data already pending is read without waiting.
+*/
+static int ReceiveReplyV(LineStruct * line, struct iovec *iov, int niov)
+{
+	int             i, result;
+	struct msghdr   msg;
+#ifdef LINE_USE_MMSG
+	int             chunk, copied;
+	unsigned char  *src;
+#endif
+
+#ifdef LINE_USE_MMSG
+	/* packets drained by an earlier recvmmsg() come first */
+	if (line->RxNext < line->RxCount) {
+		src = line->RxQueue + line->RxNext * line->RxSlotSize;
+		result = line->RxLength[line->RxNext++];
+		for (i = 0, copied = 0; (i < niov) && (copied < result); i++) {
+			chunk = ((int) iov[i].iov_len < result - copied) ? (int) iov[i].iov_len : result - copied;
+			memcpy(iov[i].iov_base, src + copied, chunk);
+			copied += chunk;
+		}
+		return copied;
+	}
+#endif
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = niov;
+	result = recvmsg(line->CommSocket, &msg, MSG_DONTWAIT);
+	if ((result < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+		i = WaitForReply(line);
+		if (i <= 0) {
+			return i;
+		}
+		result = recvmsg(line->CommSocket, &msg, 0);
+	}
+	if (T32_CaptureActive)
+		CapturePacketV(line, T32_CAPTURE_INBOUND, iov, niov, result);
+	return result;
+}
+#endif
+
+
+/** Receives a message from the given communication line, see LINE_LineReceiveV(). */
+static int LINE_LineReceiveVEx(LineStruct * line, unsigned char *out, int headSize, const LineSegment * seg, int nseg)
+{
+#ifdef LINE_USE_IOVEC
+	int             i, flag, niov;
+	int             count;
+	unsigned short  tmpw;
+	unsigned short  s;
+	unsigned char   header[4];
+	struct iovec    iov[LINE_MAXSEGMENTS + 3];  /* packet header, head, segments, excess */
+	static const unsigned char handshake[] = { 7, 0, 0, 0, 0, 0, 0, 0, 'T', 'R', 'A', 'C', 'E', '3', '2', 0 };
+
+	if (!line || (nseg < 0) || (nseg > LINE_MAXSEGMENTS))
+		return -1;
+
+retry:
+	count = 0;
+	s = line->ReceiveSeq;
+
+	do {
+		/* packet header goes to scratch, its data directly to the message position */
+		iov[0].iov_base = header;
+		iov[0].iov_len = 4;
+		niov = 1 + MessageSlices(out, headSize, seg, nseg, count, line->PacketSize - 4, iov + 1);
+
+		do {
+			if ((i = ReceiveReplyV(line, iov, niov)) <= 0) {
+				if (i == -2)
+					goto retry;
+				return -1;
+			}
+			/* we got a handshakepackage, ignore it */
+			if ((i == 1) && (header[0] == '+')) {
+				goto retry;
+			}
+
+			if (i <= 4) {
+				return -1;
+			}
+
+			/* Detect and enqeue async notification that slipped into a request/reply pair */
+			if (header[0] == T32_API_NOTIFICATION) {
+				T32_NotificationPackage *newPackage = QueueNotification(line, i);
+
+				memcpy(newPackage->payload, header, 4);
+				GatherPacket(newPackage->payload + 4, iov, niov, newPackage->length - 4);
+				goto retry;
+			}
+
+			if (header[0] != T32_API_RECEIVE) {
+				return -1;
+			}
+			SETWORDVAR(tmpw, header[2]);
+
+			/*
+				the previous reply again: TRACE32 lost the current request,
+				unless it answers a copy of the previous one
+			*/
+			if (tmpw == line->LastReceiveSeq && line->LastTransmitSize) {
+				if (line->StaleReplies > 0)
+					line->StaleReplies--;
+				else
+					Retransmit(line);
+			}
+		}
+		while (tmpw != line->ReceiveSeq);
+
+		line->ReceiveSeq++;
+		flag = header[1];
+		count += i - 4;
+
+		if (count > LINE_MSIZE) {
+			return -1;
+		}
+		if (flag == 2) {
+			if (sendto(line->CommSocket, (const char *) handshake, 16, 0, (struct sockaddr *) &line->SocketAddress, sizeof(line->SocketAddress)) != 16) {     /* send Handshake 7 */
+				return -1;
+			}
+			if (T32_CaptureActive)
+				CapturePacket(line, T32_CAPTURE_OUTBOUND, handshake, 16);
+		}
+	}
+	while (flag);
+
+	line->LastReceiveSeq = s;
+	line->StaleReplies = line->RequestRetransmits;
+	SampleRtt(line, out, count);
+
+	return count;
+#else
+	/* no scatter I/O: assemble in out and copy the segments */
+	int             i, chunk;
+	int             offset = headSize;
+	int             count = LINE_LineReceiveEx(line, out);
+
+	for (i = 0; (i < nseg) && (offset < count); i++) {
+		chunk = (seg[i].size < count - offset) ? seg[i].size : count - offset;
+		memcpy(seg[i].data, out + offset, chunk);
+		offset += seg[i].size;
+	}
+	return count;
+#endif
+}
+
+
 /** Receives notification messages. First checks for a queued
 	notification and if none is available polls the socket for new
 	notifications. For getting all pending notifications call the
@@ -814,22 +1708,30 @@ retry:
 
  */
 static int LINE_ReceiveNotifyMessage(unsigned char *package)
+{
+	return LINE_ReceiveNotifyMessageEx(pLineParams, package);
+}
+
+
+/** Receives notification messages of the given communication line, see LINE_ReceiveNotifyMessage(). */
+static int LINE_ReceiveNotifyMessageEx(LineStruct * line, unsigned char *package)
 {
 	int             len;
-	static struct timeval LongTime2 = { 0, 0 };
+	static const struct timeval LongTime2 = { 0, 0 };
+
+	if (!line)
+		return -1;
 
 	/* Check for asynchronous notifications */
-	if (T32_NotificationTail) {
-		T32_NotificationPackage *prev = T32_NotificationTail->prev;
-		if (prev)
-			prev->next = NULL;
-		memcpy(package, T32_NotificationTail->payload, T32_PCKLEN_MAX);
-		free(T32_NotificationTail);
-		T32_NotificationTail = prev;
-		if (prev == NULL)       /* deleted last message */
-			T32_NotificationHead = NULL;
+	if (line->NotificationCount) {
+		T32_NotificationPackage *oldest = &line->Notification[line->NotificationFirst];
+
+		memcpy(package, oldest->payload, oldest->length);
+		line->NotificationFirst = (line->NotificationFirst + 1) % LINE_NOTIFY_SLOTS;
+		line->NotificationCount--;
 	} else {
-		len = ReceiveWithTimeout(&LongTime2, package, T32_PCKLEN_MAX);
+		struct timeval  PollTime = LongTime2;
+		len = ReceiveWithTimeout(line, &PollTime, package, T32_PCKLEN_MAX);
 		if (len < 2)
 			return -1;
 	}
@@ -848,20 +1750,31 @@ static int LINE_ReceiveNotifyMessage(unsigned char *package)
  */
 static int LINE_NotificationPending(void)
 {
-	return T32_NotificationTail ? 1 : 0;
+	return LINE_NotificationPendingEx(pLineParams);
+}
+
+
+static int LINE_NotificationPendingEx(LineStruct * line)
+{
+	return (line && line->NotificationCount) ? 1 : 0;
 }
 
 /** Sends sync packets */
 static int LINE_LineSync(void)
+{
+	return LINE_LineSyncEx(pLineParams);
+}
+
+
+/** Sends sync packets on the given communication line */
+static int LINE_LineSyncEx(LineStruct * line)
 {
 	int                i, j;
 	unsigned char      packet[PCKLEN_MAX];
 	static const char  magicPattern[] = "TRACE32";
-	LineStruct        *line;
 
-	if (!pLineParams)
+	if (!line)
 		return -1;
-	line = pLineParams;
 
 	j = 0;
 	memset(packet, 0, sizeof(packet));
@@ -879,11 +1792,13 @@ retry:
 	if (sendto(line->CommSocket, (char *) packet, 16 /*size */ , 0, (struct sockaddr *) &line->SocketAddress, sizeof(line->SocketAddress)) == -1) {     /* Send SyncReq 2 */
 		return -1;
 	}
+	if (T32_CaptureActive)
+		CapturePacket(line, T32_CAPTURE_OUTBOUND, packet, 16);
 	while (1) { /* empty queue */
 		if (++j > 20) {
 			return -1;
 		}
-		if ((i = ReceiveWithTimeout(&LongTime, packet, PCKLEN_MAX)) <= 0) {
+		if ((i = ReceiveWithTimeout(line, &LongTime, packet, PCKLEN_MAX)) <= 0) {
 			return -1;
 		}
 		if (i != 16 || packet[0] != T32_API_SYNCACKN || strcmp((char *) packet + 8, magicPattern)) {
@@ -896,6 +1811,7 @@ retry:
 
 	SETWORDVAR(line->ReceiveSeq, packet[2]);
 	line->LastReceiveSeq = line->ReceiveSeq - 100;
+	line->StaleReplies = 0;
 
 
 	packet[0] = T32_API_SYNCBACK;
@@ -910,6 +1826,8 @@ retry:
 	if (sendto(line->CommSocket, (char *) packet, 16, 0, (struct sockaddr *) &line->SocketAddress, sizeof(line->SocketAddress)) == -1) {        /* Send SyncBack 0x22 */
 		return -1;
 	}
+	if (T32_CaptureActive)
+		CapturePacket(line, T32_CAPTURE_OUTBOUND, packet, 16);
 	return 1;
 }
 
@@ -924,16 +1842,14 @@ retry:
 		1 : OK
 		2 : ?ERROR?
 */
-static int Connection(unsigned char *ipaddrused)
+static int Connection(LineStruct * line, unsigned char *ipaddrused)
 {
 	int             i;
 	unsigned char   buffer[PCKLEN_MAX];
-	LineStruct     *line;
 	static const char magicPattern[] = "TRACE32";
 
-	if (!pLineParams)
+	if (!line)
 		return 0;
-	line = pLineParams;
 
 	memset(buffer, 0, sizeof(buffer));
 
@@ -955,7 +1871,9 @@ static int Connection(unsigned char *ipaddrused)
 	if (i == -1) {
 		return 0;
 	}
-	i = ReceiveWithTimeout(&LongTime, buffer, line->PacketSize);
+	if (T32_CaptureActive)
+		CapturePacket(line, T32_CAPTURE_OUTBOUND, buffer, i);
+	i = ReceiveWithTimeout(line, &LongTime, buffer, line->PacketSize);
 	if (i <= 0) {
 		return 0;
 	}
@@ -987,7 +1905,7 @@ static int Connection(unsigned char *ipaddrused)
 	return 1;
 }
 
-static struct T32InternalLineDriver gLineDrvNetAssist = {
+struct T32InternalLineDriver gLineDrvNetAssist = {
 	LINE_LineConfig,                // Config
 	LINE_LineInit,                  // Init
 	LINE_LineExit,                  // Exit
@@ -1003,7 +1921,33 @@ static struct T32InternalLineDriver gLineDrvNetAssist = {
 	LINE_GetReceiveToggleBit,       // GetReceiveToggleBit
 	LINE_GetNextMessageId,          // GetNextMessageId
 	LINE_GetMessageId,              // GetMessageId
-	LINE_NotificationPending        // NotificationPending
+	LINE_NotificationPending,       // NotificationPending
+	LINE_LineConfigEx,              // ConfigEx
+	LINE_LineInitEx,                // InitEx
+	LINE_LineExitEx,                // ExitEx
+	LINE_LineDriverGetSocketEx,     // GetSocketEx
+	LINE_LineTransmitEx,            // TransmitEx
+	LINE_LineReceiveEx,             // ReceiveEx
+	LINE_ReceiveNotifyMessageEx,    // ReceiveNotifyMessageEx
+	LINE_LineSyncEx,                // SyncEx
+	LINE_SetReceiveToggleBitEx,     // SetReceiveToggleBitEx
+	LINE_GetReceiveToggleBitEx,     // GetReceiveToggleBitEx
+	LINE_GetNextMessageIdEx,        // GetNextMessageIdEx
+	LINE_GetMessageIdEx,            // GetMessageIdEx
+	LINE_NotificationPendingEx,     // NotificationPendingEx
+	LINE_LineTransmitV,             // TransmitV
+	LINE_LineTransmitVEx,           // TransmitVEx
+	LINE_LineReceiveV,              // ReceiveV
+	LINE_LineReceiveVEx,            // ReceiveVEx
+	LINE_GetStats,                  // GetStats
+	LINE_GetStatsEx,                // GetStatsEx
+	LINE_ReceivePending,            // ReceivePending
+	LINE_ReceivePendingEx,          // ReceivePendingEx
+	LINE_GetMaxPacketSize,          // GetMaxPacketSize
+	LINE_SetMaxPacketSize,          // SetMaxPacketSize
+	LINE_GetMaxPacketSizeEx,        // GetMaxPacketSizeEx
+	LINE_SetMaxPacketSizeEx,        // SetMaxPacketSizeEx
+	1                               // MaxPending, only the newest request can be sent again
 };
 struct T32InternalLineDriver *gT32InternalLineDriver = &gLineDrvNetAssist;
 
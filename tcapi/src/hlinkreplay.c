@@ -0,0 +1,704 @@
+/*
+ * TRACE32 Remote API
+ *
+ * Copyright (c) 1998-2020 Lauterbach GmbH
+ * All rights reserved
+ *
+ * Replay line driver for hremote.c, selected at runtime with
+ * T32_Config("RCL=", "REPLAY"). It answers requests with the replies of a
+ * pcapng capture of the UDP driver (see hlinkcap.c, "CAPTURE=") instead of
+ * talking to TRACE32, so a recorded session can be run again offline.
+ *
+ *    REPLAY=<file>      capture to replay
+ *    REPLAYPACE=1       hand out each reply with the latency it had in the
+ *                       capture (UNIX hosts), 0: as fast as possible
+ *
+ * Replay works on messages: packets of the capture are reassembled by
+ * their sequence IDs, repeated packets (retransmissions) and connection,
+ * sync and handshake packets are skipped. Each request of the application
+ * is compared with the next request of the capture, differences are counted
+ * in T32_LineStats.ReplayMismatches but do not stop the replay. Message IDs
+ * are taken from the capture, so the replies match the requests.
+ *
+ * Licensing restrictions apply to this code.
+ * Please see documentation (api_remote_c.pdf) for
+ * licensing terms and conditions.
+ *
+ * formatted with:
+ *    indent -kr -c0 -cbi0 -cd0 -cli4 -cp10 -di16 -fc1 -il0 -nsc -ppi2 --line-length120 --no-tabs hlinkreplay.c
+ */
+
+
+#if defined(T32HOST_UNIX)
+# ifndef T32HOST_SOL
+#  define _XOPEN_SOURCE 500
+# endif
+# ifndef _POSIX_C_SOURCE
+#  define _POSIX_C_SOURCE 200112L
+# endif
+# if defined(T32HOST_SOL)
+#  define __EXTENSIONS__
+# endif
+#endif
+
+
+#define T32INTERNAL_MAGIC 0xfe8ac993
+#include "t32.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(T32HOST_UNIX)
+# include <time.h>
+#endif
+
+
+#define REPLAY_PACKET_TRANSMIT  0x11    /* packet type of messages to TRACE32 */
+#define REPLAY_NOTIFY_SLOTS     8       /* queued notifications per line, see hlinknet.c */
+
+/* Queued asynchronous notification */
+typedef struct {
+	int             length;
+	unsigned char   payload[T32_PCKLEN_MAX];
+} ReplayNotification;
+
+/* *INDENT-OFF* */
+typedef struct LineStruct_s {
+	char               FileName[256]; /* REPLAY=     */  /* capture to replay */
+	int                Pace;          /* REPLAYPACE= */  /* keep the recorded reply latency */
+	unsigned short     TransmitPort;  /* PORT=       */  /* identifies requests in foreign captures */
+	T32_CaptureRecord *Records;
+	int                NumRecords;
+	int                NextOut, NextIn;                  /* record cursors of both directions */
+	int                OutSeqValid, InSeqValid;
+	unsigned short     OutSeq, InSeq;                    /* last replayed sequence IDs */
+	uint64_t           LastOutTimeNs;                    /* capture time of the last replayed request */
+	uint64_t           LastOutWallNs;                    /* and when it was replayed */
+	int                ReceiveToggleBit;
+	int                MaxPacketSize;                    /* see T32_NegotiatePacketSize() */
+	unsigned char      MessageId;
+	int                LineUp;
+	unsigned char      Message[LINE_MSIZE];              /* reassembled request of the capture */
+	ReplayNotification Notification[REPLAY_NOTIFY_SLOTS]; /* ring of pending notifications */
+	int                NotificationFirst, NotificationCount;
+	T32_LineStats      Stats;
+} LineStruct;
+/* *INDENT-ON* */
+
+static T32_THREADLOCAL int isLineParamsInitialized;
+static T32_THREADLOCAL LineStruct LineParams;
+static T32_THREADLOCAL LineStruct *pLineParams = NULL;
+
+
+static void SetToDefaultLineParams(LineStruct * params)
+{
+	if ((params == &LineParams) && isLineParamsInitialized != 0)
+		return;
+	memset(params, 0, sizeof(LineStruct));
+	params->TransmitPort     = 20000;
+	params->ReceiveToggleBit = -1;
+	params->MaxPacketSize    = T32_MAXPACKETSIZE_DEFAULT;
+	if (params == &LineParams)
+		isLineParamsInitialized = 1;
+}
+
+
+static int str2dec(char *in)
+{
+	int             x = 0;
+	while (*in) {
+		x *= 10;
+		if (*in < '0' || *in > '9')
+			return -1;
+		x += *in - '0';
+		in++;
+	}
+	return x;
+}
+
+
+static uint64_t WallTimeNs(void)
+{
+#ifdef T32HOST_UNIX
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+
+/** Waits until WallTimeNs() reaches the given time. */
+static void WaitUntil(uint64_t wallNs)
+{
+#ifdef T32HOST_UNIX
+	struct timespec ts;
+	uint64_t        now = WallTimeNs();
+
+	if (wallNs <= now)
+		return;
+	ts.tv_sec = (time_t) ((wallNs - now) / 1000000000u);
+	ts.tv_nsec = (long) ((wallNs - now) % 1000000000u);
+	nanosleep(&ts, NULL);
+#else
+	(void) wallNs;
+#endif
+}
+
+
+/** Direction of a record; captures without epb_flags are classified by the port of TRACE32. */
+static int RecordDirection(LineStruct * line, const T32_CaptureRecord * rec)
+{
+	if (rec->Direction)
+		return rec->Direction;
+	if (rec->DstPort == line->TransmitPort)
+		return T32_CAPTURE_OUTBOUND;
+	if (rec->SrcPort == line->TransmitPort)
+		return T32_CAPTURE_INBOUND;
+	return 0;
+}
+
+
+static unsigned short PacketSeq(const T32_CaptureRecord * rec)
+{
+	unsigned short  seq;
+
+	SETWORDVAR(seq, rec->Data[2]);
+	return seq;
+}
+
+
+/**
+	Finds the next packet of a message in the given direction, starting at
+	the cursor: request packets (0x11) or replies and notifications.
+	Retransmitted packets and other packet types are skipped.
+	@return index of the record, -1 at the end of the capture
+*/
+static int FindPacket(LineStruct * line, int direction, int index)
+{
+	const T32_CaptureRecord *rec;
+	unsigned short  last = (direction == T32_CAPTURE_OUTBOUND) ? line->OutSeq : line->InSeq;
+	int             valid = (direction == T32_CAPTURE_OUTBOUND) ? line->OutSeqValid : line->InSeqValid;
+
+	for (; index < line->NumRecords; index++) {
+		rec = &line->Records[index];
+		if (RecordDirection(line, rec) != direction || rec->Size < 4)
+			continue;
+		if (direction == T32_CAPTURE_OUTBOUND && rec->Data[0] != REPLAY_PACKET_TRANSMIT)
+			continue;
+		if (direction == T32_CAPTURE_INBOUND && rec->Data[0] == T32_API_NOTIFICATION)
+			return index;
+		if (direction == T32_CAPTURE_INBOUND && rec->Data[0] != T32_API_RECEIVE)
+			continue;
+		if (valid && (short) (PacketSeq(rec) - last) <= 0)
+			continue;   /* repeated packet */
+		return index;
+	}
+	return -1;
+}
+
+
+/** Queues a notification of the capture, dropping the oldest on overflow. */
+static void QueueNotification(LineStruct * line, const T32_CaptureRecord * rec)
+{
+	ReplayNotification *slot;
+
+	if (line->NotificationCount == REPLAY_NOTIFY_SLOTS) {
+		line->NotificationFirst = (line->NotificationFirst + 1) % REPLAY_NOTIFY_SLOTS;
+		line->NotificationCount--;
+		line->Stats.NotificationsDropped++;
+	}
+	slot = &line->Notification[(line->NotificationFirst + line->NotificationCount) % REPLAY_NOTIFY_SLOTS];
+	slot->length = (rec->Size < T32_PCKLEN_MAX) ? rec->Size : T32_PCKLEN_MAX;
+	memcpy(slot->payload, rec->Data, slot->length);
+	line->NotificationCount++;
+}
+
+
+/**************************************************************************
+
+ driver functions, see struct T32InternalLineDriver
+
+***************************************************************************/
+
+static int LINE_LineConfigEx(LineStruct * line, char *input)
+{
+	int             x;
+
+	if (!strncmp((char *) input, "REPLAY=", 7)) {
+		if (strlen(input + 7) >= sizeof(line->FileName))
+			return -1;
+		strcpy(line->FileName, input + 7);
+		return 1;
+	}
+	if (!strncmp((char *) input, "REPLAYPACE=", 11)) {
+		x = str2dec(input + 11);
+		if (x == -1)
+			return -1;
+		line->Pace = x;
+		return 1;
+	}
+	if (!strncmp((char *) input, "PORT=", 5)) {
+		x = str2dec(input + 5);
+		if (x == -1)
+			return -1;
+		line->TransmitPort = (unsigned short) x;
+		return 1;
+	}
+	/* settings of the network drivers, without effect on a replay */
+	if (!strncmp((char *) input, "NODE=", 5) || !strncmp((char *) input, "PACKLEN=", 8)
+	    || !strncmp((char *) input, "HOSTPORT=", 9) || !strncmp((char *) input, "TIMEOUT=", 8)
+	    || !strncmp((char *) input, "RTOMIN=", 7) || !strncmp((char *) input, "RTOMAX=", 7)
+	    || !strncmp((char *) input, "BUSYPOLL=", 9))
+		return 1;
+	return -1;
+}
+
+
+static int LINE_LineConfig(char *input)
+{
+	if (pLineParams == NULL) {
+		pLineParams = &LineParams;
+		SetToDefaultLineParams(pLineParams);
+	}
+	return LINE_LineConfigEx(pLineParams, input);
+}
+
+
+/**
+	Loads the capture.
+	@return 0 : OK, capture already loaded
+		1 : OK, capture loaded
+		-1 : ERROR, message set
+*/
+static int LINE_LineInitEx(LineStruct * line, char *message)
+{
+	if (line->LineUp)
+		return 0;
+	if (!line->FileName[0]) {
+		strcpy(message, "no capture to replay, set REPLAY=");
+		return -1;
+	}
+	if (T32_CaptureLoad(line->FileName, &line->Records, &line->NumRecords) == -1) {
+		strcpy(message, "cannot read capture file");
+		return -1;
+	}
+	line->NextOut = line->NextIn = 0;
+	line->OutSeqValid = line->InSeqValid = 0;
+	line->LastOutWallNs = WallTimeNs();
+	line->LastOutTimeNs = line->NumRecords ? line->Records[0].TimeNs : 0;
+	line->LineUp = 1;
+	line->ReceiveToggleBit = -1;
+	line->MaxPacketSize = T32_MAXPACKETSIZE_DEFAULT;
+	return 1;
+}
+
+
+static int LINE_LineInit(char *message)
+{
+	if (pLineParams == NULL) {
+		pLineParams = &LineParams;
+		SetToDefaultLineParams(pLineParams);
+	}
+	return LINE_LineInitEx(pLineParams, message);
+}
+
+
+static void LINE_LineExitEx(LineStruct * line)
+{
+	if (!line)
+		return;
+	line->NotificationFirst = line->NotificationCount = 0;
+	if (line->Records)
+		T32_CaptureFree(line->Records, line->NumRecords);
+	line->Records = NULL;
+	line->NumRecords = 0;
+	line->LineUp = 0;
+}
+
+
+static void LINE_LineExit(void)
+{
+	LINE_LineExitEx(pLineParams);
+}
+
+
+static int LINE_LineDriverGetSocketEx(LineStruct * line)
+{
+	(void) line;
+	return -1;  /* nothing to poll, see LINE_ReceivePending() */
+}
+
+
+static int LINE_LineDriverGetSocket(void)
+{
+	return LINE_LineDriverGetSocketEx(pLineParams);
+}
+
+
+/**
+	Consumes the next request of the capture and compares it with the
+	message. Empty messages (UDP retry requests) are not replayed.
+*/
+static int LINE_LineTransmitEx(LineStruct * line, unsigned char *in, int size)
+{
+	const T32_CaptureRecord *rec = NULL;
+	int             index, count = 0;
+
+	if (!line || !line->LineUp)
+		return 0;
+	if (size == 0)
+		return 0;
+
+	while ((index = FindPacket(line, T32_CAPTURE_OUTBOUND, line->NextOut)) != -1) {
+		rec = &line->Records[index];
+		line->NextOut = index + 1;
+		line->OutSeq = PacketSeq(rec);
+		line->OutSeqValid = 1;
+		if (rec->Size == 4 && !count)
+			continue;   /* retry request */
+		if (count + rec->Size - 4 <= LINE_MSIZE)
+			memcpy(line->Message + count, rec->Data + 4, rec->Size - 4);
+		count += rec->Size - 4;
+		if (!rec->Data[1])
+			break;      /* no more packets follow */
+	}
+	if (count != size || memcmp(line->Message, in, size))
+		line->Stats.ReplayMismatches++;
+	if (rec) {
+		line->LastOutTimeNs = rec->TimeNs;
+		line->LastOutWallNs = WallTimeNs();
+	}
+	return size;
+}
+
+
+static int LINE_LineTransmit(unsigned char *in, int size)
+{
+	return LINE_LineTransmitEx(pLineParams, in, size);
+}
+
+
+/** Replays a message head followed by a payload and padding zero bytes. */
+static int LINE_LineTransmitVEx(LineStruct * line, unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding)
+{
+	/* the head buffer has room for LINE_MSIZE bytes */
+	if (payloadSize > 0)
+		memcpy(in + size, payload, payloadSize);
+	memset(in + size + payloadSize, 0, padding);
+	return LINE_LineTransmitEx(line, in, size + payloadSize + padding);
+}
+
+
+static int LINE_LineTransmitV(unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding)
+{
+	return LINE_LineTransmitVEx(pLineParams, in, size, payload, payloadSize, padding);
+}
+
+
+/**
+	Reassembles the next reply of the capture into out, queueing the
+	notifications in front of it. With REPLAYPACE=1 the reply is held
+	back until it is as late as in the capture.
+	@return length of the message, -1 at the end of the capture
+*/
+static int LINE_LineReceiveEx(LineStruct * line, unsigned char *out)
+{
+	const T32_CaptureRecord *rec;
+	int             index, count = 0;
+
+	if (!line || !line->LineUp)
+		return -1;
+
+	while ((index = FindPacket(line, T32_CAPTURE_INBOUND, line->NextIn)) != -1) {
+		rec = &line->Records[index];
+		line->NextIn = index + 1;
+		if (rec->Data[0] == T32_API_NOTIFICATION) {
+			QueueNotification(line, rec);
+			continue;
+		}
+		if (!count && line->Pace && rec->TimeNs > line->LastOutTimeNs)
+			WaitUntil(line->LastOutWallNs + (rec->TimeNs - line->LastOutTimeNs));
+		line->InSeq = PacketSeq(rec);
+		line->InSeqValid = 1;
+		if (count + rec->Size - 4 > LINE_MSIZE)
+			return -1;
+		memcpy(out + count, rec->Data + 4, rec->Size - 4);
+		count += rec->Size - 4;
+		if (!rec->Data[1])
+			return count;       /* no more packets follow, flag 2 asks for a handshake */
+	}
+	return -1;
+}
+
+
+static int LINE_LineReceive(unsigned char *out)
+{
+	return LINE_LineReceiveEx(pLineParams, out);
+}
+
+
+/** Receives a reply with its head at out and the following bytes copied to the segments. */
+static int LINE_LineReceiveVEx(LineStruct * line, unsigned char *out, int headSize, const LineSegment * seg, int nseg)
+{
+	int             i, chunk;
+	int             offset = headSize;
+	int             count = LINE_LineReceiveEx(line, out);
+
+	for (i = 0; (i < nseg) && (offset < count); i++) {
+		chunk = (seg[i].size < count - offset) ? seg[i].size : count - offset;
+		memcpy(seg[i].data, out + offset, chunk);
+		offset += seg[i].size;
+	}
+	return count;
+}
+
+
+static int LINE_LineReceiveV(unsigned char *out, int headSize, const LineSegment * seg, int nseg)
+{
+	return LINE_LineReceiveVEx(pLineParams, out, headSize, seg, nseg);
+}
+
+
+/**
+	Returns a queued notification or the next packet of the capture if it
+	is a notification.
+	@return -1 no notification pending, >=0 notification type
+*/
+static int LINE_ReceiveNotifyMessageEx(LineStruct * line, unsigned char *package)
+{
+	int             index;
+
+	if (!line || !line->LineUp)
+		return -1;
+	if (!line->NotificationCount) {
+		index = FindPacket(line, T32_CAPTURE_INBOUND, line->NextIn);
+		if (index == -1 || line->Records[index].Data[0] != T32_API_NOTIFICATION)
+			return -1;
+		line->NextIn = index + 1;
+		QueueNotification(line, &line->Records[index]);
+	}
+
+	memcpy(package, line->Notification[line->NotificationFirst].payload, line->Notification[line->NotificationFirst].length);
+	line->NotificationFirst = (line->NotificationFirst + 1) % REPLAY_NOTIFY_SLOTS;
+	line->NotificationCount--;
+	return package[1];  /* type of notification: T32_E_BREAK, T32_E_EDIT, T32_E_BREAKPOINTCONFIG  */
+}
+
+
+static int LINE_ReceiveNotifyMessage(unsigned char *package)
+{
+	return LINE_ReceiveNotifyMessageEx(pLineParams, package);
+}
+
+
+/** Sequence IDs come from the capture, there is nothing to synchronize. */
+static int LINE_LineSyncEx(LineStruct * line)
+{
+	return (line && line->LineUp) ? 1 : -1;
+}
+
+
+static int LINE_LineSync(void)
+{
+	return LINE_LineSyncEx(pLineParams);
+}
+
+
+static int LINE_GetLineParamsSize(void)
+{
+	return sizeof(LineStruct);
+}
+
+
+static void LINE_DefaultLineParams(LineStruct * ParametersOut)
+{
+	SetToDefaultLineParams(ParametersOut);
+}
+
+
+static void LINE_SetLine(LineStruct * params)
+{
+	pLineParams = params;
+}
+
+
+static void LINE_SetReceiveToggleBitEx(LineStruct * line, int value)
+{
+	if (line)
+		line->ReceiveToggleBit = value;
+}
+
+
+static int LINE_GetReceiveToggleBitEx(LineStruct * line)
+{
+	return line ? line->ReceiveToggleBit : 0;
+}
+
+
+/** Returns the message ID of the next request in the capture, so that its reply matches. */
+static unsigned char LINE_GetNextMessageIdEx(LineStruct * line)
+{
+	int             index;
+
+	if (!line)
+		return 0;
+	index = FindPacket(line, T32_CAPTURE_OUTBOUND, line->NextOut);
+	while (index != -1 && line->Records[index].Size == 4) {
+		line->OutSeq = PacketSeq(&line->Records[index]);
+		line->OutSeqValid = 1;
+		line->NextOut = index + 1;
+		index = FindPacket(line, T32_CAPTURE_OUTBOUND, line->NextOut);
+	}
+	if (index != -1 && line->Records[index].Size > 4 + 8)
+		line->MessageId = line->Records[index].Data[4 + 8];
+	else
+		line->MessageId++;
+	return line->MessageId;
+}
+
+
+static unsigned char LINE_GetMessageIdEx(LineStruct * line)
+{
+	return line ? line->MessageId : 0;
+}
+
+
+static void LINE_SetReceiveToggleBit(int value)
+{
+	LINE_SetReceiveToggleBitEx(pLineParams, value);
+}
+
+
+static int LINE_GetReceiveToggleBit(void)
+{
+	return LINE_GetReceiveToggleBitEx(pLineParams);
+}
+
+
+static unsigned char LINE_GetNextMessageId(void)
+{
+	return LINE_GetNextMessageIdEx(pLineParams);
+}
+
+
+static unsigned char LINE_GetMessageId(void)
+{
+	return LINE_GetMessageIdEx(pLineParams);
+}
+
+
+static int LINE_NotificationPendingEx(LineStruct * line)
+{
+	return (line && line->NotificationCount) ? 1 : 0;
+}
+
+
+static int LINE_NotificationPending(void)
+{
+	return LINE_NotificationPendingEx(pLineParams);
+}
+
+
+/** Only the notification and mismatch counters apply to a replay. */
+static void LINE_GetStatsEx(LineStruct * line, T32_LineStats * stats)
+{
+	memset(stats, 0, sizeof(T32_LineStats));
+	if (line)
+		*stats = line->Stats;
+}
+
+
+static void LINE_GetStats(T32_LineStats * stats)
+{
+	LINE_GetStatsEx(pLineParams, stats);
+}
+
+
+/** A reply is pending as long as the capture has one left. */
+static int LINE_ReceivePendingEx(LineStruct * line)
+{
+	if (!line || !line->LineUp)
+		return 0;
+	return FindPacket(line, T32_CAPTURE_INBOUND, line->NextIn) != -1;
+}
+
+
+static int LINE_ReceivePending(void)
+{
+	return LINE_ReceivePendingEx(pLineParams);
+}
+
+
+static int LINE_GetMaxPacketSizeEx(LineStruct * line)
+{
+	return line ? line->MaxPacketSize : T32_MAXPACKETSIZE_DEFAULT;
+}
+
+
+static void LINE_SetMaxPacketSizeEx(LineStruct * line, int size)
+{
+	if (line)
+		line->MaxPacketSize = size;
+}
+
+
+static int LINE_GetMaxPacketSize(void)
+{
+	return LINE_GetMaxPacketSizeEx(pLineParams);
+}
+
+
+static void LINE_SetMaxPacketSize(int size)
+{
+	LINE_SetMaxPacketSizeEx(pLineParams, size);
+}
+
+
+struct T32InternalLineDriver gLineDrvReplay = {
+	LINE_LineConfig,                // Config
+	LINE_LineInit,                  // Init
+	LINE_LineExit,                  // Exit
+	LINE_LineDriverGetSocket,       // GetSocket
+	LINE_LineTransmit,              // Transmit
+	LINE_LineReceive,               // Receive
+	LINE_ReceiveNotifyMessage,      // ReceiveNotifyMessage
+	LINE_LineSync,                  // Sync
+	LINE_GetLineParamsSize,         // GetParamsSize
+	LINE_DefaultLineParams,         // DefaultParams
+	LINE_SetLine,                   // SetParams
+	LINE_SetReceiveToggleBit,       // SetReceiveToggleBit
+	LINE_GetReceiveToggleBit,       // GetReceiveToggleBit
+	LINE_GetNextMessageId,          // GetNextMessageId
+	LINE_GetMessageId,              // GetMessageId
+	LINE_NotificationPending,       // NotificationPending
+	LINE_LineConfigEx,              // ConfigEx
+	LINE_LineInitEx,                // InitEx
+	LINE_LineExitEx,                // ExitEx
+	LINE_LineDriverGetSocketEx,     // GetSocketEx
+	LINE_LineTransmitEx,            // TransmitEx
+	LINE_LineReceiveEx,             // ReceiveEx
+	LINE_ReceiveNotifyMessageEx,    // ReceiveNotifyMessageEx
+	LINE_LineSyncEx,                // SyncEx
+	LINE_SetReceiveToggleBitEx,     // SetReceiveToggleBitEx
+	LINE_GetReceiveToggleBitEx,     // GetReceiveToggleBitEx
+	LINE_GetNextMessageIdEx,        // GetNextMessageIdEx
+	LINE_GetMessageIdEx,            // GetMessageIdEx
+	LINE_NotificationPendingEx,     // NotificationPendingEx
+	LINE_LineTransmitV,             // TransmitV
+	LINE_LineTransmitVEx,           // TransmitVEx
+	LINE_LineReceiveV,              // ReceiveV
+	LINE_LineReceiveVEx,            // ReceiveVEx
+	LINE_GetStats,                  // GetStats
+	LINE_GetStatsEx,                // GetStatsEx
+	LINE_ReceivePending,            // ReceivePending
+	LINE_ReceivePendingEx,          // ReceivePendingEx
+	LINE_GetMaxPacketSize,          // GetMaxPacketSize
+	LINE_SetMaxPacketSize,          // SetMaxPacketSize
+	LINE_GetMaxPacketSizeEx,        // GetMaxPacketSizeEx
+	LINE_SetMaxPacketSizeEx,        // SetMaxPacketSizeEx
+	1                               // MaxPending, as the UDP driver whose traffic is replayed
+};
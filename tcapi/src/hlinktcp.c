@@ -0,0 +1,960 @@
+/*
+ * TRACE32 Remote API
+ *
+ * Copyright (c) 1998-2020 Lauterbach GmbH
+ * All rights reserved
+ *
+ * TCP line driver for hremote.c, selected at runtime with
+ * T32_Config("RCL=", "TCPRELAY"). The UDP driver of hlinknet.c stays the
+ * default ("RCL=NETASSIST").
+ *
+ * T32_Config("RCL=", "MUX") selects the same driver over the Unix domain
+ * socket of t32mux on the local host: NODE= names the socket if it starts
+ * with '/', otherwise T32MUX_DEFAULT_SOCKET is used; PORT= is ignored.
+ * t32mux owns the link to PowerView and shares it with its other clients.
+ *
+ * This is not the RCL=NETTCP protocol of TRACE32, PowerView does not accept
+ * it. The driver needs a relay next to PowerView which accepts the stream
+ * connection, speaks the framing below and passes each message on to the
+ * RCL=NETASSIST UDP port of PowerView, so that only the local hop is UDP.
+ * The relay does the UDP connection handshake; the stream itself has no
+ * connect or attach handshake. tools/t32mux.c is such a relay, started on
+ * the host of PowerView with -t <port>; PORT= selects that port. It does not
+ * pass notifications on.
+ *
+ * Each message travels as one frame on a single stream connection:
+ *
+ *    byte 0     frame type (0x11 to TRACE32, T32_API_RECEIVE or
+ *               T32_API_NOTIFICATION from TRACE32)
+ *    byte 1     0
+ *    byte 2..3  length of the message, little endian
+ *    byte 4..   message (including the 5 byte message header)
+ *
+ * i.e. the UDP packet header with the sequence ID replaced by the length.
+ * Segmentation, ordering and loss recovery are left to the kernel, so the
+ * driver has no sequence IDs, retransmissions or multi packet assembly.
+ *
+ * Licensing restrictions apply to this code.
+ * Please see documentation (api_remote_c.pdf) for
+ * licensing terms and conditions.
+ *
+ * formatted with:
+ *    indent -kr -c0 -cbi0 -cd0 -cli4 -cp10 -di16 -fc1 -il0 -nsc -ppi2 --line-length120 --no-tabs hlinktcp.c
+ */
+
+
+#if defined(T32HOST_UNIX)
+# ifndef T32HOST_SOL
+#  define _XOPEN_SOURCE 500
+# endif
+# ifndef _POSIX_C_SOURCE
+#  define _POSIX_C_SOURCE 200112L
+# endif
+# if defined(T32HOST_SOL)
+#  define __EXTENSIONS__
+# endif
+#endif
+
+
+#define T32INTERNAL_MAGIC 0xfe8ac993
+#include "t32.h"
+
+#if defined(_MSC_VER)
+# pragma warning( push )
+# pragma warning( disable : 4255 )
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef T32HOST_WIN
+# ifndef NOGDI
+#  define NOGDI
+# endif
+# include <winsock2.h>
+# include <ws2tcpip.h>
+typedef int     socklen_t;
+#endif
+
+#if defined(T32HOST_UNIX)
+# include <sys/types.h>
+# include <unistd.h>
+# include <errno.h>
+# include <sys/socket.h>
+# include <sys/uio.h>
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+# include <netdb.h>
+# include <poll.h>
+# include <sys/un.h>
+#endif
+
+
+#if defined(_MSC_VER)
+# pragma warning( pop )
+/* disable warning for FD_SET() :-(  */
+# pragma warning( disable : 4548)
+#endif
+
+
+#define TCP_BUFSIZE         (256 * 1024)    /* socket buffers, room for several LINE_MSIZE messages */
+#define TCP_FRAME_TRANSMIT  0x11            /* frame type of messages to TRACE32 */
+#define TCP_NOTIFY_SLOTS    8               /* queued notifications per line, see hlinknet.c */
+
+/* Queued asynchronous notification */
+typedef struct {
+	int             length;
+	unsigned char   payload[T32_PCKLEN_MAX];
+} TcpNotification;
+
+/* *INDENT-OFF* */
+typedef struct LineStruct_s {
+	char               NodeName[80]; /* NODE=     */  /* node name of host running T32 SW */
+	int                CommSocket;                    /* stream socket */
+	unsigned short     TransmitPort; /* PORT=     */  /* Port of the TCP server in T32 */
+	int                PollTimeSec;  /* TIMEOUT=  */
+	int                BusyPollUs;   /* BUSYPOLL= */  /* SO_BUSY_POLL of the socket, 0: off */
+	int                ReceiveToggleBit;
+	int                MaxPacketSize;                 /* see T32_NegotiatePacketSize() */
+	unsigned char      MessageId;
+	int                LineUp;
+	TcpNotification    Notification[TCP_NOTIFY_SLOTS]; /* ring of pending notifications */
+	int                NotificationFirst, NotificationCount;
+	T32_LineStats      Stats;
+} LineStruct;
+/* *INDENT-ON* */
+
+static T32_THREADLOCAL int isLineParamsInitialized;
+static T32_THREADLOCAL LineStruct LineParams;
+static T32_THREADLOCAL LineStruct *pLineParams = NULL;
+
+
+static void SetToDefaultLineParams(LineStruct * params)
+{
+	if ((params == &LineParams) && isLineParamsInitialized != 0)
+		return;
+	memset(params, 0, sizeof(LineStruct));
+	strcpy(params->NodeName, "localhost");
+	params->CommSocket       = -1;
+	params->TransmitPort     = 20000;
+	params->PollTimeSec      = 5;
+	params->ReceiveToggleBit = -1;
+	params->MaxPacketSize    = T32_MAXPACKETSIZE_DEFAULT;
+	if (params == &LineParams)
+		isLineParamsInitialized = 1;
+}
+
+
+static int str2dec(char *in)
+{
+	int             x = 0;
+	while (*in) {
+		x *= 10;
+		if (*in < '0' || *in > '9')
+			return -1;
+		x += *in - '0';
+		in++;
+	}
+	return x;
+}
+
+
+static void CloseSocket(LineStruct * line)
+{
+	if (line->CommSocket != -1) {
+#ifdef T32HOST_WIN
+		closesocket(line->CommSocket);
+		WSACleanup();
+#endif
+#ifdef T32HOST_UNIX
+		close(line->CommSocket);
+#endif
+	}
+	line->CommSocket = -1;
+	line->LineUp = 0;
+}
+
+
+/**
+	Waits until the socket is readable.
+	@return >0 readable, 0 on timeout, <0 on error
+*/
+static int WaitReadable(LineStruct * line, int timeoutMs)
+{
+#ifdef T32HOST_UNIX
+	struct pollfd   pfd;
+
+	pfd.fd = line->CommSocket;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll(&pfd, 1, timeoutMs);
+#else
+	fd_set          readfds;
+	struct timeval  timeout;
+
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_usec = (timeoutMs % 1000) * 1000;
+	FD_ZERO(&readfds);
+	FD_SET((unsigned int) line->CommSocket, &readfds);
+	return select(FD_SETSIZE, &readfds, (fd_set *) NULL, (fd_set *) NULL, &timeout);
+#endif
+}
+
+
+/**
+	Sends size bytes, continuing after partial writes. A failed stream
+	is closed, the message boundaries would be lost otherwise.
+	@return 0 on success, -1 on error
+*/
+static int SendAll(LineStruct * line, const unsigned char *data, int size)
+{
+	int             result;
+
+	while (size > 0) {
+		result = send(line->CommSocket, (const char *) data, size, 0);
+		if (result <= 0) {
+			CloseSocket(line);
+			return -1;
+		}
+		data += result;
+		size -= result;
+	}
+	return 0;
+}
+
+
+/**
+	Receives exactly size bytes, waiting up to PollTimeSec for each part.
+	dest may be NULL to skip the bytes.
+	@return 0 on success, -1 on error (the stream is closed)
+*/
+static int ReceiveAll(LineStruct * line, unsigned char *dest, int size)
+{
+	int             result;
+	unsigned char   skip[256];
+
+	while (size > 0) {
+		if (WaitReadable(line, line->PollTimeSec * 1000) <= 0)
+			goto error;
+		if (dest)
+			result = recv(line->CommSocket, (char *) dest, size, 0);
+		else
+			result = recv(line->CommSocket, (char *) skip, (size < (int) sizeof(skip)) ? size : (int) sizeof(skip), 0);
+		if (result <= 0)
+			goto error;
+		if (dest)
+			dest += result;
+		size -= result;
+	}
+	return 0;
+
+error:
+	CloseSocket(line);
+	return -1;
+}
+
+
+/**
+	Receives the header of the next frame.
+	@return length of the frame's message, -1 on error
+*/
+static int ReceiveFrameHeader(LineStruct * line, unsigned char *header)
+{
+	int             length;
+
+	if (ReceiveAll(line, header, 4) == -1)
+		return -1;
+	length = header[2] | (header[3] << 8);
+	if (length > LINE_MSIZE) {
+		CloseSocket(line);
+		return -1;
+	}
+	return length;
+}
+
+
+/** Receives the rest of a notification frame into the queue, dropping the oldest on overflow. */
+static int QueueNotification(LineStruct * line, const unsigned char *header, int length)
+{
+	TcpNotification *slot;
+	int             keep = (length < T32_PCKLEN_MAX - 4) ? length : T32_PCKLEN_MAX - 4;
+
+	if (line->NotificationCount == TCP_NOTIFY_SLOTS) {
+		line->NotificationFirst = (line->NotificationFirst + 1) % TCP_NOTIFY_SLOTS;
+		line->NotificationCount--;
+		line->Stats.NotificationsDropped++;
+	}
+	slot = &line->Notification[(line->NotificationFirst + line->NotificationCount) % TCP_NOTIFY_SLOTS];
+	memcpy(slot->payload, header, 4);
+	slot->length = 4 + keep;
+	if ((ReceiveAll(line, slot->payload + 4, keep) == -1) || (ReceiveAll(line, NULL, length - keep) == -1))
+		return -1;
+	line->NotificationCount++;
+	return 0;
+}
+
+
+/**
+	Receives the next reply message, queueing notifications in front of it.
+	@return length of the message, -1 on error
+*/
+static int ReceiveReplyHeader(LineStruct * line, unsigned char *header)
+{
+	int             length;
+
+	if (!line || !line->LineUp)
+		return -1;
+	for (;;) {
+		if ((length = ReceiveFrameHeader(line, header)) == -1)
+			return -1;
+		if (header[0] == T32_API_RECEIVE)
+			return length;
+		if (header[0] != T32_API_NOTIFICATION) {
+			CloseSocket(line);
+			return -1;
+		}
+		if (QueueNotification(line, header, length) == -1)
+			return -1;
+	}
+}
+
+
+/**************************************************************************
+
+ driver functions, see struct T32InternalLineDriver
+
+***************************************************************************/
+
+static int LINE_LineConfigEx(LineStruct * line, char *input)
+{
+	int             x;
+
+	if (!strncmp((char *) input, "NODE=", 5)) {
+		strcpy(line->NodeName, input + 5);
+		return 1;
+	}
+	if (!strncmp((char *) input, "PORT=", 5)) {
+		x = str2dec(input + 5);
+		if (x == -1)
+			return -1;
+		line->TransmitPort = (unsigned short) x;
+		return 1;
+	}
+	if (!strncmp((char *) input, "TIMEOUT=", 8)) {
+		x = str2dec(input + 8);
+		if (x == -1)
+			return -1;
+		line->PollTimeSec = x;
+		return 1;
+	}
+	if (!strncmp((char *) input, "BUSYPOLL=", 9)) {
+		x = str2dec(input + 9);
+		if (x == -1)
+			return -1;
+		line->BusyPollUs = x;
+		return 1;
+	}
+	/* UDP settings, without effect on a stream */
+	if (!strncmp((char *) input, "PACKLEN=", 8) || !strncmp((char *) input, "HOSTPORT=", 9)
+	    || !strncmp((char *) input, "RTOMIN=", 7) || !strncmp((char *) input, "RTOMAX=", 7))
+		return 1;
+	return -1;
+}
+
+
+static int LINE_LineConfig(char *input)
+{
+	if (pLineParams == NULL) {
+		pLineParams = &LineParams;
+		SetToDefaultLineParams(pLineParams);
+	}
+	return LINE_LineConfigEx(pLineParams, input);
+}
+
+
+/** Connects the stream socket to the relay at NodeName:TransmitPort. */
+static int ConnectTcp(LineStruct * line, char *message)
+{
+	struct addrinfo hints, *result, *ai;
+	char            port[8];
+	int             val;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	sprintf(port, "%u", line->TransmitPort);
+	if (getaddrinfo(line->NodeName, port, &hints, &result) != 0) {
+		strcpy(message, "node name not found");
+		return -1;
+	}
+
+	strcpy(message, "TRACE32 not responding");
+	for (ai = result; ai; ai = ai->ai_next) {
+		line->CommSocket = (int) socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (line->CommSocket == -1) {
+			strcpy(message, "cannot create socket");
+			continue;
+		}
+		/* requests are small and latency bound, replies large: no Nagle, big buffers */
+		val = 1;
+		setsockopt(line->CommSocket, IPPROTO_TCP, TCP_NODELAY, (char *) &val, sizeof(val));
+		val = TCP_BUFSIZE;
+		setsockopt(line->CommSocket, SOL_SOCKET, SO_RCVBUF, (char *) &val, sizeof(val));
+		setsockopt(line->CommSocket, SOL_SOCKET, SO_SNDBUF, (char *) &val, sizeof(val));
+#ifdef SO_BUSY_POLL
+		line->Stats.BusyPollUs = 0;   /* refused without CAP_NET_ADMIN, see T32_LineStats */
+		if (line->BusyPollUs > 0
+		    && setsockopt(line->CommSocket, SOL_SOCKET, SO_BUSY_POLL, (char *) &line->BusyPollUs, sizeof(line->BusyPollUs)) == 0)
+			line->Stats.BusyPollUs = (uint32_t) line->BusyPollUs;
+#endif
+		if (connect(line->CommSocket, ai->ai_addr, (socklen_t) ai->ai_addrlen) == 0)
+			break;
+		CloseSocket(line);
+	}
+	freeaddrinfo(result);
+	return (line->CommSocket == -1) ? -1 : 0;
+}
+
+
+/** Connects the stream socket to the Unix domain socket of t32mux, see RCL=MUX. */
+static int ConnectLocal(LineStruct * line, char *message)
+{
+#ifdef T32HOST_UNIX
+	struct sockaddr_un addr;
+	int             val;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, (line->NodeName[0] == '/') ? line->NodeName : T32MUX_DEFAULT_SOCKET, sizeof(addr.sun_path) - 1);
+	line->CommSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (line->CommSocket == -1) {
+		strcpy(message, "cannot create socket");
+		return -1;
+	}
+	val = TCP_BUFSIZE;
+	setsockopt(line->CommSocket, SOL_SOCKET, SO_RCVBUF, (char *) &val, sizeof(val));
+	setsockopt(line->CommSocket, SOL_SOCKET, SO_SNDBUF, (char *) &val, sizeof(val));
+	if (connect(line->CommSocket, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+		strcpy(message, "t32mux not running");
+		CloseSocket(line);
+		return -1;
+	}
+	return 0;
+#else
+	(void) line;
+	strcpy(message, "RCL=MUX needs Unix domain sockets");
+	return -1;
+#endif
+}
+
+
+/**
+	Connects to the relay, over TCP or to t32mux on the local host.
+	@return 0 : OK, using previously established connection
+		1 : OK, new connection established
+		-1 : ERROR, message set
+*/
+static int LineInit(LineStruct * line, char *message, int local)
+{
+	if (line->LineUp)   /* OK, connection already exists */
+		return 0;
+
+#ifdef T32HOST_WIN
+	{
+		WSADATA         wsaData;
+		if (WSAStartup(0x0202, &wsaData)) {
+			strcpy(message, "TCP/IP not ready, check configuration");
+			return -1;
+		}
+	}
+#endif
+	if ((local ? ConnectLocal(line, message) : ConnectTcp(line, message)) == -1)
+		return -1;
+
+	line->LineUp = 1;
+	line->ReceiveToggleBit = -1;
+	line->MaxPacketSize = T32_MAXPACKETSIZE_DEFAULT;
+	return 1;
+}
+
+
+static int LINE_LineInitEx(LineStruct * line, char *message)
+{
+	return LineInit(line, message, 0);
+}
+
+
+static int LINE_MuxLineInitEx(LineStruct * line, char *message)
+{
+	return LineInit(line, message, 1);
+}
+
+
+static int LINE_LineInit(char *message)
+{
+	if (pLineParams == NULL) {
+		pLineParams = &LineParams;
+		SetToDefaultLineParams(pLineParams);
+	}
+	return LINE_LineInitEx(pLineParams, message);
+}
+
+
+static int LINE_MuxLineInit(char *message)
+{
+	if (pLineParams == NULL) {
+		pLineParams = &LineParams;
+		SetToDefaultLineParams(pLineParams);
+	}
+	return LINE_MuxLineInitEx(pLineParams, message);
+}
+
+
+static void LINE_LineExitEx(LineStruct * line)
+{
+	if (!line)
+		return;
+	line->NotificationFirst = line->NotificationCount = 0;
+	CloseSocket(line);
+}
+
+
+static void LINE_LineExit(void)
+{
+	LINE_LineExitEx(pLineParams);
+}
+
+
+static int LINE_LineDriverGetSocketEx(LineStruct * line)
+{
+	return line ? line->CommSocket : 0;
+}
+
+
+static int LINE_LineDriverGetSocket(void)
+{
+	return LINE_LineDriverGetSocketEx(pLineParams);
+}
+
+
+/**
+	Sends a message as one frame, see LINE_LineTransmit() of hlinknet.c.
+	The frame header is written into the 4 bytes in front of the message.
+	Empty messages (UDP retry requests) are not needed on a stream.
+*/
+static int LINE_LineTransmitEx(LineStruct * line, unsigned char *in, int size)
+{
+	if (!line || !line->LineUp)
+		return 0;
+	if (size == 0)
+		return 0;
+
+	in -= 4;
+	in[0] = TCP_FRAME_TRANSMIT;
+	in[1] = 0;
+	in[2] = (unsigned char) (size & 0xff);
+	in[3] = (unsigned char) (size >> 8);
+	if (SendAll(line, in, size + 4) == -1)
+		return 0;
+	return size;
+}
+
+
+static int LINE_LineTransmit(unsigned char *in, int size)
+{
+	return LINE_LineTransmitEx(pLineParams, in, size);
+}
+
+
+/** Sends a message head followed by an uncopied payload and padding zero bytes as one frame. */
+static int LINE_LineTransmitVEx(LineStruct * line, unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding)
+{
+	static const unsigned char zeros[4] = { 0, 0, 0, 0 };
+	int             total = size + payloadSize + padding;
+#ifdef T32HOST_UNIX
+	unsigned char   header[4];
+	struct iovec    iov[4];
+	struct msghdr   msg;
+	int             result, niov, i;
+#endif
+
+	if (!line || !line->LineUp)
+		return 0;
+#ifdef T32HOST_UNIX
+	header[0] = TCP_FRAME_TRANSMIT;
+	header[1] = 0;
+	header[2] = (unsigned char) (total & 0xff);
+	header[3] = (unsigned char) (total >> 8);
+	iov[0].iov_base = header;
+	iov[0].iov_len = 4;
+	iov[1].iov_base = in;
+	iov[1].iov_len = size;
+	iov[2].iov_base = (void *) payload;
+	iov[2].iov_len = payloadSize;
+	iov[3].iov_base = (void *) zeros;
+	iov[3].iov_len = padding;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = niov = 4;
+	while (niov > 0) {
+		result = sendmsg(line->CommSocket, &msg, 0);
+		if (result <= 0) {
+			CloseSocket(line);
+			return 0;
+		}
+		/* skip what was sent, continue with the rest */
+		for (i = 4 - niov; (i < 4) && (result >= (int) iov[i].iov_len); i++) {
+			result -= (int) iov[i].iov_len;
+			niov--;
+		}
+		if (niov > 0) {
+			iov[4 - niov].iov_base = (char *) iov[4 - niov].iov_base + result;
+			iov[4 - niov].iov_len -= result;
+			msg.msg_iov = iov + 4 - niov;
+			msg.msg_iovlen = niov;
+		}
+	}
+	return total;
+#else
+	/* no gather I/O: the head buffer has room for LINE_MSIZE bytes */
+	if (payloadSize > 0)
+		memcpy(in + size, payload, payloadSize);
+	memcpy(in + size + payloadSize, zeros, padding);
+	return LINE_LineTransmitEx(line, in, total);
+#endif
+}
+
+
+static int LINE_LineTransmitV(unsigned char *in, int size, const unsigned char *payload, int payloadSize, int padding)
+{
+	return LINE_LineTransmitVEx(pLineParams, in, size, payload, payloadSize, padding);
+}
+
+
+/** Receives the next reply message into out, see LINE_LineReceive() of hlinknet.c. */
+static int LINE_LineReceiveEx(LineStruct * line, unsigned char *out)
+{
+	unsigned char   header[4];
+	int             length;
+
+	if ((length = ReceiveReplyHeader(line, header)) == -1)
+		return -1;
+	if (ReceiveAll(line, out, length) == -1)
+		return -1;
+	return length;
+}
+
+
+static int LINE_LineReceive(unsigned char *out)
+{
+	return LINE_LineReceiveEx(pLineParams, out);
+}
+
+
+/** Receives a reply with its head at out and the following bytes straight into the segments. */
+static int LINE_LineReceiveVEx(LineStruct * line, unsigned char *out, int headSize, const LineSegment * seg, int nseg)
+{
+	unsigned char   header[4];
+	int             length, chunk, offset, i;
+
+	if ((length = ReceiveReplyHeader(line, header)) == -1)
+		return -1;
+	chunk = (length < headSize) ? length : headSize;
+	if (ReceiveAll(line, out, chunk) == -1)
+		return -1;
+	offset = chunk;
+	for (i = 0; (i < nseg) && (offset < length); i++) {
+		chunk = (seg[i].size < length - offset) ? seg[i].size : length - offset;
+		if (ReceiveAll(line, seg[i].data, chunk) == -1)
+			return -1;
+		offset += chunk;
+	}
+	/* bytes exceeding the segments continue at their message offset in out */
+	if ((offset < length) && (ReceiveAll(line, out + offset, length - offset) == -1))
+		return -1;
+	return length;
+}
+
+
+static int LINE_LineReceiveV(unsigned char *out, int headSize, const LineSegment * seg, int nseg)
+{
+	return LINE_LineReceiveVEx(pLineParams, out, headSize, seg, nseg);
+}
+
+
+/**
+	Returns a queued notification or reads one which is pending on the stream.
+	@return -1 no notification pending, >=0 notification type
+*/
+static int LINE_ReceiveNotifyMessageEx(LineStruct * line, unsigned char *package)
+{
+	unsigned char   header[4];
+	int             length;
+
+	if (!line || !line->LineUp)
+		return -1;
+	if (!line->NotificationCount && (WaitReadable(line, 0) > 0)) {
+		if ((length = ReceiveFrameHeader(line, header)) == -1)
+			return -1;
+		if (header[0] != T32_API_NOTIFICATION) {
+			ReceiveAll(line, NULL, length);     /* stale reply, no request is waiting for it */
+			return -1;
+		}
+		if (QueueNotification(line, header, length) == -1)
+			return -1;
+	}
+	if (!line->NotificationCount)
+		return -1;
+
+	memcpy(package, line->Notification[line->NotificationFirst].payload, line->Notification[line->NotificationFirst].length);
+	line->NotificationFirst = (line->NotificationFirst + 1) % TCP_NOTIFY_SLOTS;
+	line->NotificationCount--;
+	return package[1];  /* type of notification: T32_E_BREAK, T32_E_EDIT, T32_E_BREAKPOINTCONFIG  */
+}
+
+
+static int LINE_ReceiveNotifyMessage(unsigned char *package)
+{
+	return LINE_ReceiveNotifyMessageEx(pLineParams, package);
+}
+
+
+/** A stream stays in sync, only checks that the connection is up. */
+static int LINE_LineSyncEx(LineStruct * line)
+{
+	return (line && line->LineUp) ? 1 : -1;
+}
+
+
+static int LINE_LineSync(void)
+{
+	return LINE_LineSyncEx(pLineParams);
+}
+
+
+static int LINE_GetLineParamsSize(void)
+{
+	return sizeof(LineStruct);
+}
+
+
+static void LINE_DefaultLineParams(LineStruct * ParametersOut)
+{
+	SetToDefaultLineParams(ParametersOut);
+}
+
+
+static void LINE_SetLine(LineStruct * params)
+{
+	pLineParams = params;
+}
+
+
+static void LINE_SetReceiveToggleBitEx(LineStruct * line, int value)
+{
+	if (line)
+		line->ReceiveToggleBit = value;
+}
+
+
+static int LINE_GetReceiveToggleBitEx(LineStruct * line)
+{
+	return line ? line->ReceiveToggleBit : 0;
+}
+
+
+static unsigned char LINE_GetNextMessageIdEx(LineStruct * line)
+{
+	return line ? ++line->MessageId : 0;
+}
+
+
+static unsigned char LINE_GetMessageIdEx(LineStruct * line)
+{
+	return line ? line->MessageId : 0;
+}
+
+
+static void LINE_SetReceiveToggleBit(int value)
+{
+	LINE_SetReceiveToggleBitEx(pLineParams, value);
+}
+
+
+static int LINE_GetReceiveToggleBit(void)
+{
+	return LINE_GetReceiveToggleBitEx(pLineParams);
+}
+
+
+static unsigned char LINE_GetNextMessageId(void)
+{
+	return LINE_GetNextMessageIdEx(pLineParams);
+}
+
+
+static unsigned char LINE_GetMessageId(void)
+{
+	return LINE_GetMessageIdEx(pLineParams);
+}
+
+
+static int LINE_NotificationPendingEx(LineStruct * line)
+{
+	return (line && line->NotificationCount) ? 1 : 0;
+}
+
+
+static int LINE_NotificationPending(void)
+{
+	return LINE_NotificationPendingEx(pLineParams);
+}
+
+
+/** Retransmissions are done by the kernel, only the notification counter applies. */
+static void LINE_GetStatsEx(LineStruct * line, T32_LineStats * stats)
+{
+	memset(stats, 0, sizeof(T32_LineStats));
+	if (line)
+		*stats = line->Stats;
+}
+
+
+static void LINE_GetStats(T32_LineStats * stats)
+{
+	LINE_GetStatsEx(pLineParams, stats);
+}
+
+
+static int LINE_ReceivePendingEx(LineStruct * line)
+{
+	if (!line || !line->LineUp)
+		return 0;
+	return WaitReadable(line, 0) > 0;
+}
+
+
+static int LINE_ReceivePending(void)
+{
+	return LINE_ReceivePendingEx(pLineParams);
+}
+
+
+static int LINE_GetMaxPacketSizeEx(LineStruct * line)
+{
+	return line ? line->MaxPacketSize : T32_MAXPACKETSIZE_DEFAULT;
+}
+
+
+static void LINE_SetMaxPacketSizeEx(LineStruct * line, int size)
+{
+	if (line)
+		line->MaxPacketSize = size;
+}
+
+
+static int LINE_GetMaxPacketSize(void)
+{
+	return LINE_GetMaxPacketSizeEx(pLineParams);
+}
+
+
+static void LINE_SetMaxPacketSize(int size)
+{
+	LINE_SetMaxPacketSizeEx(pLineParams, size);
+}
+
+
+struct T32InternalLineDriver gLineDrvNetTcp = {
+	LINE_LineConfig,                // Config
+	LINE_LineInit,                  // Init
+	LINE_LineExit,                  // Exit
+	LINE_LineDriverGetSocket,       // GetSocket
+	LINE_LineTransmit,              // Transmit
+	LINE_LineReceive,               // Receive
+	LINE_ReceiveNotifyMessage,      // ReceiveNotifyMessage
+	LINE_LineSync,                  // Sync
+	LINE_GetLineParamsSize,         // GetParamsSize
+	LINE_DefaultLineParams,         // DefaultParams
+	LINE_SetLine,                   // SetParams
+	LINE_SetReceiveToggleBit,       // SetReceiveToggleBit
+	LINE_GetReceiveToggleBit,       // GetReceiveToggleBit
+	LINE_GetNextMessageId,          // GetNextMessageId
+	LINE_GetMessageId,              // GetMessageId
+	LINE_NotificationPending,       // NotificationPending
+	LINE_LineConfigEx,              // ConfigEx
+	LINE_LineInitEx,                // InitEx
+	LINE_LineExitEx,                // ExitEx
+	LINE_LineDriverGetSocketEx,     // GetSocketEx
+	LINE_LineTransmitEx,            // TransmitEx
+	LINE_LineReceiveEx,             // ReceiveEx
+	LINE_ReceiveNotifyMessageEx,    // ReceiveNotifyMessageEx
+	LINE_LineSyncEx,                // SyncEx
+	LINE_SetReceiveToggleBitEx,     // SetReceiveToggleBitEx
+	LINE_GetReceiveToggleBitEx,     // GetReceiveToggleBitEx
+	LINE_GetNextMessageIdEx,        // GetNextMessageIdEx
+	LINE_GetMessageIdEx,            // GetMessageIdEx
+	LINE_NotificationPendingEx,     // NotificationPendingEx
+	LINE_LineTransmitV,             // TransmitV
+	LINE_LineTransmitVEx,           // TransmitVEx
+	LINE_LineReceiveV,              // ReceiveV
+	LINE_LineReceiveVEx,            // ReceiveVEx
+	LINE_GetStats,                  // GetStats
+	LINE_GetStatsEx,                // GetStatsEx
+	LINE_ReceivePending,            // ReceivePending
+	LINE_ReceivePendingEx,          // ReceivePendingEx
+	LINE_GetMaxPacketSize,          // GetMaxPacketSize
+	LINE_SetMaxPacketSize,          // SetMaxPacketSize
+	LINE_GetMaxPacketSizeEx,        // GetMaxPacketSizeEx
+	LINE_SetMaxPacketSizeEx,        // SetMaxPacketSizeEx
+	T32_ASYNC_MAX_WINDOW            // MaxPending, the stream loses nothing
+};
+
+
+/* RCL=MUX: the stream to t32mux on the local host */
+struct T32InternalLineDriver gLineDrvMux = {
+	LINE_LineConfig,                // Config
+	LINE_MuxLineInit,               // Init
+	LINE_LineExit,                  // Exit
+	LINE_LineDriverGetSocket,       // GetSocket
+	LINE_LineTransmit,              // Transmit
+	LINE_LineReceive,               // Receive
+	LINE_ReceiveNotifyMessage,      // ReceiveNotifyMessage
+	LINE_LineSync,                  // Sync
+	LINE_GetLineParamsSize,         // GetParamsSize
+	LINE_DefaultLineParams,         // DefaultParams
+	LINE_SetLine,                   // SetParams
+	LINE_SetReceiveToggleBit,       // SetReceiveToggleBit
+	LINE_GetReceiveToggleBit,       // GetReceiveToggleBit
+	LINE_GetNextMessageId,          // GetNextMessageId
+	LINE_GetMessageId,              // GetMessageId
+	LINE_NotificationPending,       // NotificationPending
+	LINE_LineConfigEx,              // ConfigEx
+	LINE_MuxLineInitEx,             // InitEx
+	LINE_LineExitEx,                // ExitEx
+	LINE_LineDriverGetSocketEx,     // GetSocketEx
+	LINE_LineTransmitEx,            // TransmitEx
+	LINE_LineReceiveEx,             // ReceiveEx
+	LINE_ReceiveNotifyMessageEx,    // ReceiveNotifyMessageEx
+	LINE_LineSyncEx,                // SyncEx
+	LINE_SetReceiveToggleBitEx,     // SetReceiveToggleBitEx
+	LINE_GetReceiveToggleBitEx,     // GetReceiveToggleBitEx
+	LINE_GetNextMessageIdEx,        // GetNextMessageIdEx
+	LINE_GetMessageIdEx,            // GetMessageIdEx
+	LINE_NotificationPendingEx,     // NotificationPendingEx
+	LINE_LineTransmitV,             // TransmitV
+	LINE_LineTransmitVEx,           // TransmitVEx
+	LINE_LineReceiveV,              // ReceiveV
+	LINE_LineReceiveVEx,            // ReceiveVEx
+	LINE_GetStats,                  // GetStats
+	LINE_GetStatsEx,                // GetStatsEx
+	LINE_ReceivePending,            // ReceivePending
+	LINE_ReceivePendingEx,          // ReceivePendingEx
+	LINE_GetMaxPacketSize,          // GetMaxPacketSize
+	LINE_SetMaxPacketSize,          // SetMaxPacketSize
+	LINE_GetMaxPacketSizeEx,        // GetMaxPacketSizeEx
+	LINE_SetMaxPacketSizeEx,        // SetMaxPacketSizeEx
+	T32_ASYNC_MAX_WINDOW            // MaxPending, t32mux replies in order
+};
@@ -153,6 +153,7 @@ enum {
 # include <windows.h>
 #else
 # include <sys/time.h>
+# include <time.h>
 #endif
 
 #if defined(_MSC_VER)
@@ -161,6 +162,11 @@ enum {
 
 T32_THREADLOCAL int T32_Errno;
 
+/* users of the line parameters of the selected driver, see T32_Config("RCL=") */
+static int      LineDriverInit;         /* T32_Init() ran, until T32_Exit() */
+static int      LineDriverChannels;     /* T32_GetChannelSize() was used, channels are not released */
+static int      LineDriverContexts;     /* contexts not destroyed */
+
 #define MAXRETRY        5
 
 #define EMU_CBMAXDATASIZE 0x3c00
@@ -173,15 +179,33 @@ T32_THREADLOCAL int T32_Errno;
 T32_THREADLOCAL unsigned char LINE_OutBuffer[LINE_MSIZE + 256];
 T32_THREADLOCAL unsigned char LINE_InBuffer[LINE_MSIZE + 256];
 
+/* traffic of the calling thread, see T32_GetTraffic() */
+static T32_THREADLOCAL uint32_t LINE_NumRequests;
+static T32_THREADLOCAL uint32_t LINE_NumBytes;
+static T32_THREADLOCAL uint32_t LINE_NumBytesIn;        /* received part of LINE_NumBytes */
+
+/* messages sent again by the line driver or for a lost reply */
+extern T32_THREADLOCAL unsigned int LINE_RetransmitCounter;
+
 #define T32_OUTBUFFER (LINE_OutBuffer+13+4)
 #define T32_INBUFFER  (LINE_InBuffer+13)
 
 /* prototypes for local helper functions */
 static int LINE_Transmit(int len);
+static int LINE_TransmitV(int len, const uint8_t *pPayload, int nPayload);
 static int LINE_Receive(void);
+static int LINE_ReceiveV(int head, const LineSegment *seg, int nseg);
 static int LINE_Sync(void);
+static void asyncDiscard(void);
+static int asyncComplete(int nMin, int noWait, int *pCompleted);
+
+/* largest data chunk per message of the default connection, raised by T32_NegotiatePacketSize().
+   Part of the line state, so each channel and each new connection has its own. */
+#define MaxPacketSize   (gT32InternalLineDriver->GetMaxPacketSize())
+#define CTX_MAXPACKETSIZE(ctx) ((ctx) ? gT32InternalLineDriver->GetMaxPacketSizeEx((ctx)->line) : MaxPacketSize)
 
-static const int MaxPacketSize = 2048;
+/* trace and FDX block limit, never below the small block mode */
+#define MaxBlockSize    ((MaxPacketSize > LINE_SBLOCK) ? MaxPacketSize : LINE_SBLOCK)
 
 
 static void T32_ApiCallEpilog(void)
@@ -192,6 +216,61 @@ static void T32_ApiCallEpilog(void)
 }
 
 
+/** Explicit connection context, see T32_CtxCreate().
+	A context owns its line parameters, message buffers, error number and
+	notification callbacks. Separate contexts may be used by separate threads
+	concurrently. Functions taking a context operate on the thread local
+	default connection if ctx is NULL.
+ */
+struct T32_Context_s {
+	LineStruct     *line;
+	int             Errno;
+#ifdef ENABLE_NOTIFICATION
+	int             EventMask;
+	int             inNotify;
+	T32_NotificationCallback_t notificationCallback[T32_MAX_EVENTS];
+#endif
+	unsigned char   OutBuffer[LINE_MSIZE + 256];
+	unsigned char   InBuffer[LINE_MSIZE + 256];
+};
+
+#define CTX_OUTBUFFER(ctx) ((ctx) ? (ctx)->OutBuffer+13+4 : T32_OUTBUFFER)
+#define CTX_INBUFFER(ctx)  ((ctx) ? (ctx)->InBuffer+13 : T32_INBUFFER)
+#define CTX_ERRNO(ctx)     (*((ctx) ? &(ctx)->Errno : &T32_Errno))
+
+static int CTX_Transmit(T32_Context *ctx, int len);
+static int CTX_TransmitV(T32_Context *ctx, int len, const uint8_t *pPayload, int nPayload);
+static int CTX_Receive(T32_Context *ctx);
+static int CTX_ReceiveV(T32_Context *ctx, int head, const LineSegment *seg, int nseg);
+static int CTX_Sync(T32_Context *ctx);
+
+static unsigned char CTX_GetNextMessageId(T32_Context *ctx)
+{
+	if (ctx)
+		return gT32InternalLineDriver->GetNextMessageIdEx(ctx->line);
+	return gT32InternalLineDriver->GetNextMessageId();
+}
+
+
+static void CTX_SetMaxPacketSize(T32_Context *ctx, int size)
+{
+	if (ctx)
+		gT32InternalLineDriver->SetMaxPacketSizeEx(ctx->line, size);
+	else
+		gT32InternalLineDriver->SetMaxPacketSize(size);
+}
+
+
+static void T32_CtxApiCallEpilog(T32_Context *ctx)
+{
+#if defined(ENABLE_NOTIFICATION) && defined(ENABLE_AUTONOTIFY)
+	T32_CtxCheckStateNotify(ctx, 0);
+#else
+	(void) ctx;
+#endif
+}
+
+
 /**************************************************************************
 
   T32_GetApiRevision - Get API revision number
@@ -278,7 +357,7 @@ static int T32_CloseApiLogFile(void)
 	return 0;
 }
 
-static void T32_ApiLog(const char *func, int entry, const char *argformat, ...)
+static void T32_ApiLogWrite(const char *func, int entry, const char *argformat, ...)
 {
 	va_list         args;
 	struct timeval  time;
@@ -308,6 +387,255 @@ static void T32_ApiLog(const char *func, int entry, const char *argformat, ...)
 		va_end(args);
 }
 
+#elif defined(ENABLE_APITRACE)
+
+/**************************************************************************
+
+  Binary API trace, a low overhead replacement of the API log
+
+  Enable the code with preprocessor switch ENABLE_APITRACE
+  Enable the tracing by setting the environment variable
+	  T32APITRACEFILE to the trace file path/name
+  Decode the file with tcapi/tools/t32trace.c
+
+  Every thread appends fixed size records (T32_ApiTraceRecord) to its own
+  ring without locks, a background thread drains all rings to the file.
+  A full ring drops the record and counts it, the caller never blocks.
+
+***************************************************************************/
+
+# if !defined(T32HOST_UNIX)
+#  error ENABLE_APITRACE needs POSIX threads
+# endif
+
+# include <pthread.h>
+# include <stdatomic.h>
+# include <time.h>
+
+# define T32APITRACE_SLOTS      4096    /* records per thread, power of 2 */
+# define T32APITRACE_FLUSH_MS   20      /* drain interval of the flush thread */
+# define T32APITRACE_NAMES      1024    /* function names already written, power of 2 */
+
+typedef struct ApiTraceRing {
+	struct ApiTraceRing *next;          /* all rings, never removed */
+	uint32_t        id;
+	_Atomic uint32_t head;              /* written by the owning thread */
+	_Atomic uint32_t tail;              /* written by the flush thread */
+	_Atomic uint32_t dropped;
+	T32_ApiTraceRecord slot[T32APITRACE_SLOTS];
+} ApiTraceRing;
+
+static _Thread_local ApiTraceRing *ApiTraceOwnRing = NULL;  /* per thread even without ENABLE_THREADLOCALAPI */
+static _Atomic(ApiTraceRing *) ApiTraceRings = NULL;
+static _Atomic uint32_t ApiTraceNextId = 0;
+static _Atomic int ApiTraceState = 0;   /* 0 off, 1 tracing, 2 stopping */
+static FILE    *ApiTraceFile = NULL;
+static pthread_t ApiTraceThread;
+static uint64_t ApiTraceNames[T32APITRACE_NAMES];  /* flush thread only */
+
+static ApiTraceRing *T32_ApiTraceRegister(void)
+{
+	ApiTraceRing   *ring;
+
+	ring = (ApiTraceRing *) calloc(1, sizeof(ApiTraceRing));
+	if (!ring)
+		return NULL;
+	ring->id = atomic_fetch_add(&ApiTraceNextId, 1);
+	ring->next = atomic_load(&ApiTraceRings);
+	while (!atomic_compare_exchange_weak(&ApiTraceRings, &ring->next, ring))
+		;
+	ApiTraceOwnRing = ring;
+	return ring;
+}
+
+/* write the name of func once before its first record */
+static void T32_ApiTraceName(uint64_t func)
+{
+	T32_ApiTraceRecord rec;
+	uint32_t        i, n;
+
+	i = (uint32_t) ((func >> 3) * 2654435761u) & (T32APITRACE_NAMES - 1);
+	for (n = 0; n < T32APITRACE_NAMES; n++, i = (i + 1) & (T32APITRACE_NAMES - 1)) {
+		if (ApiTraceNames[i] == func)
+			return;
+		if (ApiTraceNames[i] == 0) {
+			ApiTraceNames[i] = func;
+			break;
+		}
+	}
+	memset(&rec, 0, sizeof(rec));
+	rec.Func = func;
+	rec.Kind = T32APITRACE_NAME;
+	rec.Aux = (uint16_t) strlen((const char *) (uintptr_t) func);
+	fwrite(&rec, sizeof(rec), 1, ApiTraceFile);
+	fwrite((const char *) (uintptr_t) func, rec.Aux, 1, ApiTraceFile);
+}
+
+static void T32_ApiTraceFlush(void)
+{
+	ApiTraceRing   *ring;
+	T32_ApiTraceRecord *rec;
+	T32_ApiTraceRecord drop;
+	struct timespec now;
+	uint32_t        head, tail, dropped;
+
+	for (ring = atomic_load(&ApiTraceRings); ring; ring = ring->next) {
+		tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+		head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		for (; tail != head; tail++) {
+			rec = &ring->slot[tail & (T32APITRACE_SLOTS - 1)];
+			T32_ApiTraceName(rec->Func);
+			fwrite(rec, sizeof(*rec), 1, ApiTraceFile);
+		}
+		atomic_store_explicit(&ring->tail, tail, memory_order_release);
+		dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+		if (dropped) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			memset(&drop, 0, sizeof(drop));
+			drop.Time = (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+			drop.Thread = ring->id;
+			drop.Kind = T32APITRACE_DROPPED;
+			drop.NumArgs = 1;
+			drop.Aux = T32APITRACE_ARG_UINT;
+			drop.Arg[0] = dropped;
+			fwrite(&drop, sizeof(drop), 1, ApiTraceFile);
+		}
+	}
+	fflush(ApiTraceFile);
+}
+
+static void *T32_ApiTraceThread(void *arg)
+{
+	struct timespec delay = { 0, T32APITRACE_FLUSH_MS * 1000000L };
+	int             stopping;
+
+	(void) arg;
+	do {
+		stopping = (atomic_load(&ApiTraceState) == 2);
+		T32_ApiTraceFlush();
+		if (!stopping)
+			nanosleep(&delay, NULL);
+	} while (!stopping);
+	return NULL;
+}
+
+static void T32_ApiTraceStop(void)
+{
+	if (atomic_load(&ApiTraceState) != 1)
+		return;
+	atomic_store(&ApiTraceState, 2);
+	pthread_join(ApiTraceThread, NULL);
+	fclose(ApiTraceFile);
+	ApiTraceFile = NULL;
+}
+
+/* the trace is process wide and runs until exit, later calls are ignored */
+static int T32_OpenApiTraceFile(const char *filename)
+{
+	T32_ApiTraceHeader hdr;
+
+	if (atomic_load(&ApiTraceState) != 0)
+		return 0;
+	ApiTraceFile = fopen(filename, "wb");
+	if (ApiTraceFile == NULL)
+		return 1;
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.Magic, T32APITRACE_MAGIC, sizeof(hdr.Magic));
+	hdr.Version = T32APITRACE_VERSION;
+	hdr.RecordSize = sizeof(T32_ApiTraceRecord);
+	fwrite(&hdr, sizeof(hdr), 1, ApiTraceFile);
+	atomic_store(&ApiTraceState, 1);
+	if (pthread_create(&ApiTraceThread, NULL, T32_ApiTraceThread, NULL)) {
+		atomic_store(&ApiTraceState, 0);
+		fclose(ApiTraceFile);
+		ApiTraceFile = NULL;
+		return 1;
+	}
+	atexit(T32_ApiTraceStop);
+	return 0;
+}
+
+static int T32_CloseApiLogFile(void)
+{
+	return 0;
+}
+
+/* record the arguments of argformat, same conversions as the API log uses */
+static void T32_ApiTraceArgs(T32_ApiTraceRecord *rec, const char *argformat, va_list args)
+{
+	const char     *p, *str;
+	uint64_t        val;
+	unsigned        type, i;
+
+	for (p = argformat; *p && rec->NumArgs < T32APITRACE_MAXARGS; p++) {
+		if (*p != '%')
+			continue;
+		p++;
+		if (*p == '%')
+			continue;
+		while ((*p >= '0' && *p <= '9') || *p == '-' || *p == '.')
+			p++;
+		if (p[0] == 'l' && p[1] == 'l') {
+			p += 2;
+			val = va_arg(args, unsigned long long);
+			type = T32APITRACE_ARG_UINT;
+		} else if (*p == 's') {
+			str = va_arg(args, const char *);
+			val = 0;
+			for (i = 0; str && str[i] && i < sizeof(val); i++)
+				((char *) &val)[i] = str[i];
+			type = T32APITRACE_ARG_STR;
+		} else if (*p == 'x') {
+			val = va_arg(args, unsigned int);
+			type = T32APITRACE_ARG_HEX;
+		} else if (*p == 'u') {
+			val = va_arg(args, unsigned int);
+			type = T32APITRACE_ARG_UINT;
+		} else {
+			val = (uint64_t) (int64_t) va_arg(args, int);
+			type = T32APITRACE_ARG_INT;
+		}
+		rec->Arg[rec->NumArgs] = val;
+		rec->Aux |= (uint16_t) (type << (2 * rec->NumArgs));
+		rec->NumArgs++;
+		if (!*p)
+			break;
+	}
+}
+
+static void T32_ApiLogWrite(const char *func, int entry, const char *argformat, ...)
+{
+	ApiTraceRing   *ring = ApiTraceOwnRing;
+	T32_ApiTraceRecord *rec;
+	struct timespec now;
+	uint32_t        head;
+	va_list         args;
+
+	if (atomic_load_explicit(&ApiTraceState, memory_order_relaxed) != 1)
+		return;
+	if (!ring && !(ring = T32_ApiTraceRegister()))
+		return;
+	head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= T32APITRACE_SLOTS) {
+		atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+		return;
+	}
+	rec = &ring->slot[head & (T32APITRACE_SLOTS - 1)];
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	rec->Time = (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+	rec->Func = (uint64_t) (uintptr_t) func;
+	rec->Thread = ring->id;
+	rec->Kind = (uint8_t) entry;
+	rec->NumArgs = 0;
+	rec->Aux = 0;
+	if (argformat) {
+		va_start(args, argformat);
+		T32_ApiTraceArgs(rec, argformat, args);
+		va_end(args);
+	}
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
 #else    /* defined(ENABLE_APILOG) */
 
 /* static int T32_OpenApiLogFile (const char* filename) {return 0;} */
@@ -316,11 +644,135 @@ static int T32_CloseApiLogFile(void)
 	return 0;
 }
 
-# define T32_ApiLog(...)
+# define T32_ApiLogWrite(...)  ((void) 0)
 
 #endif   /* defined(ENABLE_APILOG) */
 
 
+/**************************************************************************
+
+  API statistics
+
+  Counts calls, messages, retransmissions and payload bytes of every API
+  function and line primitive of the calling thread, and sorts the call
+  durations into a log-linear histogram (8 buckets per power of two, i.e.
+  12.5% resolution from 8 us up to about one minute).
+
+  Every function logging T32APILOG_FENTRY/T32APILOG_FEXIT is counted; the
+  traffic is the difference of the thread's line counters between entry
+  and exit, so nested calls are included in the caller's numbers. A call
+  returning without T32APILOG_FEXIT is simply not counted.
+
+  Counting is off until T32_EnableApiStats(1), a call then costs a test of
+  the switch only, no clock reads.
+
+***************************************************************************/
+
+#define T32_APISTATS_SLOTS  128     /* functions counted per thread, power of 2 */
+
+typedef struct {
+	T32_ApiStats    stats;
+	int             open;           /* between entry and exit */
+	uint64_t        entryUs;
+	uint32_t        entryRequests;
+	uint32_t        entryBytes;
+	uint32_t        entryBytesIn;
+	uint32_t        entryRetransmits;
+} ApiStatsSlot;
+
+static T32_THREADLOCAL ApiStatsSlot ApiStatsSlots[T32_APISTATS_SLOTS];
+static int      ApiStatsEnabled = 0;    /* see T32_EnableApiStats() */
+
+static uint64_t T32_ApiStatsTimeUs(void)
+{
+#ifdef T32HOST_WIN
+	LARGE_INTEGER   freq, count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (uint64_t) (count.QuadPart / freq.QuadPart) * 1000000u +
+		(uint64_t) (count.QuadPart % freq.QuadPart) * 1000000u / (uint64_t) freq.QuadPart;
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000u + (uint64_t) now.tv_nsec / 1000u;
+#endif
+}
+
+static int T32_ApiStatsBucket(uint64_t us)
+{
+	int             msb;
+
+	if (us < 8)
+		return (int) us;
+	for (msb = 3; (us >> (msb + 1)) != 0; msb++)
+		;
+	if ((msb - 2) * 8 >= T32_APISTATS_BUCKETS)
+		return T32_APISTATS_BUCKETS - 1;
+	return (msb - 2) * 8 + (int) ((us >> (msb - 3)) & 7);
+}
+
+static ApiStatsSlot *T32_ApiStatsSlot(const char *func)
+{
+	ApiStatsSlot   *slot;
+	unsigned        i, n;
+
+	i = (unsigned) (((uintptr_t) func >> 3) * 2654435761u) & (T32_APISTATS_SLOTS - 1);
+	for (n = 0; n < T32_APISTATS_SLOTS; n++, i = (i + 1) & (T32_APISTATS_SLOTS - 1)) {
+		slot = &ApiStatsSlots[i];
+		if (slot->stats.Name == func)
+			return slot;
+		if (!slot->stats.Name) {
+			slot->stats.Name = func;
+			return slot;
+		}
+	}
+	return NULL;
+}
+
+static void T32_ApiStatsCall(const char *func, int entry)
+{
+	ApiStatsSlot   *slot;
+	T32_ApiStats   *stats;
+	uint64_t        us;
+	uint32_t        bytesIn;
+
+	if (!ApiStatsEnabled)
+		return;
+	slot = T32_ApiStatsSlot(func);
+	if (!slot)
+		return;
+	if (entry == T32APILOG_FENTRY) {
+		slot->open = 1;
+		slot->entryUs = T32_ApiStatsTimeUs();
+		slot->entryRequests = LINE_NumRequests;
+		slot->entryBytes = LINE_NumBytes;
+		slot->entryBytesIn = LINE_NumBytesIn;
+		slot->entryRetransmits = LINE_RetransmitCounter;
+		return;
+	}
+	if (!slot->open)
+		return;
+	slot->open = 0;
+	stats = &slot->stats;
+	us = T32_ApiStatsTimeUs() - slot->entryUs;
+	bytesIn = LINE_NumBytesIn - slot->entryBytesIn;
+	stats->Calls++;
+	stats->Requests += LINE_NumRequests - slot->entryRequests;
+	stats->Retransmits += LINE_RetransmitCounter - slot->entryRetransmits;
+	stats->BytesOut += (uint32_t) (LINE_NumBytes - slot->entryBytes) - bytesIn;
+	stats->BytesIn += bytesIn;
+	stats->TotalUs += us;
+	if (us > stats->MaxUs)
+		stats->MaxUs = (us > 0xffffffffu) ? 0xffffffffu : (uint32_t) us;
+	stats->Histogram[T32_ApiStatsBucket(us)]++;
+}
+
+#define T32_ApiLog(func, entry, ...) \
+	(T32_ApiStatsCall(func, entry), T32_ApiLogWrite(func, entry, __VA_ARGS__))
+
+
 /**************************************************************************
 
   T32_GetLineSize - Get sizeof line structure for Multi-Line usage
@@ -334,6 +786,7 @@ int T32_GetChannelSize(void)
 {
 	int             size;
 	T32_ApiLog(__func__, T32APILOG_FENTRY, 0);
+	LineDriverChannels = 1;
 	size = gT32InternalLineDriver->GetParamsSize();
 	T32_ApiCallEpilog();
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", size);
@@ -567,6 +1020,61 @@ int T32_Ping(void)
 }
 
 
+/**************************************************************************
+
+  T32_TransferMessage - Passes the message of another client on to TRACE32
+
+  Parameter:  in  pRequest  message as a line driver sends it, starting with
+                            the 5 byte message header
+              in  nRequest  size of the message
+              out pReply    receives the reply as a line driver receives it,
+                            starting with the 1 byte message header
+              in/out pnReply  size of pReply, receives the size of the reply
+
+  Return:     int  0 or Number of Error
+
+  Note:       For relays like tools/t32mux.c. The message ID is replaced by
+              one of this connection and restored in the reply, the retry
+              flags of the reply belong to this connection and are cleared.
+              Notifications are not passed on.
+
+***************************************************************************/
+int T32_TransferMessage(const uint8_t *pRequest, int nRequest, uint8_t *pReply, int *pnReply)
+{
+	int             err = 0, len = 0;
+	unsigned char   messageId;
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, %d, p%x", pRequest, nRequest, pReply);
+
+	if (!pRequest || !pReply || !pnReply || nRequest < 5 + 4 || nRequest > LINE_MSIZE) {
+		err = T32_COM_PARA_FAIL;
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+		return err;
+	}
+	memcpy(T32_OUTBUFFER, pRequest + 5, nRequest - 5);
+	messageId = T32_OUTBUFFER[3];
+	T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
+
+	if (LINE_Transmit(nRequest - 5) == -1)
+		err = T32_Errno = T32_COM_TRANSMIT_FAIL;
+
+	if (!err && ((len = LINE_Receive()) == -1))
+		err = T32_Errno = T32_COM_RECEIVE_FAIL;
+
+	if (!err && (len + 1 > *pnReply))
+		err = T32_COM_PARA_FAIL;
+
+	if (!err) {
+		memcpy(pReply, T32_INBUFFER - 1, len + 1);
+		pReply[0] &= (unsigned char) ~(T32_MSG_LRETRY | T32_MSG_LHANDLE);
+		pReply[4] = messageId;
+		*pnReply = len + 1;
+	}
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
+}
+
+
 /**************************************************************************
 
   T32_Stop - Stop the currently running PRACTICE program
@@ -645,25 +1153,34 @@ int T32_Terminate(int ShellReturnValue)
 
 ***************************************************************************/
 int T32_Attach(int DeviceSpecifier)
+{
+	return T32_CtxAttach(NULL, DeviceSpecifier);
+}
+
+
+/** Context variant of T32_Attach(). */
+int T32_CtxAttach(T32_Context *ctx, int DeviceSpecifier)
 {
 	int             err = 0;
+	unsigned char  *out = CTX_OUTBUFFER(ctx);
+	unsigned char  *in  = CTX_INBUFFER(ctx);
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "%d", DeviceSpecifier);
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, %d", ctx, DeviceSpecifier);
 
-	T32_OUTBUFFER[0] = 2;
-	T32_OUTBUFFER[1] = RAPI_CMD_ATTACH;
-	T32_OUTBUFFER[2] = (unsigned char) DeviceSpecifier;
-	T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
+	out[0] = 2;
+	out[1] = RAPI_CMD_ATTACH;
+	out[2] = (unsigned char) DeviceSpecifier;
+	out[3] = CTX_GetNextMessageId(ctx);
 
-	if (LINE_Transmit(4) == -1)
-		err = T32_Errno = T32_COM_TRANSMIT_FAIL;
+	if (CTX_Transmit(ctx, 4) == -1)
+		err = CTX_ERRNO(ctx) = T32_COM_TRANSMIT_FAIL;
 
-	if (!err && (LINE_Receive() == -1))
-		err = T32_Errno = T32_COM_RECEIVE_FAIL;
+	if (!err && (CTX_Receive(ctx) == -1))
+		err = CTX_ERRNO(ctx) = T32_COM_RECEIVE_FAIL;
 
 	if (!err) {
-		err = T32_Errno = T32_INBUFFER[2];
-		T32_ApiCallEpilog();
+		err = CTX_ERRNO(ctx) = in[2];
+		T32_CtxApiCallEpilog(ctx);
 	}
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
 	return err;
@@ -684,38 +1201,47 @@ int T32_Attach(int DeviceSpecifier)
 
 ***************************************************************************/
 int T32_GetState(int *pSystemState)
+{
+	return T32_CtxGetState(NULL, pSystemState);
+}
+
+
+/** Context variant of T32_GetState(). */
+int T32_CtxGetState(T32_Context *ctx, int *pSystemState)
 {
 	int             err = 0;
+	unsigned char  *out = CTX_OUTBUFFER(ctx);
+	unsigned char  *in  = CTX_INBUFFER(ctx);
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x", pSystemState);
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, p%x", ctx, pSystemState);
 
 	if (!pSystemState)
-		err = T32_Errno = T32_COM_PARA_FAIL;
+		err = CTX_ERRNO(ctx) = T32_COM_PARA_FAIL;
 
 	if (!err) {
-		T32_OUTBUFFER[0] = 2;
-		T32_OUTBUFFER[1] = RAPI_CMD_DEVICE_SPECIFIC;
-		T32_OUTBUFFER[2] = RAPI_DSCMD_GETSTATE; /* T32_GetState: Read Status Information */
-		T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
+		out[0] = 2;
+		out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+		out[2] = RAPI_DSCMD_GETSTATE;   /* T32_GetState: Read Status Information */
+		out[3] = CTX_GetNextMessageId(ctx);
 
-		if (LINE_Transmit(4) == -1)
-			err = T32_Errno = T32_COM_TRANSMIT_FAIL;
+		if (CTX_Transmit(ctx, 4) == -1)
+			err = CTX_ERRNO(ctx) = T32_COM_TRANSMIT_FAIL;
 	}
 
-	if (!err && (LINE_Receive() == -1))
-		err = T32_Errno = T32_COM_RECEIVE_FAIL;
+	if (!err && (CTX_Receive(ctx) == -1))
+		err = CTX_ERRNO(ctx) = T32_COM_RECEIVE_FAIL;
 
 	if (!err) {
-		*pSystemState = T32_INBUFFER[4];
+		*pSystemState = in[4];
 
-		err = T32_Errno = T32_INBUFFER[2];
-		T32_ApiCallEpilog();
+		err = CTX_ERRNO(ctx) = in[2];
+		T32_CtxApiCallEpilog(ctx);
 	} else {
 		if (pSystemState)
 			*pSystemState = 0;      /* default in case of error */
 	}
 
-	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d, p%x=%d", err, pSystemState, *pSystemState);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d, p%x=%d", err, pSystemState, pSystemState ? *pSystemState : 0);
 	return err;
 }
 
@@ -847,44 +1373,51 @@ int T32_ResetCPU(void)
  *  SIZE      size of data
  */
 int T32_WriteMemory(uint32_t Address, int Access, const uint8_t * pBuffer, int Size)
+{
+	return T32_CtxWriteMemory(NULL, Address, Access, pBuffer, Size);
+}
+
+
+/** Context variant of T32_WriteMemory(). */
+int T32_CtxWriteMemory(T32_Context *ctx, uint32_t Address, int Access, const uint8_t * pBuffer, int Size)
 {
 	int             err = 0;
+	unsigned char  *out = CTX_OUTBUFFER(ctx);
+	unsigned char  *in  = CTX_INBUFFER(ctx);
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "0x%x, %d, (uint8_t*) p%x, %d", Address, Access, pBuffer, Size);
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, 0x%x, %d, (uint8_t*) p%x, %d", ctx, Address, Access, pBuffer, Size);
 
-	if (Size > MaxPacketSize) {
-		err = T32_WriteMemoryPipe(Address, Access, pBuffer, Size);
+	if (Size > CTX_MAXPACKETSIZE(ctx)) {
+		err = T32_CtxWriteMemoryPipe(ctx, Address, Access, pBuffer, Size);
 		if (!err)
-			err = T32_WriteMemoryPipe(Address, Access, pBuffer, 0);
+			err = T32_CtxWriteMemoryPipe(ctx, Address, Access, pBuffer, 0);
 		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
 		return err;
 	}
 
 	/* Protocol Header */
-	T32_OUTBUFFER[0] = 10;
-	T32_OUTBUFFER[1] = RAPI_CMD_DEVICE_SPECIFIC;
-	T32_OUTBUFFER[2] = RAPI_DSCMD_MEMORY_WRITE;
-	T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId(); /* Message ID */
+	out[0] = 10;
+	out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+	out[2] = RAPI_DSCMD_MEMORY_WRITE;
+	out[3] = CTX_GetNextMessageId(ctx);   /* Message ID */
 
 	/* Command specific part */
-	SETLONGVAR(T32_OUTBUFFER[4], Address);
-	T32_OUTBUFFER[8] = (unsigned char) Access;
-	T32_OUTBUFFER[9] = 0;
-	T32_OUTBUFFER[10] = (unsigned char) (Size & 0xff);
-	T32_OUTBUFFER[11] = (unsigned char) (Size >> 8);
+	SETLONGVAR(out[4], Address);
+	out[8] = (unsigned char) Access;
+	out[9] = 0;
+	out[10] = (unsigned char) (Size & 0xff);
+	out[11] = (unsigned char) (Size >> 8);
 
-	/* payload */
-	memcpy(T32_OUTBUFFER + 12, pBuffer, Size);
+	/* payload is sent from pBuffer */
+	if (CTX_TransmitV(ctx, 12, pBuffer, Size) == -1)
+		err = CTX_ERRNO(ctx) = T32_COM_TRANSMIT_FAIL;
 
-	if (LINE_Transmit(12 + ((Size + 1) & (~1))) == -1)
-		err = T32_Errno = T32_COM_TRANSMIT_FAIL;
-
-	if (!err && (LINE_Receive() == -1))
-		err = T32_Errno = T32_COM_RECEIVE_FAIL;
+	if (!err && (CTX_Receive(ctx) == -1))
+		err = CTX_ERRNO(ctx) = T32_COM_RECEIVE_FAIL;
 
 	if (!err) {
-		err = T32_Errno = T32_INBUFFER[2];
-		T32_ApiCallEpilog();
+		err = CTX_ERRNO(ctx) = in[2];
+		T32_CtxApiCallEpilog(ctx);
 	}
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
 	return err;
@@ -899,59 +1432,66 @@ int T32_WriteMemory(uint32_t Address, int Access, const uint8_t * pBuffer, int S
  *  SIZE      size of data
  */
 int T32_WriteMemoryPipe(uint32_t Address, int Access, const uint8_t * pBuffer, int Size)
+{
+	return T32_CtxWriteMemoryPipe(NULL, Address, Access, pBuffer, Size);
+}
+
+
+/** Context variant of T32_WriteMemoryPipe(). */
+int T32_CtxWriteMemoryPipe(T32_Context *ctx, uint32_t Address, int Access, const uint8_t * pBuffer, int Size)
 {
 	int             len, err = 0;
+	unsigned char  *out = CTX_OUTBUFFER(ctx);
+	unsigned char  *in  = CTX_INBUFFER(ctx);
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "0x%x, %d, (uint8_t*) p%x, %d", Address, Access, pBuffer, Size);
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, 0x%x, %d, (uint8_t*) p%x, %d", ctx, Address, Access, pBuffer, Size);
 
 	if (Size == 0) {
-		T32_OUTBUFFER[0] = 2;
-		T32_OUTBUFFER[1] = RAPI_CMD_DEVICE_SPECIFIC;
-		T32_OUTBUFFER[2] = RAPI_DSCMD_MEMORY_WRITEPIPE; /* T32_WriteMemoryPipe */
-		T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
+		out[0] = 2;
+		out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+		out[2] = RAPI_DSCMD_MEMORY_WRITEPIPE;   /* T32_WriteMemoryPipe */
+		out[3] = CTX_GetNextMessageId(ctx);
 
-		if (LINE_Transmit(4) == -1)
-			err = T32_Errno = T32_COM_TRANSMIT_FAIL;
+		if (CTX_Transmit(ctx, 4) == -1)
+			err = CTX_ERRNO(ctx) = T32_COM_TRANSMIT_FAIL;
 
-		if (!err && (LINE_Receive() == -1))
-			err = T32_Errno = T32_COM_RECEIVE_FAIL;
+		if (!err && (CTX_Receive(ctx) == -1))
+			err = CTX_ERRNO(ctx) = T32_COM_RECEIVE_FAIL;
 
 		if (!err)
-			err = T32_Errno = T32_INBUFFER[2];
+			err = CTX_ERRNO(ctx) = in[2];
 	}
 	while (!err && (Size > 0)) {
 		len = Size;
-		if (len > MaxPacketSize)
-			len = MaxPacketSize;
+		if (len > CTX_MAXPACKETSIZE(ctx))
+			len = CTX_MAXPACKETSIZE(ctx);
 
-		T32_OUTBUFFER[0] = 10;
-		T32_OUTBUFFER[1] = RAPI_CMD_DEVICE_SPECIFIC;
-		T32_OUTBUFFER[2] = RAPI_DSCMD_MEMORY_WRITEPIPE; /* T32_WriteMemoryPipe */
-		T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
-
-		SETLONGVAR(T32_OUTBUFFER[4], Address);
-		T32_OUTBUFFER[8] = (unsigned char) Access;
-		T32_OUTBUFFER[9] = 0;
-		T32_OUTBUFFER[10] = (unsigned char) (len & 0xff);
-		T32_OUTBUFFER[11] = (unsigned char) (len >> 8);
+		out[0] = 10;
+		out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+		out[2] = RAPI_DSCMD_MEMORY_WRITEPIPE;   /* T32_WriteMemoryPipe */
+		out[3] = CTX_GetNextMessageId(ctx);
 
-		memcpy(T32_OUTBUFFER + 12, pBuffer, len);
+		SETLONGVAR(out[4], Address);
+		out[8] = (unsigned char) Access;
+		out[9] = 0;
+		out[10] = (unsigned char) (len & 0xff);
+		out[11] = (unsigned char) (len >> 8);
 
-		if (LINE_Transmit(12 + ((len + 1) & (~1))) == -1)
-			err = T32_Errno = T32_COM_TRANSMIT_FAIL;
+		if (CTX_TransmitV(ctx, 12, pBuffer, len) == -1)
+			err = CTX_ERRNO(ctx) = T32_COM_TRANSMIT_FAIL;
 
-		if (!err && (LINE_Receive() == -1))
-			err = T32_Errno = T32_COM_RECEIVE_FAIL;
+		if (!err && (CTX_Receive(ctx) == -1))
+			err = CTX_ERRNO(ctx) = T32_COM_RECEIVE_FAIL;
 
 		if (!err)
-			err = T32_Errno = T32_INBUFFER[2];
+			err = CTX_ERRNO(ctx) = in[2];
 
 		Size -= len;
 		Address += len;
 		pBuffer += len;
 	}
 
-	T32_ApiCallEpilog();
+	T32_CtxApiCallEpilog(ctx);
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
 	return err;
 }
@@ -1030,48 +1570,186 @@ int T32_WriteMemoryEx(uint32_t Address, int Segment, int Access, int Attribute,
  */
 int T32_ReadMemory(uint32_t Address, int Access, uint8_t * pBuffer, int Size)
 {
-	int             len, err = 0;
+	return T32_CtxReadMemory(NULL, Address, Access, pBuffer, Size);
+}
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "0x%x, %d, (uint8_t*) p%x, %d", Address, Access, pBuffer, Size);
 
-	while (!err && (Size > 0)) {
-		len = Size;
-		if (len > MaxPacketSize)
-			len = MaxPacketSize;
+/** Context variant of T32_ReadMemory(). */
+int T32_CtxReadMemory(T32_Context *ctx, uint32_t Address, int Access, uint8_t * pBuffer, int Size)
+{
+	return T32_CtxReadMemoryWrapped(ctx, Address, Access, pBuffer, Size, NULL, 0);
+}
 
-		T32_OUTBUFFER[0] = 10;
-		T32_OUTBUFFER[1] = RAPI_CMD_DEVICE_SPECIFIC;
-		T32_OUTBUFFER[2] = RAPI_DSCMD_MEMORY_READ;      /* T32_ReadMemory */
-		T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
 
-		SETLONGVAR(T32_OUTBUFFER[4], Address);
-		T32_OUTBUFFER[8] = (unsigned char) Access;
-		T32_OUTBUFFER[9] = 0;
-		T32_OUTBUFFER[10] = (unsigned char) (len & 0xff);
-		T32_OUTBUFFER[11] = (unsigned char) (len >> 8);
+/** Reads Size0+Size1 bytes of contiguous target memory into two host buffers.
 
-		if (LINE_Transmit(12) == -1)
-			err = T32_Errno = T32_COM_TRANSMIT_FAIL;
+	The first Size0 bytes go to pBuffer0, the rest to pBuffer1, e.g. the two
+	parts of a wrapped host ring buffer. The data is received straight into
+	the buffers where the line driver supports it, without a copy through
+	the message buffer. On error the buffers may hold partial data.
 
-		if (!err && (LINE_Receive() == -1))
-			err = T32_Errno = T32_COM_RECEIVE_FAIL;
+	@param  Address   memory address in target memory
+	@param  Access    memory access specifier
+	@param  pBuffer0  output buffer for the first Size0 bytes
+	@param  pBuffer1  output buffer for the next Size1 bytes, may be NULL if Size1 is 0
+	@return T32_OK or error code
+ */
+int T32_ReadMemoryWrapped(uint32_t Address, int Access, uint8_t * pBuffer0, int Size0, uint8_t * pBuffer1, int Size1)
+{
+	return T32_CtxReadMemoryWrapped(NULL, Address, Access, pBuffer0, Size0, pBuffer1, Size1);
+}
 
-		if (!err) {
-			memcpy(pBuffer, T32_INBUFFER + 4, len);
-			err = T32_Errno = T32_INBUFFER[2];
+
+/** Context variant of T32_ReadMemoryWrapped(). */
+int T32_CtxReadMemoryWrapped(T32_Context *ctx, uint32_t Address, int Access, uint8_t * pBuffer0, int Size0, uint8_t * pBuffer1, int Size1)
+{
+	int             len, nseg, err = 0;
+	LineSegment     seg[2];
+	unsigned char  *out = CTX_OUTBUFFER(ctx);
+	unsigned char  *in  = CTX_INBUFFER(ctx);
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, 0x%x, %d, (uint8_t*) p%x, %d, (uint8_t*) p%x, %d", ctx, Address, Access, pBuffer0, Size0, pBuffer1, Size1);
+
+	if ((Size0 < 0) || (Size1 < 0)) {
+		err = CTX_ERRNO(ctx) = T32_COM_PARA_FAIL;
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+		return err;
+	}
+	if (Size0 == 0) {
+		pBuffer0 = pBuffer1;
+		Size0 = Size1;
+		Size1 = 0;
+	}
+
+	while (!err && (Size0 > 0)) {
+		len = Size0 + Size1;
+		if (len > CTX_MAXPACKETSIZE(ctx))
+			len = CTX_MAXPACKETSIZE(ctx);
+
+		/* reply data starts at in[4] */
+		seg[0].data = pBuffer0;
+		seg[0].size = (len < Size0) ? len : Size0;
+		nseg = 1;
+		if (len > Size0) {
+			seg[1].data = pBuffer1;
+			seg[1].size = len - Size0;
+			nseg = 2;
 		}
 
-		Size -= len;
+		out[0] = 10;
+		out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+		out[2] = RAPI_DSCMD_MEMORY_READ;        /* T32_ReadMemory */
+		out[3] = CTX_GetNextMessageId(ctx);
+
+		SETLONGVAR(out[4], Address);
+		out[8] = (unsigned char) Access;
+		out[9] = 0;
+		out[10] = (unsigned char) (len & 0xff);
+		out[11] = (unsigned char) (len >> 8);
+
+		if (CTX_Transmit(ctx, 12) == -1)
+			err = CTX_ERRNO(ctx) = T32_COM_TRANSMIT_FAIL;
+
+		if (!err && (CTX_ReceiveV(ctx, 4, seg, nseg) == -1))
+			err = CTX_ERRNO(ctx) = T32_COM_RECEIVE_FAIL;
+
+		if (!err)
+			err = CTX_ERRNO(ctx) = in[2];
+
 		Address += len;
-		pBuffer += len;
+		if (len >= Size0) {
+			/* continue in the second buffer */
+			pBuffer1 += len - Size0;
+			Size1 -= len - Size0;
+			pBuffer0 = pBuffer1;
+			Size0 = Size1;
+			Size1 = 0;
+		} else {
+			pBuffer0 += len;
+			Size0 -= len;
+		}
 	}
 
-	T32_ApiCallEpilog();
+	T32_CtxApiCallEpilog(ctx);
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
 	return err;
 }
 
 
+/** Negotiates the largest data chunk per message with PowerView.
+
+	Probes single reads of 16 KB, 8 KB and 4 KB and keeps the largest size
+	whose reply arrives for all following memory, trace and FDX transfers of
+	the connection. Only communication errors step down: a read which fails
+	on the target (e.g. past the end of RAM) was still answered with a
+	message of the full size. The size is kept in the line state: every
+	channel, see T32_SetChannel(), has its own, and a new connection starts
+	with the default of T32_MAXPACKETSIZE_DEFAULT bytes.
+
+	@param Address  target memory, preferably T32_MAXPACKETSIZE_MAX bytes readable
+	@param Access   memory access class of Address
+	@return negotiated size in bytes
+ */
+int T32_NegotiatePacketSize(uint32_t Address, int Access)
+{
+	return T32_CtxNegotiatePacketSize(NULL, Address, Access);
+}
+
+
+/** Context variant of T32_NegotiatePacketSize(), the size applies to the context only. */
+int T32_CtxNegotiatePacketSize(T32_Context *ctx, uint32_t Address, int Access)
+{
+	int             size, err;
+	uint8_t        *probe;
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, 0x%x, %d", ctx, Address, Access);
+
+	CTX_SetMaxPacketSize(ctx, T32_MAXPACKETSIZE_DEFAULT);
+	probe = (uint8_t *) malloc(T32_MAXPACKETSIZE_MAX);
+	for (size = T32_MAXPACKETSIZE_MAX; probe && (size > T32_MAXPACKETSIZE_DEFAULT); size /= 2) {
+		CTX_SetMaxPacketSize(ctx, size);   /* one message per probe */
+		err = T32_CtxReadMemory(ctx, Address, Access, probe, size);
+		if (err >= 0)
+			break;  /* a target error still proves the size */
+		if ((err == T32_COM_RECEIVE_FAIL) || (err == T32_COM_TRANSMIT_FAIL))
+			CTX_Sync(ctx);
+		CTX_SetMaxPacketSize(ctx, T32_MAXPACKETSIZE_DEFAULT);
+	}
+	free(probe);
+	size = CTX_MAXPACKETSIZE(ctx);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", size);
+	return size;
+}
+
+
+/** Context variant of T32_GetMaxPacketSize(). */
+int T32_CtxGetMaxPacketSize(T32_Context *ctx)
+{
+	return CTX_MAXPACKETSIZE(ctx);
+}
+
+
+/** Returns the data chunk size per message of the current channel, see T32_NegotiatePacketSize(). */
+int T32_GetMaxPacketSize(void)
+{
+	return MaxPacketSize;
+}
+
+
+/** Sets the data chunk size per message of the current channel, e.g. to a
+	size negotiated before on another connection to the same PowerView.
+
+	@return T32_OK, T32_COM_PARA_FAIL if out of range
+ */
+int T32_SetMaxPacketSize(int size)
+{
+	if ((size < T32_MAXPACKETSIZE_DEFAULT) || (size > T32_MAXPACKETSIZE_MAX))
+		return T32_COM_PARA_FAIL;
+	gT32InternalLineDriver->SetMaxPacketSize(size);
+	return T32_OK;
+}
+
+
 /* Read Memory, extended version */
 int T32_ReadMemoryEx(uint32_t Address, int Segment, int Access, int Attribute, uint8_t * pBuffer, int Size)
 {
@@ -2367,47 +3045,56 @@ int T32_EvalGetString(char *EvaluationString)
 
 
 int T32_GetSymbol(const char *SymbolName, uint32_t * pAddress, uint32_t * pSize, uint32_t * pAccess)
+{
+	return T32_CtxGetSymbol(NULL, SymbolName, pAddress, pSize, pAccess);
+}
+
+
+/** Context variant of T32_GetSymbol(). */
+int T32_CtxGetSymbol(T32_Context *ctx, const char *SymbolName, uint32_t * pAddress, uint32_t * pSize, uint32_t * pAccess)
 {
 	int err = 0, len;
+	unsigned char  *out = CTX_OUTBUFFER(ctx);
+	unsigned char  *in  = CTX_INBUFFER(ctx);
 
 	if (!SymbolName) {
-		err = T32_Errno = T32_COM_PARA_FAIL;
+		err = CTX_ERRNO(ctx) = T32_COM_PARA_FAIL;
 		return err;
 	}
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "\"%s\", p%x, p%x, p%x", SymbolName, pAddress, pSize, pAccess);
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, \"%s\", p%x, p%x, p%x", ctx, SymbolName, pAddress, pSize, pAccess);
 
 	len = (int) strlen(SymbolName);
 
 	if (len + 3 > 0xff)
-		err = T32_Errno = T32_COM_PARA_FAIL;
+		err = CTX_ERRNO(ctx) = T32_COM_PARA_FAIL;
 
 	if (!err) {
-		T32_OUTBUFFER[0] = (unsigned char) (len + 3);
-		T32_OUTBUFFER[1] = RAPI_CMD_DEVICE_SPECIFIC;
-		T32_OUTBUFFER[2] = RAPI_DSCMD_SYMBOL_GET;       /* T32_GetSymbol: Get Symbol Address, Size & Class */
-		T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
-		strcpy((char *) (T32_OUTBUFFER + 4), SymbolName);
+		out[0] = (unsigned char) (len + 3);
+		out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+		out[2] = RAPI_DSCMD_SYMBOL_GET; /* T32_GetSymbol: Get Symbol Address, Size & Class */
+		out[3] = CTX_GetNextMessageId(ctx);
+		strcpy((char *) (out + 4), SymbolName);
 
-		if (LINE_Transmit((len + 5 + 1) & (~1)) == -1)
-			err = T32_Errno = T32_COM_TRANSMIT_FAIL;
+		if (CTX_Transmit(ctx, (len + 5 + 1) & (~1)) == -1)
+			err = CTX_ERRNO(ctx) = T32_COM_TRANSMIT_FAIL;
 	}
 
-	if (!err && (LINE_Receive() == -1))
-		err = T32_Errno = T32_COM_RECEIVE_FAIL;
+	if (!err && (CTX_Receive(ctx) == -1))
+		err = CTX_ERRNO(ctx) = T32_COM_RECEIVE_FAIL;
 
 	if (!err) {
 		if (pAddress)
-			SETLONGVAR(*pAddress, T32_INBUFFER[4]);
+			SETLONGVAR(*pAddress, in[4]);
 		if (pSize)
-			SETLONGVAR(*pSize, T32_INBUFFER[8]);
+			SETLONGVAR(*pSize, in[8]);
 		if (pAccess)
-			SETLONGVAR(*pAccess, T32_INBUFFER[12]);
+			SETLONGVAR(*pAccess, in[12]);
 
-		err = T32_Errno = T32_INBUFFER[2];
-		T32_ApiCallEpilog();
+		err = CTX_ERRNO(ctx) = in[2];
+		T32_CtxApiCallEpilog(ctx);
 	}
-	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d, p%x=0x%x", err, pAddress, *pAddress);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d, p%x=0x%x", err, pAddress, pAddress ? *pAddress : 0);
 	return err;
 }
 
@@ -2837,8 +3524,8 @@ int T32_ReadTrace(int TraceType, int32_t StartRecord, int NumberOfRecords, uint3
 	}
 
 	while (!err && (NumberOfRecords > 0)) {
-		if (NumberOfRecords * nbytes > LINE_SBLOCK)
-			nrecs = (uint16_t) (LINE_SBLOCK / nbytes);
+		if (NumberOfRecords * nbytes > MaxBlockSize)
+			nrecs = (uint16_t) (MaxBlockSize / nbytes);
 		else
 			nrecs = (uint16_t) NumberOfRecords;
 		drecord = (uint32_t) StartRecord;
@@ -2913,75 +3600,127 @@ int T32_GetLastErrorMessage(char *ErrorMessage, uint32_t * pLastError, uint32_t
 
 ***************************************************************************/
 
-/**** Object lists: kept for local object administration ****/
-
-typedef union {
-	T32_Object *o;
-	T32_BufferObj *b;
-	T32_AddressObj *a;
-	T32_RegisterObj *r;
-	T32_RegisterSetObj *rs;
-	T32_SymbolObj *s;
-	T32_BreakpointObj *bp;
-	T32_MemoryBundleObj *mb;
-} T32_Object_u;
-
-static T32_THREADLOCAL T32_Object_u T32_BufferObjList       = {NULL};
-static T32_THREADLOCAL T32_Object_u T32_AddressObjList      = {NULL};
-static T32_THREADLOCAL T32_Object_u T32_RegisterObjList     = {NULL};
-static T32_THREADLOCAL T32_Object_u T32_RegisterSetObjList  = {NULL};
-static T32_THREADLOCAL T32_Object_u T32_SymbolObjList       = {NULL};
-static T32_THREADLOCAL T32_Object_u T32_BreakpointObjList   = {NULL};
-static T32_THREADLOCAL T32_Object_u T32_MemoryBundleObjList = {NULL};
-
-static void addToObjList(T32_Object_u *list, void *obj)
-{
-	T32_Object  **olist = &list->o;
-	T32_Object  *walker;
-	if (!list || !obj)  /* check parameters */
-		return;
-	if (!*olist) {
-		*olist = (T32_Object*) obj;
-		(*olist)->next = NULL;
-		return;
+/**** Object pools: kept for local object administration ****/
+
+/*
+	Each object is preceded by a slot which links it into the list of live
+	objects of its type, so releasing an object is O(1). Released objects
+	of fixed size are kept on a free list of their type, up to OBJ_POOL_KEEP,
+	and handed out by the next request: once warmed up, request/release
+	cycles (e.g. a bundle read per poll) do not touch the heap.
+*/
+#define OBJ_POOL_KEEP     64        /* released objects kept per type */
+#define OBJ_POOL_STORAGE  0x10000   /* largest buffer storage kept with a released buffer object */
+
+typedef struct ObjPool_s ObjPool;
+typedef union ObjSlot_u ObjSlot;
+
+union ObjSlot_u {
+	struct {
+		ObjSlot        *prev, *next;    /* live list; free list uses next only */
+		ObjPool        *pool;
+	} link;
+	uint64_t        align;              /* keeps the object behind the slot 8 byte aligned */
+};
+
+struct ObjPool_s {
+	size_t          size;               /* object size, 0: variable size, never kept */
+	void            (*dispose)(void *obj);  /* releases memory owned by an object going back to the heap */
+	ObjSlot        *live;
+	ObjSlot        *free;
+	int             nfree;
+};
+
+#define OBJ_SLOT(obj)   ((ObjSlot *) (obj) - 1)
+#define OBJ_BODY(slot)  ((void *) ((slot) + 1))
+
+static void disposeBufferObj(void *obj);
+static void disposeMemoryBundleObj(void *obj);
+
+static T32_THREADLOCAL ObjPool T32_BufferObjPool       = { sizeof(T32_BufferObj), disposeBufferObj, NULL, NULL, 0 };
+static T32_THREADLOCAL ObjPool T32_AddressObjPool      = { sizeof(T32_AddressObj), NULL, NULL, NULL, 0 };
+static T32_THREADLOCAL ObjPool T32_RegisterObjPool     = { sizeof(T32_RegisterObj), NULL, NULL, NULL, 0 };
+static T32_THREADLOCAL ObjPool T32_RegisterSetObjPool  = { 0, NULL, NULL, NULL, 0 };
+static T32_THREADLOCAL ObjPool T32_SymbolObjPool       = { sizeof(T32_SymbolObj), NULL, NULL, NULL, 0 };
+static T32_THREADLOCAL ObjPool T32_BreakpointObjPool   = { sizeof(T32_BreakpointObj), NULL, NULL, NULL, 0 };
+static T32_THREADLOCAL ObjPool T32_MemoryBundleObjPool = { sizeof(T32_MemoryBundleObj), disposeMemoryBundleObj, NULL, NULL, 0 };
+static T32_THREADLOCAL ObjPool T32_MemoryChunkPool     = { sizeof(T32_MemoryChunk), NULL, NULL, NULL, 0 };
+
+/** Returns an object of the pool, a reused one keeps its former contents, a new one is zeroed. */
+static void *objRequest(ObjPool *pool, size_t size)
+{
+	ObjSlot        *slot = pool->free;
+
+	if (slot && (size == pool->size)) {
+		pool->free = slot->link.next;
+		pool->nfree--;
+	} else {
+		slot = (ObjSlot *) calloc(1, sizeof(ObjSlot) + size);
+		if (!slot)
+			return NULL;
+		slot->link.pool = pool;
 	}
-	walker = *olist;
-	while (walker && walker->next)
-		walker = walker->next;
-	walker->next = (T32_Object*) obj;
-	if (walker->next)
-		walker->next->next = NULL;
+	slot->link.prev = NULL;
+	slot->link.next = pool->live;
+	if (pool->live)
+		pool->live->link.prev = slot;
+	pool->live = slot;
+	return OBJ_BODY(slot);
 }
 
-static void rmFromObjList(T32_Object_u *list, void *obj)
+/** Unlinks an object and keeps it for reuse or frees it. */
+static void objRelease(void *obj)
 {
-	T32_Object  **olist = &list->o;
-	T32_Object  *walker;
-	if (!list || !obj)  /* check parameters */
-		return;
-	if (*olist == obj) {
-		*olist = (*olist)->next;
+	ObjSlot        *slot = OBJ_SLOT(obj);
+	ObjPool        *pool = slot->link.pool;
+
+	if (slot->link.prev)
+		slot->link.prev->link.next = slot->link.next;
+	else
+		pool->live = slot->link.next;
+	if (slot->link.next)
+		slot->link.next->link.prev = slot->link.prev;
+
+	if (pool->size && (pool->nfree < OBJ_POOL_KEEP)) {
+		slot->link.next = pool->free;
+		pool->free = slot;
+		pool->nfree++;
 		return;
 	}
-	walker = *olist;
-	while (walker && walker->next)
-	{
-		if (walker->next == obj)
-		{
-			walker->next = ((T32_Object *) obj)->next;
-			return;
-		}
-		walker = walker->next;
+	if (pool->dispose)
+		pool->dispose(obj);
+	free(slot);
+}
+
+/** Frees the objects kept for reuse. */
+static void objPoolDrain(ObjPool *pool)
+{
+	ObjSlot        *slot;
+
+	while ((slot = pool->free) != NULL) {
+		pool->free = slot->link.next;
+		if (pool->dispose)
+			pool->dispose(OBJ_BODY(slot));
+		free(slot);
 	}
+	pool->nfree = 0;
+}
+
+static void disposeBufferObj(void *obj)
+{
+	free(((T32_BufferObj *) obj)->storage);
+}
+
+static void disposeMemoryBundleObj(void *obj)
+{
+	free(((T32_MemoryBundleObj *) obj)->chunks);
 }
 
 static int releaseAddressObj(T32_AddressHandle * pHandle)
 {
 	if (pHandle) {
-		T32_Object_u   *list = &T32_AddressObjList;
-		rmFromObjList(list, (void *) *pHandle);
 		if (*pHandle)
-			free(*pHandle);
+			objRelease(*pHandle);
 		*pHandle = NULL;
 	}
 	return 0;
@@ -2990,11 +3729,12 @@ static int releaseAddressObj(T32_AddressHandle * pHandle)
 static int releaseSymbolObj(T32_SymbolHandle * pHandle)
 {
 	if (pHandle) {
-		T32_Object_u   *list = &T32_SymbolObjList;
-		releaseAddressObj(&(*pHandle)->address);
-		rmFromObjList(list, (void *) (*pHandle));
-		if (*pHandle)
-			free(*pHandle);
+		if (*pHandle) {
+			releaseAddressObj(&(*pHandle)->address);
+			free((*pHandle)->name2);
+			free((*pHandle)->path2);
+			objRelease(*pHandle);
+		}
 		*pHandle = NULL;
 	}
 	return 0;
@@ -3003,11 +3743,10 @@ static int releaseSymbolObj(T32_SymbolHandle * pHandle)
 static int releaseBreakpointObj(T32_BreakpointHandle * pHandle)
 {
 	if (pHandle) {
-		T32_Object_u   *list = &T32_BreakpointObjList;
-		releaseAddressObj(&(*pHandle)->address);
-		rmFromObjList(list, (void *) (*pHandle));
-		if (*pHandle)
-			free(*pHandle);
+		if (*pHandle) {
+			releaseAddressObj(&(*pHandle)->address);
+			objRelease(*pHandle);
+		}
 		*pHandle = NULL;
 	}
 	return 0;
@@ -3016,12 +3755,14 @@ static int releaseBreakpointObj(T32_BreakpointHandle * pHandle)
 static int releaseBufferObj(T32_BufferHandle * pHandle)
 {
 	if (pHandle) {
-		T32_Object_u   *list = &T32_BufferObjList;
-		rmFromObjList(list, (void *) *pHandle);
 		if (*pHandle) {
-			if ((*pHandle)->storage)
+			/* large storage is not worth keeping around */
+			if ((*pHandle)->capacity > OBJ_POOL_STORAGE) {
 				free((*pHandle)->storage);
-			free(*pHandle);
+				(*pHandle)->storage = NULL;
+				(*pHandle)->capacity = 0;
+			}
+			objRelease(*pHandle);
 		}
 		*pHandle = NULL;
 	}
@@ -3031,10 +3772,8 @@ static int releaseBufferObj(T32_BufferHandle * pHandle)
 static int releaseRegisterObj(T32_RegisterHandle * pHandle)
 {
 	if (pHandle) {
-		T32_Object_u   *list = &T32_RegisterObjList;
-		rmFromObjList(list, (void *) *pHandle);
 		if (*pHandle)
-			free(*pHandle);
+			objRelease(*pHandle);
 		*pHandle = NULL;
 	}
 	return 0;
@@ -3044,36 +3783,40 @@ static int releaseRegisterSetObj(T32_RegisterSetHandle * pHandle)
 {
 	int     i;
 	if (pHandle) {
-		T32_Object_u   *list = &T32_RegisterSetObjList;
-		for (i = 0; i < (*pHandle)->nregs; i++)
-			releaseRegisterObj(&((*pHandle)->regs[i]));
-		rmFromObjList(list, (void *) (*pHandle));
-		if (*pHandle)
-			free(*pHandle);
+		if (*pHandle) {
+			for (i = 0; i < (*pHandle)->nregs; i++)
+				releaseRegisterObj(&((*pHandle)->regs[i]));
+			objRelease(*pHandle);
+		}
 		*pHandle = NULL;
 	}
 	return 0;
 }
 
-static int releaseMemoryBundleObj(T32_MemoryBundleHandle * pHandle)
+/** Releases the chunks of a bundle, including those kept by T32_ResetMemoryBundleObj(). */
+static void releaseMemoryChunks(T32_MemoryBundleHandle handle)
 {
 	unsigned i;
+	T32_MemoryChunk *ch;
+
+	for (i = 0; i < handle->size; i++) {
+		ch = handle->chunks[i];
+		if (ch) {
+			releaseAddressObj(&ch->address);
+			releaseBufferObj(&ch->buffer);
+			objRelease(ch);
+			handle->chunks[i] = NULL;
+		}
+	}
+	handle->used = 0;
+}
+
+static int releaseMemoryBundleObj(T32_MemoryBundleHandle * pHandle)
+{
 	if (pHandle) {
-		T32_Object_u *list = &T32_MemoryBundleObjList;
-		rmFromObjList(list, (void *) *pHandle);
 		if (*pHandle) {
-			if ((*pHandle)->chunks) {
-				for (i = 0; i < (*pHandle)->used; i++) {
-					T32_MemoryChunk *ch = (*pHandle)->chunks[i];
-					if (ch) {
-						releaseAddressObj(&ch->address);
-						releaseBufferObj(&ch->buffer);
-						free(ch);
-					}
-				}
-				free((*pHandle)->chunks);
-			}
-			free(*pHandle);
+			releaseMemoryChunks(*pHandle);
+			objRelease(*pHandle);   /* keeps the chunk array when the bundle is reused */
 		}
 		*pHandle = NULL;
 	}
@@ -3087,40 +3830,48 @@ static int releaseAllObjects(void)
 	/* Release memory bundle objects *before* address and buffer objects,
 	 * due to embedded address and buffer objects!
 	 */
-	while (T32_MemoryBundleObjList.mb) {
-		T32_MemoryBundleHandle handle = T32_MemoryBundleObjList.mb;
+	while (T32_MemoryBundleObjPool.live) {
+		T32_MemoryBundleHandle handle = (T32_MemoryBundleHandle) OBJ_BODY(T32_MemoryBundleObjPool.live);
 		releaseMemoryBundleObj(&handle);
 	}
 	/* Release symbol and breakpoint objects *before* address objects,
 	 * due to embedded address objects!
 	 */
-	while (T32_SymbolObjList.s) {
-		T32_SymbolHandle handle = T32_SymbolObjList.s;
+	while (T32_SymbolObjPool.live) {
+		T32_SymbolHandle handle = (T32_SymbolHandle) OBJ_BODY(T32_SymbolObjPool.live);
 		releaseSymbolObj(&handle);
 	}
-	while (T32_BreakpointObjList.bp) {
-		T32_BreakpointHandle handle = T32_BreakpointObjList.bp;
+	while (T32_BreakpointObjPool.live) {
+		T32_BreakpointHandle handle = (T32_BreakpointHandle) OBJ_BODY(T32_BreakpointObjPool.live);
 		releaseBreakpointObj(&handle);
 	}
-	while (T32_BufferObjList.b) {
-		T32_BufferHandle handle = T32_BufferObjList.b;
+	while (T32_BufferObjPool.live) {
+		T32_BufferHandle handle = (T32_BufferHandle) OBJ_BODY(T32_BufferObjPool.live);
 		releaseBufferObj(&handle);
 	}
-	while (T32_AddressObjList.a) {
-		T32_AddressHandle handle = T32_AddressObjList.a;
+	while (T32_AddressObjPool.live) {
+		T32_AddressHandle handle = (T32_AddressHandle) OBJ_BODY(T32_AddressObjPool.live);
 		releaseAddressObj(&handle);
 	}
 	/* Release RegisterSet objects *before* Register objects,
 	 * due to embedded Register objects!
 	 */
-	while (T32_RegisterSetObjList.rs) {
-		T32_RegisterSetHandle handle = T32_RegisterObjList.rs;
+	while (T32_RegisterSetObjPool.live) {
+		T32_RegisterSetHandle handle = (T32_RegisterSetHandle) OBJ_BODY(T32_RegisterSetObjPool.live);
 		releaseRegisterSetObj(&handle);
 	}
-	while (T32_RegisterObjList.r) {
-		T32_RegisterHandle handle = T32_RegisterObjList.r;
+	while (T32_RegisterObjPool.live) {
+		T32_RegisterHandle handle = (T32_RegisterHandle) OBJ_BODY(T32_RegisterObjPool.live);
 		releaseRegisterObj(&handle);
 	}
+	objPoolDrain(&T32_MemoryBundleObjPool);
+	objPoolDrain(&T32_MemoryChunkPool);
+	objPoolDrain(&T32_SymbolObjPool);
+	objPoolDrain(&T32_BreakpointObjPool);
+	objPoolDrain(&T32_BufferObjPool);
+	objPoolDrain(&T32_AddressObjPool);
+	objPoolDrain(&T32_RegisterSetObjPool);
+	objPoolDrain(&T32_RegisterObjPool);
 	return 0;
 }
 
@@ -3144,21 +3895,34 @@ int T32_ReleaseAllObjects(void)
 
 /**** Buffer Object: used to keep memory buffers ****/
 
+/** Sets the size of a buffer, its storage only grows. */
+static int resizeBufferObj(T32_BufferHandle handle, const int size)
+{
+	uint8_t        *storage;
+
+	if ((uint32_t) size > handle->capacity || !handle->storage) {
+		storage = (uint8_t *) realloc(handle->storage, size ? size : 1);
+		if (!storage)
+			return T32_ERR_MALLOC_FAIL;
+		handle->storage = storage;
+		handle->capacity = size;
+	}
+	handle->bufsize = size;
+	return T32_OK;
+}
+
 static int requestBufferObj(T32_BufferHandle * pHandle, const int size)
 {
 	T32_BufferHandle handle;
 
-	handle = (T32_BufferHandle) malloc(sizeof(T32_BufferObj));
+	handle = (T32_BufferHandle) objRequest(&T32_BufferObjPool, sizeof(T32_BufferObj));
+	if (!handle)
+		return T32_ERR_MALLOC_FAIL;
 	handle->used = 0;
-	handle->storage = (uint8_t *) malloc(size);
-	if (!handle->storage) {
+	if (resizeBufferObj(handle, size) != T32_OK) {
+		objRelease(handle);
 		return T32_ERR_MALLOC_FAIL;
 	}
-	handle->bufsize = size;
-	{
-		T32_Object_u   *list = &T32_BufferObjList;
-		addToObjList(list, (void *) handle);
-	}
 	*pHandle = handle;
 
 	return T32_OK;
@@ -3176,7 +3940,7 @@ static int copyDataFromBufferObj(uint8_t * localbuffer, int lbsize, T32_BufferHa
 static int copyDataToBufferObj(T32_BufferHandle handle, int size, const uint8_t * localbuffer)
 {
 	if ((int) handle->bufsize < size)
-		T32_ResizeBufferObj(handle, size);
+		resizeBufferObj(handle, size);
 
 	memcpy(handle->storage, localbuffer, size);
 	handle->used = size;
@@ -3186,7 +3950,7 @@ static int copyDataToBufferObj(T32_BufferHandle handle, int size, const uint8_t
 static int copyDataToBufferMaskObj(T32_BufferHandle handle, int size, const uint8_t * localbuffer, const uint8_t * localmaskbuffer)
 {
 	if ((int) handle->bufsize < size * 3)
-		T32_ResizeBufferObj(handle, size * 3);
+		resizeBufferObj(handle, size * 3);
 
 	memcpy(handle->storage + size, localbuffer, size);
 	memcpy(handle->storage + size + size, localmaskbuffer, size);
@@ -3208,11 +3972,12 @@ int T32_RequestBufferObj(T32_BufferHandle * pHandle, const int size)
 
 int T32_ResizeBufferObj(T32_BufferHandle handle, const int size)
 {
+	int             err;
+
 	T32_ApiLog(__func__, T32APILOG_FENTRY, "h%x, %d", handle, size);
-	handle->storage = (uint8_t *) realloc(handle->storage, size);
-	handle->bufsize = size;
-	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
-	return 0;
+	err = resizeBufferObj(handle, size);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
 }
 
 int T32_ReleaseBufferObj(T32_BufferHandle * pHandle)
@@ -3288,24 +4053,18 @@ static void initAddressObjCommon(T32_AddressHandle handle)
 
 static int requestAddressObj(T32_AddressHandle * pHandle)
 {
-	*pHandle = (T32_AddressHandle) malloc(sizeof(T32_AddressObj));
+	*pHandle = (T32_AddressHandle) objRequest(&T32_AddressObjPool, sizeof(T32_AddressObj));
+	if (!*pHandle)
+		return T32_ERR_MALLOC_FAIL;
 	initAddressObjCommon(*pHandle);
-	{
-		T32_Object_u   *list = &T32_AddressObjList;
-		addToObjList(list, (void *) (*pHandle));
-	}
 	return 0;
 }
 
 static int copyAddressObj(T32_AddressHandle * pToHandle, T32_AddressHandle fromHandle)
 {
-	T32_Object     *preserveNext;
-
-	if (*pToHandle == NULL)
-		requestAddressObj(pToHandle);
-	preserveNext = (*pToHandle)->common.next;
+	if (*pToHandle == NULL && requestAddressObj(pToHandle) != 0)
+		return T32_ERR_MALLOC_FAIL;
 	*(*pToHandle) = *fromHandle;
-	(*pToHandle)->common.next = preserveNext;
 
 	return 0;
 }
@@ -3326,14 +4085,12 @@ int T32_RequestAddressObjA32(T32_AddressHandle * pHandle, const uint32_t address
 {
 	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, 0x%x", pHandle, address);
 
-	*pHandle = (T32_AddressHandle) malloc(sizeof(T32_AddressObj));
-	initAddressObjCommon(*pHandle);
+	if (requestAddressObj(pHandle) != 0) {
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", T32_ERR_MALLOC_FAIL);
+		return T32_ERR_MALLOC_FAIL;
+	}
 	(*pHandle)->common.type = T32_ADDRTYPE_A32;
 	(*pHandle)->a32.address = address;
-	{
-		T32_Object_u   *list = &T32_AddressObjList;
-		addToObjList(list, (void *) (*pHandle));
-	}
 
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d, p%x=h%x", 0, pHandle, *pHandle);
 	return 0;
@@ -3343,14 +4100,12 @@ int T32_RequestAddressObjA64(T32_AddressHandle * pHandle, const uint64_t address
 {
 	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, 0x%x", pHandle, address);
 
-	*pHandle = (T32_AddressHandle) malloc(sizeof(T32_AddressObj));
-	initAddressObjCommon(*pHandle);
+	if (requestAddressObj(pHandle) != 0) {
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", T32_ERR_MALLOC_FAIL);
+		return T32_ERR_MALLOC_FAIL;
+	}
 	(*pHandle)->common.type = T32_ADDRTYPE_A64;
 	(*pHandle)->a64.address = address;
-	{
-		T32_Object_u   *list = &T32_AddressObjList;
-		addToObjList(list, (void *) (*pHandle));
-	}
 
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
 	return 0;
@@ -3545,26 +4300,20 @@ static void initRegisterObjCommon(T32_RegisterHandle handle)
 
 static void requestRegisterObjCommon(T32_RegisterHandle * pHandle, T32_RegisterObjType type)
 {
-	T32_Object_u   *list = &T32_RegisterObjList;
-	*pHandle = (T32_RegisterHandle) malloc(sizeof(T32_RegisterObj));
+	*pHandle = (T32_RegisterHandle) objRequest(&T32_RegisterObjPool, sizeof(T32_RegisterObj));
 	initRegisterObjCommon(*pHandle);
 	(*pHandle)->common.type = type;
-	addToObjList(list, (void *) (*pHandle));
 }
 
 static int requestRegisterObjNameCommon(T32_RegisterHandle * pHandle, const char *regName, T32_RegisterObjType type)
 {
 	int             err = 0;
-	T32_Object_u   *list = &T32_RegisterObjList;
 
 	if (strlen(regName) > T32_MAX_REGNAME)
 		err = T32_COM_PARA_FAIL;
 
 	if (!err) {
-		*pHandle = (T32_RegisterHandle) malloc(sizeof(T32_RegisterObj));
-		initRegisterObjCommon(*pHandle);
-		(*pHandle)->common.type = type;
-		addToObjList(list, (void *) (*pHandle));
+		requestRegisterObjCommon(pHandle, type);
 		strncpy((*pHandle)->common.name, regName, T32_MAX_REGNAME);
 	}
 
@@ -3984,7 +4733,7 @@ int T32_SetRegisterObjCore(T32_RegisterHandle handle, uint16_t core)
 
 int T32_GetRegisterObjCore(T32_RegisterHandle handle, uint16_t *pCore)
 {
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "h%x, %d", handle, core);
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "h%x, p%x", handle, pCore);
 	*pCore = handle->common.core;
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
 	return 0;
@@ -3995,13 +4744,11 @@ int T32_GetRegisterObjCore(T32_RegisterHandle handle, uint16_t *pCore)
 static int requestRegisterSetObj (T32_RegisterSetHandle *pHandle, int numRegisters, T32_RegisterObjType regType)
 {
 	int             i;
-	T32_Object_u   *list = &T32_RegisterSetObjList;
 
-	*pHandle = (T32_RegisterSetHandle) malloc(sizeof(T32_RegisterSetObj) + numRegisters * sizeof(T32_RegisterHandle));
+	*pHandle = (T32_RegisterSetHandle) objRequest(&T32_RegisterSetObjPool, sizeof(T32_RegisterSetObj) + numRegisters * sizeof(T32_RegisterHandle));
 	(*pHandle)->nregs = numRegisters;
 	for (i = 0; i < numRegisters; i++)
 		requestRegisterObjCommon(&((*pHandle)->regs[i]), regType);
-	addToObjList(list, (void *) (*pHandle));
 
 	return 0;
 }
@@ -4140,13 +4887,9 @@ int T32_RequestSymbolObj(T32_SymbolHandle *pSymHandle)
 {
 	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x", pSymHandle);
 
-	*pSymHandle = (T32_SymbolHandle) malloc(sizeof(T32_SymbolObj));
+	*pSymHandle = (T32_SymbolHandle) objRequest(&T32_SymbolObjPool, sizeof(T32_SymbolObj));
 	initSymbolObj(*pSymHandle);
 	requestAddressObj(&((*pSymHandle)->address));
-	{
-		T32_Object_u   *list = &T32_SymbolObjList;
-		addToObjList(list, (void *) (*pSymHandle));
-	}
 
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
 	return 0;
@@ -4385,13 +5128,9 @@ int T32_RequestBreakpointObj(T32_BreakpointHandle * pHandle)
 {
 	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x", pHandle);
 
-	*pHandle = (T32_BreakpointHandle) malloc(sizeof(T32_BreakpointObj));
+	*pHandle = (T32_BreakpointHandle) objRequest(&T32_BreakpointObjPool, sizeof(T32_BreakpointObj));
 	initBreakpointObj(*pHandle);
 	requestAddressObj(&((*pHandle)->address));
-	{
-		T32_Object_u   *list = &T32_BreakpointObjList;
-		addToObjList(list, (void *) (*pHandle));
-	}
 
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
 	return 0;
@@ -4401,13 +5140,9 @@ int T32_RequestBreakpointObjAddr(T32_BreakpointHandle * pBpHandle, const T32_Add
 {
 	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, h%x", pBpHandle, addrHandle);
 
-	*pBpHandle = (T32_BreakpointHandle) malloc(sizeof(T32_BreakpointObj));
+	*pBpHandle = (T32_BreakpointHandle) objRequest(&T32_BreakpointObjPool, sizeof(T32_BreakpointObj));
 	initBreakpointObj(*pBpHandle);
 	requestAddressObj(&((*pBpHandle)->address));
-	{
-		T32_Object_u   *list = &T32_BreakpointObjList;
-		addToObjList(list, (void *) (*pBpHandle));
-	}
 	copyAddressObj((&(*pBpHandle)->address), addrHandle);
 
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d, p%x=h%x", 0, pBpHandle, *pBpHandle);
@@ -4512,26 +5247,53 @@ int T32_GetBreakpointObjEnable(T32_BreakpointHandle handle, uint8_t * pEnable)
 
 /******** Memory Bundle Object ********/
 
+/** Makes room for size chunks, new entries are empty. A reused bundle keeps its chunk array. */
+static int growMemoryBundleObj(T32_MemoryBundleHandle handle, unsigned size)
+{
+	T32_MemoryChunk **chunks;
+
+	if (size <= handle->size && handle->chunks)
+		return 0;
+	if (size < 1)
+		size = 1;
+	chunks = (T32_MemoryChunk **) realloc(handle->chunks, size * sizeof(T32_MemoryChunk *));
+	if (!chunks)
+		return -1;
+	memset(chunks + handle->size, 0, (size - handle->size) * sizeof(T32_MemoryChunk *));
+	handle->chunks = chunks;
+	handle->size = size;
+	return 0;
+}
+
 static int addToBundleObjAddrLengthByteArray(T32_MemoryBundleHandle bundleHandle, const T32_AddressHandle addrHandle, const T32_Length length, uint8_t *localbuffer, uint8_t *localmaskbuffer)
 {
-	T32_BufferHandle bh = NULL;
-	T32_AddressHandle ah = NULL;
+	T32_BufferHandle bh;
 	T32_MemoryChunk *ch;
 
-	if (bundleHandle->used >= bundleHandle->size) {
-		T32_Size newsize = bundleHandle->size ?  bundleHandle->size*2 : 1;
-		bundleHandle->chunks = (T32_MemoryChunk**) realloc(bundleHandle->chunks, newsize*sizeof(T32_MemoryChunk*));
-		bundleHandle->size = newsize;
-	}
+	if (bundleHandle->used >= bundleHandle->size
+	    && growMemoryBundleObj(bundleHandle, bundleHandle->size ? bundleHandle->size * 2 : 1) != 0)
+		return T32_ERR_MALLOC_FAIL;
 
-	requestBufferObj(&bh, length);
-	requestAddressObj(&ah);
-	copyAddressObj(&ah, addrHandle);
+	/* a chunk kept by T32_ResetMemoryBundleObj() is refilled in place */
+	ch = bundleHandle->chunks[bundleHandle->used];
+	if (!ch) {
+		ch = (T32_MemoryChunk*) objRequest(&T32_MemoryChunkPool, sizeof(T32_MemoryChunk));
+		if (!ch)
+			return T32_ERR_MALLOC_FAIL;
+		if (requestBufferObj(&ch->buffer, length) != T32_OK) {
+			objRelease(ch);
+			return T32_ERR_MALLOC_FAIL;
+		}
+		ch->address = NULL;
+		bundleHandle->chunks[bundleHandle->used] = ch;
+	} else if (resizeBufferObj(ch->buffer, length) != T32_OK)
+		return T32_ERR_MALLOC_FAIL;
+	bh = ch->buffer;
+	bh->used = 0;
+	if (copyAddressObj(&ch->address, addrHandle) != 0)
+		return T32_ERR_MALLOC_FAIL;
 
-	ch = (T32_MemoryChunk*) malloc(sizeof(T32_MemoryChunk));
 	ch->synched = T32_BUFFER_NOTSYNCHED;
-	ch->buffer = bh;
-	ch->address = ah;
 	if (localbuffer == NULL)
 		ch->read = 1;
 	else if (localmaskbuffer == NULL)
@@ -4546,7 +5308,7 @@ static int addToBundleObjAddrLengthByteArray(T32_MemoryBundleHandle bundleHandle
 			copyDataToBufferObj(bh, length, localbuffer);
 	}
 
-	bundleHandle->chunks[bundleHandle->used++] = ch;
+	bundleHandle->used++;
 
 	return 0;
 }
@@ -4557,20 +5319,35 @@ int T32_RequestMemoryBundleObj(T32_MemoryBundleHandle *pHandle, const int initia
 
 	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, %d", pHandle, initial_size);
 
-	handle = (T32_MemoryBundleHandle) malloc(sizeof(T32_MemoryBundleObj));
-	handle->chunks = (T32_MemoryChunk**) malloc(sizeof(T32_MemoryChunk*)*initial_size);
-	handle->size = initial_size;
-	handle->used = 0;
-	{
-		T32_Object_u *list = &T32_MemoryBundleObjList;
-		addToObjList(list, (void *) handle);
+	handle = (T32_MemoryBundleHandle) objRequest(&T32_MemoryBundleObjPool, sizeof(T32_MemoryBundleObj));
+	if (!handle || growMemoryBundleObj(handle, initial_size) != 0) {
+		if (handle)
+			objRelease(handle);
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", T32_ERR_MALLOC_FAIL);
+		return T32_ERR_MALLOC_FAIL;
 	}
+	handle->used = 0;
 	*pHandle = handle;
 
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d, h%x", 0, *pHandle);
 	return 0;
 }
 
+/**
+	Empties a bundle for refilling. Its chunks stay allocated and are reused
+	by the next T32_AddToBundleObj* calls, so a bundle read in every cycle
+	needs no allocation once the bundle has reached its size.
+*/
+int T32_ResetMemoryBundleObj(T32_MemoryBundleHandle handle)
+{
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "h%x", handle);
+
+	handle->used = 0;
+
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
+	return 0;
+}
+
 int T32_ReleaseMemoryBundleObj(T32_MemoryBundleHandle *pHandle)
 {
 	int err = 0;
@@ -4673,75 +5450,80 @@ int T32_AddToBundleObjAddrLengthByteArrayMaskArray(T32_MemoryBundleHandle bundle
 
 /******** Access memory ********/
 
-static int streamAddressParams(const T32_AddressHandle addressHandle, int offset, int index)
+static int streamAddressParamsTo(unsigned char *out, int *pErrno, const T32_AddressHandle addressHandle, int offset, int index)
 {
 	uint16_t        tmp_ui16;
 	uint32_t        tmp_ui32;
 	uint64_t        tmp_ui64;
 
-	SETWORDVAR(T32_OUTBUFFER[index], addressHandle->common.type);
+	SETWORDVAR(out[index], addressHandle->common.type);
 	index += 2;
 	switch (addressHandle->common.type) {
 		case T32_ADDRTYPE_A32:
 			tmp_ui32 = addressHandle->a32.address + offset;
-			SETLONGVAR(T32_OUTBUFFER[index], tmp_ui32);
+			SETLONGVAR(out[index], tmp_ui32);
 			index += 4;
 			break;
 		case T32_ADDRTYPE_A64:
 			tmp_ui64 = addressHandle->a64.address + offset;
-			SETQUADVAR(T32_OUTBUFFER[index], tmp_ui64);
+			SETQUADVAR(out[index], tmp_ui64);
 			index += 8;
 			break;
 		default:
-			T32_Errno = T32_COM_PARA_FAIL;
-			return T32_Errno;
+			*pErrno = T32_COM_PARA_FAIL;
+			return *pErrno;
 	}
 	if (*(addressHandle->common.access)) {
 		int             len = (int) strlen(addressHandle->common.access) + 1;	/* +1 for zero termination */
 		if (len & 1)
 			len++;	/* align to 16bit */
 		tmp_ui16 = 0x4341;	/* "AC" */
-		SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
-		SETWORDVAR(T32_OUTBUFFER[index + 2], len);
-		strcpy((char *) T32_OUTBUFFER + index + 4, addressHandle->common.access);
-		T32_OUTBUFFER[index + 4 + len - 1] = 0;
+		SETWORDVAR(out[index], tmp_ui16);
+		SETWORDVAR(out[index + 2], len);
+		strcpy((char *) out + index + 4, addressHandle->common.access);
+		out[index + 4 + len - 1] = 0;
 		index = index + 4 + len;
 	}
 	if (addressHandle->common.width) {
 		tmp_ui16 = 0x4957;      /* "WI" */
-		SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
-		SETWORDVAR(T32_OUTBUFFER[index + 2], addressHandle->common.width);
+		SETWORDVAR(out[index], tmp_ui16);
+		SETWORDVAR(out[index + 2], addressHandle->common.width);
 		index += 4;
 	}
 	if (addressHandle->common.core != (uint16_t) - 1) {
 		tmp_ui16 = 0x4f43;      /* "CO" */
-		SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
-		SETWORDVAR(T32_OUTBUFFER[index + 2], addressHandle->common.core);
+		SETWORDVAR(out[index], tmp_ui16);
+		SETWORDVAR(out[index + 2], addressHandle->common.core);
 		index += 4;
 	}
 	if (addressHandle->common.spaceid != (uint32_t) - 1) {
 		tmp_ui16 = 0x4953;      /* "SI" */
-		SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
-		SETLONGVAR(T32_OUTBUFFER[index + 2], addressHandle->common.spaceid);
+		SETWORDVAR(out[index], tmp_ui16);
+		SETLONGVAR(out[index + 2], addressHandle->common.spaceid);
 		index += 6;
 	}
 	if (addressHandle->common.attr) {
 		tmp_ui16 = 0x4a41;      /* "AT" */
-		SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
-		SETLONGVAR(T32_OUTBUFFER[index + 2], addressHandle->common.attr);
+		SETWORDVAR(out[index], tmp_ui16);
+		SETLONGVAR(out[index + 2], addressHandle->common.attr);
 		index += 6;
 	}
 	if (addressHandle->common.sizeofmau) {
 		tmp_ui16 = 0x554d;      /* "MU" */
-		SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
-		SETWORDVAR(T32_OUTBUFFER[index + 2], addressHandle->common.sizeofmau);
+		SETWORDVAR(out[index], tmp_ui16);
+		SETWORDVAR(out[index + 2], addressHandle->common.sizeofmau);
 		index += 4;
 	}
 	tmp_ui16 = 0x5858;  /* "XX" = end marker */
-	SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
+	SETWORDVAR(out[index], tmp_ui16);
 	return index + 2;
 }
 
+static int streamAddressParams(const T32_AddressHandle addressHandle, int offset, int index)
+{
+	return streamAddressParamsTo(T32_OUTBUFFER, &T32_Errno, addressHandle, offset, index);
+}
+
 static int extractAddressParams(const T32_AddressHandle addressHandle, int index)
 {
 	uint16_t        parId;
@@ -5053,12 +5835,21 @@ int T32_WriteMemoryObj(T32_BufferHandle bufferHandle, const T32_AddressHandle ad
 }
 
 int T32_TransferMemoryBundleObj(T32_MemoryBundleHandle bundles)
+{
+	return T32_CtxTransferMemoryBundleObj(NULL, bundles);
+}
+
+
+/** Context variant of T32_TransferMemoryBundleObj(). */
+int T32_CtxTransferMemoryBundleObj(T32_Context *ctx, T32_MemoryBundleHandle bundles)
 {
 	int err;
+	unsigned char  *out = CTX_OUTBUFFER(ctx);
+	unsigned char  *in  = CTX_INBUFFER(ctx);
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "h%x", bundles);
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, h%x", ctx, bundles);
 
-	err = T32_Errno = 0;
+	err = CTX_ERRNO(ctx) = 0;
 
 	if (!bundles)
 		err = T32_COM_PARA_FAIL;
@@ -5084,39 +5875,39 @@ int T32_TransferMemoryBundleObj(T32_MemoryBundleHandle bundles)
 		unsigned i, index;
 		uint16_t tmp_ui16;
 
-		T32_OUTBUFFER[0] = 0;
-		T32_OUTBUFFER[1] = RAPI_CMD_DEVICE_SPECIFIC;
-		T32_OUTBUFFER[2] = RAPI_DSCMD_BUNDLE_OBJ_TRANSFER;
-		T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
+		out[0] = 0;
+		out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+		out[2] = RAPI_DSCMD_BUNDLE_OBJ_TRANSFER;
+		out[3] = CTX_GetNextMessageId(ctx);
 		tmp_ui16 = (uint16_t)(bundles->used);
-		SETWORDVAR(T32_OUTBUFFER[6], tmp_ui16);
+		SETWORDVAR(out[6], tmp_ui16);
 		index = 8;
 
 		for (i = 0; i < bundles->used && !err; i++) {
 			unsigned bufsize = (bundles->chunks[i]->read == 0 || bundles->chunks[i]->read == 2) ? bundles->chunks[i]->buffer->used : bundles->chunks[i]->buffer->bufsize;
 			tmp_ui16 = (bundles->chunks[i]->read <= 2) ? (uint16_t) bundles->chunks[i]->read : 1;
-			SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
+			SETWORDVAR(out[index], tmp_ui16);
 			index += 2;
 			tmp_ui16 = (uint16_t)bufsize;
-			SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
+			SETWORDVAR(out[index], tmp_ui16);
 			index += 2;
-			index = streamAddressParams(bundles->chunks[i]->address, 0, index);
-			if (T32_Errno)
-				err = T32_Errno;
+			index = streamAddressParamsTo(out, &CTX_ERRNO(ctx), bundles->chunks[i]->address, 0, index);
+			if (CTX_ERRNO(ctx))
+				err = CTX_ERRNO(ctx);
 			if (bundles->chunks[i]->read == 0) {
-				memcpy(T32_OUTBUFFER + index, bundles->chunks[i]->buffer->storage, bufsize);
+				memcpy(out + index, bundles->chunks[i]->buffer->storage, bufsize);
 				index += (bufsize + 1) & (~1);  //16 bit alignment
 			} else if (bundles->chunks[i]->read == 2) {
-				memcpy(T32_OUTBUFFER + index, bundles->chunks[i]->buffer->storage + bufsize, bufsize * 2);
+				memcpy(out + index, bundles->chunks[i]->buffer->storage + bufsize, bufsize * 2);
 				index += (bufsize * 2 + 1) & (~1);  //16 bit alignment
 			}
 		}
 
 		tmp_ui16 = 0x5858;  /* "XX" = end marker */
-		SETWORDVAR(T32_OUTBUFFER[index], tmp_ui16);
+		SETWORDVAR(out[index], tmp_ui16);
 		index += 2;
 		tmp_ui16 = (uint16_t)index;
-		SETWORDVAR(T32_OUTBUFFER[4], tmp_ui16);
+		SETWORDVAR(out[4], tmp_ui16);
 
 		// total data to send exceeds buffer size
 		if (index > EMU_CBMAXDATASIZE) {
@@ -5124,16 +5915,16 @@ int T32_TransferMemoryBundleObj(T32_MemoryBundleHandle bundles)
 		}
 
 		if (!err) {
-			if (LINE_Transmit(index) == -1)
-				err = T32_Errno = T32_COM_TRANSMIT_FAIL;
+			if (CTX_Transmit(ctx, index) == -1)
+				err = CTX_ERRNO(ctx) = T32_COM_TRANSMIT_FAIL;
 		}
 	}
 
-	if (!err && (LINE_Receive() == -1))
-		err = T32_Errno = T32_COM_RECEIVE_FAIL;
+	if (!err && (CTX_Receive(ctx) == -1))
+		err = CTX_ERRNO(ctx) = T32_COM_RECEIVE_FAIL;
 
 	if (!err) {
-		err = T32_INBUFFER[2];
+		err = in[2];
 		if (err == T32_ERR_FN1)
 			err = T32_ERR_TRANSFERMEMOBJ_PARAFAIL;
 		if (err == T32_ERR_FN2)
@@ -5147,7 +5938,7 @@ int T32_TransferMemoryBundleObj(T32_MemoryBundleHandle bundles)
 
 		for (i = 0; i < bundles->used; i++) {
 			uint16_t        ok;
-			SETWORDVAR(ok, T32_INBUFFER[index]);
+			SETWORDVAR(ok, in[index]);
 			index += 2;
 			if (bundles->chunks[i]->read == 0) {
 				bundles->chunks[i]->synched = ok ? T32_BUFFER_WRITTEN : T32_BUFFER_ERROR;
@@ -5155,14 +5946,14 @@ int T32_TransferMemoryBundleObj(T32_MemoryBundleHandle bundles)
 				unsigned        bufsize = bundles->chunks[i]->buffer->used;
 				bundles->chunks[i]->synched = ok ? T32_BUFFER_READ : T32_BUFFER_ERROR;
 				if (ok) {
-					memcpy(bundles->chunks[i]->buffer->storage, T32_INBUFFER + index, bufsize);
+					memcpy(bundles->chunks[i]->buffer->storage, in + index, bufsize);
 					index += bufsize;
 				}
 			} else {
 				unsigned        bufsize = bundles->chunks[i]->buffer->bufsize;
 				bundles->chunks[i]->synched = ok ? T32_BUFFER_READ : T32_BUFFER_ERROR;
 				if (ok) {
-					memcpy(bundles->chunks[i]->buffer->storage, T32_INBUFFER + index, bufsize);
+					memcpy(bundles->chunks[i]->buffer->storage, in + index, bufsize);
 					bundles->chunks[i]->buffer->used = bufsize;
 					index += bufsize;
 				}
@@ -5173,9 +5964,9 @@ int T32_TransferMemoryBundleObj(T32_MemoryBundleHandle bundles)
 		}
 	}
 
-	T32_Errno = err;
+	CTX_ERRNO(ctx) = err;
 
-	T32_ApiCallEpilog();
+	T32_CtxApiCallEpilog(ctx);
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
 	return err;
 }
@@ -6244,8 +7035,8 @@ int T32_Fdx_ReceivePoll(int Channel, void *pData, int Width, int MaxSize)
 		goto returnlabel;
 	}
 	MaxSize *= Width;
-	if (MaxSize > LINE_SBLOCK)
-		MaxSize = LINE_SBLOCK;
+	if (MaxSize > MaxBlockSize)
+		MaxSize = MaxBlockSize;
 
 	T32_OUTBUFFER[0] = 6;
 	T32_OUTBUFFER[1] = RAPI_CMD_DEVICE_SPECIFIC;
@@ -6319,8 +7110,8 @@ int T32_Fdx_Receive(int Channel, void *pData, int Width, int MaxSize)
 		goto returnlabel;
 	}
 	MaxSize *= Width;
-	if (MaxSize > LINE_SBLOCK)
-		MaxSize = LINE_SBLOCK;
+	if (MaxSize > MaxBlockSize)
+		MaxSize = MaxBlockSize;
 
 	do {
 		id = (uint32_t) Channel;
@@ -6389,7 +7180,7 @@ int T32_Fdx_SendPoll(int Channel, void *pData, int Width, int Size)
 		goto returnlabel;
 	}
 	bsize = Size * Width;
-	if (bsize > LINE_SBLOCK || bsize <= 0) {
+	if (bsize > MaxBlockSize || bsize <= 0) {
 		T32_Errno = T32_COM_PARA_FAIL;
 		result = -1;
 		goto returnlabel;
@@ -6410,9 +7201,8 @@ int T32_Fdx_SendPoll(int Channel, void *pData, int Width, int Size)
 	T32_OUTBUFFER[9] = 0;
 	T32_OUTBUFFER[10] = (10 + bsize) & 0xff;
 	T32_OUTBUFFER[11] = ((10 + bsize) >> 8) & 0xff;
-	memcpy(T32_OUTBUFFER + 12, pData, bsize);
 
-	if (LINE_Transmit((bsize + 12 + 1) & (~1)) == -1) {
+	if (LINE_TransmitV(12, (const uint8_t *) pData, bsize) == -1) {
 		T32_Errno = T32_COM_TRANSMIT_FAIL;
 		result = -1;
 		goto returnlabel;
@@ -6451,7 +7241,7 @@ int T32_Fdx_Send(int Channel, void *pData, int Width, int Size)
 		goto returnlabel;
 	}
 	bsize = Size * Width;
-	if (bsize > LINE_SBLOCK || bsize <= 0) {
+	if (bsize > MaxBlockSize || bsize <= 0) {
 		T32_Errno = T32_COM_PARA_FAIL;
 		result = -1;
 		goto returnlabel;
@@ -6473,9 +7263,8 @@ int T32_Fdx_Send(int Channel, void *pData, int Width, int Size)
 		T32_OUTBUFFER[9] = 0;
 		T32_OUTBUFFER[10] = (10 + bsize) & 0xff;
 		T32_OUTBUFFER[11] = ((10 + bsize) >> 8) & 0xff;
-		memcpy(T32_OUTBUFFER + 12, pData, bsize);
 
-		if (LINE_Transmit((bsize + 12 + 1) & (~1)) == -1) {
+		if (LINE_TransmitV(12, (const uint8_t *) pData, bsize) == -1) {
 			T32_Errno = T32_COM_TRANSMIT_FAIL;
 			result = -1;
 			goto returnlabel;
@@ -7757,11 +8546,36 @@ T32EXTERN int T32_DirectAccessExecuteLua(T32_BUNDLEDACCESS_HANDLE Handle, const
 	return res;
 }
 
+/**
+	Configures the line driver. "RCL=" selects the driver itself: "NETASSIST"
+	(UDP, default), "TCPRELAY" (TCP stream to a relay, see hlinktcp.c), "MUX"
+	(stream to t32mux on the local host, see hlinktcp.c) or "REPLAY" (replies
+	of a capture made with "CAPTURE=", see hlinkreplay.c).
+	Select the driver before any other setting. It fails once T32_Init() ran
+	or channels or contexts exist, their line parameters are sized and
+	initialised by the driver.
+*/
 int T32_Config(const char *String1, const char *String2)
 {
 	int             err = 0;
 	char            configline[256];
 	T32_ApiLog(__func__, T32APILOG_FENTRY, "\"%s\", \"%s\"", String1, String2);
+	if (!strcmp(String1, "RCL=")) {
+		if (LineDriverInit || LineDriverChannels || LineDriverContexts)
+			err = -1;
+		else if (!strcmp(String2, "NETASSIST"))
+			gT32InternalLineDriver = &gLineDrvNetAssist;
+		else if (!strcmp(String2, "TCPRELAY"))
+			gT32InternalLineDriver = &gLineDrvNetTcp;
+		else if (!strcmp(String2, "MUX"))
+			gT32InternalLineDriver = &gLineDrvMux;
+		else if (!strcmp(String2, "REPLAY"))
+			gT32InternalLineDriver = &gLineDrvReplay;
+		else
+			err = -1;
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+		return err;
+	}
 	strcpy(configline, String1);
 	strcat(configline, String2);
 	if (gT32InternalLineDriver->Config(configline) == -1)
@@ -7775,7 +8589,9 @@ int T32_Exit(void)
 {
 	T32_ApiLog(__func__, T32APILOG_FENTRY, 0);
 	gT32InternalLineDriver->Exit();
+	LineDriverInit = 0;
 	releaseAllObjects();
+	asyncDiscard();
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
 	T32_CloseApiLogFile();
 	return 0;
@@ -7809,43 +8625,54 @@ static T32_THREADLOCAL T32_NotificationEvent_t *eventlist = NULL;
 static T32_THREADLOCAL int T32_EventMask = 0;
 static T32_THREADLOCAL T32_NotificationCallback_t notificationCallback[T32_MAX_EVENTS];
 int T32_NotifyStateEnable(int EventNumber, T32_NotificationCallback_t pFunction)
+{
+	return T32_CtxNotifyStateEnable(NULL, EventNumber, pFunction);
+}
+
+
+/** Context variant of T32_NotifyStateEnable(). */
+int T32_CtxNotifyStateEnable(T32_Context *ctx, int EventNumber, T32_NotificationCallback_t pFunction)
 {
 	int             err = 0;
+	int            *pEventMask = ctx ? &ctx->EventMask : &T32_EventMask;
+	T32_NotificationCallback_t *callbacks = ctx ? ctx->notificationCallback : notificationCallback;
+	unsigned char  *out = CTX_OUTBUFFER(ctx);
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "%d, p%x", EventNumber, pFunction);
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, %d, p%x", ctx, EventNumber, pFunction);
 
 	if (EventNumber >= T32_MAX_EVENTS)
-		err = T32_Errno = T32_MAX_EVENT_FAIL;
+		err = CTX_ERRNO(ctx) = T32_MAX_EVENT_FAIL;
 
 	if (!err) {
-		T32_EventMask |= 1 << EventNumber;
+		*pEventMask |= 1 << EventNumber;
 
 		if (EventNumber == T32_E_EDIT) {
 			/* device independent -> win/main.c */
-			T32_OUTBUFFER[0] = 4;
-			T32_OUTBUFFER[1] = RAPI_CMD_EDITNOTIFY;
-			T32_OUTBUFFER[2] = 0x0;
-			T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
-			T32_OUTBUFFER[4] = 0x01;    /* bit 0 set == enable */
-			T32_OUTBUFFER[5] = 0x00;    /* high byte */
+			out[0] = 4;
+			out[1] = RAPI_CMD_EDITNOTIFY;
+			out[2] = 0x0;
+			out[3] = CTX_GetNextMessageId(ctx);
+			out[4] = 0x01;      /* bit 0 set == enable */
+			out[5] = 0x00;      /* high byte */
 		} else {
 			/* device dependent -> debug/comemu12.c */
-			T32_OUTBUFFER[0] = 4;
-			T32_OUTBUFFER[1] = RAPI_CMD_DEVICE_SPECIFIC;
-			T32_OUTBUFFER[2] = RAPI_DSCMD_STATE_SETNOTIFIER; /* -> T32_NotifyStateEnable */
-			T32_OUTBUFFER[3] = gT32InternalLineDriver->GetNextMessageId();
-			T32_OUTBUFFER[4] = T32_EventMask;
-			T32_OUTBUFFER[5] = 0;       /* padding for even byte count */
+			out[0] = 4;
+			out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+			out[2] = RAPI_DSCMD_STATE_SETNOTIFIER;   /* -> T32_NotifyStateEnable */
+			out[3] = CTX_GetNextMessageId(ctx);
+			out[4] = *pEventMask;
+			out[5] = 0; /* padding for even byte count */
 		}
 
-		if (LINE_Transmit(6) == -1)
-			err = T32_Errno = T32_COM_TRANSMIT_FAIL;
+		if (CTX_Transmit(ctx, 6) == -1)
+			err = CTX_ERRNO(ctx) = T32_COM_TRANSMIT_FAIL;
 	}
 
-	if (!err && (LINE_Receive() == -1))
-		err = T32_Errno = T32_COM_RECEIVE_FAIL;
+	if (!err && (CTX_Receive(ctx) == -1))
+		err = CTX_ERRNO(ctx) = T32_COM_RECEIVE_FAIL;
 
-	notificationCallback[EventNumber] = pFunction;      /* update pointer in case of success only */
+	if (!err)
+		callbacks[EventNumber] = pFunction;     /* update pointer in case of success only */
 
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
 	return err;
@@ -7860,30 +8687,50 @@ int T32_NotifyStateEnable(int EventNumber, T32_NotificationCallback_t pFunction)
 */
 
 int T32_CheckStateNotify(unsigned ParameterOfCallbackFunction)
+{
+	return T32_CtxCheckStateNotify(NULL, ParameterOfCallbackFunction);
+}
+
+
+static int CTX_ReceiveNotifyMessage(T32_Context *ctx, unsigned char *package)
+{
+	if (ctx)
+		return gT32InternalLineDriver->ReceiveNotifyMessageEx(ctx->line, package);
+	return gT32InternalLineDriver->ReceiveNotifyMessage(package);
+}
+
+
+/** Context variant of T32_CheckStateNotify().
+	ON event notifications (T32_NotifyEventEnable()) are only dispatched
+	for the default connection.
+ */
+int T32_CtxCheckStateNotify(T32_Context *ctx, unsigned ParameterOfCallbackFunction)
 {
 	unsigned char                   package[T32_PCKLEN_MAX];
 	int                             notifyid;
 	static T32_THREADLOCAL int      inFunction = 0;
+	int                            *pInFunction = ctx ? &ctx->inNotify : &inFunction;
+	T32_NotificationCallback_t     *callbacks = ctx ? ctx->notificationCallback : notificationCallback;
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, "%d", ParameterOfCallbackFunction);
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, %d", ctx, ParameterOfCallbackFunction);
 
 	/* notification handler may cause another notification -
 	   block against recursive call */
 
-	if (inFunction) {
+	if (*pInFunction) {
 		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
 		return 0;
 	}
-	inFunction = 1;
+	*pInFunction = 1;
 
 	/* Check if there is a pending notification message */
-	notifyid = gT32InternalLineDriver->ReceiveNotifyMessage(package);
+	notifyid = CTX_ReceiveNotifyMessage(ctx, package);
 
 	/* process all received notifications */
 	while (notifyid != -1) {
 		switch (notifyid) {
 		case T32_E_BREAK:
-			if (notificationCallback[T32_E_BREAK]) {
+			if (callbacks[T32_E_BREAK]) {
 				int             off = 16;
 				uint32_t        low, high;
 				uint64_t        pc, reason;
@@ -7893,30 +8740,30 @@ int T32_CheckStateNotify(unsigned ParameterOfCallbackFunction)
 				SETLONGVAR(low, package[off + 8]);
 				SETLONGVAR(high, package[off + 12]);
 				reason = ((uint64_t) low) | (((uint64_t) high) << 32);
-				((T32_NotificationCallback_iqq_t) notificationCallback[T32_E_BREAK]) (ParameterOfCallbackFunction, pc, reason);
+				((T32_NotificationCallback_iqq_t) callbacks[T32_E_BREAK]) (ParameterOfCallbackFunction, pc, reason);
 			}
 			break;
 
 		case T32_E_EDIT:
-			if (notificationCallback[T32_E_EDIT]) {
+			if (callbacks[T32_E_EDIT]) {
 				int             off = 16;
 				uint32_t        lineNr;
 				unsigned char  *fileName = package + 20;
 				SETLONGVAR(lineNr, package[off]);
-				((T32_NotificationCallback_iicp_t) notificationCallback[T32_E_EDIT]) (ParameterOfCallbackFunction, (int) lineNr, (const char*) fileName);
+				((T32_NotificationCallback_iicp_t) callbacks[T32_E_EDIT]) (ParameterOfCallbackFunction, (int) lineNr, (const char*) fileName);
 			}
 			break;
 
 
 		case T32_E_BREAKPOINTCONFIG:
-			if (notificationCallback[T32_E_BREAKPOINTCONFIG]) {
-				((T32_NotificationCallback_i_t) notificationCallback[T32_E_BREAKPOINTCONFIG]) (ParameterOfCallbackFunction);
+			if (callbacks[T32_E_BREAKPOINTCONFIG]) {
+				((T32_NotificationCallback_i_t) callbacks[T32_E_BREAKPOINTCONFIG]) (ParameterOfCallbackFunction);
 			}
 			break;
 
 		case T32_E_ONEVENT:
 			{
-				T32_NotificationEvent_t *event_c = eventlist;
+				T32_NotificationEvent_t *event_c = ctx ? NULL : eventlist;
 				char           *event = (char *) package + 16;
 				while (event_c) {
 					if (!strcmp(event_c->name, event)) {
@@ -7929,7 +8776,7 @@ int T32_CheckStateNotify(unsigned ParameterOfCallbackFunction)
 			break;
 
 		case T32_E_RTSTRIGGER:
-			if (notificationCallback[T32_E_RTSTRIGGER]) {
+			if (callbacks[T32_E_RTSTRIGGER]) {
 				int             off = 16;
 				uint32_t        low, high;
 				uint64_t        time, code, param;
@@ -7942,24 +8789,24 @@ int T32_CheckStateNotify(unsigned ParameterOfCallbackFunction)
 				SETLONGVAR(low, package[off + 16]);
 				SETLONGVAR(high, package[off + 20]);
 				param = ((uint64_t) low) | (((uint64_t) high) << 32);
-				((T32_NotificationCallback_iqqq_t) notificationCallback[T32_E_RTSTRIGGER]) (ParameterOfCallbackFunction, time, code, param);
+				((T32_NotificationCallback_iqqq_t) callbacks[T32_E_RTSTRIGGER]) (ParameterOfCallbackFunction, time, code, param);
 			}
 			break;
 
 		case T32_E_ERROR:
-			if (notificationCallback[T32_E_ERROR]) {
+			if (callbacks[T32_E_ERROR]) {
 				int             off = 16;
 				int             code =  package[off];
 				unsigned char  *message = package + 20;
-				((T32_NotificationCallback_iicp_t) notificationCallback[T32_E_ERROR]) (ParameterOfCallbackFunction, code, (const char*) message);
+				((T32_NotificationCallback_iicp_t) callbacks[T32_E_ERROR]) (ParameterOfCallbackFunction, code, (const char*) message);
 			}
 			break;
 		}
 
-		notifyid = gT32InternalLineDriver->ReceiveNotifyMessage(package);
+		notifyid = CTX_ReceiveNotifyMessage(ctx, package);
 	}
 
-	inFunction = 0;
+	*pInFunction = 0;
 	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
 	return 0;
 }
@@ -8046,67 +8893,1340 @@ int T32_NotificationPending(void)
 	return gT32InternalLineDriver->NotificationPending();
 }
 
-#endif   /*ENABLE_NOTIFICATION */
-
+int T32_CtxNotificationPending(T32_Context *ctx)
+{
+	if (!ctx)
+		return T32_NotificationPending();
+	return gT32InternalLineDriver->NotificationPendingEx(ctx->line);
+}
+
+#endif   /*ENABLE_NOTIFICATION */
+
 int T32_Init(void)
 {
 	int             err = 0;
 	char            errorline[256];
 
-#if defined(ENABLE_APILOG)
-	{
-		char            envvar[4000] = "";
+#if defined(ENABLE_APILOG)
+	{
+		char            envvar[4000] = "";
+
+# ifdef _WIN32
+		GetEnvironmentVariable("T32APILOGFILE", envvar, 4000);
+# else
+		{
+			char           *envptr = NULL;
+			envptr = getenv("T32APILOGFILE");
+			if (envptr)
+				strcpy(envvar, envptr);
+		}
+# endif
+
+		if (envvar[0])
+			T32_OpenApiLogFile(envvar);
+	}
+#elif defined(ENABLE_APITRACE)
+	{
+		const char     *envptr = getenv("T32APITRACEFILE");
+
+		if (envptr && envptr[0])
+			T32_OpenApiTraceFile(envptr);
+	}
+#endif
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, 0);
+
+	LineDriverInit = 1;
+	if (gT32InternalLineDriver->Init(errorline) == -1)
+		err = -1;
+
+	if (!err) {
+		gT32InternalLineDriver->SetReceiveToggleBit(-1);
+
+		if (LINE_Sync() == -1)
+			err = -1;
+	}
+#ifdef ENABLE_NOTIFICATION
+	{
+		int             i;
+		for (i = 0; i < T32_MAX_EVENTS; i++)
+			notificationCallback[i] = 0;
+	}
+#endif   /*ENABLE_NOTIFICATION */
+
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
+}
+
+
+/** Get socket handle of TRACE32 remote connection.
+
+	@param t32soc int pointer (for socket handle)
+*/
+
+void T32_GetSocketHandle(int *t32soc)
+{
+	T32_ApiLog(__func__, T32APILOG_FENTRY, 0);
+	*t32soc = gT32InternalLineDriver->GetSocket();
+	T32_ApiLog(__func__, T32APILOG_FEXIT, 0);
+}
+
+
+/** Get the traffic caused by the calling thread on all channels and contexts.
+
+	The counters only increase and wrap around, callers take differences
+	(e.g. before and after a poll) to budget the link to TRACE32.
+
+	@param pNumRequests  number of messages sent, retransmissions not included
+	@param pNumBytes     payload bytes sent and received
+*/
+
+void T32_GetTraffic(uint32_t *pNumRequests, uint32_t *pNumBytes)
+{
+	if (pNumRequests)
+		*pNumRequests = LINE_NumRequests;
+	if (pNumBytes)
+		*pNumBytes = LINE_NumBytes;
+}
+
+
+/** Get the retransmission statistics of the current channel.
+
+	Requests are sent again when no reply arrives within the retransmission
+	timeout, which follows the measured round trip time between RTOMIN and
+	RTOMAX milliseconds (see T32_Config()).
+
+	@param pStats  receives counters and the round trip estimation
+	@return T32_OK
+*/
+
+int T32_GetLineStats(T32_LineStats *pStats)
+{
+	gT32InternalLineDriver->GetStats(pStats);
+	return T32_OK;
+}
+
+
+/** Switches the call statistics of all threads on or off, off by default.
+
+	Calls in progress when the statistics are switched on are not counted.
+
+	@param Enable  1 to count calls, 0 to stop counting (the counts are kept)
+*/
+
+void T32_EnableApiStats(int Enable)
+{
+	ApiStatsEnabled = Enable ? 1 : 0;
+}
+
+
+/** Get a snapshot of the call statistics of the calling thread.
+
+	One entry per API function and line primitive (LINE_Transmit,
+	LINE_ReceiveV, ...) called since T32_EnableApiStats() or
+	T32_ResetApiStats().
+
+	@param pStats    receives up to MaxStats entries, may be NULL
+	@param MaxStats  size of pStats
+	@return number of entries available
+*/
+
+int T32_GetApiStats(T32_ApiStats *pStats, int MaxStats)
+{
+	int             i, n = 0;
+
+	for (i = 0; i < T32_APISTATS_SLOTS; i++) {
+		if (!ApiStatsSlots[i].stats.Calls)
+			continue;
+		if (pStats && n < MaxStats)
+			pStats[n] = ApiStatsSlots[i].stats;
+		n++;
+	}
+	return n;
+}
+
+
+/** Clears the call statistics of the calling thread. */
+
+void T32_ResetApiStats(void)
+{
+	int             i;
+
+	for (i = 0; i < T32_APISTATS_SLOTS; i++) {
+		memset(&ApiStatsSlots[i].stats, 0, sizeof(T32_ApiStats));
+		ApiStatsSlots[i].open = 0;
+	}
+}
+
+
+/** Get the lowest call duration counted in a histogram bucket.
+
+	@param Bucket  0 ... T32_APISTATS_BUCKETS-1
+	@return duration in microseconds
+*/
+
+uint32_t T32_GetApiStatsBucketUs(int Bucket)
+{
+	if (Bucket < 8)
+		return (uint32_t) (Bucket < 0 ? 0 : Bucket);
+	if (Bucket >= T32_APISTATS_BUCKETS)
+		Bucket = T32_APISTATS_BUCKETS - 1;
+	return (uint32_t) (8 + (Bucket & 7)) << ((Bucket >> 3) - 1);
+}
+
+
+/** Get a percentile of the call durations from the histogram.
+
+	@param pStats   entry of T32_GetApiStats()
+	@param Percent  0 ... 100
+	@return upper bound in microseconds of the bucket holding the percentile
+*/
+
+uint32_t T32_GetApiStatsPercentile(const T32_ApiStats *pStats, int Percent)
+{
+	uint64_t        rank, sum = 0;
+	int             i;
+
+	if (!pStats->Calls)
+		return 0;
+	rank = ((uint64_t) pStats->Calls * (uint64_t) Percent + 99) / 100;
+	if (!rank)
+		rank = 1;
+	for (i = 0; i < T32_APISTATS_BUCKETS - 1; i++) {
+		sum += pStats->Histogram[i];
+		if (sum >= rank)
+			return T32_GetApiStatsBucketUs(i + 1) > pStats->MaxUs ? pStats->MaxUs : T32_GetApiStatsBucketUs(i + 1);
+	}
+	return pStats->MaxUs;
+}
+
+
+/**************************************************************************
+
+ Explicit context API
+
+ Every context carries its own line parameters, message buffers, message id,
+ error number and notification state. Two contexts never share state, so
+ each one may be driven by its own thread. A single context must not be
+ used by more than one thread at the same time.
+
+ Usage:     T32_Context *ctx;
+            T32_CtxCreate(&ctx);
+            T32_CtxConfig(ctx, "NODE=", "localhost");
+            T32_CtxConfig(ctx, "PORT=", "20000");
+            T32_CtxInit(ctx);
+            T32_CtxAttach(ctx, T32_DEV_ICD);
+            ...
+            T32_CtxExit(ctx);
+            T32_CtxDestroy(ctx);
+
+***************************************************************************/
+
+/** Allocates a new context with default line parameters.
+
+	@param pCtx  receives the context handle
+	@return T32_OK, T32_COM_PARA_FAIL or T32_MALLOC_FAIL
+ */
+int T32_CtxCreate(T32_Context **pCtx)
+{
+	T32_Context    *ctx;
+
+	if (!pCtx)
+		return T32_COM_PARA_FAIL;
+	*pCtx = NULL;
+
+	ctx = (T32_Context *) calloc(1, sizeof(T32_Context));
+	if (!ctx)
+		return T32_MALLOC_FAIL;
+
+	ctx->line = (LineStruct *) malloc(gT32InternalLineDriver->GetParamsSize());
+	if (!ctx->line) {
+		free(ctx);
+		return T32_MALLOC_FAIL;
+	}
+	gT32InternalLineDriver->DefaultParams(ctx->line);
+	LineDriverContexts++;
+
+	*pCtx = ctx;
+	return T32_OK;
+}
+
+
+/** Frees a context. The connection is closed if still open. */
+void T32_CtxDestroy(T32_Context *ctx)
+{
+	if (!ctx)
+		return;
+	gT32InternalLineDriver->ExitEx(ctx->line);
+	free(ctx->line);
+	free(ctx);
+	LineDriverContexts--;
+}
+
+
+/** Context variant of T32_Config(). */
+int T32_CtxConfig(T32_Context *ctx, const char *String1, const char *String2)
+{
+	int             err = 0;
+	char            configline[256];
+
+	if (!ctx)
+		return T32_Config(String1, String2);
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x, \"%s\", \"%s\"", ctx, String1, String2);
+	if (strlen(String1) + strlen(String2) >= sizeof(configline))
+		err = -1;
+	if (!err) {
+		strcpy(configline, String1);
+		strcat(configline, String2);
+		if (gT32InternalLineDriver->ConfigEx(ctx->line, configline) == -1)
+			err = -1;
+	}
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
+}
+
+
+/** Context variant of T32_Init(). */
+int T32_CtxInit(T32_Context *ctx)
+{
+	int             err = 0;
+	char            errorline[256];
+
+	if (!ctx)
+		return T32_Init();
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x", ctx);
+
+	if (gT32InternalLineDriver->InitEx(ctx->line, errorline) == -1)
+		err = -1;
+
+	if (!err) {
+		gT32InternalLineDriver->SetReceiveToggleBitEx(ctx->line, -1);
+
+		if (CTX_Sync(ctx) == -1)
+			err = -1;
+	}
+#ifdef ENABLE_NOTIFICATION
+	ctx->EventMask = 0;
+	ctx->inNotify = 0;
+	memset(ctx->notificationCallback, 0, sizeof(ctx->notificationCallback));
+#endif
+
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
+}
+
+
+/** Context variant of T32_Exit().
+	Objects allocated with T32_Request*Obj() are not owned by a context
+	and stay valid.
+ */
+int T32_CtxExit(T32_Context *ctx)
+{
+	if (!ctx)
+		return T32_Exit();
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "p%x", ctx);
+	gT32InternalLineDriver->ExitEx(ctx->line);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", 0);
+	return 0;
+}
+
+
+/** Returns the error number of the last failed call on the context. */
+int T32_CtxGetErrno(T32_Context *ctx)
+{
+	return CTX_ERRNO(ctx);
+}
+
+
+/** Context variant of T32_GetSocketHandle(). */
+void T32_CtxGetSocketHandle(T32_Context *ctx, int *t32soc)
+{
+	if (!ctx) {
+		T32_GetSocketHandle(t32soc);
+		return;
+	}
+	*t32soc = gT32InternalLineDriver->GetSocketEx(ctx->line);
+}
+
+
+/** Context variant of T32_GetLineStats(). */
+int T32_CtxGetLineStats(T32_Context *ctx, T32_LineStats *pStats)
+{
+	if (!ctx)
+		return T32_GetLineStats(pStats);
+	gT32InternalLineDriver->GetStatsEx(ctx->line, pStats);
+	return T32_OK;
+}
+
+
+/**************************************************************************
+
+ Pipelined asynchronous requests
+
+ The T32_Async* functions keep up to T32_AsyncSetWindow() memory requests
+ with distinct message ids in flight on the default connection of the
+ calling thread. Replies are matched by message id, so they may complete
+ in any order. The callback of a request runs inside T32_AsyncComplete().
+ Synchronous calls must not be issued while requests are pending.
+
+ Lost packets are recovered by the line driver, which sends a request
+ again with its original sequence ID. The UDP driver can do so for the
+ newest request only, as PowerView repeats only its last reply, so the
+ window is limited to the MaxPending requests of the driver: one over UDP,
+ T32_ASYNC_MAX_WINDOW over a reliable TCP line.
+
+	T32_AsyncReadMemory(a0, 0x40, buf0, n0, done, &r0);
+	T32_AsyncReadMemory(a1, 0x40, buf1, n1, done, &r1);
+	err = T32_AsyncComplete(-1);        // both reads took one round trip
+
+***************************************************************************/
+
+#define ASYNC_MAXDATA   T32_MAXPACKETSIZE_DEFAULT   /* slots are not resized by negotiation */
+
+/* room behind the head for a pipe payload, which line drivers without gather I/O copy there */
+#ifdef T32HOST_UNIX
+# define ASYNC_PAYLOADROOM  0
+#else
+# define ASYNC_PAYLOADROOM  (T32_MAXPACKETSIZE_MAX + 4)
+#endif
+
+typedef struct {
+	int             used;
+	unsigned char   msgid;
+	int             len;                /* length of the message */
+	uint8_t        *dest;               /* read: destination of the data */
+	int             size;
+	T32_AsyncCallback_t callback;
+	void           *user;
+	const uint8_t  *payload;            /* data sent from the caller's buffer, after len bytes of buffer */
+	int             payloadSize;
+	unsigned char   buffer[13 + 4 + 12 + ASYNC_MAXDATA + ASYNC_PAYLOADROOM];  /* room for the headers, see T32_OUTBUFFER */
+} T32_AsyncSlot;
+
+#define ASYNC_OUT(slot) ((slot)->buffer + 13 + 4)
+
+static T32_THREADLOCAL T32_AsyncSlot AsyncSlots[T32_ASYNC_MAX_WINDOW];
+static T32_THREADLOCAL int      AsyncWindow = T32_ASYNC_DEFAULT_WINDOW;
+static T32_THREADLOCAL int      AsyncPending;
+
+
+/** Returns the window in effect, T32_AsyncSetWindow() limited by the line driver. */
+static int asyncWindow(void)
+{
+	return (AsyncWindow < gT32InternalLineDriver->MaxPending) ? AsyncWindow : gT32InternalLineDriver->MaxPending;
+}
+
+
+static int asyncTransmit(T32_AsyncSlot *slot)
+{
+	unsigned char  *out = ASYNC_OUT(slot);
+
+	out[-5] = 0;        /* message header */
+	out[-4] = 0;
+	out[-3] = 0;
+	out[-2] = 0;
+	out[-1] = 0;
+
+	if (slot->payload) {
+		if (gT32InternalLineDriver->TransmitV(out - 5, slot->len + 4 + 1, slot->payload, slot->payloadSize, slot->payloadSize & 1) <= 0)
+			return -1;
+	} else if (gT32InternalLineDriver->Transmit(out - 5, slot->len + 4 + 1) <= 0)
+		return -1;
+	LINE_NumRequests++;
+	LINE_NumBytes += slot->len + (slot->payload ? slot->payloadSize + (slot->payloadSize & 1) : 0);
+	return 0;
+}
+
+
+static void asyncFinish(T32_AsyncSlot *slot, int err)
+{
+	slot->used = 0;
+	AsyncPending--;
+	if (slot->callback)
+		slot->callback(slot->user, err, err ? NULL : slot->dest, slot->size);
+}
+
+
+/** Returns a free slot. Waits for a reply when the window is full,
+	NULL if that failed (see T32_Errno). */
+static T32_AsyncSlot *asyncAlloc(void)
+{
+	int             i;
+
+	if ((AsyncPending >= asyncWindow()) && (T32_AsyncComplete(1) != T32_OK))
+		return NULL;
+	for (i = 0; i < T32_ASYNC_MAX_WINDOW; i++) {
+		if (!AsyncSlots[i].used) {
+			AsyncSlots[i].payload = NULL;
+			return &AsyncSlots[i];
+		}
+	}
+	return NULL;
+}
+
+
+static int asyncSubmit(T32_AsyncSlot *slot, int len, uint8_t *dest, int size, T32_AsyncCallback_t callback, void *user)
+{
+	slot->used     = 1;
+	slot->msgid    = ASYNC_OUT(slot)[3];
+	slot->len      = len;
+	slot->dest     = dest;
+	slot->size     = size;
+	slot->callback = callback;
+	slot->user     = user;
+	AsyncPending++;
+	if (asyncTransmit(slot) == -1) {
+		slot->callback = NULL;
+		asyncFinish(slot, T32_COM_TRANSMIT_FAIL);
+		return T32_Errno = T32_COM_TRANSMIT_FAIL;
+	}
+	return T32_OK;
+}
+
+
+/** Submits a memory read, see T32_ReadMemory(). Size must not exceed 2048 or
+	the negotiated T32_GetMaxPacketSize(), whichever is larger.
+
+	@param  pBuffer  receives the data, must stay valid until the request completed
+	@param  callback called on completion, may be NULL
+	@return T32_OK if the request is in flight, else error number. The
+		callback is not called for a request which failed to submit.
+*/
+int T32_AsyncReadMemory(uint32_t Address, int Access, uint8_t * pBuffer, int Size, T32_AsyncCallback_t callback, void *user)
+{
+	T32_AsyncSlot  *slot;
+	unsigned char  *out;
+	int             err = 0;
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "0x%x, %d, (uint8_t*) p%x, %d", Address, Access, pBuffer, Size);
+
+	/* the reply is received in T32_INBUFFER, the slot holds the request only */
+	if ((Size <= 0) || ((Size > ASYNC_MAXDATA) && (Size > MaxPacketSize)))
+		err = T32_Errno = T32_COM_PARA_FAIL;
+	else if (!(slot = asyncAlloc()))
+		err = T32_Errno;
+	if (err) {
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+		return err;
+	}
+	out = ASYNC_OUT(slot);
+	out[0] = 10;
+	out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+	out[2] = RAPI_DSCMD_MEMORY_READ;        /* T32_ReadMemory */
+	out[3] = gT32InternalLineDriver->GetNextMessageId();
+
+	SETLONGVAR(out[4], Address);
+	out[8] = (unsigned char) Access;
+	out[9] = 0;
+	out[10] = (unsigned char) (Size & 0xff);
+	out[11] = (unsigned char) (Size >> 8);
+
+	err = asyncSubmit(slot, 12, pBuffer, Size, callback, user);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
+}
+
+
+/** Submits a memory write, see T32_WriteMemory(). Size must not exceed 2048.
+	The data is copied, pBuffer may be reused right away.
+*/
+int T32_AsyncWriteMemory(uint32_t Address, int Access, const uint8_t * pBuffer, int Size, T32_AsyncCallback_t callback, void *user)
+{
+	T32_AsyncSlot  *slot;
+	unsigned char  *out;
+	int             err = 0;
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "0x%x, %d, (uint8_t*) p%x, %d", Address, Access, pBuffer, Size);
+
+	if ((Size < 0) || (Size > ASYNC_MAXDATA))
+		err = T32_Errno = T32_COM_PARA_FAIL;
+	else if (!(slot = asyncAlloc()))
+		err = T32_Errno;
+	if (err) {
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+		return err;
+	}
+	out = ASYNC_OUT(slot);
+	out[0] = 10;
+	out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+	out[2] = RAPI_DSCMD_MEMORY_WRITE;
+	out[3] = gT32InternalLineDriver->GetNextMessageId();
+
+	SETLONGVAR(out[4], Address);
+	out[8] = (unsigned char) Access;
+	out[9] = 0;
+	out[10] = (unsigned char) (Size & 0xff);
+	out[11] = (unsigned char) (Size >> 8);
+	memcpy(out + 12, pBuffer, Size);
+
+	err = asyncSubmit(slot, 12 + ((Size + 1) & (~1)), NULL, Size, callback, user);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
+}
+
+
+/** Submits a pipelined memory write, see T32_WriteMemoryPipe(). Size may
+	be up to T32_GetMaxPacketSize(). The data is sent from pBuffer, which
+	must stay valid until the request completed.
+*/
+int T32_AsyncWriteMemoryPipe(uint32_t Address, int Access, const uint8_t * pBuffer, int Size, T32_AsyncCallback_t callback, void *user)
+{
+	T32_AsyncSlot  *slot;
+	unsigned char  *out;
+	int             err = 0;
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "0x%x, %d, (uint8_t*) p%x, %d", Address, Access, pBuffer, Size);
+
+	if ((Size <= 0) || (Size > MaxPacketSize))
+		err = T32_Errno = T32_COM_PARA_FAIL;
+	else if (!(slot = asyncAlloc()))
+		err = T32_Errno;
+	if (err) {
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+		return err;
+	}
+	out = ASYNC_OUT(slot);
+	out[0] = 10;
+	out[1] = RAPI_CMD_DEVICE_SPECIFIC;
+	out[2] = RAPI_DSCMD_MEMORY_WRITEPIPE;   /* T32_WriteMemoryPipe */
+	out[3] = gT32InternalLineDriver->GetNextMessageId();
+
+	SETLONGVAR(out[4], Address);
+	out[8] = (unsigned char) Access;
+	out[9] = 0;
+	out[10] = (unsigned char) (Size & 0xff);
+	out[11] = (unsigned char) (Size >> 8);
+	slot->payload = pBuffer;
+	slot->payloadSize = Size;
+
+	err = asyncSubmit(slot, 12, NULL, Size, callback, user);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
+}
+
+
+/* state of T32_LoadMemory(), a ring of the packets between the oldest unacknowledged and the newest sent */
+#define LOAD_RING   (2 * T32_ASYNC_MAX_WINDOW)
+
+typedef struct T32_LoadState_s T32_LoadState;
+
+typedef struct {
+	T32_LoadState  *load;
+	int             state;              /* 0 free, 1 in flight, 2 acknowledged */
+} T32_LoadPacket;
+
+struct T32_LoadState_s {
+	T32_LoadPacket  packets[LOAD_RING];
+	uint32_t        acked;              /* packets acknowledged in sequence */
+	int             err;                /* first error of a packet */
+};
+
+static void loadDone(void *user, int err, uint8_t *pData, int size)
+{
+	T32_LoadPacket *packet = (T32_LoadPacket *) user;
+
+	(void) pData;
+	(void) size;
+	packet->state = err ? 0 : 2;   /* a failed packet stops the sequence */
+	if (err && !packet->load->err)
+		packet->load->err = err;
+}
+
+
+/** Streams a buffer into target memory with T32_WriteMemoryPipe() packets of
+	T32_GetMaxPacketSize() bytes, keeping T32_AsyncGetWindow() of them in
+	flight. The window is limited to the requests the line driver recovers
+	when packets are lost: over UDP it is 1 and every packet waits for its
+	reply before the next one is sent. Negotiate the packet size first for
+	the best throughput.
+
+	The load starts at offset *pDone, so a load which failed can be resumed
+	by calling again with the same arguments. On return *pDone holds the
+	number of bytes acknowledged in sequence. The final flush of the pipe
+	reports errors of the target which are not attributed to a packet; if it
+	fails, *pDone is reset to where this call started.
+
+	@param  progress  called whenever *pDone advanced, may be NULL. A non-zero
+		return aborts the load with T32_COM_PARA_FAIL.
+	@return T32_OK or error number
+*/
+int T32_LoadMemory(uint32_t Address, int Access, const uint8_t * pBuffer, uint32_t Size, uint32_t * pDone,
+		   T32_LoadProgressCallback_t progress, void *user)
+{
+	T32_LoadState   load;
+	T32_LoadProgress info;
+	uint32_t        start, next, offset, packetSize;
+	uint32_t        retransmits;
+	uint64_t        startUs;
+	int             i, err = 0, len;
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "0x%x, %d, (uint8_t*) p%x, %d, p%x", Address, Access, pBuffer, Size, pDone);
+
+	if (!pDone || (*pDone > Size) || AsyncPending) {
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", T32_COM_PARA_FAIL);
+		return T32_Errno = T32_COM_PARA_FAIL;
+	}
+	memset(&load, 0, sizeof(load));
+	for (i = 0; i < LOAD_RING; i++)
+		load.packets[i].load = &load;
+	start = *pDone;
+	packetSize = (uint32_t) MaxPacketSize;
+	retransmits = LINE_RetransmitCounter;
+
+	memset(&info, 0, sizeof(info));
+	info.Done = start;
+	info.Start = start;
+	info.Total = Size;
+	info.PacketSize = packetSize;
+	info.Window = (uint32_t) asyncWindow();
+	startUs = T32_ApiStatsTimeUs();
+
+	next = 0;
+	while (!err) {
+		/* advance over the packets acknowledged in sequence */
+		while (load.packets[load.acked % LOAD_RING].state == 2) {
+			load.packets[load.acked % LOAD_RING].state = 0;
+			load.acked++;
+		}
+		offset = start + load.acked * packetSize;
+		if (offset > Size)
+			offset = Size;
+		if (offset != info.Done) {
+			info.Done = offset;
+			info.ElapsedUs = T32_ApiStatsTimeUs() - startUs;
+			info.Retransmits = LINE_RetransmitCounter - retransmits;
+			if (progress && progress(user, &info)) {
+				load.err = T32_COM_PARA_FAIL;
+			}
+		}
+		if (load.err)
+			break;
+		offset = start + next * packetSize;
+		if (offset >= Size && next == load.acked)
+			break;
+		if (offset >= Size || next - load.acked >= LOAD_RING) {
+			err = T32_AsyncComplete(1);
+			continue;
+		}
+		len = (int) ((Size - offset < packetSize) ? Size - offset : packetSize);
+		load.packets[next % LOAD_RING].state = 1;
+		err = T32_AsyncWriteMemoryPipe(Address + offset, Access, pBuffer + offset, len, loadDone, &load.packets[next % LOAD_RING]);
+		if (err)
+			load.packets[next % LOAD_RING].state = 0;
+		else
+			next++;
+	}
+	if (AsyncPending && T32_AsyncComplete(-1) != T32_OK && !err)
+		err = T32_Errno;
+	if (!err)
+		err = load.err;
+	while (load.packets[load.acked % LOAD_RING].state == 2) {
+		load.packets[load.acked % LOAD_RING].state = 0;
+		load.acked++;
+	}
+	offset = start + load.acked * packetSize;
+	*pDone = (offset > Size) ? Size : offset;
+
+	if (!err) {
+		err = T32_WriteMemoryPipe(0, 0, NULL, 0);   /* flush, collects errors of the target */
+		if (err)
+			*pDone = start;
+	}
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d, p%x=%d", err, pDone, *pDone);
+	return err;
+}
+
+
+/* state of T32_DumpMemory(), a ring of packet buffers between the oldest incomplete and the newest sent */
+#define DUMP_RING       LOAD_RING
+#define DUMP_MIN_RETRY  1024    /* smallest range a packet the target failed is split into */
+#define DUMP_BUNDLE_BYTES 0x3800  /* reply data per bundle, below the EMU_CBMAXDATASIZE message limit */
+
+typedef struct T32_DumpState_s T32_DumpState;
+
+typedef struct {
+	T32_DumpState  *dump;
+	uint32_t        offset;
+	int             state;              /* 0 free, 1 in flight, 2 passed on, 3 failed by the target */
+} T32_DumpPacket;
+
+struct T32_DumpState_s {
+	T32_DumpPacket  packets[DUMP_RING];
+	uint8_t        *buffer;             /* DUMP_RING packets */
+	uint32_t        done;               /* packets completed in sequence */
+	int             err;                /* first communication error */
+	T32_DumpDataCallback_t data;
+	void           *user;
+};
+
+static void dumpDone(void *user, int err, uint8_t *pData, int size)
+{
+	T32_DumpPacket *packet = (T32_DumpPacket *) user;
+	T32_DumpState  *dump = packet->dump;
+
+	if (!err) {
+		packet->state = 2;
+		dump->data(dump->user, packet->offset, pData, (uint32_t) size, T32_OK);
+	} else if (err > 0) {
+		packet->state = 3;  /* error of the target, see dumpRetry() */
+	} else {
+		packet->state = 0;
+		if (!dump->err)
+			dump->err = err;
+	}
+}
+
+/** Reads a range of a packet the target failed on its own, in halves down to
+	DUMP_MIN_RETRY bytes. Ranges which still fail are passed on with their error.
+
+	@return T32_OK or the communication error
+*/
+static int dumpRetry(T32_DumpState * dump, uint32_t Address, int Access, uint32_t offset, uint8_t * pBuffer, uint32_t size)
+{
+	uint32_t        half;
+	int             err;
+
+	err = T32_ReadMemory(Address + offset, Access, pBuffer, (int) size);
+	if (err < 0)
+		return err;
+	if (!err || (size <= DUMP_MIN_RETRY)) {
+		dump->data(dump->user, offset, err ? NULL : pBuffer, size, err);
+		return T32_OK;
+	}
+	half = size / 2;
+	err = dumpRetry(dump, Address, Access, offset, pBuffer, half);
+	if (!err)
+		err = dumpRetry(dump, Address, Access, offset + half, pBuffer + half, size - half);
+	return err;
+}
+
+
+/** Access class string of the object API and of commands, e.g. "ED:", for
+	the access numbers of data and program memory with or without 0x40 (E:).
+
+	@return 0, -1 for other access numbers
+*/
+static int memoryAccessClass(int Access, char *accessClass, size_t size)
+{
+	if (((Access & ~0x40) != T32_MEMORY_ACCESS_DATA) && ((Access & ~0x40) != T32_MEMORY_ACCESS_PROGRAM))
+		return -1;
+	snprintf(accessClass, size, "%s%s:", (Access & 0x40) ? "E" : "",
+		 ((Access & ~0x40) == T32_MEMORY_ACCESS_PROGRAM) ? "P" : "D");
+	return 0;
+}
+
 
-# ifdef _WIN32
-		GetEnvironmentVariable("T32APILOGFILE", envvar, 4000);
-# else
-		{
-			char           *envptr = NULL;
-			envptr = getenv("T32APILOGFILE");
-			if (envptr)
-				strcpy(envvar, envptr);
-		}
-# endif
+/** Reads count packets of T32_DumpMemory(), starting with packet next at
+	offset, with one memory bundle in a single round trip and completes them
+	as dumpDone() would.
 
-		if (envvar[0])
-			T32_OpenApiLogFile(envvar);
+	@return T32_OK, or the communication error which failed all packets
+*/
+static int dumpBundle(T32_DumpState * dump, T32_MemoryBundleHandle bundle, T32_AddressHandle addr, uint32_t Address,
+		      uint32_t offset, uint32_t Size, uint32_t packetSize, uint32_t next, uint32_t count)
+{
+	T32_BufferSynchStatus status;
+	T32_DumpPacket *packet;
+	uint8_t        *buffer;
+	uint32_t        i, len;
+	int             err;
+
+	T32_ResetMemoryBundleObj(bundle);
+	for (i = 0; i < count; i++) {
+		len = (Size - (offset + i * packetSize) < packetSize) ? Size - (offset + i * packetSize) : packetSize;
+		T32_SetAddressObjAddr32(addr, Address + offset + i * packetSize);
+		T32_AddToBundleObjAddrLength(bundle, addr, len);
 	}
-#endif
+	err = T32_TransferMemoryBundleObj(bundle);
+	if (err < 0)
+		return err;
+	for (i = 0; i < count; i++) {
+		packet = &dump->packets[(next + i) % DUMP_RING];
+		packet->offset = offset + i * packetSize;
+		len = (Size - packet->offset < packetSize) ? Size - packet->offset : packetSize;
+		status = T32_BUFFER_ERROR;
+		T32_GetBundleObjSyncStatusByIndex(bundle, &status, (T32_Index) i);
+		if (status != T32_BUFFER_READ) {
+			packet->state = 3;  /* error of the target, see dumpRetry() */
+			continue;
+		}
+		buffer = dump->buffer + ((next + i) % DUMP_RING) * packetSize;
+		T32_CopyDataFromBundleObjByIndex(buffer, (int) len, bundle, (T32_Index) i);
+		packet->state = 2;
+		dump->data(dump->user, packet->offset, buffer, len, T32_OK);
+	}
+	return T32_OK;
+}
 
-	T32_ApiLog(__func__, T32APILOG_FENTRY, 0);
 
-	if (gT32InternalLineDriver->Init(errorline) == -1)
-		err = -1;
+/** Reads target memory in packets of T32_GetMaxPacketSize() bytes. Over a
+	line driver which keeps several requests in flight the packets are
+	T32_AsyncReadMemory() requests, T32_AsyncGetWindow() of them pipelined.
+	Over UDP, which waits for the reply of every request, each round trip
+	is one T32_TransferMemoryBundleObj() of as many packets as fit into
+	DUMP_BUNDLE_BYTES of reply data (data and program memory only, other
+	access numbers fall back to one packet per round trip). Negotiate the
+	packet size first for the best throughput.
 
-	if (!err) {
-		gT32InternalLineDriver->SetReceiveToggleBit(-1);
+	The data is passed to the data callback as packets complete, not
+	necessarily in address order. A packet the target fails to read is
+	retried on its own in smaller ranges, and ranges which still fail are
+	passed on with pData NULL and the error instead of aborting the dump.
 
-		if (LINE_Sync() == -1)
-			err = -1;
+	The dump starts at offset *pDone, so a dump which failed with a
+	communication error can be resumed by calling again with the same
+	arguments. On return *pDone holds the number of bytes passed on in
+	sequence.
+
+	@param  progress  called whenever *pDone advanced, may be NULL. A non-zero
+		return aborts the dump with T32_COM_PARA_FAIL.
+	@return T32_OK or error number
+*/
+int T32_DumpMemory(uint32_t Address, int Access, uint32_t Size, uint32_t * pDone,
+		   T32_DumpDataCallback_t data, T32_LoadProgressCallback_t progress, void *user)
+{
+	T32_DumpState   dump;
+	T32_DumpPacket *packet;
+	T32_LoadProgress info;
+	T32_MemoryBundleHandle bundle = NULL;
+	T32_AddressHandle addr = NULL;
+	char            accessClass[4];
+	uint32_t        start, next, offset, packetSize, bundlePackets = 0;
+	uint32_t        retransmits;
+	uint64_t        startUs;
+	int             i, err = 0, len;
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "0x%x, %d, %d, p%x", Address, Access, Size, pDone);
+
+	if (!pDone || (*pDone > Size) || !data || AsyncPending) {
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", T32_COM_PARA_FAIL);
+		return T32_Errno = T32_COM_PARA_FAIL;
+	}
+	memset(&dump, 0, sizeof(dump));
+	for (i = 0; i < DUMP_RING; i++)
+		dump.packets[i].dump = &dump;
+	dump.data = data;
+	dump.user = user;
+	start = *pDone;
+	packetSize = (uint32_t) MaxPacketSize;
+	retransmits = LINE_RetransmitCounter;
+	if ((asyncWindow() < 2) && !memoryAccessClass(Access, accessClass, sizeof(accessClass))) {
+		/* one round trip per bundle, see dumpBundle() */
+		if (packetSize > DUMP_BUNDLE_BYTES - 4 - 2)
+			packetSize = DUMP_BUNDLE_BYTES - 4 - 2;
+		bundlePackets = (DUMP_BUNDLE_BYTES - 4) / (packetSize + 2);
+		if ((T32_RequestMemoryBundleObj(&bundle, (int) bundlePackets) != T32_OK) || (T32_RequestAddressObjA32(&addr, Address) != T32_OK)) {
+			T32_ReleaseMemoryBundleObj(&bundle);
+			T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", T32_ERR_MALLOC_FAIL);
+			return T32_Errno = T32_ERR_MALLOC_FAIL;
+		}
+		T32_SetAddressObjAccessString(addr, accessClass);
 	}
-#ifdef ENABLE_NOTIFICATION
-	{
-		int             i;
-		for (i = 0; i < T32_MAX_EVENTS; i++)
-			notificationCallback[i] = 0;
+	dump.buffer = (uint8_t *) malloc(DUMP_RING * packetSize);
+	if (!dump.buffer) {
+		if (bundle) {
+			T32_ReleaseAddressObj(&addr);
+			T32_ReleaseMemoryBundleObj(&bundle);
+		}
+		T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", T32_ERR_MALLOC_FAIL);
+		return T32_Errno = T32_ERR_MALLOC_FAIL;
+	}
+
+	memset(&info, 0, sizeof(info));
+	info.Done = start;
+	info.Start = start;
+	info.Total = Size;
+	info.PacketSize = packetSize;
+	info.Window = bundle ? bundlePackets : (uint32_t) asyncWindow();
+	startUs = T32_ApiStatsTimeUs();
+
+	next = 0;
+	while (!err) {
+		/* advance over the packets completed in sequence, retrying failed ones */
+		while (!err && ((packet = &dump.packets[dump.done % DUMP_RING])->state >= 2)) {
+			if (packet->state == 3) {
+				if (AsyncPending)
+					err = T32_AsyncComplete(-1);
+				offset = start + dump.done * packetSize;
+				len = (int) ((Size - offset < packetSize) ? Size - offset : packetSize);
+				if (!err)
+					err = dumpRetry(&dump, Address, Access, offset, dump.buffer + (dump.done % DUMP_RING) * packetSize, (uint32_t) len);
+				if (err)
+					break;
+			}
+			packet->state = 0;
+			dump.done++;
+		}
+		offset = start + dump.done * packetSize;
+		if (offset > Size)
+			offset = Size;
+		if (offset != info.Done) {
+			info.Done = offset;
+			info.ElapsedUs = T32_ApiStatsTimeUs() - startUs;
+			info.Retransmits = LINE_RetransmitCounter - retransmits;
+			if (progress && progress(user, &info)) {
+				dump.err = T32_COM_PARA_FAIL;
+			}
+		}
+		if (err || dump.err)
+			break;
+		offset = start + next * packetSize;
+		if (offset >= Size && next == dump.done)
+			break;
+		if (offset >= Size || next - dump.done >= DUMP_RING) {
+			err = T32_AsyncComplete(1);
+			continue;
+		}
+		if (bundle) {
+			/* packets up to the end, the ring is empty after each bundle */
+			len = (int) ((Size - offset - 1) / packetSize + 1);
+			err = dumpBundle(&dump, bundle, addr, Address, offset, Size, packetSize, next,
+					 ((uint32_t) len < bundlePackets) ? (uint32_t) len : bundlePackets);
+			if (!err)
+				next += ((uint32_t) len < bundlePackets) ? (uint32_t) len : bundlePackets;
+			continue;
+		}
+		len = (int) ((Size - offset < packetSize) ? Size - offset : packetSize);
+		packet = &dump.packets[next % DUMP_RING];
+		packet->offset = offset;
+		packet->state = 1;
+		err = T32_AsyncReadMemory(Address + offset, Access, dump.buffer + (next % DUMP_RING) * packetSize, len, dumpDone, packet);
+		if (err)
+			packet->state = 0;
+		else
+			next++;
+	}
+	if (AsyncPending && T32_AsyncComplete(-1) != T32_OK && !err)
+		err = T32_Errno;
+	if (!err)
+		err = dump.err;
+	while (dump.packets[dump.done % DUMP_RING].state == 2) {
+		dump.packets[dump.done % DUMP_RING].state = 0;
+		dump.done++;
+	}
+	offset = start + dump.done * packetSize;
+	*pDone = (offset > Size) ? Size : offset;
+	free(dump.buffer);
+	if (bundle) {
+		T32_ReleaseAddressObj(&addr);
+		T32_ReleaseMemoryBundleObj(&bundle);
 	}
-#endif   /*ENABLE_NOTIFICATION */
 
-	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d, p%x=%d", err, pDone, *pDone);
 	return err;
 }
 
 
-/** Get socket handle of TRACE32 remote connection.
+/** Waits for replies of pending requests and runs their callbacks.
 
-	@param t32soc int pointer (for socket handle)
+	@param  nMin  number of requests to complete, -1 for all pending
+	@return T32_OK or the communication error, which failed all pending
+		requests with that error
 */
+int T32_AsyncComplete(int nMin)
+{
+	int             err;
 
-void T32_GetSocketHandle(int *t32soc)
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "%d", nMin);
+	err = asyncComplete(nMin, 0, NULL);
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
+}
+
+
+/** Runs the callbacks of requests whose replies are already pending, without waiting.
+
+	This is the non-blocking receive step for event loops: wait for the
+	socket of T32_GetSocketHandle() to become readable (e.g. with poll() or
+	epoll(), next to other sessions) and call T32_AsyncPoll() on the session.
+
+	@return number of completed requests, -1 on a communication error
+		(which failed all pending requests, see T32_Errno)
+ */
+int T32_AsyncPoll(void)
 {
+	int             err, completed = 0;
+
 	T32_ApiLog(__func__, T32APILOG_FENTRY, 0);
-	*t32soc = gT32InternalLineDriver->GetSocket();
-	T32_ApiLog(__func__, T32APILOG_FEXIT, 0);
+	err = asyncComplete(-1, 1, &completed);
+	if (err)
+		completed = -1;
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", completed);
+	return completed;
+}
+
+
+/** Receives replies until nMin requests completed (-1: all), with noWait
+	only as long as reply data is pending. */
+static int asyncComplete(int nMin, int noWait, int *pCompleted)
+{
+	T32_AsyncSlot  *slot;
+	unsigned char  *in = T32_INBUFFER;
+	int             len, i, err = 0, completed = 0;
+
+	T32_ApiStatsCall(__func__, T32APILOG_FENTRY);
+	while ((AsyncPending > 0) && ((nMin < 0) || (completed < nMin))) {
+		if (noWait && !gT32InternalLineDriver->ReceivePending())
+			break;
+		len = gT32InternalLineDriver->Receive(in - 1);
+		if (len == -1) {
+			/* the line driver gave up repeating the request */
+			err = T32_Errno = T32_COM_RECEIVE_FAIL;
+			for (i = 0; i < T32_ASYNC_MAX_WINDOW; i++) {
+				if (AsyncSlots[i].used)
+					asyncFinish(&AsyncSlots[i], err);
+			}
+			break;
+		}
+		if (in[2] == 0xfe) {
+			/* KeepAlive packet */
+			gT32InternalLineDriver->SetReceiveToggleBit(-1);
+			continue;
+		}
+		slot = NULL;
+		for (i = 0; i < T32_ASYNC_MAX_WINDOW; i++) {
+			if (AsyncSlots[i].used && (AsyncSlots[i].msgid == in[3]))
+				slot = &AsyncSlots[i];
+		}
+		if (!slot)
+			continue;   /* reply to a retransmitted request which completed already */
+		gT32InternalLineDriver->SetReceiveToggleBit(! !(in[-1] & T32_MSG_LHANDLE));
+		LINE_NumBytes += len - 1;
+		LINE_NumBytesIn += len - 1;
+
+		if (slot->dest && !in[2]) {
+			if (len - 1 < 4 + slot->size) {
+				asyncFinish(slot, T32_COM_RECEIVE_FAIL);
+				completed++;
+				continue;
+			}
+			memcpy(slot->dest, in + 4, slot->size);
+		}
+		asyncFinish(slot, in[2]);
+		completed++;
+	}
+	T32_ApiCallEpilog();
+	if (pCompleted)
+		*pCompleted = completed;
+	T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+	return err;
+}
+
+
+/** Returns the number of requests in flight. */
+int T32_AsyncPending(void)
+{
+	return AsyncPending;
+}
+
+
+/** Sets the number of requests kept in flight, 1 ... T32_ASYNC_MAX_WINDOW.
+	A window of 1 completes every request before the next one is sent. The
+	line driver may keep fewer in flight, see T32_AsyncGetWindow().
+
+	@return T32_OK, T32_COM_PARA_FAIL if out of range or requests are pending
+*/
+int T32_AsyncSetWindow(int nWindow)
+{
+	if ((nWindow < 1) || (nWindow > T32_ASYNC_MAX_WINDOW) || AsyncPending)
+		return T32_COM_PARA_FAIL;
+	AsyncWindow = nWindow;
+	return T32_OK;
+}
+
+
+/** Returns the number of requests kept in flight: T32_AsyncSetWindow(),
+	limited to what the line driver can recover when packets are lost. */
+int T32_AsyncGetWindow(void)
+{
+	return asyncWindow();
+}
+
+
+/** Drops pending requests without calling their callbacks, see T32_Exit(). */
+static void asyncDiscard(void)
+{
+	int             i;
+
+	for (i = 0; i < T32_ASYNC_MAX_WINDOW; i++)
+		AsyncSlots[i].used = 0;
+	AsyncPending = 0;
+}
+
+
+/**************************************************************************
+
+ Remote checksum verification
+
+ T32_VerifyMemory() compares target memory with a host buffer without
+ reading it back: TRACE32 computes the CRC-32 of a range (Data.SUM /CRC32)
+ and compares it with T32_Crc32() of the buffer. A range whose checksum
+ differs is bisected with further checksums down to blocks, which are read
+ and compared byte by byte. A matching range costs two round trips.
+
+***************************************************************************/
+
+static uint32_t Crc32Table[8][256];
+static int      Crc32TableReady;
+
+static void crc32Init(void)
+{
+	uint32_t        crc;
+	int             i, j;
+
+	for (i = 0; i < 256; i++) {
+		crc = (uint32_t) i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320u : 0);
+		Crc32Table[0][i] = crc;
+	}
+	for (i = 0; i < 256; i++) {
+		for (j = 1; j < 8; j++)
+			Crc32Table[j][i] = (Crc32Table[j - 1][i] >> 8) ^ Crc32Table[0][Crc32Table[j - 1][i] & 0xff];
+	}
+	Crc32TableReady = 1;
+}
+
+
+/** Computes the CRC-32 of IEEE 802.3 (reflected, as Data.SUM /CRC32), eight
+	bytes per step (slice-by-8).
+
+	@param  crc  0, or the result for the preceding data to continue
+*/
+uint32_t T32_Crc32(uint32_t crc, const uint8_t * pData, uint32_t Size)
+{
+	uint32_t        lo, hi;
+
+	if (!Crc32TableReady)
+		crc32Init();
+	crc = ~crc;
+	while (Size >= 8) {
+		lo = crc ^ ((uint32_t) pData[0] | (uint32_t) pData[1] << 8 | (uint32_t) pData[2] << 16 | (uint32_t) pData[3] << 24);
+		hi = (uint32_t) pData[4] | (uint32_t) pData[5] << 8 | (uint32_t) pData[6] << 16 | (uint32_t) pData[7] << 24;
+		crc = Crc32Table[7][lo & 0xff] ^ Crc32Table[6][(lo >> 8) & 0xff] ^
+			Crc32Table[5][(lo >> 16) & 0xff] ^ Crc32Table[4][lo >> 24] ^
+			Crc32Table[3][hi & 0xff] ^ Crc32Table[2][(hi >> 8) & 0xff] ^
+			Crc32Table[1][(hi >> 16) & 0xff] ^ Crc32Table[0][hi >> 24];
+		pData += 8;
+		Size -= 8;
+	}
+	while (Size--)
+		crc = Crc32Table[0][(crc ^ *pData++) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+
+typedef struct {
+	uint32_t        address;
+	int             access;
+	char            accessClass[4];     /* of the Data.SUM command */
+	const uint8_t  *expected;
+	uint8_t        *block;              /* read back buffer */
+	uint32_t        blockSize;
+	T32_VerifyMismatchCallback_t mismatch;
+	void           *user;
+	T32_VerifyStats *stats;
+} T32_VerifyState;
+
+/** Lets TRACE32 compute the CRC-32 of a range. */
+static int verifyRemoteCrc(T32_VerifyState * state, uint32_t offset, uint32_t size, uint32_t * pCrc)
+{
+	char            command[64], message[128];
+	uint64_t        result = 0;
+	int             err;
+
+	snprintf(command, sizeof(command), "Data.SUM %s0x%x--0x%x /CRC32", state->accessClass,
+		 state->address + offset, state->address + offset + size - 1);
+	err = T32_ExecuteCommand(command, message, sizeof(message));
+	if (!err)
+		err = T32_ExecuteFunction_UInt64("Data.SUM()", message, sizeof(message), &result);
+	state->stats->Checksums++;
+	*pCrc = (uint32_t) result;
+	return err;
+}
+
+/** Locates the differences in a range. known: the checksum of the range is known to differ. */
+static int verifyRange(T32_VerifyState * state, uint32_t offset, uint32_t size, int known, int *pDiffers)
+{
+	uint32_t        crc, half, i, bad;
+	int             err, differs;
+
+	*pDiffers = known;
+	if (!known) {
+		err = verifyRemoteCrc(state, offset, size, &crc);
+		if (err)
+			return err;
+		if (crc == T32_Crc32(0, state->expected + offset, size))
+			return T32_OK;
+		*pDiffers = 1;
+	}
+	if (size <= state->blockSize) {
+		err = T32_ReadMemory(state->address + offset, state->access, state->block, (int) size);
+		if (err)
+			return err;
+		state->stats->BytesRead += size;
+		for (i = bad = 0; i < size; i++)
+			bad += state->block[i] != state->expected[offset + i];
+		if (bad) {
+			state->stats->BadBlocks++;
+			state->stats->BadBytes += bad;
+			if (state->mismatch)
+				state->mismatch(state->user, state->address + offset, state->block, state->expected + offset, size);
+		}
+		return T32_OK;
+	}
+	/* a matching first half means the second one differs */
+	half = (size / 2 + state->blockSize - 1) / state->blockSize * state->blockSize;
+	err = verifyRange(state, offset, half, 0, &differs);
+	if (!err)
+		err = verifyRange(state, offset + half, size - half, !differs, &differs);
+	return err;
+}
+
+
+/** Verifies target memory against a buffer with checksums computed by
+	TRACE32, reading back only blocks whose checksum differs.
+
+	@param  Access     T32_MEMORY_ACCESS_DATA or _PROGRAM, optionally with 0x40 (E:)
+	@param  BlockSize  size of the blocks compared byte by byte, at least 1
+	@param  mismatch   called with the target data of each differing block, may be NULL
+	@param  pStats     receives the checksums computed, bytes read and differences
+	@return T32_OK if the memory has been verified (see pStats->BadBytes),
+		else error number, e.g. of a TRACE32 without Data.SUM /CRC32
+*/
+int T32_VerifyMemory(uint32_t Address, int Access, const uint8_t * pBuffer, uint32_t Size, uint32_t BlockSize,
+		     T32_VerifyMismatchCallback_t mismatch, void *user, T32_VerifyStats * pStats)
+{
+	T32_VerifyState state;
+	int             err, differs;
+
+	T32_ApiLog(__func__, T32APILOG_FENTRY, "0x%x, %d, (uint8_t*) p%x, %d, %d", Address, Access, pBuffer, Size, BlockSize);
+
+	memset(pStats, 0, sizeof(*pStats));
+	memset(&state, 0, sizeof(state));
+	err = T32_OK;
+	if (memoryAccessClass(Access, state.accessClass, sizeof(state.accessClass)) || !BlockSize)
+		err = T32_Errno = T32_COM_PARA_FAIL;
+	if (!err && Size) {
+		state.address = Address;
+		state.access = Access;
+		state.expected = pBuffer;
+		state.blockSize = BlockSize;
+		state.mismatch = mismatch;
+		state.user = user;
+		state.stats = pStats;
+		state.block = (uint8_t *) malloc(BlockSize);
+		if (!state.block)
+			err = T32_Errno = T32_ERR_MALLOC_FAIL;
+		else
+			err = verifyRange(&state, 0, Size, 0, &differs);
+		free(state.block);
+	}
+	T32_ApiLog(__func__, T32APILOG_FEXIT, "%d", err);
+	return err;
 }
 
 
@@ -8124,8 +10244,13 @@ static int LINE_Transmit(int len)
 {
 	int             LastTransmitLen = 0;
 
-	if (len)
+	T32_ApiStatsCall(__func__, T32APILOG_FENTRY);
+	if (len) {
 		LastTransmitLen = len + 4 + 1;
+		LINE_NumRequests++;
+		LINE_NumBytes += len;
+	} else
+		LINE_RetransmitCounter++;
 
 	T32_OUTBUFFER[-5] = 0;      /* message header */
 
@@ -8136,21 +10261,65 @@ static int LINE_Transmit(int len)
 
 	if (gT32InternalLineDriver->Transmit(T32_OUTBUFFER - 5, LastTransmitLen) == -1) {
 		T32_Errno = T32_COM_TRANSMIT_FAIL;
+		T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+		return -1;
+	}
+	T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+	return 0;
+}
+
+
+/** Sends message with head in T32_OUTBUFFER[0...len-1] followed by nPayload bytes
+	of pPayload, padded with a zero byte to an even length. The payload is passed
+	to gT32InternalLineDriver->TransmitV without copying it into T32_OUTBUFFER.
+ */
+static int LINE_TransmitV(int len, const uint8_t *pPayload, int nPayload)
+{
+	T32_ApiStatsCall(__func__, T32APILOG_FENTRY);
+
+	LINE_NumRequests++;
+	LINE_NumBytes += len + nPayload + (nPayload & 1);
+
+	T32_OUTBUFFER[-5] = 0;      /* message header */
+
+	T32_OUTBUFFER[-4] = 0;
+	T32_OUTBUFFER[-3] = 0;
+	T32_OUTBUFFER[-2] = 0;
+	T32_OUTBUFFER[-1] = 0;
+
+	if (gT32InternalLineDriver->TransmitV(T32_OUTBUFFER - 5, len + 4 + 1, pPayload, nPayload, nPayload & 1) <= 0) {
+		T32_Errno = T32_COM_TRANSMIT_FAIL;
+		T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
 		return -1;
 	}
+	T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
 	return 0;
 }
 
 
 static int LINE_Receive(void)
+{
+	return LINE_ReceiveV(0, NULL, 0);
+}
+
+
+/** Receives a reply with T32_INBUFFER[0...head-1] in place and the following
+	bytes scattered to the nseg segments, e.g. straight into the caller's buffer.
+ */
+static int LINE_ReceiveV(int head, const LineSegment *seg, int nseg)
 {
 	int             len;
 	int             retry;
 
+	T32_ApiStatsCall(__func__, T32APILOG_FENTRY);
 	for (retry = 0; retry < MAXRETRY; retry++) {
-		len = gT32InternalLineDriver->Receive(T32_INBUFFER - 1);
+		if (nseg)
+			len = gT32InternalLineDriver->ReceiveV(T32_INBUFFER - 1, head + 1, seg, nseg);
+		else
+			len = gT32InternalLineDriver->Receive(T32_INBUFFER - 1);
 		if (len == -1) {
 			T32_Errno = T32_COM_RECEIVE_FAIL;
+			T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
 			return -1;
 		}
 		if (T32_INBUFFER[2] == 0xfe) {
@@ -8172,10 +10341,14 @@ static int LINE_Receive(void)
 		}
 		gT32InternalLineDriver->SetReceiveToggleBit(! !(T32_INBUFFER[-1] & T32_MSG_LHANDLE));
 
+		LINE_NumBytes += len - 1;
+		LINE_NumBytesIn += len - 1;
+		T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
 		return len - 1;
 	}
 
 	T32_Errno = T32_COM_RECEIVE_FAIL;
+	T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
 	return -1;
 }
 
@@ -8191,5 +10364,145 @@ static int LINE_Sync(void)
 }
 
 
+/** Context variant of LINE_Transmit(), uses the buffers and line of ctx. */
+static int CTX_Transmit(T32_Context *ctx, int len)
+{
+	int             LastTransmitLen = 0;
+	unsigned char  *out;
+
+	if (!ctx)
+		return LINE_Transmit(len);
+	T32_ApiStatsCall(__func__, T32APILOG_FENTRY);
+	out = CTX_OUTBUFFER(ctx);
+
+	if (len) {
+		LastTransmitLen = len + 4 + 1;
+		LINE_NumRequests++;
+		LINE_NumBytes += len;
+	} else
+		LINE_RetransmitCounter++;
+
+	out[-5] = 0;        /* message header */
+
+	out[-4] = 0;
+	out[-3] = 0;
+	out[-2] = 0;
+	out[-1] = 0;
+
+	if (gT32InternalLineDriver->TransmitEx(ctx->line, out - 5, LastTransmitLen) == -1) {
+		ctx->Errno = T32_COM_TRANSMIT_FAIL;
+		T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+		return -1;
+	}
+	T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+	return 0;
+}
+
+
+/** Context variant of LINE_TransmitV(), uses the buffers and line of ctx. */
+static int CTX_TransmitV(T32_Context *ctx, int len, const uint8_t *pPayload, int nPayload)
+{
+	unsigned char  *out;
+
+	if (!ctx)
+		return LINE_TransmitV(len, pPayload, nPayload);
+	T32_ApiStatsCall(__func__, T32APILOG_FENTRY);
+	out = CTX_OUTBUFFER(ctx);
+
+	LINE_NumRequests++;
+	LINE_NumBytes += len + nPayload + (nPayload & 1);
+
+	out[-5] = 0;        /* message header */
+
+	out[-4] = 0;
+	out[-3] = 0;
+	out[-2] = 0;
+	out[-1] = 0;
+
+	if (gT32InternalLineDriver->TransmitVEx(ctx->line, out - 5, len + 4 + 1, pPayload, nPayload, nPayload & 1) <= 0) {
+		ctx->Errno = T32_COM_TRANSMIT_FAIL;
+		T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+		return -1;
+	}
+	T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+	return 0;
+}
+
+
+/** Context variant of LINE_Receive(), uses the buffers and line of ctx. */
+static int CTX_Receive(T32_Context *ctx)
+{
+	return CTX_ReceiveV(ctx, 0, NULL, 0);
+}
+
+
+/** Context variant of LINE_ReceiveV(), uses the buffers and line of ctx. */
+static int CTX_ReceiveV(T32_Context *ctx, int head, const LineSegment *seg, int nseg)
+{
+	int             len;
+	int             retry;
+	unsigned char  *in;
+	LineStruct     *line;
+
+	if (!ctx)
+		return LINE_ReceiveV(head, seg, nseg);
+	T32_ApiStatsCall(__func__, T32APILOG_FENTRY);
+	in = CTX_INBUFFER(ctx);
+	line = ctx->line;
+
+	for (retry = 0; retry < MAXRETRY; retry++) {
+		if (nseg)
+			len = gT32InternalLineDriver->ReceiveVEx(line, in - 1, head + 1, seg, nseg);
+		else
+			len = gT32InternalLineDriver->ReceiveEx(line, in - 1);
+		if (len == -1) {
+			ctx->Errno = T32_COM_RECEIVE_FAIL;
+			T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+			return -1;
+		}
+		if (in[2] == 0xfe) {
+			// KeepAlive packet.
+			retry = 0;
+			gT32InternalLineDriver->SetReceiveToggleBitEx(line, -1);
+			continue;
+		}
+		if (in[3] != gT32InternalLineDriver->GetMessageIdEx(line))
+			continue;
+
+		if (in[-1] & T32_MSG_LRETRY) {
+			if (gT32InternalLineDriver->GetReceiveToggleBitEx(line) == (! !(in[-1] & T32_MSG_LHANDLE))) {
+				if (CTX_Transmit(ctx, 0) == -1)
+					CTX_Sync(ctx);
+				continue;
+			}
+		}
+		gT32InternalLineDriver->SetReceiveToggleBitEx(line, ! !(in[-1] & T32_MSG_LHANDLE));
+
+		LINE_NumBytes += len - 1;
+		LINE_NumBytesIn += len - 1;
+		T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+		return len - 1;
+	}
+
+	ctx->Errno = T32_COM_RECEIVE_FAIL;
+	T32_ApiStatsCall(__func__, T32APILOG_FEXIT);
+	return -1;
+}
+
+
+static int CTX_Sync(T32_Context *ctx)
+{
+	int             retry = MAXRETRY;
+
+	if (!ctx)
+		return LINE_Sync();
+	while (--retry > 0) {
+		if (gT32InternalLineDriver->SyncEx(ctx->line) != -1)
+			return 0;
+	}
+	return -1;
+}
+
+
 /* *INDENT-OFF* */
 #endif   /* !(HREMOTE_DEFINITIONS_ONLY) */
@@ -0,0 +1,608 @@
+/*
+ * TRACE32 Remote API
+ *
+ * Copyright (c) 1998-2020 Lauterbach GmbH
+ * All rights reserved
+ *
+ * Loss and delay test of the retransmissions of the UDP line driver
+ * (hlinknet.c). A thread plays TRACE32 on a local port: like PowerView it
+ * answers every copy of a request, a repeated request with the reply it sent
+ * last. It serves slowly or drops requests on demand. It simulates
+ * TEST_MEMORY_SIZE bytes of target memory for memory reads, pipe writes,
+ * memory bundles and Data.SUM /CRC32, and fails reads of a range on demand.
+ *
+ *    t32linetest
+ *    t32linetest memory
+ *    t32linetest relay <t32mux>
+ *    t32linetest mux <t32mux>
+ *
+ * Checks that requests slower than the retransmission timeout cost a bounded
+ * number of retransmits which end with them, that the timeout is sampled
+ * again afterwards, and that each lost request is sent again once.
+ *
+ * With "memory" it checks T32_Crc32() against known answers and a bitwise
+ * reference, then T32_LoadMemory() into the simulated memory, the bisection
+ * of T32_VerifyMemory() down to the differing blocks, and T32_DumpMemory()
+ * passing on a range the target fails to read with its error.
+ *
+ * With "relay" it starts t32mux in front of the simulated PowerView instead
+ * and checks that two RCL=TCPRELAY connections (hlinktcp.c) share its link,
+ * with "mux" the same for two RCL=MUX connections to its Unix domain socket.
+ *
+ * Licensing restrictions apply to this code.
+ * Please see documentation (api_remote_c.pdf) for
+ * licensing terms and conditions.
+ *
+ * formatted with:
+ *    indent -kr -c0 -cbi0 -cd0 -cli4 -cp10 -di16 -fc1 -il0 -nsc -ppi2 --line-length120 --no-tabs t32linetest.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "t32.h"
+
+#define TEST_RTOMIN_MS      5       /* lowered floor, keeps the slow requests short */
+#define TEST_SLOW_MS        40      /* service time of a slow request, several timeouts */
+#define TEST_SLOW           3
+#define TEST_FAST           100
+#define TEST_LOSSY          50
+#define TEST_DROP_EVERY     5       /* the first copy of every 5th request is lost */
+#define TEST_RELAY_WAIT     200     /* 10 ms steps until t32mux accepts connections */
+#define TEST_PACKLEN        1024    /* PACKLEN=, UDP packet size of both sides */
+#define TEST_MEMORY_BASE    0x20000000u
+#define TEST_MEMORY_SIZE    0x10000u
+#define TEST_TARGET_ERROR   0x10    /* status of a read the target fails */
+#define TEST_BLOCK          256     /* compared byte by byte by T32_VerifyMemory() */
+#define TEST_BAD_LO         0x8100  /* range the target fails to read in the dump test */
+#define TEST_BAD_HI         0x8200
+
+static int      ServerSocket;
+static volatile int ServerStop;
+static volatile int ServerDelayMs;
+static volatile int ServerDropEvery;
+static volatile uint32_t ServerBadLo, ServerBadHi;      /* offsets the target fails to read */
+static uint8_t  Memory[TEST_MEMORY_SIZE];               /* target memory at TEST_MEMORY_BASE */
+
+static uint32_t Get16(const unsigned char *p)
+{
+	return (uint32_t) p[0] | (uint32_t) p[1] << 8;
+}
+
+static uint32_t Get32(const unsigned char *p)
+{
+	return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+/** Bitwise CRC-32 of IEEE 802.3, the reference for T32_Crc32() and the Data.SUM /CRC32 of the simulation. */
+static uint32_t Crc32(const uint8_t * data, uint32_t size)
+{
+	uint32_t        crc = 0xffffffffu;
+	int             j;
+
+	while (size--) {
+		crc ^= *data++;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320u : 0);
+	}
+	return ~crc;
+}
+
+/** Checks that a range lies within the simulated memory, and with checkBad that the target can read it. */
+static int InMemory(uint32_t address, uint32_t size, int checkBad)
+{
+	uint32_t        offset = address - TEST_MEMORY_BASE;
+
+	if (address < TEST_MEMORY_BASE || offset > TEST_MEMORY_SIZE || size > TEST_MEMORY_SIZE - offset)
+		return 0;
+	return !checkBad || !(offset < ServerBadHi && offset + size > ServerBadLo);
+}
+
+/**
+	Serves a request message (5 byte message header, then the command) into
+	reply (1 byte message header, then status and data).
+	@return size of the reply message
+*/
+static int Serve(const unsigned char *request, int size, unsigned char *reply)
+{
+	static uint64_t sum;    /* result of the last Data.SUM for the Data.SUM() function */
+	const unsigned char *out = request + 5, *end = request + size;
+	unsigned char  *in = reply + 1;
+	uint32_t        address, last, length, count, tag, k;
+	int             n = 4 + 12, i;
+
+	memset(reply, 0, 1 + n);
+	in[0] = 2;
+	in[1] = out[1];         /* command */
+	in[3] = out[3];         /* message ID */
+	if (out[1] == 0x72 && out[2] == 0x04) {
+		/* T32_ExecuteCommand(), the short or the long form */
+		if (sscanf((const char *) out + (out[0] ? 8 : 10), "Data.SUM %*[A-Z]:0x%x--0x%x", &address, &last) == 2
+		    && last >= address && InMemory(address, last - address + 1, 0))
+			sum = Crc32(Memory + (address - TEST_MEMORY_BASE), last - address + 1);
+		else
+			in[2] = TEST_TARGET_ERROR;
+	} else if (out[1] == 0x72 && out[2] == 0x07) {
+		/* T32_ExecuteFunction_UInt64(): 8 result bytes */
+		in[8] = 8;
+		for (i = 0; i < 8; i++)
+			in[12 + i] = (unsigned char) (sum >> (8 * i));
+	} else if (out[1] == 0x74 && out[2] == 0x30) {
+		/* memory read */
+		address = Get32(out + 4);
+		length = Get16(out + 10);
+		if (InMemory(address, length, 1)) {
+			memcpy(in + 4, Memory + (address - TEST_MEMORY_BASE), length);
+			n = 4 + (int) length;
+		} else
+			in[2] = TEST_TARGET_ERROR;
+	} else if (out[1] == 0x74 && out[2] == 0x32 && out[0] == 10) {
+		/* memory pipe write, the empty flush has out[0] 2 */
+		address = Get32(out + 4);
+		length = Get16(out + 10);
+		if (InMemory(address, length, 0) && out + 12 + length <= end)
+			memcpy(Memory + (address - TEST_MEMORY_BASE), out + 12, length);
+		else
+			in[2] = TEST_TARGET_ERROR;
+	} else if (out[1] == 0x74 && out[2] == 0x38) {
+		/* memory bundle: per chunk read flag, size, address type, address and tags up to "XX" */
+		count = Get16(out + 6);
+		out += 8;
+		n = 4;
+		for (k = 0; k < count && out + 10 <= end; k++) {
+			length = Get16(out + 2);
+			address = Get32(out + 6);
+			out += 6 + (Get16(out + 4) == 2 ? 4 : 8);
+			while (out + 2 <= end && (tag = Get16(out)) != 0x5858) {
+				out += 2;
+				if (tag == 0x4341)
+					out += 2 + Get16(out);  /* "AC", access class string */
+				else if (tag == 0x4953 || tag == 0x4a41)
+					out += 4;
+				else
+					out += 2;
+			}
+			out += 2;
+			in[n] = 0;
+			in[n + 1] = 0;
+			if (InMemory(address, length, 1) && n + 2 + (int) length <= LINE_MSIZE - 1) {
+				in[n] = 1;
+				memcpy(in + n + 2, Memory + (address - TEST_MEMORY_BASE), length);
+				n += (int) length;
+			}
+			n += 2;
+		}
+	}
+	return 1 + n;
+}
+
+/** Sends a reply message in packets of TEST_PACKLEN bytes starting with sequence ID seq, returns the number of packets. */
+static int SendReply(const unsigned char *message, int size, unsigned short seq, const struct sockaddr_in *peer,
+		     socklen_t length)
+{
+	unsigned char   packet[TEST_PACKLEN];
+	int             offset, part, n;
+
+	for (offset = n = 0; offset < size; offset += part, n++) {
+		part = (size - offset < TEST_PACKLEN - 4) ? size - offset : TEST_PACKLEN - 4;
+		packet[0] = T32_API_RECEIVE;
+		packet[1] = (offset + part < size) ? 1 : 0;     /* more packets follow */
+		packet[2] = (unsigned char) (seq + n);
+		packet[3] = (unsigned char) ((seq + n) >> 8);
+		memcpy(packet + 4, message + offset, part);
+		sendto(ServerSocket, packet, part + 4, 0, (const struct sockaddr *) peer, length);
+	}
+	return n;
+}
+
+/** Plays TRACE32: answers connect and sync packets and every message of a request. */
+static void    *Server(void *arg)
+{
+	static const unsigned char magic[8] = { 'T', 'R', 'A', 'C', 'E', '3', '2', 0 };
+	static unsigned char request[LINE_MSIZE], reply[LINE_MSIZE];
+	unsigned char   packet[2048];
+	struct sockaddr_in peer;
+	socklen_t       length;
+	struct pollfd   pfd;
+	unsigned short  seq = 100, replySeq = 0, requestSeq = 0, lastRequestSeq = 0;
+	int             len, size = 0, haveLast = 0, replySize = 0, numRequests = 0;
+
+	(void) arg;
+	pfd.fd = ServerSocket;
+	pfd.events = POLLIN;
+	while (!ServerStop) {
+		if (poll(&pfd, 1, 10) <= 0)
+			continue;
+		length = sizeof(peer);
+		len = (int) recvfrom(ServerSocket, packet, sizeof(packet), 0, (struct sockaddr *) &peer, &length);
+		if (len < 4)
+			continue;
+		if (packet[0] == 3 || packet[0] == 2) {
+			/* connect request, sync request */
+			packet[0] = (unsigned char) (packet[0] + 0x10);
+			memset(packet + 1, 0, 1024 - 1);
+			packet[2] = (unsigned char) seq;
+			packet[3] = (unsigned char) (seq >> 8);
+			memcpy(packet + 8, magic, sizeof(magic));
+			sendto(ServerSocket, packet, (packet[0] == 0x13) ? 1024 : 16, 0, (struct sockaddr *) &peer, length);
+			continue;
+		}
+		if (packet[0] != 0x11)
+			continue;
+		if (size == 0)
+			requestSeq = (unsigned short) (packet[2] | packet[3] << 8);
+		if (size + len - 4 <= (int) sizeof(request)) {
+			memcpy(request + size, packet + 4, len - 4);
+			size += len - 4;
+		}
+		if (packet[1])
+			continue;   /* more packets follow */
+		len = size;
+		size = 0;
+		if (len < 9)
+			continue;
+		if (haveLast && requestSeq == lastRequestSeq) {
+			/* a copy of the last request: its reply again */
+			SendReply(reply, replySize, replySeq, &peer, length);
+			continue;
+		}
+		numRequests++;
+		if (ServerDropEvery && (numRequests % ServerDropEvery == 0))
+			continue;   /* lost on the way */
+		if (ServerDelayMs)
+			usleep(ServerDelayMs * 1000);
+		replySize = Serve(request, len, reply);
+		replySeq = seq;
+		lastRequestSeq = requestSeq;
+		haveLast = 1;
+		seq = (unsigned short) (seq + SendReply(reply, replySize, replySeq, &peer, length));
+	}
+	return NULL;
+}
+
+
+/** Sends n pings, returns the number of failed ones. */
+static int Pings(int n)
+{
+	int             i, failed = 0;
+
+	for (i = 0; i < n; i++)
+		failed += (T32_Ping() != T32_OK);
+	return failed;
+}
+
+
+/** Retransmission tests over the UDP line driver, returns the number of failed ones. */
+static int TestRetransmit(const char *port)
+{
+	T32_LineStats   before, after;
+	char            rtoMin[16];
+	int             failed, errors = 0;
+
+	snprintf(rtoMin, sizeof(rtoMin), "%d", TEST_RTOMIN_MS);
+	T32_Config("NODE=", "127.0.0.1");
+	T32_Config("PORT=", port);
+	T32_Config("PACKLEN=", "1024");
+	T32_Config("RTOMIN=", rtoMin);
+	if (T32_Init() != T32_OK || T32_Attach(T32_DEV_ICD) != T32_OK) {
+		printf("FAIL: no connection\n");
+		return 1;
+	}
+	Pings(20);
+
+	/* slow requests: the timer repeats them, PowerView answers every copy */
+	T32_GetLineStats(&before);
+	ServerDelayMs = TEST_SLOW_MS;
+	failed = Pings(TEST_SLOW);
+	ServerDelayMs = 0;
+	T32_GetLineStats(&after);
+	printf("slow:  %d requests, %u retransmits, %d failed\n", TEST_SLOW, after.Retransmits - before.Retransmits, failed);
+	if (failed || after.Retransmits == before.Retransmits || after.Retransmits - before.Retransmits > 4 * TEST_SLOW) {
+		printf("FAIL: slow requests\n");
+		errors++;
+	}
+
+	/* the replies to the copies must not trigger retransmits of the next requests */
+	T32_GetLineStats(&before);
+	failed = Pings(TEST_FAST);
+	T32_GetLineStats(&after);
+	printf("fast:  %d requests, %u retransmits, %d failed, RTO %u us\n", TEST_FAST, after.Retransmits - before.Retransmits,
+	       failed, after.RtoUs);
+	if (failed || after.Retransmits != before.Retransmits) {
+		printf("FAIL: retransmits outlast the slow requests\n");
+		errors++;
+	}
+	if (after.RtoUs > 4 * TEST_RTOMIN_MS * 1000) {
+		printf("FAIL: retransmission timeout not sampled again\n");
+		errors++;
+	}
+
+	/* lost requests are sent again once */
+	T32_GetLineStats(&before);
+	ServerDropEvery = TEST_DROP_EVERY;
+	failed = Pings(TEST_LOSSY);
+	ServerDropEvery = 0;
+	T32_GetLineStats(&after);
+	printf("lossy: %d requests, %u retransmits, %d failed\n", TEST_LOSSY, after.Retransmits - before.Retransmits, failed);
+	if (failed || after.Retransmits - before.Retransmits > 2 * (TEST_LOSSY / TEST_DROP_EVERY)) {
+		printf("FAIL: lost requests\n");
+		errors++;
+	}
+
+	T32_Exit();
+	return errors;
+}
+
+
+/** Data passed on by T32_DumpMemory(), and the bytes passed on as failed. */
+static uint8_t  Dumped[TEST_MEMORY_SIZE];
+static uint8_t  DumpFailed[TEST_MEMORY_SIZE];
+static int      DumpErrors;
+
+static void OnDumpData(void *user, uint32_t Offset, const uint8_t * pData, uint32_t Size, int err)
+{
+	(void) user;
+	if (Offset > TEST_MEMORY_SIZE || Size > TEST_MEMORY_SIZE - Offset || (!pData && err <= 0)) {
+		DumpErrors++;
+		return;
+	}
+	if (pData)
+		memcpy(Dumped + Offset, pData, Size);
+	else
+		memset(DumpFailed + Offset, 1, Size);
+}
+
+/** Blocks reported by T32_VerifyMemory(). */
+static uint32_t MismatchAt[4];
+static int      NumMismatches;
+
+static void OnMismatch(void *user, uint32_t Address, const uint8_t * pTarget, const uint8_t * pExpected, uint32_t Size)
+{
+	(void) user;
+	(void) pTarget;
+	(void) pExpected;
+	(void) Size;
+	if (NumMismatches < 4)
+		MismatchAt[NumMismatches] = Address;
+	NumMismatches++;
+}
+
+
+/** Checks T32_Crc32() against known answers and the bitwise reference, returns 1 if it failed. */
+static int TestCrc32(void)
+{
+	static const uint8_t check[] = "123456789";
+	uint8_t         data[300];
+	uint32_t        i, size;
+	int             failed = 0;
+
+	/* the check value of CRC-32 (IEEE 802.3), also continued, and of no data */
+	failed += T32_Crc32(0, check, 9) != 0xcbf43926u;
+	failed += T32_Crc32(T32_Crc32(0, check, 4), check + 4, 5) != 0xcbf43926u;
+	failed += T32_Crc32(0, check, 0) != 0;
+
+	/* every length around the 8 byte steps at every alignment */
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = (uint8_t) (i * 7 + (i >> 3));
+	for (size = 0; size <= 64; size++) {
+		for (i = 0; i < 8; i++)
+			failed += T32_Crc32(0, data + i, size) != Crc32(data + i, size);
+	}
+	failed += T32_Crc32(0, data, sizeof(data)) != Crc32(data, sizeof(data));
+
+	printf("crc32:  \"123456789\" 0x%08x, %d failed\n", (unsigned) T32_Crc32(0, check, 9), failed);
+	if (failed) {
+		printf("FAIL: CRC-32\n");
+		return 1;
+	}
+	return 0;
+}
+
+
+/** Load, verify and dump of the simulated memory over the UDP line driver, returns the number of failed tests. */
+static int TestMemory(const char *port)
+{
+	static uint8_t  image[TEST_MEMORY_SIZE];
+	T32_VerifyStats stats;
+	uint32_t        i, done, failed, differs;
+	int             err, errors;
+
+	errors = TestCrc32();
+	for (i = 0; i < TEST_MEMORY_SIZE; i++)
+		image[i] = (uint8_t) ((i * 2654435761u) >> 24);
+
+	T32_Config("NODE=", "127.0.0.1");
+	T32_Config("PORT=", port);
+	T32_Config("PACKLEN=", "1024");
+	if (T32_Init() != T32_OK || T32_Attach(T32_DEV_ICD) != T32_OK) {
+		printf("FAIL: no connection\n");
+		return errors + 1;
+	}
+
+	/* pipe writes of T32_GetMaxPacketSize() bytes, each of several UDP packets */
+	done = 0;
+	err = T32_LoadMemory(TEST_MEMORY_BASE, T32_MEMORY_ACCESS_DATA, image, TEST_MEMORY_SIZE, &done, NULL, NULL);
+	printf("load:   %u bytes, error %d\n", (unsigned) done, err);
+	if (err || done != TEST_MEMORY_SIZE || memcmp(Memory, image, TEST_MEMORY_SIZE)) {
+		printf("FAIL: load\n");
+		errors++;
+	}
+
+	/* matching memory costs one checksum */
+	NumMismatches = 0;
+	err = T32_VerifyMemory(TEST_MEMORY_BASE, T32_MEMORY_ACCESS_DATA, image, TEST_MEMORY_SIZE, TEST_BLOCK, OnMismatch, NULL,
+			       &stats);
+	printf("verify: %u checksums, %u bytes read, %u bad bytes, error %d\n", (unsigned) stats.Checksums,
+	       (unsigned) stats.BytesRead, (unsigned) stats.BadBytes, err);
+	if (err || stats.Checksums != 1 || stats.BytesRead || stats.BadBytes || NumMismatches) {
+		printf("FAIL: verify of matching memory\n");
+		errors++;
+	}
+
+	/* two differing bytes are bisected down to their blocks, only these are read; at
+	   most two checksums per level and block below the first */
+	Memory[0x1234] ^= 0xff;
+	Memory[0xe001] ^= 0x01;
+	NumMismatches = 0;
+	err = T32_VerifyMemory(TEST_MEMORY_BASE, T32_MEMORY_ACCESS_DATA, image, TEST_MEMORY_SIZE, TEST_BLOCK, OnMismatch, NULL,
+			       &stats);
+	Memory[0x1234] ^= 0xff;
+	Memory[0xe001] ^= 0x01;
+	printf("verify: %u checksums, %u bytes read, %u bad bytes in %u blocks, error %d\n", (unsigned) stats.Checksums,
+	       (unsigned) stats.BytesRead, (unsigned) stats.BadBytes, (unsigned) stats.BadBlocks, err);
+	if (err || stats.BadBlocks != 2 || stats.BadBytes != 2 || stats.BytesRead != 2 * TEST_BLOCK || NumMismatches != 2
+	    || MismatchAt[0] != TEST_MEMORY_BASE + 0x1200 || MismatchAt[1] != TEST_MEMORY_BASE + 0xe000
+	    || stats.Checksums > 1 + 2 * 2 * 8 /* log2(TEST_MEMORY_SIZE / TEST_BLOCK) */ ) {
+		printf("FAIL: verify bisection\n");
+		errors++;
+	}
+
+	/* memory bundles; the packet with the range the target fails is read again in halves
+	   down to 1024 bytes and the failing one passed on with its error */
+	memset(Dumped, 0, sizeof(Dumped));
+	memset(DumpFailed, 0, sizeof(DumpFailed));
+	DumpErrors = 0;
+	ServerBadLo = TEST_BAD_LO;
+	ServerBadHi = TEST_BAD_HI;
+	done = 0;
+	err = T32_DumpMemory(TEST_MEMORY_BASE, T32_MEMORY_ACCESS_DATA, TEST_MEMORY_SIZE, &done, OnDumpData, NULL, NULL);
+	ServerBadLo = ServerBadHi = 0;
+	for (i = failed = differs = 0; i < TEST_MEMORY_SIZE; i++) {
+		if (DumpFailed[i])
+			failed++;
+		else if (Dumped[i] != Memory[i])
+			differs++;
+	}
+	printf("dump:   %u bytes, %u failed, %u differ, error %d\n", (unsigned) done, (unsigned) failed, (unsigned) differs,
+	       err);
+	if (err || done != TEST_MEMORY_SIZE || DumpErrors || differs || failed > 1024
+	    || memchr(DumpFailed + TEST_BAD_LO, 0, TEST_BAD_HI - TEST_BAD_LO)) {
+		printf("FAIL: dump\n");
+		errors++;
+	}
+
+	T32_Exit();
+	return errors;
+}
+
+
+/** Starts t32mux as relay of the simulated PowerView and talks to it over two connections of driver rcl. */
+static int TestRelay(const char *mux, const char *port, const char *rcl)
+{
+	struct sockaddr_in addr;
+	socklen_t       length = sizeof(addr);
+	T32_Context    *ctx = NULL;
+	char            tcpPort[16], path[64];
+	const char     *node;
+	pid_t           pid;
+	int             fd, i, state, failed = 0, errors = 0;
+
+	/* a free port for the relay */
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (fd < 0 || bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0
+	    || getsockname(fd, (struct sockaddr *) &addr, &length) != 0) {
+		printf("FAIL: no relay port\n");
+		return 1;
+	}
+	snprintf(tcpPort, sizeof(tcpPort), "%u", (unsigned) ntohs(addr.sin_port));
+	close(fd);
+	snprintf(path, sizeof(path), "/tmp/t32linetest-%ld.sock", (long) getpid());
+
+	pid = fork();
+	if (pid == 0) {
+		execl(mux, mux, "-n", "127.0.0.1", "-p", port, "-s", path, "-t", tcpPort, (char *) NULL);
+		_exit(127);
+	}
+	if (pid < 0) {
+		printf("FAIL: cannot start %s\n", mux);
+		return 1;
+	}
+
+	/* RCL=MUX takes the socket from NODE=, RCL=TCPRELAY the port from PORT= */
+	node = strcmp(rcl, "MUX") ? "127.0.0.1" : path;
+	T32_Config("RCL=", rcl);
+	T32_Config("NODE=", node);
+	T32_Config("PORT=", tcpPort);
+	for (i = 0; i < TEST_RELAY_WAIT && T32_Init() != T32_OK; i++)
+		usleep(10000);
+	if (i == TEST_RELAY_WAIT || T32_Attach(T32_DEV_ICD) != T32_OK) {
+		printf("FAIL: no connection to the relay\n");
+		errors++;
+	} else if (T32_CtxCreate(&ctx) != T32_OK || T32_CtxConfig(ctx, "NODE=", node) != T32_OK
+		   || T32_CtxConfig(ctx, "PORT=", tcpPort) != T32_OK || T32_CtxInit(ctx) != T32_OK
+		   || T32_CtxAttach(ctx, T32_DEV_ICD) != T32_OK) {
+		printf("FAIL: no second connection to the relay\n");
+		errors++;
+	} else {
+		/* alternating clients: the relay maps both message ID sequences to its link */
+		for (i = 0; i < TEST_FAST; i++) {
+			failed += (T32_Ping() != T32_OK);
+			failed += (T32_CtxGetState(ctx, &state) != T32_OK);
+		}
+		printf("%s: %d requests of two clients, %d failed\n", rcl, 2 * TEST_FAST, failed);
+		if (failed) {
+			printf("FAIL: requests through the relay\n");
+			errors++;
+		}
+	}
+	if (ctx) {
+		T32_CtxExit(ctx);
+		T32_CtxDestroy(ctx);
+	}
+	T32_Exit();
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+	return errors;
+}
+
+
+int main(int argc, char **argv)
+{
+	struct sockaddr_in addr;
+	socklen_t       length = sizeof(addr);
+	pthread_t       thread;
+	char            port[16];
+	int             errors;
+
+	if (argc != 1 && !(argc == 2 && !strcmp(argv[1], "memory"))
+	    && !(argc == 3 && (!strcmp(argv[1], "relay") || !strcmp(argv[1], "mux")))) {
+		printf("usage: t32linetest [memory | relay <t32mux> | mux <t32mux>]\n");
+		return 1;
+	}
+	ServerSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (ServerSocket < 0 || bind(ServerSocket, (struct sockaddr *) &addr, sizeof(addr)) != 0
+	    || getsockname(ServerSocket, (struct sockaddr *) &addr, &length) != 0) {
+		printf("FAIL: no server socket\n");
+		return 1;
+	}
+	pthread_create(&thread, NULL, Server, NULL);
+	snprintf(port, sizeof(port), "%u", (unsigned) ntohs(addr.sin_port));
+
+	if (argc == 3)
+		errors = TestRelay(argv[2], port, strcmp(argv[1], "mux") ? "TCPRELAY" : "MUX");
+	else if (argc == 2)
+		errors = TestMemory(port);
+	else
+		errors = TestRetransmit(port);
+
+	ServerStop = 1;
+	pthread_join(thread, NULL);
+	close(ServerSocket);
+	printf("%s\n", errors ? "FAIL" : "PASS");
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,1008 @@
+/*
+ * TRACE32 Remote API
+ *
+ * Copyright (c) 1998-2020 Lauterbach GmbH
+ * All rights reserved
+ *
+ * RCL multiplexer: owns the single RCL connection to PowerView and serves the
+ * memory requests of local tools over a Unix domain socket, see T32_MuxRequest
+ * in t32.h.
+ *
+ *    t32mux [-n node] [-p port] [-l packlen] [-s socket] [-t port] [-w us] [-i seconds]
+ *    t32mux [-s socket] -q
+ *    t32mux [-s socket] -r address,size[,access]
+ *
+ * The daemon collects the requests queued by all clients and serves them in
+ * cycles. Clients are taken round robin, one request at a time, in priority
+ * order, so a client with a deep queue cannot crowd out the others when a
+ * bundle is full. Writes are done as they are taken, the reads of a cycle
+ * travel in one memory bundle, i.e. one round trip. Reads of the same access
+ * class which overlap or lie less than MUX_MERGE_GAP bytes apart share a chunk.
+ * -w waits up to the given time after the first queued request for more to
+ * coalesce; by default only requests queued while the previous round trip was
+ * in flight are combined.
+ *
+ * While the link is down requests fail at once with the last link error, it is
+ * reconnected every MUX_RECONNECT_MS; a connect attempt blocks the daemon.
+ *
+ * The daemon is also the relay of the RCL=TCPRELAY line driver (hlinktcp.c):
+ * framed RCL messages, sent over the Unix domain socket or to the TCP port of
+ * -t on all interfaces, are passed on to PowerView one at a time like writes.
+ * Their message IDs are mapped to the daemon's link, so the API functions of
+ * any number of clients share it, e.g. telnet-rtt with --rcl MUX over the Unix
+ * domain socket (RCL=MUX). Notifications are not passed on. A client whose
+ * message cannot be served is disconnected, a frame has no status; so is a
+ * client which leaves more than MUX_MAX_OUTPUT bytes of replies unread.
+ *
+ * SIGUSR1 and -i print the metrics: per client served requests, share and
+ * queueing time, and the round trips saved by bundling. -q fetches them from a
+ * running daemon, -r reads target memory through it and dumps it in hex.
+ *
+ * Licensing restrictions apply to this code.
+ * Please see documentation (api_remote_c.pdf) for
+ * licensing terms and conditions.
+ *
+ * formatted with:
+ *    indent -kr -c0 -cbi0 -cd0 -cli4 -cp10 -di16 -fc1 -il0 -nsc -ppi2 --line-length120 --no-tabs t32mux.c
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE    /* struct ucred */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+
+#include "t32.h"
+
+#define MUX_MAX_CLIENTS         32
+#define MUX_QUEUE               64      /* pending requests per client */
+#define MUX_MAX_CHUNKS          64      /* chunks per bundle */
+#define MUX_BUNDLE_BYTES        0x3800  /* reply data per bundle, below the 0x3c00 message limit */
+#define MUX_MERGE_GAP           32      /* bytes read in between to merge two reads */
+#define MUX_RECONNECT_MS        1000
+#define MUX_MAX_OUTPUT          (1024 * 1024)   /* unsent reply bytes per client */
+
+typedef struct {
+	uint64_t        Requests;
+	uint64_t        Reads;
+	uint64_t        Writes;
+	uint64_t        Errors;
+	uint64_t        BytesRead;
+	uint64_t        BytesWritten;
+	uint64_t        WaitUs;         /* summed time from queued to replied */
+	uint64_t        MaxWaitUs;
+	uint64_t        Deferred;       /* cycles which left requests of the client queued */
+} MuxClientStats;
+
+typedef struct {
+	T32_MuxRequest  req;
+	uint8_t        *data;           /* write data, framed message */
+	uint64_t        queued;         /* ns */
+} MuxPending;
+
+typedef struct {
+	int             fd;
+	unsigned        id;
+	long            pid;
+	uint8_t         in[4 + LINE_MSIZE];     /* a framed message is the largest request */
+	size_t          inlen;
+	uint8_t        *out;
+	size_t          outlen;
+	size_t          outsize;
+	MuxPending      queue[MUX_QUEUE];
+	unsigned        head;
+	unsigned        count;
+	unsigned        picked;         /* queued reads taken by the current cycle */
+	int             barrier;        /* a write waits for the reads taken before it */
+	int             drop;           /* a framed message failed or replies are not read, close after flushing */
+	MuxClientStats  st;
+} MuxClient;
+
+typedef struct {
+	uint64_t        address;
+	uint32_t        size;
+	char            access[sizeof(((T32_MuxRequest *) 0)->Access)];
+	int             status;
+	uint8_t         data[T32MUX_MAXSIZE];
+} MuxRange;
+
+typedef struct {
+	MuxClient      *client;
+	MuxPending     *pending;
+	MuxRange       *range;
+} MuxItem;
+
+static struct {
+	uint64_t        Cycles;
+	uint64_t        Bundles;
+	uint64_t        Chunks;
+	uint64_t        Reads;
+	uint64_t        Coalesced;      /* reads served from the chunk of another read */
+	uint64_t        Writes;
+	uint64_t        Messages;       /* framed messages passed on */
+	uint64_t        RoundTrips;
+	uint64_t        Connects;
+	uint64_t        LinkErrors;
+	uint64_t        Clients;        /* connections accepted */
+	MuxClientStats  Departed;       /* summed over closed connections */
+} Stats;
+
+static MuxClient *Clients[MUX_MAX_CLIENTS];
+static unsigned NumClients = 0;
+static unsigned NumPending = 0;
+static uint64_t FirstQueued;
+
+static MuxRange Ranges[MUX_MAX_CHUNKS];
+static MuxItem  Items[MUX_MAX_CLIENTS * MUX_QUEUE];
+
+static const char *Node = "localhost";
+static const char *Port = "20000";
+static const char *PackLen = "1024";
+
+static int      LinkUp = 0;
+static int      LinkError = T32_COM_TRANSMIT_FAIL;
+static uint64_t NextConnect = 0;
+static T32_MemoryBundleHandle Bundle;
+static T32_AddressHandle Addr32, Addr64;
+static T32_BufferHandle WriteBuf;
+
+static volatile sig_atomic_t PrintRequested = 0;
+static volatile sig_atomic_t QuitRequested = 0;
+
+static uint64_t NowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void OnSignal(int sig)
+{
+	if (sig == SIGUSR1)
+		PrintRequested = 1;
+	else
+		QuitRequested = 1;
+}
+
+/**************************************************************************
+
+	Link to PowerView
+
+***************************************************************************/
+
+static void LinkDown(int err)
+{
+	if (LinkUp) {
+		fprintf(stderr, "t32mux: link lost, error %d\n", err);
+		Stats.LinkErrors++;
+		T32_Exit();             /* releases all objects */
+	}
+	LinkUp = 0;
+	LinkError = err;
+	NextConnect = NowNs() + MUX_RECONNECT_MS * 1000000ull;
+}
+
+static void Connect(void)
+{
+	int             err;
+
+	T32_Config("NODE=", Node);
+	T32_Config("PORT=", Port);
+	T32_Config("PACKLEN=", PackLen);
+	err = T32_Init();
+	if (err == T32_OK)
+		err = T32_Attach(T32_DEV_ICD);
+	if (err == T32_OK)
+		err = T32_Ping();
+	if (err == T32_OK)
+		err = T32_RequestMemoryBundleObj(&Bundle, MUX_MAX_CHUNKS);
+	if (err == T32_OK)
+		err = T32_RequestAddressObjA32(&Addr32, 0);
+	if (err == T32_OK)
+		err = T32_RequestAddressObjA64(&Addr64, 0);
+	if (err == T32_OK)
+		err = T32_RequestBufferObj(&WriteBuf, T32MUX_MAXSIZE);
+	if (err != T32_OK) {
+		T32_Exit();
+		LinkUp = 0;
+		LinkError = err;
+		NextConnect = NowNs() + MUX_RECONNECT_MS * 1000000ull;
+		return;
+	}
+	fprintf(stderr, "t32mux: connected to %s:%s\n", Node, Port);
+	Stats.Connects++;
+	LinkUp = 1;
+}
+
+/** Communication errors take the link down, target errors only fail the request. */
+static int IsLinkError(int err)
+{
+	return err == T32_COM_RECEIVE_FAIL || err == T32_COM_TRANSMIT_FAIL || err == T32_COM_SEQ_FAIL;
+}
+
+static T32_AddressHandle SetAddress(uint64_t address, const char *access)
+{
+	T32_AddressHandle handle;
+
+	if (address > UINT32_MAX) {
+		handle = Addr64;
+		T32_SetAddressObjAddr64(handle, address);
+	} else {
+		handle = Addr32;
+		T32_SetAddressObjAddr32(handle, (uint32_t) address);
+	}
+	T32_SetAddressObjAccessString(handle, access);
+	return handle;
+}
+
+/**************************************************************************
+
+	Clients
+
+***************************************************************************/
+
+static void Reply(MuxClient * c, MuxPending * p, int status, const uint8_t * data, uint32_t size)
+{
+	T32_MuxReply    reply;
+	uint8_t         frame[4];
+	const void     *head = &reply;
+	size_t          headSize = sizeof(reply), need;
+	uint64_t        waitUs;
+
+	if (status != T32_OK)
+		size = 0;
+	memset(&reply, 0, sizeof(reply));
+	reply.Op = p->req.Op;
+	reply.Tag = p->req.Tag;
+	reply.Status = status;
+	reply.Size = size;
+	if (p->req.Op == T32MUX_FRAME) {
+		frame[0] = T32_API_RECEIVE;
+		frame[1] = 0;
+		frame[2] = (uint8_t) (size & 0xff);
+		frame[3] = (uint8_t) (size >> 8);
+		head = frame;
+		headSize = sizeof(frame);
+		if (status != T32_OK) {
+			c->drop = 1;
+			headSize = 0;
+		}
+	}
+
+	need = c->outlen + headSize + size;
+	if (need > MUX_MAX_OUTPUT && !c->drop) {
+		fprintf(stderr, "t32mux: client %u does not read its replies, disconnected\n", c->id);
+		c->drop = 1;
+	}
+	if (c->drop) {
+		c->st.Errors++;
+		return;
+	}
+	if (need > c->outsize) {
+		size_t          outsize = need * 2 < MUX_MAX_OUTPUT ? need * 2 : MUX_MAX_OUTPUT;
+		uint8_t        *out = (uint8_t *) realloc(c->out, outsize);
+		if (!out) {
+			c->st.Errors++;
+			return;
+		}
+		c->out = out;
+		c->outsize = outsize;
+	}
+	memcpy(c->out + c->outlen, head, headSize);
+	if (size)
+		memcpy(c->out + c->outlen + headSize, data, size);
+	c->outlen = need;
+
+	waitUs = (NowNs() - p->queued) / 1000;
+	c->st.Requests++;
+	c->st.WaitUs += waitUs;
+	if (waitUs > c->st.MaxWaitUs)
+		c->st.MaxWaitUs = waitUs;
+	if (status != T32_OK)
+		c->st.Errors++;
+	else if (p->req.Op == T32MUX_READ) {
+		c->st.Reads++;
+		c->st.BytesRead += size;
+	} else if (p->req.Op == T32MUX_WRITE) {
+		c->st.Writes++;
+		c->st.BytesWritten += p->req.Size;
+	}
+}
+
+static void Flush(MuxClient * c)
+{
+	ssize_t         n;
+
+	while (c->outlen) {
+		n = send(c->fd, c->out, c->outlen, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (n <= 0)
+			return;
+		memmove(c->out, c->out + n, c->outlen - n);
+		c->outlen -= n;
+	}
+}
+
+static void Pop(MuxClient * c)
+{
+	MuxPending     *p = &c->queue[c->head];
+
+	free(p->data);
+	p->data = NULL;
+	c->head = (c->head + 1) % MUX_QUEUE;
+	c->count--;
+	NumPending--;
+}
+
+static void AddStats(MuxClientStats * to, const MuxClientStats * from)
+{
+	to->Requests += from->Requests;
+	to->Reads += from->Reads;
+	to->Writes += from->Writes;
+	to->Errors += from->Errors;
+	to->BytesRead += from->BytesRead;
+	to->BytesWritten += from->BytesWritten;
+	to->WaitUs += from->WaitUs;
+	if (from->MaxWaitUs > to->MaxWaitUs)
+		to->MaxWaitUs = from->MaxWaitUs;
+	to->Deferred += from->Deferred;
+}
+
+static void CloseClient(unsigned index)
+{
+	MuxClient      *c = Clients[index];
+
+	while (c->count)
+		Pop(c);
+	AddStats(&Stats.Departed, &c->st);
+	close(c->fd);
+	free(c->out);
+	free(c);
+	Clients[index] = Clients[--NumClients];
+}
+
+static void Accept(int listenfd, int tcp)
+{
+	MuxClient      *c;
+	int             fd, val = 1;
+
+	fd = accept(listenfd, NULL, NULL);
+	if (fd < 0)
+		return;
+	if (NumClients == MUX_MAX_CLIENTS || !(c = (MuxClient *) calloc(1, sizeof(MuxClient)))) {
+		close(fd);
+		return;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	if (tcp)
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &val, sizeof(val));
+	c->fd = fd;
+	c->id = (unsigned) ++Stats.Clients;
+	c->pid = -1;
+#ifdef SO_PEERCRED
+	{
+		struct ucred    cred;
+		socklen_t       len = sizeof(cred);
+		if (!tcp && !getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len))
+			c->pid = cred.pid;
+	}
+#endif
+	Clients[NumClients++] = c;
+}
+
+/** Moves complete requests from the input buffer to the queue. Returns -1 on a protocol error. */
+static int Parse(MuxClient * c)
+{
+	T32_MuxRequest  req;
+	MuxPending     *p;
+	size_t          pos = 0, head, need;
+
+	while (c->inlen - pos >= 4 && c->count < MUX_QUEUE) {
+		if (c->in[pos] == T32MUX_FRAME) {
+			/* frame header of hlinktcp.c: type, 0, message length */
+			memset(&req, 0, sizeof(req));
+			req.Op = T32MUX_FRAME;
+			req.Size = c->in[pos + 2] | c->in[pos + 3] << 8;
+			if (c->in[pos + 1] || req.Size < 5 + 4 || req.Size > LINE_MSIZE)
+				return -1;
+			head = 4;
+		} else {
+			if (c->inlen - pos < sizeof(req))
+				break;
+			memcpy(&req, c->in + pos, sizeof(req));
+			if (req.Op < T32MUX_READ || req.Op > T32MUX_STATS || req.Size > T32MUX_MAXSIZE)
+				return -1;
+			head = sizeof(req);
+		}
+		need = head + (req.Op == T32MUX_WRITE || req.Op == T32MUX_FRAME ? req.Size : 0);
+		if (c->inlen - pos < need)
+			break;
+		req.Access[sizeof(req.Access) - 1] = 0;
+		if (req.Priority >= T32MUX_PRIORITIES)
+			req.Priority = T32MUX_PRIORITIES - 1;
+
+		p = &c->queue[(c->head + c->count) % MUX_QUEUE];
+		p->req = req;
+		p->data = NULL;
+		p->queued = NowNs();
+		if ((req.Op == T32MUX_WRITE || req.Op == T32MUX_FRAME) && req.Size) {
+			p->data = (uint8_t *) malloc(req.Size);
+			if (!p->data)
+				return -1;
+			memcpy(p->data, c->in + pos + head, req.Size);
+		}
+		if (!NumPending)
+			FirstQueued = p->queued;
+		c->count++;
+		NumPending++;
+		pos += need;
+	}
+	memmove(c->in, c->in + pos, c->inlen - pos);
+	c->inlen -= pos;
+	return 0;
+}
+
+static int Receive(MuxClient * c)
+{
+	ssize_t         n;
+
+	n = recv(c->fd, c->in + c->inlen, sizeof(c->in) - c->inlen, MSG_DONTWAIT);
+	if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+		return -1;
+	if (n > 0)
+		c->inlen += n;
+	return Parse(c);
+}
+
+/**************************************************************************
+
+	Metrics
+
+***************************************************************************/
+
+static int FormatStats(char *buf, size_t size)
+{
+	MuxClientStats  total = Stats.Departed;
+	uint64_t        saved;
+	unsigned        i;
+	int             len;
+
+	for (i = 0; i < NumClients; i++)
+		AddStats(&total, &Clients[i]->st);
+	saved = Stats.Reads > Stats.Bundles ? Stats.Reads - Stats.Bundles : 0;
+
+	len = snprintf(buf, size,
+		       "link %s:%s %s, connects %" PRIu64 ", link errors %" PRIu64 "\n"
+		       "cycles %" PRIu64 ", round trips %" PRIu64 " (%" PRIu64 " bundles, %" PRIu64 " writes, %" PRIu64
+		       " messages)\n"
+		       "reads %" PRIu64 " in %" PRIu64 " chunks, coalesced %" PRIu64 ", round trips saved %" PRIu64
+		       " (%.1f%%)\n"
+		       "clients %u connected, %" PRIu64 " accepted, requests %" PRIu64 ", errors %" PRIu64
+		       ", wait avg %" PRIu64 " us max %" PRIu64 " us\n",
+		       Node, Port, LinkUp ? "up" : "down", Stats.Connects, Stats.LinkErrors,
+		       Stats.Cycles, Stats.RoundTrips, Stats.Bundles, Stats.Writes, Stats.Messages,
+		       Stats.Reads, Stats.Chunks, Stats.Coalesced, saved,
+		       Stats.Reads ? 100.0 * saved / Stats.Reads : 0.0,
+		       NumClients, Stats.Clients, total.Requests, total.Errors,
+		       total.Requests ? total.WaitUs / total.Requests : 0, total.MaxWaitUs);
+
+	for (i = 0; i < NumClients && len >= 0 && (size_t) len < size; i++) {
+		const MuxClientStats *st = &Clients[i]->st;
+		len += snprintf(buf + len, size - len,
+				"  client %u pid %ld: requests %" PRIu64 " (%.1f%%), reads %" PRIu64 " (%" PRIu64
+				" B), writes %" PRIu64 " (%" PRIu64 " B), errors %" PRIu64
+				", wait avg %" PRIu64 " us max %" PRIu64 " us, deferred %" PRIu64 "\n",
+				Clients[i]->id, Clients[i]->pid, st->Requests,
+				total.Requests ? 100.0 * st->Requests / total.Requests : 0.0,
+				st->Reads, st->BytesRead, st->Writes, st->BytesWritten, st->Errors,
+				st->Requests ? st->WaitUs / st->Requests : 0, st->MaxWaitUs, st->Deferred);
+	}
+	return len;
+}
+
+static void PrintStats(void)
+{
+	static char     buf[MUX_MAX_CLIENTS * 200 + 1024];
+
+	FormatStats(buf, sizeof(buf));
+	fputs(buf, stdout);
+	fflush(stdout);
+}
+
+/**************************************************************************
+
+	Scheduling
+
+***************************************************************************/
+
+/** Serves a write, stats request or framed message at once. */
+static void ServeDirect(MuxClient * c, MuxPending * p)
+{
+	static char     buf[MUX_MAX_CLIENTS * 200 + 1024];
+	static uint8_t  message[LINE_MSIZE];
+	int             err, len;
+
+	if (p->req.Op == T32MUX_STATS) {
+		len = FormatStats(buf, sizeof(buf));
+		if (len < 0)
+			len = 0;
+		if ((size_t) len >= sizeof(buf))
+			len = sizeof(buf) - 1;
+		Reply(c, p, T32_OK, (const uint8_t *) buf, (uint32_t) len);
+		return;
+	}
+	if (!LinkUp) {
+		Reply(c, p, LinkError, NULL, 0);
+		return;
+	}
+	if (p->req.Op == T32MUX_FRAME) {
+		len = sizeof(message);
+		err = T32_TransferMessage(p->data, (int) p->req.Size, message, &len);
+		Stats.Messages++;
+		Stats.RoundTrips++;
+		Reply(c, p, err, message, err == T32_OK ? (uint32_t) len : 0);
+		if (IsLinkError(err))
+			LinkDown(err);
+		return;
+	}
+	err = T32_CopyDataToBufferObj(WriteBuf, p->req.Size, p->data);
+	if (err == T32_OK)
+		err = T32_WriteMemoryObj(WriteBuf, SetAddress(p->req.Address, p->req.Access), p->req.Size);
+	Stats.Writes++;
+	Stats.RoundTrips++;
+	Reply(c, p, err, NULL, 0);
+	if (IsLinkError(err))
+		LinkDown(err);
+}
+
+/** Adds a read to the bundle of the cycle, merged into a chunk if possible. Returns 0 if it does not fit. */
+static int AddRead(MuxClient * c, MuxPending * p, unsigned *pNumRanges, unsigned *pNumItems, unsigned *pBytes)
+{
+	uint64_t        address = p->req.Address, end = address + p->req.Size;
+	uint64_t        lo, hi;
+	MuxRange       *r;
+	unsigned        i;
+
+	for (i = 0; i < *pNumRanges; i++) {
+		r = &Ranges[i];
+		if (strcmp(r->access, p->req.Access)
+		    || address > r->address + r->size + MUX_MERGE_GAP || end + MUX_MERGE_GAP < r->address)
+			continue;
+		lo = address < r->address ? address : r->address;
+		hi = end > r->address + r->size ? end : r->address + r->size;
+		if (hi - lo > T32MUX_MAXSIZE || *pBytes + (hi - lo) - r->size > MUX_BUNDLE_BYTES)
+			continue;
+		*pBytes += (unsigned) (hi - lo) - r->size;
+		r->address = lo;
+		r->size = (uint32_t) (hi - lo);
+		Stats.Coalesced++;
+		break;
+	}
+	if (i == *pNumRanges) {
+		if (*pNumRanges == MUX_MAX_CHUNKS || *pBytes + 2 + p->req.Size > MUX_BUNDLE_BYTES)
+			return 0;
+		r = &Ranges[(*pNumRanges)++];
+		r->address = address;
+		r->size = p->req.Size;
+		memcpy(r->access, p->req.Access, sizeof(r->access));
+		*pBytes += 2 + p->req.Size;
+	}
+	Items[*pNumItems].client = c;
+	Items[*pNumItems].pending = p;
+	Items[*pNumItems].range = r;
+	(*pNumItems)++;
+	return 1;
+}
+
+static void TransferReads(unsigned numRanges, unsigned numItems)
+{
+	T32_BufferSynchStatus status;
+	MuxRange       *r;
+	MuxItem        *item;
+	unsigned        i;
+	int             err = LinkError;
+
+	if (LinkUp) {
+		T32_ResetMemoryBundleObj(Bundle);
+		for (i = 0; i < numRanges; i++)
+			T32_AddToBundleObjAddrLength(Bundle, SetAddress(Ranges[i].address, Ranges[i].access), Ranges[i].size);
+		err = T32_TransferMemoryBundleObj(Bundle);
+		Stats.Bundles++;
+		Stats.Chunks += numRanges;
+		Stats.Reads += numItems;
+		Stats.RoundTrips++;
+	}
+	for (i = 0; i < numRanges; i++) {
+		r = &Ranges[i];
+		r->status = err;
+		if (err == T32_OK || err == T32_ERR_TRANSFERMEMOBJ_TRANSFERFAIL) {
+			status = T32_BUFFER_ERROR;
+			T32_GetBundleObjSyncStatusByIndex(Bundle, &status, i);
+			r->status = T32_ERR_TRANSFERMEMOBJ_TRANSFERFAIL;
+			if (status == T32_BUFFER_READ
+			    && T32_CopyDataFromBundleObjByIndex(r->data, r->size, Bundle, i) == T32_OK)
+				r->status = T32_OK;
+		}
+	}
+	if (LinkUp && IsLinkError(err))
+		LinkDown(err);
+
+	for (i = 0; i < numItems; i++) {
+		item = &Items[i];
+		r = item->range;
+		Reply(item->client, item->pending, r->status, r->data + (item->pending->req.Address - r->address),
+		      item->pending->req.Size);
+	}
+}
+
+/**
+	Serves the queued requests of all clients: round robin over the clients,
+	one request at a time, in priority order of the request at the head of each
+	queue, until the queues are empty or the bundle is full.
+*/
+static void Cycle(void)
+{
+	MuxClient      *c;
+	MuxPending     *p;
+	unsigned        numRanges = 0, numItems = 0, bytes = 4;
+	unsigned        start, prio, i, k;
+	int             progress, full = 0;
+
+	if (!NumClients)
+		return;
+	for (i = 0; i < NumClients; i++) {
+		Clients[i]->picked = 0;
+		Clients[i]->barrier = 0;
+	}
+	start = (unsigned) (Stats.Cycles++ % NumClients);
+
+	for (prio = 0; prio < T32MUX_PRIORITIES; prio++) {
+		do {
+			progress = 0;
+			for (k = 0; k < NumClients; k++) {
+				c = Clients[(start + k) % NumClients];
+				if (c->barrier || c->picked == c->count)
+					continue;
+				p = &c->queue[(c->head + c->picked) % MUX_QUEUE];
+				if (p->req.Priority != prio)
+					continue;
+				if (p->req.Op != T32MUX_READ) {
+					if (c->picked) {
+						c->barrier = 1;
+						continue;
+					}
+					ServeDirect(c, p);
+					Pop(c);
+					progress = 1;
+					continue;
+				}
+				if (full || !AddRead(c, p, &numRanges, &numItems, &bytes)) {
+					full = 1;
+					continue;
+				}
+				c->picked++;
+				progress = 1;
+			}
+		} while (progress);
+	}
+
+	if (numItems)
+		TransferReads(numRanges, numItems);
+	for (i = 0; i < NumClients; i++) {
+		c = Clients[i];
+		while (c->picked) {
+			Pop(c);
+			c->picked--;
+		}
+		if (c->count)
+			c->st.Deferred++;
+	}
+}
+
+/**************************************************************************
+
+	Daemon
+
+***************************************************************************/
+
+static int Listen(const char *path)
+{
+	struct sockaddr_un addr;
+	int             fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "t32mux: socket path too long\n");
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(fd, 8) < 0) {
+		perror(path);
+		if (fd >= 0)
+			close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/** Listens for RCL=TCPRELAY clients on all interfaces. */
+static int ListenTcp(const char *port)
+{
+	struct addrinfo hints, *ai;
+	int             fd, val = 1;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	if (getaddrinfo(NULL, port, &hints, &ai) != 0) {
+		fprintf(stderr, "t32mux: invalid port %s\n", port);
+		return -1;
+	}
+	fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+	if (fd >= 0)
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+	if (fd < 0 || bind(fd, ai->ai_addr, ai->ai_addrlen) < 0 || listen(fd, 8) < 0) {
+		perror(port);
+		if (fd >= 0)
+			close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(ai);
+	return fd;
+}
+
+static int Serve(const char *path, const char *tcpPort, unsigned windowUs, unsigned intervalS)
+{
+	struct pollfd   fds[2 + MUX_MAX_CLIENTS];
+	uint64_t        now, nextPrint;
+	int             listenfd, tcpfd = -1, timeout;
+	unsigned        i, n;
+
+	listenfd = Listen(path);
+	if (listenfd < 0)
+		return 1;
+	if (tcpPort && (tcpfd = ListenTcp(tcpPort)) < 0) {
+		close(listenfd);
+		unlink(path);
+		return 1;
+	}
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGUSR1, OnSignal);
+	signal(SIGINT, OnSignal);
+	signal(SIGTERM, OnSignal);
+
+	Connect();
+	nextPrint = NowNs() + intervalS * 1000000000ull;
+
+	while (!QuitRequested) {
+		now = NowNs();
+		timeout = -1;
+		if (NumPending) {
+			uint64_t        due = FirstQueued + windowUs * 1000ull;
+			timeout = due > now ? (int) ((due - now + 999999) / 1000000) : 0;
+		}
+		if (!LinkUp) {
+			int             t = NextConnect > now ? (int) ((NextConnect - now) / 1000000) + 1 : 0;
+			if (timeout < 0 || t < timeout)
+				timeout = t;
+		}
+		if (intervalS) {
+			int             t = nextPrint > now ? (int) ((nextPrint - now) / 1000000) + 1 : 0;
+			if (timeout < 0 || t < timeout)
+				timeout = t;
+		}
+
+		n = 0;
+		fds[n].fd = listenfd;
+		fds[n++].events = POLLIN;
+		fds[n].fd = tcpfd;      /* ignored by poll() without -t */
+		fds[n++].events = POLLIN;
+		for (i = 0; i < NumClients; i++) {
+			fds[n].fd = Clients[i]->fd;
+			fds[n].events = (Clients[i]->count < MUX_QUEUE ? POLLIN : 0) | (Clients[i]->outlen ? POLLOUT : 0);
+			fds[n++].revents = 0;
+		}
+		if (poll(fds, n, timeout) < 0 && errno != EINTR)
+			break;
+
+		if (PrintRequested) {
+			PrintRequested = 0;
+			PrintStats();
+		}
+		for (i = NumClients; i-- > 0;) {
+			if ((fds[2 + i].revents & (POLLIN | POLLHUP | POLLERR)) && Receive(Clients[i]) < 0)
+				CloseClient(i);
+		}
+		if (fds[0].revents & POLLIN)
+			Accept(listenfd, 0);
+		if (fds[1].revents & POLLIN)
+			Accept(tcpfd, 1);
+
+		now = NowNs();
+		if (!LinkUp && now >= NextConnect)
+			Connect();
+		if (NumPending && now >= FirstQueued + windowUs * 1000ull) {
+			Cycle();
+			/* input held back by full queues, then the oldest request left */
+			FirstQueued = UINT64_MAX;
+			for (i = 0; i < NumClients; i++) {
+				if (Parse(Clients[i]) < 0) {
+					CloseClient(i--);
+					continue;
+				}
+				if (Clients[i]->count && Clients[i]->queue[Clients[i]->head].queued < FirstQueued)
+					FirstQueued = Clients[i]->queue[Clients[i]->head].queued;
+			}
+		}
+		for (i = NumClients; i-- > 0;) {
+			Flush(Clients[i]);
+			if (Clients[i]->drop)
+				CloseClient(i);
+		}
+		if (intervalS && now >= nextPrint) {
+			PrintStats();
+			nextPrint = now + intervalS * 1000000000ull;
+		}
+	}
+
+	PrintStats();
+	while (NumClients)
+		CloseClient(NumClients - 1);
+	close(listenfd);
+	unlink(path);
+	if (tcpfd >= 0)
+		close(tcpfd);
+	if (LinkUp)
+		T32_Exit();
+	return 0;
+}
+
+/**************************************************************************
+
+	Client mode
+
+***************************************************************************/
+
+static int ReadAll(int fd, void *buf, size_t size)
+{
+	ssize_t         n;
+
+	while (size) {
+		n = recv(fd, buf, size, 0);
+		if (n <= 0)
+			return -1;
+		buf = (uint8_t *) buf + n;
+		size -= n;
+	}
+	return 0;
+}
+
+static int Query(const char *path, T32_MuxRequest * req)
+{
+	static uint8_t  data[MUX_MAX_CLIENTS * 200 + 1024];
+	struct sockaddr_un addr;
+	T32_MuxReply    reply;
+	uint32_t        i;
+	int             fd;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		perror(path);
+		return 1;
+	}
+	if (send(fd, req, sizeof(*req), 0) != sizeof(*req) || ReadAll(fd, &reply, sizeof(reply))
+	    || reply.Size > sizeof(data) || ReadAll(fd, data, reply.Size)) {
+		fprintf(stderr, "%s: connection closed\n", path);
+		close(fd);
+		return 1;
+	}
+	close(fd);
+	if (reply.Status != T32_OK) {
+		fprintf(stderr, "error %d\n", (int) reply.Status);
+		return 1;
+	}
+	if (req->Op == T32MUX_STATS) {
+		fwrite(data, 1, reply.Size, stdout);
+		return 0;
+	}
+	for (i = 0; i < reply.Size; i++) {
+		if (i % 16 == 0)
+			printf("%s%08" PRIx64 ":", i ? "\n" : "", req->Address + i);
+		printf(" %02x", data[i]);
+	}
+	printf("\n");
+	return 0;
+}
+
+static void Usage(void)
+{
+	fprintf(stderr,
+		"usage: t32mux [-n node] [-p port] [-l packlen] [-s socket] [-t port] [-w us] [-i seconds]\n"
+		"       t32mux [-s socket] -q\n"
+		"       t32mux [-s socket] -r address,size[,access]\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char     *path = T32MUX_DEFAULT_SOCKET, *tcpPort = NULL;
+	T32_MuxRequest  req;
+	unsigned        windowUs = 0, intervalS = 0;
+	char           *end;
+	int             opt, client = 0;
+
+	memset(&req, 0, sizeof(req));
+	while ((opt = getopt(argc, argv, "n:p:l:s:t:w:i:qr:")) != -1) {
+		switch (opt) {
+		case 'n':
+			Node = optarg;
+			break;
+		case 'p':
+			Port = optarg;
+			break;
+		case 'l':
+			PackLen = optarg;
+			break;
+		case 's':
+			path = optarg;
+			break;
+		case 't':
+			tcpPort = optarg;
+			break;
+		case 'w':
+			windowUs = (unsigned) strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			intervalS = (unsigned) strtoul(optarg, NULL, 0);
+			break;
+		case 'q':
+			req.Op = T32MUX_STATS;
+			client = 1;
+			break;
+		case 'r':
+			req.Op = T32MUX_READ;
+			req.Address = strtoull(optarg, &end, 0);
+			if (*end != ',') {
+				Usage();
+				return 1;
+			}
+			req.Size = (uint32_t) strtoul(end + 1, &end, 0);
+			if (*end == ',')
+				strncpy(req.Access, end + 1, sizeof(req.Access) - 1);
+			if (!req.Size || req.Size > T32MUX_MAXSIZE) {
+				fprintf(stderr, "size 1..%u\n", T32MUX_MAXSIZE);
+				return 1;
+			}
+			client = 1;
+			break;
+		default:
+			Usage();
+			return 1;
+		}
+	}
+	if (optind != argc) {
+		Usage();
+		return 1;
+	}
+	return client ? Query(path, &req) : Serve(path, tcpPort, windowUs, intervalS);
+}
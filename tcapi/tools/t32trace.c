@@ -0,0 +1,184 @@
+/*
+ * TRACE32 Remote API
+ *
+ * Copyright (c) 1998-2020 Lauterbach GmbH
+ * All rights reserved
+ *
+ * Offline decoder of the binary API trace written by hremote.c when it is
+ * built with ENABLE_APITRACE and T32APITRACEFILE is set.
+ *
+ *    t32trace [-j] <tracefile>
+ *
+ * prints one line per record, in the style of the text API log, or with -j
+ * one JSON object per line. Times are relative to the first record.
+ *
+ * Licensing restrictions apply to this code.
+ * Please see documentation (api_remote_c.pdf) for
+ * licensing terms and conditions.
+ *
+ * formatted with:
+ *    indent -kr -c0 -cbi0 -cd0 -cli4 -cp10 -di16 -fc1 -il0 -nsc -ppi2 --line-length120 --no-tabs t32trace.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "t32.h"
+
+typedef struct {
+	uint64_t        func;
+	char           *name;
+} TraceName;
+
+static TraceName *Names = NULL;
+static size_t   NumNames = 0;
+
+static const char *LookupName(uint64_t func)
+{
+	size_t          i;
+
+	for (i = 0; i < NumNames; i++)
+		if (Names[i].func == func)
+			return Names[i].name;
+	return "?";
+}
+
+static int AddName(uint64_t func, char *name)
+{
+	TraceName      *names;
+
+	names = (TraceName *) realloc(Names, (NumNames + 1) * sizeof(TraceName));
+	if (!names)
+		return -1;
+	Names = names;
+	Names[NumNames].func = func;
+	Names[NumNames].name = name;
+	NumNames++;
+	return 0;
+}
+
+static void PrintString(const char *s, size_t len, int json)
+{
+	size_t          i;
+
+	putchar('"');
+	for (i = 0; i < len && s[i]; i++) {
+		if (json && (s[i] == '"' || s[i] == '\\'))
+			printf("\\%c", s[i]);
+		else if ((unsigned char) s[i] < 0x20)
+			printf(json ? "\\u%04x" : "\\x%02x", (unsigned char) s[i]);
+		else
+			putchar(s[i]);
+	}
+	putchar('"');
+}
+
+static void PrintArgs(const T32_ApiTraceRecord *rec, int json)
+{
+	int             i;
+	char            str[8];
+
+	for (i = 0; i < rec->NumArgs && i < T32APITRACE_MAXARGS; i++) {
+		if (i)
+			printf(json ? "," : ", ");
+		switch ((rec->Aux >> (2 * i)) & 3) {
+		case T32APITRACE_ARG_INT:
+			printf("%d", (int32_t) rec->Arg[i]);
+			break;
+		case T32APITRACE_ARG_HEX:
+			printf(json ? "%" PRIu64 : "0x%" PRIx64, rec->Arg[i]);
+			break;
+		case T32APITRACE_ARG_UINT:
+			printf("%" PRIu64, rec->Arg[i]);
+			break;
+		default:
+			memcpy(str, &rec->Arg[i], sizeof(str));
+			PrintString(str, sizeof(str), json);
+			break;
+		}
+	}
+}
+
+static void PrintRecord(const T32_ApiTraceRecord *rec, uint64_t start, int json)
+{
+	uint64_t        t = rec->Time >= start ? rec->Time - start : 0;
+
+	if (json) {
+		printf("{\"t\":%" PRIu64 ",\"thread\":%u,", t, rec->Thread);
+		if (rec->Kind == T32APITRACE_DROPPED) {
+			printf("\"dropped\":%" PRIu64 "}\n", rec->Arg[0]);
+			return;
+		}
+		printf("\"func\":");
+		PrintString(LookupName(rec->Func), (size_t) -1, json);
+		printf(",\"%s\":[", rec->Kind == T32APITRACE_ENTRY ? "args" : "result");
+		PrintArgs(rec, json);
+		printf("]}\n");
+		return;
+	}
+	printf("/*%" PRIu64 ".%09" PRIu64 " #%u*/ ", t / 1000000000u, t % 1000000000u, rec->Thread);
+	if (rec->Kind == T32APITRACE_DROPPED) {
+		printf("/* %" PRIu64 " records dropped */\n", rec->Arg[0]);
+	} else if (rec->Kind == T32APITRACE_ENTRY) {
+		printf("%s(", LookupName(rec->Func));
+		PrintArgs(rec, json);
+		printf(");\n");
+	} else if (rec->Kind == T32APITRACE_EXIT) {
+		printf("//%s()=", LookupName(rec->Func));
+		if (rec->NumArgs)
+			PrintArgs(rec, json);
+		else
+			printf("<void>");
+		printf("\n");
+	} else
+		printf("ERROR kind %d in %s\n", rec->Kind, LookupName(rec->Func));
+}
+
+int main(int argc, char **argv)
+{
+	FILE           *f;
+	T32_ApiTraceHeader hdr;
+	T32_ApiTraceRecord rec;
+	uint64_t        start = 0;
+	int             json = 0, first = 1;
+	char           *name;
+
+	if (argc == 3 && !strcmp(argv[1], "-j"))
+		json = 1;
+	else if (argc != 2) {
+		fprintf(stderr, "usage: t32trace [-j] <tracefile>\n");
+		return 2;
+	}
+	f = fopen(argv[argc - 1], "rb");
+	if (!f) {
+		perror(argv[argc - 1]);
+		return 1;
+	}
+	if (fread(&hdr, sizeof(hdr), 1, f) != 1 || memcmp(hdr.Magic, T32APITRACE_MAGIC, sizeof(hdr.Magic))) {
+		fprintf(stderr, "%s: not an API trace file\n", argv[argc - 1]);
+		return 1;
+	}
+	if (hdr.Version != T32APITRACE_VERSION || hdr.RecordSize != sizeof(rec)) {
+		fprintf(stderr, "%s: unsupported version %u, record size %u\n", argv[argc - 1], hdr.Version, hdr.RecordSize);
+		return 1;
+	}
+	while (fread(&rec, sizeof(rec), 1, f) == 1) {
+		if (rec.Kind == T32APITRACE_NAME) {
+			name = (char *) calloc(1, rec.Aux + 1u);
+			if (!name || (rec.Aux && fread(name, rec.Aux, 1, f) != 1) || AddName(rec.Func, name)) {
+				fprintf(stderr, "%s: truncated name record\n", argv[argc - 1]);
+				return 1;
+			}
+			continue;
+		}
+		if (first && rec.Kind != T32APITRACE_DROPPED) {
+			start = rec.Time;
+			first = 0;
+		}
+		PrintRecord(&rec, start, json);
+	}
+	fclose(f);
+	return 0;
+}